@@ -0,0 +1,247 @@
+/*
+ * Copyright (C) 2016-2022 T-Head Semiconductor Co., Ltd. All rights reserved.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* CSI-NN2 version 2.0.x */
+
+/*
+ * Camera pipeline: capture -> pre-process -> inference -> post-process.
+ * The synchronous loop runs the four stages one after another. The
+ * asynchronous loop captures and pre-processes frame N + 1 while the
+ * session runs frame N, and post-processes frame N - 1 in the completion
+ * callback. The pipelined loop also splits the inference into stages, each
+ * on its own thread and cores, so several frames are in inference at once.
+ * Capture waits for the sensor, it is modeled by a sleep.
+ */
+
+#include <unistd.h>
+
+#include "csi_nn.h"
+#include "shl_utils.h"
+
+#define FRAMES 32
+#define WIDTH 160
+#define HEIGHT 120
+#define CAPTURE_US 8000
+
+static struct csinn_tensor *alloc_tensor(struct csinn_session *sess, int n, int c, int h, int w)
+{
+    struct csinn_tensor *t = csinn_alloc_tensor(sess);
+    t->dim[0] = n;
+    t->dim[1] = c;
+    t->dim[2] = h;
+    t->dim[3] = w;
+    t->dim_count = 4;
+    t->dtype = CSINN_DTYPE_FLOAT32;
+    t->layout = CSINN_LAYOUT_NCHW;
+    return t;
+}
+
+/* 3x3 stride 2 convolution followed by relu, with random weights */
+static struct csinn_tensor *conv_relu(struct csinn_session *sess, struct csinn_tensor *input,
+                                      int out_c)
+{
+    int in_c = input->dim[1];
+    int out_h = (input->dim[2] - 1) / 2 + 1;
+    int out_w = (input->dim[3] - 1) / 2 + 1;
+    struct csinn_tensor *conv = alloc_tensor(sess, 1, out_c, out_h, out_w);
+    struct csinn_tensor *output = alloc_tensor(sess, 1, out_c, out_h, out_w);
+    struct csinn_tensor *kernel = alloc_tensor(sess, out_c, in_c, 3, 3);
+    struct csinn_tensor *bias = alloc_tensor(sess, out_c, 1, 1, 1);
+    kernel->layout = CSINN_LAYOUT_OIHW;
+    kernel->is_const = 1;
+    bias->dim_count = 1;
+    bias->layout = CSINN_LAYOUT_O;
+    bias->is_const = 1;
+    float *kernel_data = malloc(out_c * in_c * 9 * sizeof(float));
+    float *bias_data = malloc(out_c * sizeof(float));
+    for (int i = 0; i < out_c * in_c * 9; i++) {
+        kernel_data[i] = (float)(rand() % 2001 - 1000) / 1000 / in_c;
+    }
+    for (int i = 0; i < out_c; i++) {
+        bias_data[i] = (float)(rand() % 2001 - 1000) / 10000;
+    }
+    kernel->data = kernel_data;
+    bias->data = bias_data;
+
+    struct csinn_conv2d_params *conv_params =
+        csinn_alloc_params(sizeof(struct csinn_conv2d_params), sess);
+    conv_params->base.layout = CSINN_LAYOUT_NCHW;
+    conv_params->group = 1;
+    conv_params->stride_height = 2;
+    conv_params->stride_width = 2;
+    conv_params->dilation_height = 1;
+    conv_params->dilation_width = 1;
+    conv_params->pad_top = 1;
+    conv_params->pad_down = 1;
+    conv_params->pad_left = 1;
+    conv_params->pad_right = 1;
+    csinn_conv2d_init(input, conv, kernel, bias, conv_params);
+    csinn_conv2d(input, conv, kernel, bias, conv_params);
+
+    struct csinn_relu_params *relu_params =
+        csinn_alloc_params(sizeof(struct csinn_relu_params), sess);
+    relu_params->base.layout = CSINN_LAYOUT_NCHW;
+    csinn_relu_init(conv, output, relu_params);
+    csinn_relu(conv, output, relu_params);
+    return output;
+}
+
+static struct csinn_session *build_session()
+{
+    struct csinn_session *sess = csinn_alloc_session();
+    sess->base_api = CSINN_REF;
+    sess->base_run_mode = CSINN_RM_CPU_GRAPH;
+    sess->base_dtype = CSINN_DTYPE_FLOAT32;
+    csinn_session_init(sess);
+    csinn_set_input_number(1, sess);
+    csinn_set_output_number(1, sess);
+
+    struct csinn_tensor *input = alloc_tensor(sess, 1, 3, HEIGHT, WIDTH);
+    input->name = "input";
+    csinn_set_tensor_entry(input, sess);
+    csinn_set_input(0, input, sess);
+    struct csinn_tensor *x = conv_relu(sess, input, 16);
+    x = conv_relu(sess, x, 32);
+    x = conv_relu(sess, x, 64);
+    x = conv_relu(sess, x, 64);
+    struct csinn_tensor *output = alloc_tensor(sess, 1, 64, 1, 1);
+    struct csinn_pool_params *pool_params =
+        csinn_alloc_params(sizeof(struct csinn_pool_params), sess);
+    pool_params->base.layout = CSINN_LAYOUT_NCHW;
+    csinn_global_avgpool2d_init(x, output, pool_params);
+    csinn_global_avgpool2d(x, output, pool_params);
+    csinn_set_output(0, output, sess);
+    csinn_session_setup(sess);
+    return sess;
+}
+
+/* wait for the sensor, then fill an interleaved 8 bit RGB frame */
+static void capture(uint8_t *frame, int index)
+{
+    usleep(CAPTURE_US);
+    for (int i = 0; i < HEIGHT * WIDTH * 3; i++) {
+        frame[i] = (uint8_t)(i * 7 + index * 13);
+    }
+}
+
+/* HWC uint8 to normalized CHW float */
+static void preprocess(const uint8_t *frame, float *data)
+{
+    const float mean[3] = {123.7f, 116.3f, 103.5f};
+    const float scale[3] = {0.0171f, 0.0175f, 0.0174f};
+    for (int c = 0; c < 3; c++) {
+        for (int i = 0; i < HEIGHT * WIDTH; i++) {
+            data[c * HEIGHT * WIDTH + i] = (frame[i * 3 + c] - mean[c]) * scale[c];
+        }
+    }
+}
+
+/* top class of the frame */
+static int postprocess(struct csinn_tensor *output)
+{
+    float *score = output->data;
+    int top = 0;
+    for (int i = 1; i < csinn_tensor_size(output); i++) {
+        if (score[i] > score[top]) {
+            top = i;
+        }
+    }
+    return top;
+}
+
+struct frame_result {
+    int top[FRAMES];
+    int count;
+};
+
+static void on_complete(struct csinn_session *sess, struct csinn_tensor **outputs, int status,
+                        void *user)
+{
+    struct frame_result *result = user;
+    result->top[result->count++] = status == CSINN_TRUE ? postprocess(outputs[0]) : -1;
+}
+
+int main(int argc, char **argv)
+{
+    struct csinn_session *sess = build_session();
+    uint8_t *frame = malloc(HEIGHT * WIDTH * 3);
+    struct csinn_tensor *input = csinn_alloc_tensor(NULL);
+    csinn_get_input(0, input, sess);
+    input->data = malloc(csinn_tensor_byte_size(input));
+
+    /* synchronous: every stage waits for the previous one */
+    struct frame_result sync_result = {0};
+    uint64_t start_time = shl_get_timespec();
+    for (int i = 0; i < FRAMES; i++) {
+        capture(frame, i);
+        preprocess(frame, input->data);
+        csinn_update_input(0, input, sess);
+        csinn_session_run(sess);
+        struct csinn_tensor *output = csinn_alloc_tensor(NULL);
+        csinn_get_output(0, output, sess);
+        sync_result.top[sync_result.count++] = postprocess(output);
+        shl_mem_free(output->data);
+        csinn_free_tensor(output);
+    }
+    float sync_ms = (shl_get_timespec() - start_time) / 1000000.0f;
+
+    /* asynchronous: two frames in flight, the input buffer is free once queued */
+    struct frame_result async_result = {0};
+    csinn_session_set_async(sess, 2);
+    start_time = shl_get_timespec();
+    for (int i = 0; i < FRAMES; i++) {
+        capture(frame, i);
+        preprocess(frame, input->data);
+        csinn_session_run_async(sess, &input, NULL, on_complete, &async_result);
+    }
+    csinn_session_wait(sess);
+    float async_ms = (shl_get_timespec() - start_time) / 1000000.0f;
+    csinn_session_set_async(sess, 0);
+
+    /* pipelined: three inference stages, one frame in each */
+    struct frame_result pipe_result = {0};
+    csinn_session_set_pipeline(sess, 3, 3);
+    start_time = shl_get_timespec();
+    for (int i = 0; i < FRAMES; i++) {
+        capture(frame, i);
+        preprocess(frame, input->data);
+        csinn_session_run_async(sess, &input, NULL, on_complete, &pipe_result);
+    }
+    csinn_session_wait(sess);
+    float pipe_ms = (shl_get_timespec() - start_time) / 1000000.0f;
+    csinn_session_set_pipeline(sess, 1, 0);
+
+    int mismatch = 0;
+    for (int i = 0; i < FRAMES; i++) {
+        mismatch += sync_result.top[i] != async_result.top[i];
+        mismatch += sync_result.top[i] != pipe_result.top[i];
+    }
+    printf("sync:  %d frames in %.1fms, %.1f FPS\n", FRAMES, sync_ms, FRAMES * 1000 / sync_ms);
+    printf("async: %d frames in %.1fms, %.1f FPS, %.2fx\n", FRAMES, async_ms,
+           FRAMES * 1000 / async_ms, sync_ms / async_ms);
+    printf("pipe:  %d frames in %.1fms, %.1f FPS, %.2fx\n", FRAMES, pipe_ms,
+           FRAMES * 1000 / pipe_ms, sync_ms / pipe_ms);
+    printf("%d of %d results differ\n", mismatch, 2 * FRAMES);
+
+    free(input->data);
+    csinn_free_tensor(input);
+    free(frame);
+    csinn_session_deinit(sess);
+    csinn_free_session(sess);
+    return mismatch != 0;
+}
@@ -0,0 +1,204 @@
+/*
+ * Copyright (C) 2016-2022 T-Head Semiconductor Co., Ltd. All rights reserved.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* CSI-NN2 version 2.0.x */
+
+/*
+ * Dynamic batching: client threads send single requests to a batcher over
+ * a session set up for batch 8, which runs them in batches. The results
+ * are checked against a batch 1 session run request by request.
+ */
+
+#include <pthread.h>
+#include <unistd.h>
+
+#include "csi_nn.h"
+#include "shl_utils.h"
+
+#define BATCH 8
+#define CLIENTS 8
+#define REQUESTS 32
+#define IN_SIZE 512
+#define HIDDEN 1024
+#define OUT_SIZE 16
+#define LATENCY_US 2000
+
+static float *weight_data[2];
+static float *bias_data[2];
+
+static struct csinn_tensor *alloc_tensor(struct csinn_session *sess, int n, int c)
+{
+    struct csinn_tensor *t = csinn_alloc_tensor(sess);
+    t->dim[0] = n;
+    t->dim[1] = c;
+    t->dim_count = 2;
+    t->dtype = CSINN_DTYPE_FLOAT32;
+    t->layout = CSINN_LAYOUT_NC;
+    return t;
+}
+
+static struct csinn_tensor *fc(struct csinn_session *sess, struct csinn_tensor *input, int out_c,
+                               int index)
+{
+    int in_c = input->dim[1];
+    struct csinn_tensor *output = alloc_tensor(sess, input->dim[0], out_c);
+    struct csinn_tensor *weight = alloc_tensor(sess, out_c, in_c);
+    struct csinn_tensor *bias = alloc_tensor(sess, out_c, 1);
+    weight->layout = CSINN_LAYOUT_OI;
+    weight->is_const = 1;
+    bias->dim_count = 1;
+    bias->layout = CSINN_LAYOUT_O;
+    bias->is_const = 1;
+    /* both sessions share the weights */
+    if (weight_data[index] == NULL) {
+        weight_data[index] = malloc(out_c * in_c * sizeof(float));
+        bias_data[index] = malloc(out_c * sizeof(float));
+        for (int i = 0; i < out_c * in_c; i++) {
+            weight_data[index][i] = (float)(rand() % 2001 - 1000) / 1000 / in_c;
+        }
+        for (int i = 0; i < out_c; i++) {
+            bias_data[index][i] = (float)(rand() % 2001 - 1000) / 10000;
+        }
+    }
+    weight->data = weight_data[index];
+    bias->data = bias_data[index];
+
+    struct csinn_fc_params *params = csinn_alloc_params(sizeof(struct csinn_fc_params), sess);
+    params->units = out_c;
+    csinn_fullyconnected_init(input, output, weight, bias, params);
+    csinn_fullyconnected(input, output, weight, bias, params);
+    return output;
+}
+
+static struct csinn_session *build_session(int batch)
+{
+    struct csinn_session *sess = csinn_alloc_session();
+    sess->base_api = CSINN_REF;
+    sess->base_run_mode = CSINN_RM_CPU_GRAPH;
+    sess->base_dtype = CSINN_DTYPE_FLOAT32;
+    csinn_session_init(sess);
+    csinn_set_input_number(1, sess);
+    csinn_set_output_number(1, sess);
+
+    struct csinn_tensor *input = alloc_tensor(sess, batch, IN_SIZE);
+    input->name = "input";
+    csinn_set_tensor_entry(input, sess);
+    csinn_set_input(0, input, sess);
+    struct csinn_tensor *hidden = fc(sess, input, HIDDEN, 0);
+    struct csinn_tensor *output = alloc_tensor(sess, batch, HIDDEN);
+    struct csinn_relu_params *relu_params =
+        csinn_alloc_params(sizeof(struct csinn_relu_params), sess);
+    csinn_relu_init(hidden, output, relu_params);
+    csinn_relu(hidden, output, relu_params);
+    output = fc(sess, output, OUT_SIZE, 1);
+    csinn_set_output(0, output, sess);
+    csinn_session_setup(sess);
+    return sess;
+}
+
+static float request_data[CLIENTS * REQUESTS][IN_SIZE];
+static float expected[CLIENTS * REQUESTS][OUT_SIZE];
+static int mismatch;
+
+struct client {
+    struct csinn_batcher *batcher;
+    int index;
+};
+
+/* send requests one at a time, with think time between them */
+static void *client_main(void *arg)
+{
+    struct client *c = arg;
+    struct csinn_tensor *input = alloc_tensor(NULL, 1, IN_SIZE);
+    struct csinn_tensor *output = alloc_tensor(NULL, 1, OUT_SIZE);
+    float result[OUT_SIZE];
+    output->data = result;
+    for (int i = 0; i < REQUESTS; i++) {
+        int id = c->index * REQUESTS + i;
+        input->data = request_data[id];
+        csinn_batcher_run(c->batcher, &input, &output);
+        if (memcmp(result, expected[id], sizeof(result)) != 0) {
+            __atomic_add_fetch(&mismatch, 1, __ATOMIC_RELAXED);
+        }
+        usleep(rand() % 500);
+    }
+    csinn_free_tensor(input);
+    csinn_free_tensor(output);
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    for (int i = 0; i < CLIENTS * REQUESTS; i++) {
+        for (int k = 0; k < IN_SIZE; k++) {
+            request_data[i][k] = (float)(rand() % 2001 - 1000) / 1000;
+        }
+    }
+
+    /* batch 1: one run per request */
+    struct csinn_session *single = build_session(1);
+    struct csinn_tensor *input = csinn_alloc_tensor(NULL);
+    csinn_get_input(0, input, single);
+    uint64_t start_time = shl_get_timespec();
+    for (int i = 0; i < CLIENTS * REQUESTS; i++) {
+        input->data = request_data[i];
+        csinn_update_input(0, input, single);
+        csinn_session_run(single);
+        struct csinn_tensor *output = csinn_alloc_tensor(NULL);
+        csinn_get_output(0, output, single);
+        memcpy(expected[i], output->data, sizeof(expected[i]));
+        shl_mem_free(output->data);
+        csinn_free_tensor(output);
+    }
+    float single_ms = (shl_get_timespec() - start_time) / 1000000.0f;
+    csinn_free_tensor(input);
+    csinn_session_deinit(single);
+    csinn_free_session(single);
+
+    /* batched: concurrent clients share a batch 8 session */
+    struct csinn_session *sess = build_session(BATCH);
+    struct csinn_batcher *batcher = csinn_alloc_batcher(sess, LATENCY_US);
+    pthread_t thread[CLIENTS];
+    struct client client[CLIENTS];
+    start_time = shl_get_timespec();
+    for (int i = 0; i < CLIENTS; i++) {
+        client[i].batcher = batcher;
+        client[i].index = i;
+        pthread_create(&thread[i], NULL, client_main, &client[i]);
+    }
+    for (int i = 0; i < CLIENTS; i++) {
+        pthread_join(thread[i], NULL);
+    }
+    float batch_ms = (shl_get_timespec() - start_time) / 1000000.0f;
+
+    struct csinn_batch_stats stats;
+    csinn_batcher_stats(batcher, &stats);
+    printf("batch 1: %d requests in %.1fms of inference\n", CLIENTS * REQUESTS, single_ms);
+    printf("batched: %d requests in %d runs, %.1fms with client think time\n",
+           (int)stats.request_count, stats.run_count, batch_ms);
+    printf("batch size histogram:");
+    for (int k = 1; k <= stats.max_batch; k++) {
+        printf(" %d:%d", k, stats.histogram[k]);
+    }
+    printf("\nlongest batching wait %.2fms\n", stats.max_wait_time / 1000000.0f);
+    printf("%d of %d results differ\n", mismatch, CLIENTS * REQUESTS);
+    csinn_free_batcher(batcher);
+    csinn_session_deinit(sess);
+    csinn_free_session(sess);
+    return mismatch != 0;
+}
@@ -0,0 +1,233 @@
+/*
+ * Copyright (C) 2016-2022 T-Head Semiconductor Co., Ltd. All rights reserved.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* CSI-NN2 version 2.0.x */
+
+/*
+ * Layout propagation: an NCHW graph mixing ops whose reference kernels only
+ * exist for NHWC (resize, shuffle_channel) with ops that run in both
+ * layouts. The same graph is set up with and without
+ * csinn_session_set_layout_opt, and the results and run times compared.
+ */
+
+#include <math.h>
+
+#include "csi_nn.h"
+#include "shl_utils.h"
+
+#define CHANNELS 16
+#define HEIGHT 48
+#define WIDTH 48
+#define RUNS 10
+
+static float *weight_data[2];
+static float *bias_data[2];
+
+static struct csinn_tensor *alloc_tensor(struct csinn_session *sess, int n, int c, int h, int w)
+{
+    struct csinn_tensor *t = csinn_alloc_tensor(sess);
+    t->dim[0] = n;
+    t->dim[1] = c;
+    t->dim[2] = h;
+    t->dim[3] = w;
+    t->dim_count = 4;
+    t->dtype = CSINN_DTYPE_FLOAT32;
+    t->layout = CSINN_LAYOUT_NCHW;
+    return t;
+}
+
+static struct csinn_tensor *resize(struct csinn_session *sess, struct csinn_tensor *input, int h,
+                                   int w, enum csinn_resize_enum mode)
+{
+    struct csinn_tensor *output = alloc_tensor(sess, 1, CHANNELS, h, w);
+    struct csinn_resize_params *params =
+        csinn_alloc_params(sizeof(struct csinn_resize_params), sess);
+    params->base.layout = CSINN_LAYOUT_NCHW;
+    params->resize_mode = mode;
+    csinn_resize_init(input, output, params);
+    csinn_resize(input, output, params);
+    return output;
+}
+
+static struct csinn_tensor *shuffle(struct csinn_session *sess, struct csinn_tensor *input)
+{
+    struct csinn_tensor *output =
+        alloc_tensor(sess, 1, CHANNELS, input->dim[2], input->dim[3]);
+    struct csinn_shuffle_channel_params *params =
+        csinn_alloc_params(sizeof(struct csinn_shuffle_channel_params), sess);
+    params->base.layout = CSINN_LAYOUT_NCHW;
+    params->group = 4;
+    csinn_shuffle_channel_init(input, output, params);
+    csinn_shuffle_channel(input, output, params);
+    return output;
+}
+
+/* 3x3 convolution, depthwise when group is the channel count, weights shared by both sessions */
+static struct csinn_tensor *conv(struct csinn_session *sess, struct csinn_tensor *input, int group,
+                                 int index)
+{
+    int in_c = CHANNELS / group;
+    struct csinn_tensor *output =
+        alloc_tensor(sess, 1, CHANNELS, input->dim[2], input->dim[3]);
+    struct csinn_tensor *kernel = alloc_tensor(sess, CHANNELS, in_c, 3, 3);
+    struct csinn_tensor *bias = alloc_tensor(sess, CHANNELS, 1, 1, 1);
+    kernel->layout = group == 1 ? CSINN_LAYOUT_OIHW : CSINN_LAYOUT_O1HW;
+    kernel->is_const = 1;
+    bias->dim_count = 1;
+    bias->layout = CSINN_LAYOUT_O;
+    bias->is_const = 1;
+    if (weight_data[index] == NULL) {
+        weight_data[index] = malloc(CHANNELS * in_c * 9 * sizeof(float));
+        bias_data[index] = malloc(CHANNELS * sizeof(float));
+        for (int i = 0; i < CHANNELS * in_c * 9; i++) {
+            weight_data[index][i] = (float)(rand() % 2001 - 1000) / 1000 / in_c;
+        }
+        for (int i = 0; i < CHANNELS; i++) {
+            bias_data[index][i] = (float)(rand() % 2001 - 1000) / 10000;
+        }
+    }
+    kernel->data = weight_data[index];
+    bias->data = bias_data[index];
+
+    struct csinn_conv2d_params *params =
+        csinn_alloc_params(sizeof(struct csinn_conv2d_params), sess);
+    params->base.layout = CSINN_LAYOUT_NCHW;
+    params->group = group;
+    params->stride_height = 1;
+    params->stride_width = 1;
+    params->dilation_height = 1;
+    params->dilation_width = 1;
+    params->pad_top = 1;
+    params->pad_down = 1;
+    params->pad_left = 1;
+    params->pad_right = 1;
+    csinn_conv2d_init(input, output, kernel, bias, params);
+    csinn_conv2d(input, output, kernel, bias, params);
+    return output;
+}
+
+/*
+ * resize x2, shuffle, depthwise conv, relu, shuffle, conv plus a residual
+ * add, resize /2, max pooling, shuffle
+ */
+static struct csinn_session *build_session(bool layout_opt)
+{
+    struct csinn_session *sess = csinn_alloc_session();
+    sess->base_api = CSINN_REF;
+    sess->base_run_mode = CSINN_RM_CPU_GRAPH;
+    sess->base_dtype = CSINN_DTYPE_FLOAT32;
+    csinn_session_init(sess);
+    csinn_session_set_layout_opt(sess, layout_opt);
+    csinn_set_input_number(1, sess);
+    csinn_set_output_number(1, sess);
+
+    struct csinn_tensor *input = alloc_tensor(sess, 1, CHANNELS, HEIGHT, WIDTH);
+    input->name = "input";
+    csinn_set_tensor_entry(input, sess);
+    csinn_set_input(0, input, sess);
+    struct csinn_tensor *x = resize(sess, input, HEIGHT * 2, WIDTH * 2, CSINN_RESIZE_BILINEAR);
+    x = shuffle(sess, x);
+    x = conv(sess, x, CHANNELS, 0);
+    struct csinn_tensor *act = alloc_tensor(sess, 1, CHANNELS, x->dim[2], x->dim[3]);
+    struct csinn_relu_params *relu_params =
+        csinn_alloc_params(sizeof(struct csinn_relu_params), sess);
+    csinn_relu_init(x, act, relu_params);
+    csinn_relu(x, act, relu_params);
+    x = shuffle(sess, act);
+    struct csinn_tensor *y = conv(sess, x, 1, 1);
+    struct csinn_tensor *sum = alloc_tensor(sess, 1, CHANNELS, x->dim[2], x->dim[3]);
+    struct csinn_diso_params *add_params =
+        csinn_alloc_params(sizeof(struct csinn_diso_params), sess);
+    csinn_add_init(x, y, sum, add_params);
+    csinn_add(x, y, sum, add_params);
+    x = resize(sess, sum, HEIGHT, WIDTH, CSINN_RESIZE_NEAREST_NEIGHBOR);
+
+    struct csinn_tensor *pool = alloc_tensor(sess, 1, CHANNELS, HEIGHT / 2, WIDTH / 2);
+    struct csinn_pool_params *pool_params =
+        csinn_alloc_params(sizeof(struct csinn_pool_params), sess);
+    pool_params->base.layout = CSINN_LAYOUT_NCHW;
+    pool_params->filter_height = 2;
+    pool_params->filter_width = 2;
+    pool_params->stride_height = 2;
+    pool_params->stride_width = 2;
+    csinn_maxpool2d_init(x, pool, pool_params);
+    csinn_maxpool2d(x, pool, pool_params);
+    struct csinn_tensor *output = shuffle(sess, pool);
+    csinn_set_output(0, output, sess);
+    csinn_session_setup(sess);
+    return sess;
+}
+
+/* average time of RUNS runs in ms, the last output is left in result */
+static float run(struct csinn_session *sess, struct csinn_tensor *input, float *result, int size)
+{
+    uint64_t start_time = shl_get_timespec();
+    for (int i = 0; i < RUNS; i++) {
+        csinn_update_input(0, input, sess);
+        csinn_session_run(sess);
+        struct csinn_tensor *output = csinn_alloc_tensor(NULL);
+        csinn_get_output(0, output, sess);
+        memcpy(result, output->data, size * sizeof(float));
+        shl_mem_free(output->data);
+        csinn_free_tensor(output);
+    }
+    return (shl_get_timespec() - start_time) / 1000000.0f / RUNS;
+}
+
+int main(int argc, char **argv)
+{
+    int in_size = CHANNELS * HEIGHT * WIDTH;
+    int out_size = CHANNELS * HEIGHT / 2 * WIDTH / 2;
+    struct csinn_tensor *input = alloc_tensor(NULL, 1, CHANNELS, HEIGHT, WIDTH);
+    float *data = malloc(in_size * sizeof(float));
+    for (int i = 0; i < in_size; i++) {
+        data[i] = (float)(rand() % 2001 - 1000) / 1000;
+    }
+    input->data = data;
+    float *expected = malloc(out_size * sizeof(float));
+    float *result = malloc(out_size * sizeof(float));
+
+    struct csinn_session *sess = build_session(false);
+    float nchw_ms = run(sess, input, expected, out_size);
+    csinn_session_deinit(sess);
+    csinn_free_session(sess);
+
+    sess = build_session(true);
+    float opt_ms = run(sess, input, result, out_size);
+    struct csinn_layout_stats stats;
+    csinn_session_layout_stats(sess, &stats);
+    csinn_session_deinit(sess);
+    csinn_free_session(sess);
+
+    float max_diff = 0;
+    for (int i = 0; i < out_size; i++) {
+        max_diff = fmaxf(max_diff, fabsf(result[i] - expected[i]));
+    }
+    printf("layers switched to NHWC: %d, weights re-laid out: %d\n", stats.nhwc_layers,
+           stats.kernels);
+    printf("layout conversions per run: %d before, %d after (%d transpose layers), %d removed\n",
+           stats.conversions_before, stats.conversions_after, stats.transposes,
+           stats.conversions_removed);
+    printf("run time: %.3fms without the pass, %.3fms with it\n", nchw_ms, opt_ms);
+    printf("max abs difference %g\n", max_diff);
+    free(data);
+    free(expected);
+    free(result);
+    csinn_free_tensor(input);
+    return max_diff > 1e-4f;
+}
@@ -0,0 +1,221 @@
+/*
+ * Copyright (C) 2016-2022 T-Head Semiconductor Co., Ltd. All rights reserved.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* CSI-NN2 version 2.0.x */
+
+/*
+ * Input resolution changes at run time: one session serves frames of
+ * several resolutions through csinn_session_resize_input. Each result is
+ * checked against a session set up for that resolution, and the cost of a
+ * resize is compared with setting up a new session.
+ */
+
+#include "csi_nn.h"
+#include "shl_utils.h"
+
+#define CHANNELS 16
+#define RESOLUTIONS 5
+#define ROUNDS 3
+
+static const int resolution[RESOLUTIONS][2] = {
+    {64, 64}, {96, 128}, {120, 160}, {64, 64}, {33, 47},
+};
+
+static float *weight_data[3];
+static float *bias_data[3];
+
+static struct csinn_tensor *alloc_tensor(struct csinn_session *sess, int n, int c, int h, int w)
+{
+    struct csinn_tensor *t = csinn_alloc_tensor(sess);
+    t->dim[0] = n;
+    t->dim[1] = c;
+    t->dim[2] = h;
+    t->dim[3] = w;
+    t->dim_count = 4;
+    t->dtype = CSINN_DTYPE_FLOAT32;
+    t->layout = CSINN_LAYOUT_NCHW;
+    return t;
+}
+
+/* 3x3 convolution with random weights shared by all sessions */
+static struct csinn_tensor *conv(struct csinn_session *sess, struct csinn_tensor *input, int out_c,
+                                 int stride, int index)
+{
+    int in_c = input->dim[1];
+    int out_h = (input->dim[2] - 1) / stride + 1;
+    int out_w = (input->dim[3] - 1) / stride + 1;
+    struct csinn_tensor *output = alloc_tensor(sess, 1, out_c, out_h, out_w);
+    struct csinn_tensor *kernel = alloc_tensor(sess, out_c, in_c, 3, 3);
+    struct csinn_tensor *bias = alloc_tensor(sess, out_c, 1, 1, 1);
+    kernel->layout = CSINN_LAYOUT_OIHW;
+    kernel->is_const = 1;
+    bias->dim_count = 1;
+    bias->layout = CSINN_LAYOUT_O;
+    bias->is_const = 1;
+    if (weight_data[index] == NULL) {
+        weight_data[index] = malloc(out_c * in_c * 9 * sizeof(float));
+        bias_data[index] = malloc(out_c * sizeof(float));
+        for (int i = 0; i < out_c * in_c * 9; i++) {
+            weight_data[index][i] = (float)(rand() % 2001 - 1000) / 1000 / in_c;
+        }
+        for (int i = 0; i < out_c; i++) {
+            bias_data[index][i] = (float)(rand() % 2001 - 1000) / 10000;
+        }
+    }
+    kernel->data = weight_data[index];
+    bias->data = bias_data[index];
+
+    struct csinn_conv2d_params *params =
+        csinn_alloc_params(sizeof(struct csinn_conv2d_params), sess);
+    params->base.layout = CSINN_LAYOUT_NCHW;
+    params->group = 1;
+    params->stride_height = stride;
+    params->stride_width = stride;
+    params->dilation_height = 1;
+    params->dilation_width = 1;
+    params->pad_top = 1;
+    params->pad_down = 1;
+    params->pad_left = 1;
+    params->pad_right = 1;
+    csinn_conv2d_init(input, output, kernel, bias, params);
+    csinn_conv2d(input, output, kernel, bias, params);
+    return output;
+}
+
+/*
+ * conv s2, then a residual block of two 3x3 s1 convs and relu, max pooling
+ * and global average pooling
+ */
+static struct csinn_session *build_session(int height, int width)
+{
+    struct csinn_session *sess = csinn_alloc_session();
+    sess->base_api = CSINN_REF;
+    sess->base_run_mode = CSINN_RM_CPU_GRAPH;
+    sess->base_dtype = CSINN_DTYPE_FLOAT32;
+    csinn_session_init(sess);
+    csinn_set_input_number(1, sess);
+    csinn_set_output_number(1, sess);
+
+    struct csinn_tensor *input = alloc_tensor(sess, 1, 3, height, width);
+    input->name = "input";
+    csinn_set_tensor_entry(input, sess);
+    csinn_set_input(0, input, sess);
+    struct csinn_tensor *x = conv(sess, input, CHANNELS, 2, 0);
+    struct csinn_tensor *y = conv(sess, x, CHANNELS, 1, 1);
+    y = conv(sess, y, CHANNELS, 1, 2);
+    struct csinn_tensor *sum = alloc_tensor(sess, 1, CHANNELS, x->dim[2], x->dim[3]);
+    struct csinn_diso_params *add_params =
+        csinn_alloc_params(sizeof(struct csinn_diso_params), sess);
+    csinn_add_init(x, y, sum, add_params);
+    csinn_add(x, y, sum, add_params);
+    struct csinn_tensor *act = alloc_tensor(sess, 1, CHANNELS, x->dim[2], x->dim[3]);
+    struct csinn_relu_params *relu_params =
+        csinn_alloc_params(sizeof(struct csinn_relu_params), sess);
+    csinn_relu_init(sum, act, relu_params);
+    csinn_relu(sum, act, relu_params);
+
+    struct csinn_tensor *pool =
+        alloc_tensor(sess, 1, CHANNELS, (sum->dim[2] - 2) / 2 + 1, (sum->dim[3] - 2) / 2 + 1);
+    struct csinn_pool_params *pool_params =
+        csinn_alloc_params(sizeof(struct csinn_pool_params), sess);
+    pool_params->base.layout = CSINN_LAYOUT_NCHW;
+    pool_params->filter_height = 2;
+    pool_params->filter_width = 2;
+    pool_params->stride_height = 2;
+    pool_params->stride_width = 2;
+    csinn_maxpool2d_init(act, pool, pool_params);
+    csinn_maxpool2d(act, pool, pool_params);
+
+    struct csinn_tensor *output = alloc_tensor(sess, 1, CHANNELS, 1, 1);
+    struct csinn_pool_params *gap_params =
+        csinn_alloc_params(sizeof(struct csinn_pool_params), sess);
+    gap_params->base.layout = CSINN_LAYOUT_NCHW;
+    csinn_global_avgpool2d_init(pool, output, gap_params);
+    csinn_global_avgpool2d(pool, output, gap_params);
+    csinn_set_output(0, output, sess);
+    csinn_session_setup(sess);
+    return sess;
+}
+
+static void run(struct csinn_session *sess, struct csinn_tensor *input, float *result)
+{
+    csinn_update_input(0, input, sess);
+    csinn_session_run(sess);
+    struct csinn_tensor *output = csinn_alloc_tensor(NULL);
+    csinn_get_output(0, output, sess);
+    memcpy(result, output->data, CHANNELS * sizeof(float));
+    shl_mem_free(output->data);
+    csinn_free_tensor(output);
+}
+
+int main(int argc, char **argv)
+{
+    struct csinn_tensor *input[RESOLUTIONS];
+    float expected[RESOLUTIONS][CHANNELS];
+    uint64_t setup_time = 0;
+    for (int r = 0; r < RESOLUTIONS; r++) {
+        int h = resolution[r][0];
+        int w = resolution[r][1];
+        input[r] = alloc_tensor(NULL, 1, 3, h, w);
+        float *data = malloc(3 * h * w * sizeof(float));
+        for (int i = 0; i < 3 * h * w; i++) {
+            data[i] = (float)(rand() % 2001 - 1000) / 1000;
+        }
+        input[r]->data = data;
+
+        uint64_t start_time = shl_get_timespec();
+        struct csinn_session *sess = build_session(h, w);
+        setup_time += shl_get_timespec() - start_time;
+        run(sess, input[r], expected[r]);
+        csinn_session_deinit(sess);
+        csinn_free_session(sess);
+    }
+
+    /* one session, set up for the first resolution, serves them all */
+    struct csinn_session *sess = build_session(resolution[0][0], resolution[0][1]);
+    int mismatch = 0;
+    uint64_t resize_time[ROUNDS] = {0};
+    for (int round = 0; round < ROUNDS; round++) {
+        for (int r = 0; r < RESOLUTIONS; r++) {
+            float result[CHANNELS];
+            uint64_t start_time = shl_get_timespec();
+            if (csinn_session_resize_input(sess, &input[r]) != CSINN_TRUE) {
+                printf("resize to %dx%d failed\n", resolution[r][0], resolution[r][1]);
+                return 1;
+            }
+            resize_time[round] += shl_get_timespec() - start_time;
+            run(sess, input[r], result);
+            mismatch += memcmp(result, expected[r], sizeof(result)) != 0;
+        }
+    }
+    csinn_session_deinit(sess);
+    csinn_free_session(sess);
+
+    printf("new session per resolution: %.3fms per setup\n",
+           setup_time / 1000000.0f / RESOLUTIONS);
+    for (int round = 0; round < ROUNDS; round++) {
+        printf("round %d: %.3fms per resize\n", round,
+               resize_time[round] / 1000000.0f / RESOLUTIONS);
+    }
+    printf("%d of %d results differ\n", mismatch, ROUNDS * RESOLUTIONS);
+    for (int r = 0; r < RESOLUTIONS; r++) {
+        free(input[r]->data);
+        csinn_free_tensor(input[r]);
+    }
+    return mismatch != 0;
+}
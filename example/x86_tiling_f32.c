@@ -0,0 +1,205 @@
+/*
+ * Copyright (C) 2016-2022 T-Head Semiconductor Co., Ltd. All rights reserved.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* CSI-NN2 version 2.0.x */
+
+/*
+ * Depth-first tiling: a MobileNetV2-style block (1x1 expand, depthwise 3x3,
+ * 1x1 project, each but the last followed by relu6, then max pooling) is set
+ * up with and without csinn_session_set_tiling. The tiled session runs the
+ * chain band by band; results, run times and the activation peaks the
+ * runtime computes from the tensor sizes of both plans are compared.
+ */
+
+#include <math.h>
+
+#include "csi_nn.h"
+#include "shl_utils.h"
+
+#define CHANNELS 8
+#define EXPAND 32
+#define HEIGHT 112
+#define WIDTH 112
+#define RUNS 10
+
+static float *weight_data[3];
+static float *bias_data[3];
+
+static struct csinn_tensor *alloc_tensor(struct csinn_session *sess, int n, int c, int h, int w)
+{
+    struct csinn_tensor *t = csinn_alloc_tensor(sess);
+    t->dim[0] = n;
+    t->dim[1] = c;
+    t->dim[2] = h;
+    t->dim[3] = w;
+    t->dim_count = 4;
+    t->dtype = CSINN_DTYPE_FLOAT32;
+    t->layout = CSINN_LAYOUT_NCHW;
+    return t;
+}
+
+/* convolution with same padding, depthwise when group is the channel count */
+static struct csinn_tensor *conv(struct csinn_session *sess, struct csinn_tensor *input, int out_c,
+                                 int ksize, int group, int index)
+{
+    int in_c = input->dim[1] / group;
+    struct csinn_tensor *output = alloc_tensor(sess, 1, out_c, input->dim[2], input->dim[3]);
+    struct csinn_tensor *kernel = alloc_tensor(sess, out_c, in_c, ksize, ksize);
+    struct csinn_tensor *bias = alloc_tensor(sess, out_c, 1, 1, 1);
+    int kernel_size = out_c * in_c * ksize * ksize;
+    kernel->layout = group == 1 ? CSINN_LAYOUT_OIHW : CSINN_LAYOUT_O1HW;
+    kernel->is_const = 1;
+    bias->dim_count = 1;
+    bias->layout = CSINN_LAYOUT_O;
+    bias->is_const = 1;
+    if (weight_data[index] == NULL) {
+        weight_data[index] = malloc(kernel_size * sizeof(float));
+        bias_data[index] = malloc(out_c * sizeof(float));
+        for (int i = 0; i < kernel_size; i++) {
+            weight_data[index][i] = (float)(rand() % 2001 - 1000) / 1000 / in_c;
+        }
+        for (int i = 0; i < out_c; i++) {
+            bias_data[index][i] = (float)(rand() % 2001 - 1000) / 10000;
+        }
+    }
+    kernel->data = weight_data[index];
+    bias->data = bias_data[index];
+
+    struct csinn_conv2d_params *params =
+        csinn_alloc_params(sizeof(struct csinn_conv2d_params), sess);
+    params->base.layout = CSINN_LAYOUT_NCHW;
+    params->group = group;
+    params->stride_height = 1;
+    params->stride_width = 1;
+    params->dilation_height = 1;
+    params->dilation_width = 1;
+    params->pad_top = ksize / 2;
+    params->pad_down = ksize / 2;
+    params->pad_left = ksize / 2;
+    params->pad_right = ksize / 2;
+    csinn_conv2d_init(input, output, kernel, bias, params);
+    csinn_conv2d(input, output, kernel, bias, params);
+    return output;
+}
+
+static struct csinn_tensor *relu6(struct csinn_session *sess, struct csinn_tensor *input)
+{
+    struct csinn_tensor *output =
+        alloc_tensor(sess, 1, input->dim[1], input->dim[2], input->dim[3]);
+    struct csinn_relu_params *params = csinn_alloc_params(sizeof(struct csinn_relu_params), sess);
+    csinn_relu6_init(input, output, params);
+    csinn_relu6(input, output, params);
+    return output;
+}
+
+static struct csinn_session *build_session(bool tiling)
+{
+    struct csinn_session *sess = csinn_alloc_session();
+    sess->base_api = CSINN_REF;
+    sess->base_run_mode = CSINN_RM_CPU_GRAPH;
+    sess->base_dtype = CSINN_DTYPE_FLOAT32;
+    csinn_session_init(sess);
+    csinn_set_input_number(1, sess);
+    csinn_set_output_number(1, sess);
+
+    struct csinn_tensor *input = alloc_tensor(sess, 1, CHANNELS, HEIGHT, WIDTH);
+    input->name = "input";
+    csinn_set_tensor_entry(input, sess);
+    csinn_set_input(0, input, sess);
+    struct csinn_tensor *x = relu6(sess, conv(sess, input, EXPAND, 1, 1, 0));
+    x = relu6(sess, conv(sess, x, EXPAND, 3, EXPAND, 1));
+    x = conv(sess, x, CHANNELS, 1, 1, 2);
+
+    struct csinn_tensor *output = alloc_tensor(sess, 1, CHANNELS, HEIGHT / 2, WIDTH / 2);
+    struct csinn_pool_params *pool_params =
+        csinn_alloc_params(sizeof(struct csinn_pool_params), sess);
+    pool_params->base.layout = CSINN_LAYOUT_NCHW;
+    pool_params->filter_height = 2;
+    pool_params->filter_width = 2;
+    pool_params->stride_height = 2;
+    pool_params->stride_width = 2;
+    csinn_maxpool2d_init(x, output, pool_params);
+    csinn_maxpool2d(x, output, pool_params);
+    csinn_set_output(0, output, sess);
+    csinn_session_setup(sess);
+    csinn_session_set_tiling(sess, tiling);
+    return sess;
+}
+
+/* average time of RUNS runs in ms, the last output is left in result */
+static float run(struct csinn_session *sess, struct csinn_tensor *input, float *result, int size)
+{
+    uint64_t start_time = shl_get_timespec();
+    for (int i = 0; i < RUNS; i++) {
+        csinn_update_input(0, input, sess);
+        csinn_session_run(sess);
+        struct csinn_tensor *output = csinn_alloc_tensor(NULL);
+        csinn_get_output(0, output, sess);
+        memcpy(result, output->data, size * sizeof(float));
+        shl_mem_free(output->data);
+        csinn_free_tensor(output);
+    }
+    return (shl_get_timespec() - start_time) / 1000000.0f / RUNS;
+}
+
+int main(int argc, char **argv)
+{
+    int in_size = CHANNELS * HEIGHT * WIDTH;
+    int out_size = CHANNELS * HEIGHT / 2 * WIDTH / 2;
+    struct csinn_tensor *input = alloc_tensor(NULL, 1, CHANNELS, HEIGHT, WIDTH);
+    float *data = malloc(in_size * sizeof(float));
+    for (int i = 0; i < in_size; i++) {
+        data[i] = (float)(rand() % 2001 - 1000) / 1000;
+    }
+    input->data = data;
+    float *expected = malloc(out_size * sizeof(float));
+    float *result = malloc(out_size * sizeof(float));
+
+    struct csinn_session *sess = build_session(false);
+    float layer_ms = run(sess, input, expected, out_size);
+    csinn_session_deinit(sess);
+    csinn_free_session(sess);
+
+    sess = build_session(true);
+    float tiled_ms = run(sess, input, result, out_size);
+    struct csinn_tiling_stats stats;
+    csinn_session_tiling_stats(sess, &stats);
+    csinn_session_deinit(sess);
+    csinn_free_session(sess);
+
+    float max_diff = 0;
+    for (int i = 0; i < out_size; i++) {
+        max_diff = fmaxf(max_diff, fabsf(result[i] - expected[i]));
+    }
+    printf("tiled groups: %d, fused layers: %d, tiles per run: %d\n", stats.groups,
+           stats.fused_layers, stats.tiles);
+    printf("computed activation peak: %.2fMB tiled, %.2fMB layer by layer\n",
+           stats.peak_bytes / 1048576.0, stats.layer_peak_bytes / 1048576.0);
+    printf("run time: %.3fms layer by layer, %.3fms tiled\n", layer_ms, tiled_ms);
+    printf("max abs difference %g\n", max_diff);
+    for (int i = 0; i < 3; i++) {
+        free(weight_data[i]);
+        free(bias_data[i]);
+    }
+    free(data);
+    free(expected);
+    free(result);
+    csinn_free_tensor(input);
+    return max_diff > 1e-4f || stats.groups == 0 || stats.tiles <= stats.groups ||
+           stats.peak_bytes >= stats.layer_peak_bytes;
+}
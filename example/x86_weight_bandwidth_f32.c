@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2016-2022 T-Head Semiconductor Co., Ltd. All rights reserved.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* CSI-NN2 version 2.0.x */
+
+/*
+ * Weight-only quantization bandwidth: a batch 1 fullyconnected (GEMV) over a layer larger
+ * than the caches spends its time reading weights. The layer runs with float32, int8 and int4
+ * weights and the weight bytes read per token are reported next to the time per token.
+ *
+ * usage: x86_weight_bandwidth_f32.elf [in_c] [out_c] [loops]
+ */
+
+#include <math.h>
+
+#include "csi_nn.h"
+#include "shl_utils.h"
+
+/* symmetric per output channel quantization of float OI weights */
+static struct csinn_tensor *quantize_weight(struct csinn_tensor *weight,
+                                            enum csinn_dtype_enum dtype)
+{
+    int out_c = weight->dim[0];
+    int in_c = weight->dim[1];
+    float *data = weight->data;
+    float q_max = dtype == CSINN_DTYPE_INT4 ? 7.0f : 127.0f;
+    csinn_realloc_quant_info(weight, out_c);
+    for (int i = 0; i < out_c; i++) {
+        float max_abs = 0;
+        for (int j = 0; j < in_c; j++) {
+            max_abs = fmaxf(max_abs, fabsf(data[i * in_c + j]));
+        }
+        weight->qinfo[i].scale = max_abs > 0 ? max_abs / q_max : 1.0f;
+        weight->qinfo[i].zero_point = 0;
+    }
+
+    struct csinn_tensor *ret = csinn_alloc_tensor(NULL);
+    csinn_tensor_copy(ret, weight);
+    ret->dtype = dtype;
+    ret->data = shl_mem_alloc(csinn_tensor_byte_size(ret));
+    csinn_tensor_data_convert(ret, weight);
+    return ret;
+}
+
+static struct csinn_tensor *alloc_tensor(int dim0, int dim1, int dim_count)
+{
+    struct csinn_tensor *t = csinn_alloc_tensor(NULL);
+    t->dim[0] = dim0;
+    t->dim[1] = dim1;
+    t->dim_count = dim_count;
+    t->dtype = CSINN_DTYPE_FLOAT32;
+    t->data = shl_mem_alloc((int64_t)csinn_tensor_size(t) * sizeof(float));
+    return t;
+}
+
+static void free_tensor(struct csinn_tensor *t)
+{
+    shl_mem_free(t->data);
+    csinn_free_tensor(t);
+}
+
+static void run_fc(struct csinn_tensor *input, struct csinn_tensor *output,
+                   struct csinn_tensor *weight, struct csinn_tensor *bias,
+                   struct csinn_session *sess)
+{
+    struct csinn_fc_params *params = csinn_alloc_params(sizeof(struct csinn_fc_params), sess);
+    if (csinn_fullyconnected_init(input, output, weight, bias, params) == CSINN_TRUE) {
+        csinn_fullyconnected(input, output, weight, bias, params);
+    }
+    csinn_free_params(params);
+}
+
+int main(int argc, char **argv)
+{
+    int in_c = argc > 1 ? atoi(argv[1]) : 4096;
+    int out_c = argc > 2 ? atoi(argv[2]) : 4096;
+    int loops = argc > 3 ? atoi(argv[3]) : 10;
+
+    struct csinn_session *sess = csinn_alloc_session();
+    sess->base_api = CSINN_REF;
+    sess->base_run_mode = CSINN_RM_LAYER;
+
+    struct csinn_tensor *input = alloc_tensor(1, in_c, 2);
+    struct csinn_tensor *output = alloc_tensor(1, out_c, 2);
+    struct csinn_tensor *weight = alloc_tensor(out_c, in_c, 2);
+    struct csinn_tensor *bias = alloc_tensor(out_c, 1, 1);
+    weight->layout = CSINN_LAYOUT_OI;
+    float *input_data = input->data;
+    float *weight_data = weight->data;
+    float *bias_data = bias->data;
+    for (int i = 0; i < in_c; i++) {
+        input_data[i] = (float)(rand() % 2001 - 1000) / 1000;
+    }
+    for (int64_t i = 0; i < (int64_t)in_c * out_c; i++) {
+        weight_data[i] = (float)(rand() % 2001 - 1000) / 1000;
+    }
+    for (int i = 0; i < out_c; i++) {
+        bias_data[i] = 0;
+    }
+
+    struct csinn_tensor *weights[3] = {weight, quantize_weight(weight, CSINN_DTYPE_INT8),
+                                       quantize_weight(weight, CSINN_DTYPE_INT4)};
+    const char *names[3] = {"float32", "int8", "int4"};
+    double base_ms = 0;
+    for (int w = 0; w < 3; w++) {
+        run_fc(input, output, weights[w], bias, sess);
+        uint64_t start = shl_get_timespec();
+        for (int l = 0; l < loops; l++) {
+            run_fc(input, output, weights[w], bias, sess);
+        }
+        double ms = (shl_get_timespec() - start) / 1000000.0 / loops;
+        double mbytes = csinn_tensor_byte_size(weights[w]) / 1048576.0;
+        base_ms = w == 0 ? ms : base_ms;
+        printf("%dx%d %-7s weights: %8.2f MB/token %8.3f ms/token %7.2f GB/s %5.2fx\n", out_c,
+               in_c, names[w], mbytes, ms, mbytes / 1024 / (ms / 1000), base_ms / ms);
+    }
+
+    for (int w = 0; w < 3; w++) {
+        free_tensor(weights[w]);
+    }
+    free_tensor(input);
+    free_tensor(output);
+    free_tensor(bias);
+    csinn_free_session(sess);
+    return 0;
+}
@@ -43,6 +43,8 @@ int csinn_conv2d(struct csinn_tensor *input, struct csinn_tensor *output,
                  struct csinn_tensor *kernel, struct csinn_tensor *bias,
                  struct csinn_conv2d_params *params);
 
+void csinn_conv2d_deinit(struct csinn_conv2d_params *params);
+
 int csinn_depthwise_conv2d_init(struct csinn_tensor *input, struct csinn_tensor *output,
                                 struct csinn_tensor *kernel, struct csinn_tensor *bias,
                                 struct csinn_conv2d_params *params);
@@ -824,6 +826,12 @@ int csinn_yuv_rgb_scale_init(struct csinn_tensor *input, struct csinn_tensor *ou
 int csinn_yuv_rgb_scale(struct csinn_tensor *input, struct csinn_tensor *output,
                         struct csinn_siso_params *params);
 
+int csinn_yuv_preprocess_init(struct csinn_tensor *input, struct csinn_tensor *output,
+                              struct csinn_yuv_preprocess_params *params);
+
+int csinn_yuv_preprocess(struct csinn_tensor *input, struct csinn_tensor *output,
+                         struct csinn_yuv_preprocess_params *params);
+
 int csinn_segment_max_init(struct csinn_tensor *input0, struct csinn_tensor *input1,
                            struct csinn_tensor *output, struct csinn_segment_params *params);
 
@@ -1068,6 +1076,14 @@ int csinn_data_convert_init(struct csinn_tensor *input, struct csinn_tensor *out
 int csinn_data_convert(struct csinn_tensor *input, struct csinn_tensor *output,
                        struct csinn_siso_params *params);
 
+int csinn_attention_init(struct csinn_tensor *query, struct csinn_tensor *key,
+                         struct csinn_tensor *value, struct csinn_tensor *mask,
+                         struct csinn_tensor *output, struct csinn_attention_params *params);
+
+int csinn_attention(struct csinn_tensor *query, struct csinn_tensor *key,
+                    struct csinn_tensor *value, struct csinn_tensor *mask,
+                    struct csinn_tensor *output, struct csinn_attention_params *params);
+
 #ifdef __cplusplus
 }
 #endif
@@ -285,6 +285,9 @@ enum csinn_op_enum {
     CSINN_OP_WHERE,
     CSINN_OP_XOR,
     CSINN_OP_YUV_RGB_SCALE,
+    /* ops added later go here, so existing ids stay stable for prebuilt backends and models */
+    CSINN_OP_ATTENTION,
+    CSINN_OP_YUV_PREPROCESS,
 
     CSINN_OP_SIZE,
 
@@ -312,6 +315,21 @@ enum csinn_runtime_enum {
     CSINN_GET_OUTPUT,
     CSINN_TENSOR_ENTRY,
     CSINN_LOAD_BG,
+    CSINN_SESSION_SET_STREAM,
+    CSINN_SESSION_STREAM_RESET,
+    CSINN_SESSION_STREAM_STATS,
+    CSINN_SESSION_SET_TILING,
+    CSINN_SESSION_TILING_STATS,
+    CSINN_SESSION_SET_COUNTERS,
+    CSINN_SESSION_COUNTER_STATS,
+    CSINN_SESSION_SET_ASYNC,
+    CSINN_SESSION_RUN_ASYNC,
+    CSINN_SESSION_WAIT,
+    CSINN_SESSION_SET_PIPELINE,
+    CSINN_SESSION_RESIZE_INPUT,
+    CSINN_SESSION_SET_LAYOUT_OPT,
+    CSINN_SESSION_LAYOUT_STATS,
+    CSINN_SESSION_SET_TUNING,
     CSINN_RUNTIME_OP_SIZE,
 };
 
@@ -336,6 +354,12 @@ enum csinn_resize_enum {
     CSINN_RESIZE_NEAREST_BICUBIC = 0x2,
 };
 
+/* yuv_preprocess input format */
+enum csinn_yuv_format_enum {
+    CSINN_YUV_NV12 = 0x0, /* Y plane, then interleaved UV at half resolution */
+    CSINN_YUV_I420 = 0x1, /* Y plane, then U and V planes at half resolution */
+};
+
 /* depth2space mode */
 enum csinn_depth2space_enum {
     CSINN_DEPTHTOSPACE_DCR = 0x0,
@@ -454,6 +478,139 @@ struct csinn_session {
     struct csinn_tensor **input;
     struct csinn_tensor **output;
     void *td;
+    bool fast_math;  // let reference kernels use the fast approximations in ref_mathfun.h
+    struct csinn_kv_cache **kv_cache;
+    int32_t kv_cache_num;
+    struct csinn_tuning *tuning;  // conv algorithm autotuning, NULL when disabled
+};
+
+enum csinn_kv_cache_mode_enum {
+    CSINN_KV_CACHE_APPEND = 0,  // writes past max_len fail
+    CSINN_KV_CACHE_RING,        // writes past max_len evict the oldest positions
+};
+
+/*
+ * Past keys and values of one decoder layer. Storage is preallocated as [..., max_len, dim], the
+ * sequence axis is dim_count - 2. Positions are read oldest first.
+ */
+struct csinn_kv_cache {
+    struct csinn_tensor *key;
+    struct csinn_tensor *value;
+    int32_t max_len;
+    int32_t cur_len;  // committed positions
+    int32_t new_len;  // positions written by the step in flight, not yet committed
+    int32_t start;    // storage row of the oldest position
+    enum csinn_kv_cache_mode_enum mode;
+    struct csinn_session *sess;
+};
+
+/* streaming mode statistics, times are in nanoseconds */
+struct csinn_stream_stats {
+    int32_t chunk_count;
+    int32_t static_layers;  // layers computed once, on the first chunk only
+    int32_t stream_layers;  // layers computed on every chunk
+    uint64_t first_chunk_time;
+    uint64_t last_chunk_time;
+    uint64_t min_chunk_time;
+    uint64_t max_chunk_time;
+    uint64_t total_time;
+};
+
+/*
+ * depth-first tiling statistics, sizes are in bytes and times in nanoseconds. The peaks are
+ * estimates computed at planning time from the tensor sizes and the output lifetimes, not
+ * allocator measurements.
+ */
+struct csinn_tiling_stats {
+    int32_t groups;            // chains of spatially local layers run tile by tile
+    int32_t fused_layers;      // layers in those chains
+    int32_t tiles;             // tiles per run, summed over the chains
+    int64_t peak_bytes;        // estimated peak activation memory with tiling
+    int64_t layer_peak_bytes;  // estimated peak activation memory running layer by layer
+    int32_t run_count;
+    uint64_t last_run_time;
+};
+
+/* layout propagation statistics, conversions are NCHW<->NHWC tensor transposes per run */
+struct csinn_layout_stats {
+    int32_t nhwc_layers;          // layers switched to NHWC
+    int32_t transposes;           // transpose layers inserted at layout boundaries
+    int32_t kernels;              // weights re-laid out once at setup
+    int32_t conversions_before;   // done inside NCHW kernels without the pass
+    int32_t conversions_after;    // done by the inserted transposes
+    int32_t conversions_removed;  // conversions_before - conversions_after
+};
+
+enum csinn_counter_enum {
+    CSINN_COUNTER_CYCLES = 0,
+    CSINN_COUNTER_INSTRUCTIONS,
+    CSINN_COUNTER_LLC_MISSES,
+    CSINN_COUNTER_BRANCH_MISSES,
+    CSINN_COUNTER_SIZE,
+};
+
+/* one graph node, values are summed over runs and times are in nanoseconds */
+struct csinn_layer_counters {
+    char *name;
+    int32_t op;
+    int64_t bytes;  // input, weight and output bytes the node touches per run
+    uint64_t time;
+    uint64_t value[CSINN_COUNTER_SIZE];  // zero for events that are not counted
+};
+
+/*
+ * Per node hardware counters of a session, read with perf_event_open on
+ * Linux. When no event can be opened only the wall time is collected.
+ * Counts cover the thread that enables the counters, its OpenMP workers and
+ * threads it starts later, but not threads started by other threads (e.g.
+ * an application thread pool running nodes on its own workers). Only the
+ * layer by layer run is counted: counters cannot be combined with
+ * streaming, tiling or pipelined runs.
+ */
+struct csinn_counter_stats {
+    uint32_t events;  // bit CSINN_COUNTER_* is set for each event that is counted
+    int32_t run_count;
+    int32_t layer_num;
+    struct csinn_layer_counters *layer;  // owned by the session
+};
+
+/* completion of csinn_session_run_async, status is the result of the run */
+typedef void (*csinn_async_callback)(struct csinn_session *sess, struct csinn_tensor **outputs,
+                                     int status, void *user);
+
+/*
+ * Dynamic batching statistics. histogram[k] counts the batched runs that
+ * carried k requests, k = 1 .. max_batch. Times are in nanoseconds.
+ */
+struct csinn_batch_stats {
+    int32_t max_batch;
+    int32_t run_count;
+    int64_t request_count;
+    int32_t *histogram;      // max_batch + 1 entries, owned by the batcher
+    uint64_t max_wait_time;  // longest wait from a batch's first request to its dispatch
+};
+
+/* batching front end of a session, see csinn_alloc_batcher */
+struct csinn_batcher;
+
+/* one autotuning decision: the fastest algorithm measured for a layer key */
+struct csinn_tuning_entry {
+    char *key;
+    char *algo;
+    float time;  // microseconds per run when it was measured
+};
+
+/*
+ * Conv algorithm autotuning of a session. Keys name the backend, dtype and
+ * layer shape; decisions loaded from the tuning file are reused without
+ * measuring, new ones are appended to it.
+ */
+struct csinn_tuning {
+    char *path;  // tuning file, NULL keeps decisions in memory only
+    struct csinn_tuning_entry *entry;
+    int32_t entry_num;
+    int32_t measured;  // layers timed by this session
+    int32_t reused;    // layers answered from earlier decisions
 };
 
 struct csinn_callback {
@@ -578,6 +735,7 @@ struct csinn_roi_pool_params {
 
 struct csinn_siso_params {
     struct csinn_params_base base;
+    uint8_t *lut;  // 256-entry output table for 8-bit inputs, built at init
 };
 
 struct csinn_scatter_nd_params {
@@ -586,6 +744,7 @@ struct csinn_scatter_nd_params {
 
 struct csinn_sigmoid_params {
     struct csinn_params_base base;
+    uint8_t *lut;  // 256-entry output table for 8-bit inputs, built at init
 };
 
 struct csinn_relu_params {
@@ -595,6 +754,7 @@ struct csinn_relu_params {
     float n;
     int32_t n_multiplier;
     int32_t n_shift;
+    uint8_t *lut;  // 256-entry output table for 8-bit inputs, built at init
 };
 
 struct csinn_prelu_params {
@@ -642,6 +802,14 @@ struct csinn_matmul_params {
     struct csinn_params_base base;
     bool trans_a;
     bool trans_b;
+    /*
+     * mat1 holds the new rows of the cached key (trans_b) or value (kv_cache_value), and the
+     * product runs over all cached positions. Key side output is [..., m, max_len] with
+     * positions past the cached length set to -inf; value side reads the first cached length
+     * columns of mat0 and commits the step.
+     */
+    struct csinn_kv_cache *kv_cache;
+    bool kv_cache_value;
 };
 
 struct csinn_diso_params {
@@ -667,6 +835,16 @@ struct csinn_resize_params {
     bool align_corners;
 };
 
+struct csinn_yuv_preprocess_params {
+    struct csinn_params_base base;
+    enum csinn_yuv_format_enum format;
+    bool full_range;  // BT.601 full range (JPEG) YUV, else video range (Y in [16, 235])
+    bool bgr;         // write B, G, R instead of R, G, B
+    float mean[3];    // subtracted from each output channel, in output channel order
+    float std[3];     // divides each output channel after the mean, 0 means 1
+    void *plan;       // resize taps and folded normalization, built at init, freed at deinit
+};
+
 struct csinn_concat_params {
     struct csinn_params_base base;
     int32_t inputs_count;
@@ -691,6 +869,7 @@ struct csinn_proposal_params {
     int rpn_post_nms_top_n;
     int rpn_min_size;
     bool iou_loss;
+    void *plan;  // anchor grid and scratch buffers, built at init, freed at deinit
 };
 
 struct csinn_psroipooling_params {
@@ -979,6 +1158,15 @@ struct csinn_asr_buffer_t {
     uint8_t flag;
 };
 
+struct csinn_attention_params {
+    struct csinn_params_base base;
+    float scale;         // multiplies q.k before the softmax, 0 means 1 / sqrt(head_dim)
+    int32_t num_heads;   // > 0: inputs are [batch, seq, heads * dim], else [..., seq, dim]
+    int32_t block_size;  // query/key block edge of the streaming softmax, 0 means 64
+    bool causal;         // query i only attends keys j <= i + seq_k - seq_q
+    struct csinn_kv_cache *kv_cache;  // key/value are appended to it and attention runs over it
+};
+
 struct csinn_cache_matmul_params {
     struct csinn_params_base base;
     struct csinn_asr_buffer_t asr_buffer;
@@ -52,6 +52,9 @@ void csinn_realloc_quant_info(struct csinn_tensor *tensor, int quant_info_num);
 void csinn_tensor_copy(struct csinn_tensor *dest, struct csinn_tensor *src);
 int csinn_tensor_data_convert(struct csinn_tensor *dest, struct csinn_tensor *src);
 int csinn_tensor_layout_convert(struct csinn_tensor *dest, struct csinn_tensor *src);
+int csinn_sparse_weight_compress(struct csinn_tensor *weight, enum csinn_mem_type_enum mtype);
+int csinn_sparse_weight_kept(struct csinn_tensor *weight);
+int csinn_sparse_weight_byte_size(struct csinn_tensor *weight);
 
 /* op parameters */
 void *csinn_alloc_params(int params_size, struct csinn_session *session);
@@ -64,9 +67,45 @@ void csinn_session_init(struct csinn_session *session);
 void csinn_session_deinit(struct csinn_session *session);
 int csinn_session_setup(struct csinn_session *session);
 int csinn_session_run(struct csinn_session *session);
+int csinn_session_set_stream(struct csinn_session *session, bool enable);
+int csinn_session_stream_reset(struct csinn_session *session);
+int csinn_session_stream_stats(struct csinn_session *session, struct csinn_stream_stats *stats);
+int csinn_session_set_tiling(struct csinn_session *session, bool enable);
+int csinn_session_tiling_stats(struct csinn_session *session, struct csinn_tiling_stats *stats);
+int csinn_session_set_counters(struct csinn_session *session, bool enable);
+int csinn_session_counter_stats(struct csinn_session *session, struct csinn_counter_stats *stats);
+int csinn_session_set_async(struct csinn_session *session, int depth);
+int csinn_session_run_async(struct csinn_session *session, struct csinn_tensor **inputs,
+                            struct csinn_tensor **outputs, csinn_async_callback callback,
+                            void *user);
+int csinn_session_wait(struct csinn_session *session);
+int csinn_session_set_pipeline(struct csinn_session *session, int stages, int depth);
+int csinn_session_resize_input(struct csinn_session *session, struct csinn_tensor **inputs);
+int csinn_session_set_layout_opt(struct csinn_session *session, bool enable);
+int csinn_session_layout_stats(struct csinn_session *session, struct csinn_layout_stats *stats);
+int csinn_session_set_tuning(struct csinn_session *session, bool enable, const char *path);
+struct csinn_batcher *csinn_alloc_batcher(struct csinn_session *session, int max_latency_us);
+void csinn_free_batcher(struct csinn_batcher *batcher);
+int csinn_batcher_run(struct csinn_batcher *batcher, struct csinn_tensor **inputs,
+                      struct csinn_tensor **outputs);
+int csinn_batcher_stats(struct csinn_batcher *batcher, struct csinn_batch_stats *stats);
 int csinn_load_binary_model(struct csinn_session *session);
 struct csinn_session *__attribute__((weak)) csinn_import_binary_model(char *bm_addr);
 
+/* kv cache */
+struct csinn_kv_cache *csinn_alloc_kv_cache(struct csinn_tensor *key, struct csinn_tensor *value,
+                                            int32_t max_len, enum csinn_kv_cache_mode_enum mode,
+                                            struct csinn_session *sess);
+void csinn_free_kv_cache(struct csinn_kv_cache *cache);
+struct csinn_kv_cache *csinn_kv_cache_clone(struct csinn_kv_cache *cache);
+void csinn_kv_cache_reset(struct csinn_kv_cache *cache);
+void csinn_session_kv_cache_reset(struct csinn_session *sess);
+int csinn_kv_cache_write(struct csinn_kv_cache *cache, struct csinn_tensor *rows, bool value);
+void csinn_kv_cache_commit(struct csinn_kv_cache *cache);
+int csinn_kv_cache_append(struct csinn_kv_cache *cache, struct csinn_tensor *key,
+                          struct csinn_tensor *value);
+int csinn_kv_cache_read(struct csinn_kv_cache *cache, struct csinn_tensor *dest, bool value);
+
 /* input/output */
 void csinn_set_input_number(int number, struct csinn_session *sess);
 void csinn_set_output_number(int number, struct csinn_session *sess);
@@ -108,6 +108,11 @@ int shl_batch_to_space_nd_debug_info(struct csinn_tensor *input, struct csinn_te
                                      struct csinn_batch_to_space_nd_params *params,
                                      const char *name);
 
+int shl_attention_debug_info(struct csinn_tensor *query, struct csinn_tensor *key,
+                             struct csinn_tensor *value, struct csinn_tensor *mask,
+                             struct csinn_tensor *output, struct csinn_attention_params *params,
+                             const char *name);
+
 int shl_cache_matmul_debug_info(struct csinn_tensor *input, struct csinn_tensor *output,
                                 struct csinn_tensor *weight, struct csinn_tensor *bias,
                                 struct csinn_cache_matmul_params *params, const char *name);
@@ -222,6 +227,9 @@ int shl_reshape_debug_info(struct csinn_tensor *input, struct csinn_tensor *outp
 int shl_resize_debug_info(struct csinn_tensor *input, struct csinn_tensor *output,
                           struct csinn_resize_params *params, const char *name);
 
+int shl_yuv_preprocess_debug_info(struct csinn_tensor *input, struct csinn_tensor *output,
+                                  struct csinn_yuv_preprocess_params *params, const char *name);
+
 int shl_reverse_debug_info(struct csinn_tensor *input, struct csinn_tensor *output,
                            struct csinn_reverse_params *params, const char *name);
 
@@ -537,10 +537,17 @@ int shl_gref_xor(struct csinn_tensor *input0, struct csinn_tensor *input1,
 int shl_gref_yuv_rgb_scale(struct csinn_tensor *input, struct csinn_tensor *output,
                            struct csinn_siso_params *params);
 
+int shl_gref_yuv_preprocess(struct csinn_tensor *input, struct csinn_tensor *output,
+                            struct csinn_yuv_preprocess_params *params);
+
 int shl_gref_layer_norm(struct csinn_tensor *input, struct csinn_tensor *output,
                         struct csinn_tensor *gamma, struct csinn_tensor *beta,
                         struct csinn_layer_norm_params *params);
 
+int shl_gref_attention(struct csinn_tensor *query, struct csinn_tensor *key,
+                       struct csinn_tensor *value, struct csinn_tensor *mask,
+                       struct csinn_tensor *output, struct csinn_attention_params *params);
+
 int shl_gref_cache_matmul(struct csinn_tensor *input, struct csinn_tensor *output,
                           struct csinn_tensor *weight, struct csinn_tensor *bias,
                           struct csinn_cache_matmul_params *params);
@@ -561,8 +568,53 @@ struct shl_ref_graph {
     int layer_index;
 };
 
+struct shl_gref_stream {
+    bool *is_static;    // per layer: depends only on constants
+    bool static_ready;  // static layers have been computed
+    struct csinn_stream_stats stats;
+};
+
+/* consecutive layers that are run band by band along the output height */
+struct shl_gref_tile_group {
+    int first;           // index of the first layer in the graph
+    int count;           // number of layers
+    int tile_rows;       // output rows of the last layer per tile
+    int64_t tile_bytes;  // band buffers of one tile
+};
+
+struct shl_gref_tiling {
+    bool planned;
+    struct shl_gref_tile_group *group;
+    int group_num;
+    struct csinn_tiling_stats stats;
+};
+
+struct shl_gref_counters {
+    struct shl_perf_counters *pc;  // NULL when counters are unavailable
+    struct csinn_counter_stats stats;
+};
+
+/* state of the layout propagation pass, see shl_gref_layout_opt */
+struct shl_gref_layout {
+    bool applied;
+    void **owned;  // names, permutations and kernel data allocated by the pass
+    int owned_num;
+    struct csinn_tensor **tensor;  // transposed activations and weights
+    int tensor_num;
+    struct csinn_layout_stats stats;
+};
+
+struct shl_gref_async;
+struct shl_gref_shapes;
+
 struct shl_gref_target_data {
     struct shl_ref_graph *graph;
+    struct shl_gref_stream *stream;
+    struct shl_gref_tiling *tiling;
+    struct shl_gref_counters *counters;
+    struct shl_gref_async *async;
+    struct shl_gref_shapes *shapes;
+    struct shl_gref_layout *layout;
 };
 
 struct shl_ref_graph *shl_gref_get_graph(struct csinn_session *sess);
@@ -580,7 +632,33 @@ int shl_gref_diso_op(struct csinn_tensor *input0, struct csinn_tensor *input1,
 int shl_gref_sidcso_op(struct csinn_tensor *input, struct csinn_tensor *output,
                        struct csinn_tensor *const0, struct csinn_tensor *const1, int op,
                        void *params);
+int shl_gref_fuse_attention(struct shl_ref_graph *graph);
 void shl_gref_set_tensor(struct csinn_tensor *tensor, struct csinn_session *sess);
+void shl_gref_update_input(int index, struct csinn_tensor *input, struct csinn_session *sess);
+int shl_gref_session_run(struct csinn_session *sess);
+int shl_gref_session_set_stream(struct csinn_session *sess, bool enable);
+int shl_gref_session_stream_reset(struct csinn_session *sess);
+int shl_gref_session_stream_stats(struct csinn_session *sess, struct csinn_stream_stats *stats);
+int shl_gref_session_set_tiling(struct csinn_session *sess, bool enable);
+int shl_gref_session_tiling_stats(struct csinn_session *sess, struct csinn_tiling_stats *stats);
+int shl_gref_session_set_counters(struct csinn_session *sess, bool enable);
+int shl_gref_session_counter_stats(struct csinn_session *sess, struct csinn_counter_stats *stats);
+int shl_gref_session_set_tuning(struct csinn_session *sess, bool enable, const char *path);
+int shl_gref_session_set_async(struct csinn_session *sess, int depth);
+int shl_gref_session_run_async(struct csinn_session *sess, struct csinn_tensor **inputs,
+                               struct csinn_tensor **outputs, csinn_async_callback callback,
+                               void *user);
+int shl_gref_session_wait(struct csinn_session *sess);
+bool shl_gref_session_pipelined(struct csinn_session *sess);
+int shl_gref_session_set_pipeline(struct csinn_session *sess, int stages, int depth);
+int shl_gref_run_layers(struct shl_ref_graph *g, int first, int last);
+int shl_gref_session_resize_input(struct csinn_session *sess, struct csinn_tensor **inputs);
+void shl_gref_shapes_free(struct csinn_session *sess);
+int shl_gref_layout_opt(struct csinn_session *sess);
+int shl_gref_session_set_layout_opt(struct csinn_session *sess, bool enable);
+int shl_gref_session_layout_stats(struct csinn_session *sess, struct csinn_layout_stats *stats);
+void shl_gref_layout_free(struct csinn_session *sess);
+int shl_gref_init_op(struct shl_node *node);
 void shl_gref_set_const_tensor(struct csinn_tensor *tensor, struct csinn_session *sess);
 int shl_gref_get_tensor(int index, struct csinn_tensor *ret, struct csinn_session *sess);
 void shl_gref_nbg(struct csinn_tensor **input, struct csinn_tensor **output, uint32_t inputs_count,
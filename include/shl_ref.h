@@ -156,12 +156,18 @@ int shl_ref_clip_quant(struct csinn_tensor *input, struct csinn_tensor *output,
 int shl_ref_col2im_f32(struct csinn_tensor *input, struct csinn_tensor *output,
                        struct csinn_tensor *kernel, struct csinn_col2im_params *params);
 
+int shl_ref_concat_init(struct csinn_tensor **input, struct csinn_tensor *output,
+                        struct csinn_concat_params *params);
+
 int shl_ref_concat_f32(struct csinn_tensor **input, struct csinn_tensor *output,
                        struct csinn_concat_params *params);
 
 int shl_ref_concat_quant(struct csinn_tensor **input, struct csinn_tensor *output,
                          struct csinn_concat_params *params);
 
+int shl_ref_concat(struct csinn_tensor **input, struct csinn_tensor *output,
+                   struct csinn_concat_params *params);
+
 int shl_ref_conv1d_f32(struct csinn_tensor *input, struct csinn_tensor *output,
                        struct csinn_tensor *kernel, struct csinn_tensor *bias,
                        struct csinn_conv1d_params *params);
@@ -170,10 +176,32 @@ int shl_ref_conv1d_quant(struct csinn_tensor *input, struct csinn_tensor *output
                          struct csinn_tensor *kernel, struct csinn_tensor *bias,
                          struct csinn_conv1d_params *params);
 
+int shl_ref_conv2d_init(struct csinn_tensor *input, struct csinn_tensor *output,
+                        struct csinn_tensor *kernel, struct csinn_tensor *bias,
+                        struct csinn_conv2d_params *params);
+
+void shl_ref_conv2d_deinit(struct csinn_conv2d_params *params);
+
 int shl_ref_conv2d_f32(struct csinn_tensor *input, struct csinn_tensor *output,
                        struct csinn_tensor *kernel, struct csinn_tensor *bias,
                        struct csinn_conv2d_params *params);
 
+bool shl_ref_conv2d_winograd_support(struct csinn_tensor *input, struct csinn_tensor *kernel,
+                                     struct csinn_conv2d_params *params);
+int shl_ref_wg_f3s1_select_tile(int out_h, int out_w);
+void shl_ref_wg_f3s1_trans_kernel_f32(struct csinn_tensor *src_kernel,
+                                      struct csinn_tensor *dst_kernel, int m,
+                                      enum csinn_layout_enum layout);
+int shl_ref_conv2d_winograd_f32(struct csinn_tensor *input, struct csinn_tensor *output,
+                                struct csinn_tensor *kernel, struct csinn_tensor *bias,
+                                struct csinn_conv2d_params *params);
+
+bool shl_ref_is_sparse_weight(struct csinn_tensor *weight);
+
+int shl_ref_conv2d_sparse_f32(struct csinn_tensor *input, struct csinn_tensor *output,
+                              struct csinn_tensor *kernel, struct csinn_tensor *bias,
+                              struct csinn_conv2d_params *params);
+
 int shl_ref_conv2d_quant(struct csinn_tensor *input, struct csinn_tensor *output,
                          struct csinn_tensor *kernel, struct csinn_tensor *bias,
                          struct csinn_conv2d_params *params);
@@ -190,6 +218,14 @@ int shl_ref_conv2d_relu_quant(struct csinn_tensor *o_input, struct csinn_tensor
                               struct csinn_tensor *o_kernel, struct csinn_tensor *o_bias,
                               struct csinn_conv2d_params *params);
 
+int shl_ref_attention_f32(struct csinn_tensor *query, struct csinn_tensor *key,
+                          struct csinn_tensor *value, struct csinn_tensor *mask,
+                          struct csinn_tensor *output, struct csinn_attention_params *params);
+
+int shl_ref_attention_quant(struct csinn_tensor *query, struct csinn_tensor *key,
+                            struct csinn_tensor *value, struct csinn_tensor *mask,
+                            struct csinn_tensor *output, struct csinn_attention_params *params);
+
 int shl_ref_cache_matmul_init(struct csinn_tensor *input, struct csinn_tensor *output,
                               struct csinn_tensor *weight, struct csinn_tensor *bias,
                               struct csinn_cache_matmul_params *params);
@@ -323,6 +359,12 @@ int shl_ref_data_convert_f32(struct csinn_tensor *input, struct csinn_tensor *ou
 int shl_ref_data_convert_quant(struct csinn_tensor *input, struct csinn_tensor *output,
                                struct csinn_siso_params *params);
 
+int shl_ref_deconv2d_init(struct csinn_tensor *input, struct csinn_tensor *output,
+                          struct csinn_tensor *kernel, struct csinn_tensor *bias,
+                          struct csinn_conv2d_params *params);
+
+void shl_ref_deconv2d_deinit(struct csinn_conv2d_params *params);
+
 int shl_ref_deconv2d_f32(struct csinn_tensor *input, struct csinn_tensor *output,
                          struct csinn_tensor *kernel, struct csinn_tensor *bias,
                          struct csinn_conv2d_params *params);
@@ -365,6 +407,9 @@ int shl_ref_elu_f32(struct csinn_tensor *input, struct csinn_tensor *output,
 int shl_ref_elu_quant(struct csinn_tensor *input, struct csinn_tensor *output,
                       struct csinn_relu_params *params);
 
+int shl_ref_elu_init(struct csinn_tensor *input, struct csinn_tensor *output,
+                     struct csinn_relu_params *params);
+
 int shl_ref_fsmn_f32(struct csinn_tensor *frame, struct csinn_tensor *l_filter,
                      struct csinn_tensor *r_filter, struct csinn_tensor *frame_sequence,
                      struct csinn_tensor *frame_counter, struct csinn_tensor *output,
@@ -387,12 +432,18 @@ int shl_ref_erf_f32(struct csinn_tensor *input, struct csinn_tensor *output,
 int shl_ref_erf_quant(struct csinn_tensor *input, struct csinn_tensor *output,
                       struct csinn_siso_params *params);
 
+int shl_ref_erf_init(struct csinn_tensor *input, struct csinn_tensor *output,
+                     struct csinn_siso_params *params);
+
 int shl_ref_exp_f32(struct csinn_tensor *input, struct csinn_tensor *output,
                     struct csinn_siso_params *params);
 
 int shl_ref_exp_quant(struct csinn_tensor *input, struct csinn_tensor *output,
                       struct csinn_siso_params *params);
 
+int shl_ref_exp_init(struct csinn_tensor *input, struct csinn_tensor *output,
+                     struct csinn_siso_params *params);
+
 int shl_ref_expand_dims_f32(struct csinn_tensor *input, struct csinn_tensor *output,
                             struct csinn_expand_dims_params *params);
 
@@ -405,6 +456,9 @@ int shl_ref_expm1_f32(struct csinn_tensor *input, struct csinn_tensor *output,
 int shl_ref_expm1_quant(struct csinn_tensor *input, struct csinn_tensor *output,
                         struct csinn_siso_params *params);
 
+int shl_ref_expm1_init(struct csinn_tensor *input, struct csinn_tensor *output,
+                       struct csinn_siso_params *params);
+
 int shl_ref_flatten(struct csinn_tensor *input, struct csinn_tensor *output,
                     struct csinn_flatten_params *params);
 
@@ -437,18 +491,28 @@ int shl_ref_fullyconnected_quant(struct csinn_tensor *input, struct csinn_tensor
                                  struct csinn_tensor *weights, struct csinn_tensor *bias,
                                  struct csinn_fc_params *params);
 
+int shl_ref_fullyconnected_sparse_f32(struct csinn_tensor *input, struct csinn_tensor *output,
+                                      struct csinn_tensor *weights, struct csinn_tensor *bias,
+                                      struct csinn_fc_params *params);
+
 int shl_ref_gather_nd_f32(struct csinn_tensor *input, struct csinn_tensor *indices,
                           struct csinn_tensor *output, struct csinn_gather_nd_params *params);
 
 int shl_ref_gather_nd_quant(struct csinn_tensor *input, struct csinn_tensor *indices,
                             struct csinn_tensor *output, struct csinn_gather_nd_params *params);
 
+int shl_ref_gather_init(struct csinn_tensor *input, struct csinn_tensor *indices,
+                        struct csinn_tensor *output, struct csinn_gather_params *params);
+
 int shl_ref_gather_f32(struct csinn_tensor *input, struct csinn_tensor *indices,
                        struct csinn_tensor *output, struct csinn_gather_params *params);
 
 int shl_ref_gather_quant(struct csinn_tensor *input, struct csinn_tensor *indices,
                          struct csinn_tensor *output, struct csinn_gather_params *params);
 
+int shl_ref_gather(struct csinn_tensor *input, struct csinn_tensor *indices,
+                   struct csinn_tensor *output, struct csinn_gather_params *params);
+
 int shl_ref_global_avgpool2d_f32(struct csinn_tensor *input, struct csinn_tensor *output,
                                  struct csinn_pool_params *params);
 
@@ -479,6 +543,9 @@ int shl_ref_hard_sigmoid_f32(struct csinn_tensor *input, struct csinn_tensor *ou
 int shl_ref_hard_sigmoid_quant(struct csinn_tensor *input, struct csinn_tensor *output,
                                struct csinn_sigmoid_params *params);
 
+int shl_ref_hard_sigmoid_init(struct csinn_tensor *input, struct csinn_tensor *output,
+                              struct csinn_sigmoid_params *params);
+
 int shl_ref_im2col_f32(struct csinn_tensor *input, struct csinn_tensor *output,
                        struct csinn_im2col_params *params);
 
@@ -535,12 +602,18 @@ int shl_ref_log_f32(struct csinn_tensor *input, struct csinn_tensor *output,
 int shl_ref_log_quant(struct csinn_tensor *input, struct csinn_tensor *output,
                       struct csinn_siso_params *params);
 
+int shl_ref_log_init(struct csinn_tensor *input, struct csinn_tensor *output,
+                     struct csinn_siso_params *params);
+
 int shl_ref_log1p_f32(struct csinn_tensor *input, struct csinn_tensor *output,
                       struct csinn_siso_params *params);
 
 int shl_ref_log1p_quant(struct csinn_tensor *input, struct csinn_tensor *output,
                         struct csinn_siso_params *params);
 
+int shl_ref_log1p_init(struct csinn_tensor *input, struct csinn_tensor *output,
+                       struct csinn_siso_params *params);
+
 int shl_ref_logical_and_f32(struct csinn_tensor *input0, struct csinn_tensor *input1,
                             struct csinn_tensor *output, struct csinn_diso_params *params);
 
@@ -686,12 +759,18 @@ int shl_ref_or_u8(struct csinn_tensor *input0, struct csinn_tensor *input1,
 int shl_ref_or_i8(struct csinn_tensor *input0, struct csinn_tensor *input1,
                   struct csinn_tensor *output, struct csinn_diso_params *params);
 
+int shl_ref_pad_init(struct csinn_tensor *input, struct csinn_tensor *output,
+                     struct csinn_pad_params *params);
+
 int shl_ref_pad_f32(struct csinn_tensor *input, struct csinn_tensor *output,
                     struct csinn_pad_params *params);
 
 int shl_ref_pad_quant(struct csinn_tensor *input, struct csinn_tensor *output,
                       struct csinn_pad_params *params);
 
+int shl_ref_pad(struct csinn_tensor *input, struct csinn_tensor *output,
+                struct csinn_pad_params *params);
+
 int shl_ref_power_f32(struct csinn_tensor *input0, struct csinn_tensor *input1,
                       struct csinn_tensor *output, struct csinn_diso_params *params);
 
@@ -710,6 +789,12 @@ int shl_ref_prod_stride_f32(struct csinn_tensor *input, struct csinn_tensor *out
 int shl_ref_prod_stride_quant(struct csinn_tensor *input, struct csinn_tensor *output,
                               struct csinn_reduce_params *params);
 
+int shl_ref_proposal_init(struct csinn_tensor *cls_prob, struct csinn_tensor *bbox_pred,
+                          struct csinn_tensor *im_info, struct csinn_tensor *output,
+                          struct csinn_proposal_params *params);
+
+void shl_ref_proposal_deinit(struct csinn_proposal_params *params);
+
 int shl_ref_proposal_f32(struct csinn_tensor *cls_prob, struct csinn_tensor *bbox_pred,
                          struct csinn_tensor *im_info, struct csinn_tensor *output,
                          struct csinn_proposal_params *params);
@@ -718,6 +803,8 @@ int shl_ref_proposal_quant(struct csinn_tensor *cls_prob, struct csinn_tensor *b
                            struct csinn_tensor *im_info, struct csinn_tensor *output,
                            struct csinn_proposal_params *params);
 
+void shl_ref_proposal_deinit(struct csinn_proposal_params *params);
+
 int shl_ref_psroipooling_f32(struct csinn_tensor *data, struct csinn_tensor *rois,
                              struct csinn_tensor *output, struct csinn_psroipooling_params *params);
 
@@ -824,6 +911,9 @@ int shl_ref_rsqrt_f32(struct csinn_tensor *input, struct csinn_tensor *output,
 int shl_ref_rsqrt_quant(struct csinn_tensor *input, struct csinn_tensor *output,
                         struct csinn_siso_params *params);
 
+int shl_ref_rsqrt_init(struct csinn_tensor *input, struct csinn_tensor *output,
+                       struct csinn_siso_params *params);
+
 int shl_ref_scatter_nd_f32(struct csinn_tensor *input, struct csinn_tensor *indices,
                            struct csinn_tensor *updates, struct csinn_tensor *output,
                            struct csinn_scatter_nd_params *params);
@@ -937,6 +1027,9 @@ int shl_ref_sigmoid_f32(struct csinn_tensor *input, struct csinn_tensor *output,
 int shl_ref_sigmoid_quant(struct csinn_tensor *input, struct csinn_tensor *output,
                           struct csinn_sigmoid_params *params);
 
+int shl_ref_sigmoid_init(struct csinn_tensor *input, struct csinn_tensor *output,
+                         struct csinn_sigmoid_params *params);
+
 int shl_ref_sign_f32(struct csinn_tensor *input, struct csinn_tensor *output,
                      struct csinn_siso_params *params);
 
@@ -955,12 +1048,18 @@ int shl_ref_sinh_f32(struct csinn_tensor *input, struct csinn_tensor *output,
 int shl_ref_sinh_quant(struct csinn_tensor *input, struct csinn_tensor *output,
                        struct csinn_siso_params *params);
 
+int shl_ref_slice_init(struct csinn_tensor *input, struct csinn_tensor *output,
+                       struct csinn_slice_params *params);
+
 int shl_ref_slice_f32(struct csinn_tensor *input, struct csinn_tensor *output,
                       struct csinn_slice_params *params);
 
 int shl_ref_slice_quant(struct csinn_tensor *input, struct csinn_tensor *output,
                         struct csinn_slice_params *params);
 
+int shl_ref_slice(struct csinn_tensor *input, struct csinn_tensor *output,
+                  struct csinn_slice_params *params);
+
 int shl_ref_softmax_f32(struct csinn_tensor *input, struct csinn_tensor *output,
                         struct csinn_softmax_params *params);
 
@@ -973,6 +1072,9 @@ int shl_ref_softplus_f32(struct csinn_tensor *input, struct csinn_tensor *output
 int shl_ref_softplus_quant(struct csinn_tensor *input, struct csinn_tensor *output,
                            struct csinn_siso_params *params);
 
+int shl_ref_softplus_init(struct csinn_tensor *input, struct csinn_tensor *output,
+                          struct csinn_siso_params *params);
+
 int shl_ref_softrelu_f32(struct csinn_tensor *input, struct csinn_tensor *output,
                          struct csinn_relu_params *params);
 
@@ -985,6 +1087,9 @@ int shl_ref_softsign_f32(struct csinn_tensor *input, struct csinn_tensor *output
 int shl_ref_softsign_quant(struct csinn_tensor *input, struct csinn_tensor *output,
                            struct csinn_siso_params *params);
 
+int shl_ref_softsign_init(struct csinn_tensor *input, struct csinn_tensor *output,
+                          struct csinn_siso_params *params);
+
 int shl_ref_space_to_batch_f32(struct csinn_tensor *input, struct csinn_tensor *output,
                                struct csinn_space_to_batch_params *params);
 
@@ -997,18 +1102,27 @@ int shl_ref_space_to_depth_f32(struct csinn_tensor *input, struct csinn_tensor *
 int shl_ref_space_to_depth_quant(struct csinn_tensor *input, struct csinn_tensor *output,
                                  struct csinn_space_to_depth_params *params);
 
+int shl_ref_split_init(struct csinn_tensor *input, struct csinn_tensor **output,
+                       struct csinn_split_params *params);
+
 int shl_ref_split_f32(struct csinn_tensor *input, struct csinn_tensor **output,
                       struct csinn_split_params *params);
 
 int shl_ref_split_quant(struct csinn_tensor *input, struct csinn_tensor **output,
                         struct csinn_split_params *params);
 
+int shl_ref_split(struct csinn_tensor *input, struct csinn_tensor **output,
+                  struct csinn_split_params *params);
+
 int shl_ref_sqrt_f32(struct csinn_tensor *input, struct csinn_tensor *output,
                      struct csinn_siso_params *params);
 
 int shl_ref_sqrt_quant(struct csinn_tensor *input, struct csinn_tensor *output,
                        struct csinn_siso_params *params);
 
+int shl_ref_sqrt_init(struct csinn_tensor *input, struct csinn_tensor *output,
+                      struct csinn_siso_params *params);
+
 int shl_ref_square_f32(struct csinn_tensor *input, struct csinn_tensor *output,
                        struct csinn_siso_params *params);
 
@@ -1021,12 +1135,18 @@ int shl_ref_stack_f32(struct csinn_tensor **input, struct csinn_tensor *output,
 int shl_ref_stack_quant(struct csinn_tensor **input, struct csinn_tensor *output,
                         struct csinn_stack_params *params);
 
+int shl_ref_strided_slice_init(struct csinn_tensor *input, struct csinn_tensor *output,
+                               struct csinn_strided_slice_params *params);
+
 int shl_ref_strided_slice_f32(struct csinn_tensor *input, struct csinn_tensor *output,
                               struct csinn_strided_slice_params *params);
 
 int shl_ref_strided_slice_quant(struct csinn_tensor *input, struct csinn_tensor *output,
                                 struct csinn_strided_slice_params *params);
 
+int shl_ref_strided_slice(struct csinn_tensor *input, struct csinn_tensor *output,
+                          struct csinn_strided_slice_params *params);
+
 int shl_ref_sub_f32(struct csinn_tensor *input0, struct csinn_tensor *input1,
                     struct csinn_tensor *output, struct csinn_diso_params *params);
 
@@ -1054,18 +1174,27 @@ int shl_ref_tanh_f64(struct csinn_tensor *input, struct csinn_tensor *output,
 int shl_ref_tanh_quant(struct csinn_tensor *input, struct csinn_tensor *output,
                        struct csinn_siso_params *params);
 
+int shl_ref_tanh_init(struct csinn_tensor *input, struct csinn_tensor *output,
+                      struct csinn_siso_params *params);
+
 int shl_ref_threshold_relu_f32(struct csinn_tensor *input, struct csinn_tensor *output,
                                struct csinn_relu_params *params);
 
 int shl_ref_threshold_relu_quant(struct csinn_tensor *input, struct csinn_tensor *output,
                                  struct csinn_relu_params *params);
 
+int shl_ref_tile_init(struct csinn_tensor *input, struct csinn_tensor *output,
+                      struct csinn_tile_params *params);
+
 int shl_ref_tile_f32(struct csinn_tensor *input, struct csinn_tensor *output,
                      struct csinn_tile_params *params);
 
 int shl_ref_tile_quant(struct csinn_tensor *input, struct csinn_tensor *output,
                        struct csinn_tile_params *params);
 
+int shl_ref_tile(struct csinn_tensor *input, struct csinn_tensor *output,
+                 struct csinn_tile_params *params);
+
 int shl_ref_topk_f32(struct csinn_tensor *input, struct csinn_tensor *output1,
                      struct csinn_tensor *output2, struct csinn_topk_params *params);
 
@@ -1111,6 +1240,14 @@ int shl_ref_yuv_rgb_scale_f32(struct csinn_tensor *input, struct csinn_tensor *o
 int shl_ref_yuv_rgb_scale_quant(struct csinn_tensor *input, struct csinn_tensor *output,
                                 struct csinn_siso_params *params);
 
+int shl_ref_yuv_preprocess_init(struct csinn_tensor *input, struct csinn_tensor *output,
+                                struct csinn_yuv_preprocess_params *params);
+
+void shl_ref_yuv_preprocess_deinit(struct csinn_yuv_preprocess_params *params);
+
+int shl_ref_yuv_preprocess(struct csinn_tensor *input, struct csinn_tensor *output,
+                           struct csinn_yuv_preprocess_params *params);
+
 int32_t shl_ref_max_internal_s32(int32_t a, int32_t b);
 int32_t shl_ref_min_internal_s32(int32_t a, int32_t b);
 int32_t shl_ref_get_index(int32_t *dim, int32_t index0, int32_t index1, int32_t index2,
@@ -1148,9 +1285,45 @@ void shl_ref_conv_free_float_tensor(struct csinn_tensor *input, struct csinn_ten
                                     struct csinn_tensor *kernel, struct csinn_tensor *bias);
 struct csinn_tensor *shl_ref_tensor_transform_f32(struct csinn_tensor *input);
 int shl_ref_tensor_transform_free_f32(struct csinn_tensor *input);
+struct csinn_tensor *shl_ref_kv_cache_storage_f32(struct csinn_kv_cache *cache, bool value);
+void shl_ref_kv_cache_storage_free_f32(struct csinn_kv_cache *cache, struct csinn_tensor *storage);
+int shl_ref_get_dtype_size(enum csinn_dtype_enum dtype);
+
+enum shl_ref_reduce_type {
+    SHL_REF_REDUCE_SUM,
+    SHL_REF_REDUCE_MEAN,
+    SHL_REF_REDUCE_PROD,
+    SHL_REF_REDUCE_MAX,
+    SHL_REF_REDUCE_MIN,
+    SHL_REF_REDUCE_LOGSUMEXP,
+};
+
+int shl_ref_reduce_f32(struct csinn_tensor *input, struct csinn_tensor *output,
+                       const int32_t *axis, int32_t axis_count, enum shl_ref_reduce_type type);
+int shl_ref_reduce_stride_f32(struct csinn_tensor *input, struct csinn_tensor *output,
+                              struct csinn_reduce_params *params, enum shl_ref_reduce_type type);
+void shl_ref_fast_exp_f32(const float *src, float *dst, int64_t size);
+void shl_ref_fast_log_f32(const float *src, float *dst, int64_t size);
+void shl_ref_fast_tanh_f32(const float *src, float *dst, int64_t size);
+void shl_ref_fast_sigmoid_f32(const float *src, float *dst, int64_t size);
+void shl_ref_fast_erf_f32(const float *src, float *dst, int64_t size);
+bool shl_ref_is_same_quant(struct csinn_tensor *a, struct csinn_tensor *b);
+bool shl_ref_scalar_to_dtype(struct csinn_tensor *t, float value, void *dst);
+void shl_ref_strided_copy(const void *src, void *dst, int dim_count, const int32_t *dim,
+                          const int32_t *begin, const int32_t *count, const int32_t *stride,
+                          int elem_size);
+void shl_ref_gemm_f32(float *dst, const float *sa, const float *sb, int m, int k, int n, int lda,
+                      int ldb, int ldc);
+void shl_ref_col2im_nhwc_acc_f32(const float *col, float *im, int height, int width, int depth,
+                                 int filter_h, int filter_w, int pad_t, int pad_l, int stride_h,
+                                 int stride_w, int h_start, int h_end, int width_col);
+void shl_ref_col2im_nchw_acc_f32(const float *col, float *im, int height, int width, int depth,
+                                 int filter_h, int filter_w, int pad_t, int pad_l, int stride_h,
+                                 int stride_w, int h_start, int h_end, int width_col);
 uint8_t *shl_ref_f32_to_input_dtype(uint32_t index, float *data, struct csinn_session *sess);
 
 struct shl_ref_diso_callback {
+    /* run kernel: (float *src0, float *src1, float *dest, size, stride0, stride1) */
     void (*bc)();
     struct csinn_tensor *input0;
     struct csinn_tensor *input1;
@@ -1161,6 +1334,44 @@ struct shl_ref_diso_callback {
 int shl_ref_diso_broadcast_base(struct csinn_tensor *input0, struct csinn_tensor *input1,
                                 struct csinn_tensor *output, struct csinn_diso_params *params,
                                 struct shl_ref_diso_callback *cb);
+
+/*
+ * Define the run kernel of a broadcast binary op. expr computes one element
+ * from x (input0) and y (input1). A zero stride means the operand is the same
+ * value for the whole run, so scalar, row-vector and channel-vector operands
+ * each get their own loop.
+ */
+#define SHL_REF_DISO_LOOP(name, expr)                                                        \
+    static void name(float *src0, float *src1, float *dest, int32_t size, int32_t stride0, \
+                     int32_t stride1)                                                       \
+    {                                                                                       \
+        if (stride0 && stride1) {                                                           \
+            for (int i = 0; i < size; i++) {                                                \
+                float x = src0[i];                                                          \
+                float y = src1[i];                                                          \
+                dest[i] = (expr);                                                           \
+            }                                                                               \
+        } else if (stride0) {                                                               \
+            float y = src1[0];                                                              \
+            for (int i = 0; i < size; i++) {                                                \
+                float x = src0[i];                                                          \
+                dest[i] = (expr);                                                           \
+            }                                                                               \
+        } else if (stride1) {                                                               \
+            float x = src0[0];                                                              \
+            for (int i = 0; i < size; i++) {                                                \
+                float y = src1[i];                                                          \
+                dest[i] = (expr);                                                           \
+            }                                                                               \
+        } else {                                                                            \
+            float x = src0[0];                                                              \
+            float y = src1[0];                                                              \
+            float r = (expr);                                                               \
+            for (int i = 0; i < size; i++) {                                                \
+                dest[i] = r;                                                                \
+            }                                                                               \
+        }                                                                                   \
+    }
 int shl_ref_broadcast_to_shape(struct csinn_tensor *input, struct csinn_tensor *output,
                                int32_t *shape, int32_t shape_count);
 int shl_ref_broadcast_to_shape_f32(struct csinn_tensor *input, struct csinn_tensor *output,
@@ -1170,6 +1381,9 @@ int shl_ref_broadcast_to_shape_quant(struct csinn_tensor *input, struct csinn_te
 
 int shl_ref_siso_callback_base(struct csinn_tensor *input, struct csinn_tensor *output,
                                void *params, void *cb);
+uint8_t *shl_ref_siso_lut_init(struct csinn_tensor *input, struct csinn_tensor *output,
+                               void *params, void *cb);
+int shl_ref_siso_lut(struct csinn_tensor *input, struct csinn_tensor *output, const uint8_t *lut);
 int shl_ref_diso_callback_base(struct csinn_tensor *input0, struct csinn_tensor *input1,
                                struct csinn_tensor *output, void *params, void *cb);
 int shl_ref_conv_callback_base(struct csinn_tensor *input, struct csinn_tensor *output,
@@ -1180,6 +1394,8 @@ void shl_ref_nn_init(struct csinn_tensor *input, struct csinn_tensor *output);
 
 void shl_ref_nn_deinit(struct csinn_tensor *input, struct csinn_tensor *output);
 
+void shl_ref_op_deinit(int op, void *params);
+
 int shl_ref_flatten_init(struct csinn_tensor *input, struct csinn_tensor *output,
                          struct csinn_reshape_params *params);
 
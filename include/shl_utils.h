@@ -90,6 +90,27 @@ void shl_dump_bm_section_info(FILE *f, struct shl_binary_model_section_info *inf
 void shl_dump_bm_graph_info_section(FILE *f, struct csinn_session *sess);
 void shl_bm_session_load(struct csinn_session *dest, struct csinn_session *src);
 
+void shl_tuning_conv2d_key(char *key, int size, const char *backend, struct csinn_tensor *input,
+                           struct csinn_tensor *output, struct csinn_tensor *kernel,
+                           struct csinn_conv2d_params *params);
+struct csinn_tuning_entry *shl_tuning_find(struct csinn_tuning *tuning, const char *key);
+void shl_tuning_add(struct csinn_tuning *tuning, const char *key, const char *algo, float time);
+int shl_session_set_tuning(struct csinn_session *sess, bool enable, const char *path);
+
+/*
+ * perf_event_open counters of the calling thread, the OpenMP workers it has already started and
+ * the threads it creates later. Threads started by other threads are not counted.
+ */
+struct shl_perf_counters {
+    int *fd;          // thread_num x CSINN_COUNTER_SIZE, -1 where an event could not be opened
+    int thread_num;   // threads that opened their own events
+    uint32_t events;  // bit CSINN_COUNTER_* is set for each event the calling thread opened
+};
+
+struct shl_perf_counters *shl_perf_counters_open();
+void shl_perf_counters_read(struct shl_perf_counters *pc, uint64_t *value);
+void shl_perf_counters_close(struct shl_perf_counters *pc);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,704 @@
+/*
+ * Copyright (C) 2016-2022 T-Head Semiconductor Co., Ltd. All rights reserved.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* CSI-NN2 version 2.0.x */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE  // pthread_setaffinity_np
+#endif
+
+#include "shl_gref.h"
+
+#ifndef SHL_BUILD_RTOS
+#include <pthread.h>
+#include <sched.h>
+
+/*
+ * Asynchronous runs: a ring of depth slots, each with its own input and
+ * output buffers. The caller copies a frame into a free slot and returns,
+ * stage workers run the graph on queued slots, and a completion thread
+ * hands finished slots to their callbacks. So the caller's pre-processing
+ * of frame N + 1, the inference of frame N and the callback's
+ * post-processing of frame N - 1 overlap. Frames are run and completed in
+ * submission order.
+ *
+ * In pipeline mode the sorted top level layers (ops or subgraphs) are cut
+ * into stages of balanced estimated FLOPs, each run by its own worker, so
+ * successive frames stream through the stages and the throughput
+ * approaches that of the slowest stage. The slots are the bounded queues
+ * between the stages: stage s takes frame i once stage s - 1 has finished
+ * it, and at most depth frames are in flight.
+ */
+struct shl_gref_async_slot {
+    struct csinn_tensor **input;
+    struct csinn_tensor **output;
+    struct csinn_tensor **user_output;  // tensors that receive the results, or NULL
+    void **cross;                       // buffers of the tensors passed between stages
+    csinn_async_callback callback;
+    void *user;
+    int status;
+};
+
+/* a tensor produced by one stage, or a graph input, and read by later stages */
+struct shl_gref_pipe_cross {
+    struct shl_node *node;
+    int producer;     // stage, -1 for graph inputs
+    int input_index;  // graph input index when producer is -1
+    bool owned;       // allocated by an op of the producer, freed after the last stage
+};
+
+/*
+ * A stage reads crossing tensors through private copies of their tensor
+ * nodes, so the producer can already write the next frame's buffer pointer.
+ */
+struct shl_gref_pipe_clone {
+    struct shl_node *node;
+    int cross;
+};
+
+/* a layer input rebound to a clone, restored when the pipeline is freed */
+struct shl_gref_pipe_bind {
+    struct shl_node *layer;
+    int index;
+    struct shl_node *orig;
+};
+
+struct shl_gref_pipe_stage {
+    int first;     // first layer
+    int last;      // one past the last layer
+    int64_t cost;  // estimated FLOPs
+    struct shl_gref_pipe_clone *clone;
+    int clone_num;
+    uint64_t busy_time;  // nanoseconds spent running frames
+};
+
+struct shl_gref_async_worker {
+    struct shl_gref_async *async;
+    int stage;
+    pthread_t thread;
+};
+
+struct shl_gref_async {
+    struct csinn_session *sess;
+    int depth;
+    struct shl_gref_async_slot *slot;
+    int stage_num;
+    struct shl_gref_pipe_stage *stage;  // NULL when one worker runs the whole graph
+    struct shl_gref_pipe_cross *cross;
+    int cross_num;
+    struct shl_gref_pipe_bind *bind;
+    int bind_num;
+    struct shl_gref_async_worker *worker;
+    int worker_started;
+    pthread_t completer;
+    bool completer_started;
+    uint64_t submitted;  // frames queued by the caller
+    uint64_t *finished;  // per stage, frames run by its worker
+    uint64_t completed;  // frames whose callback has returned
+    bool stop;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+};
+
+static struct csinn_tensor **async_alloc_buffers(struct shl_node **node, int num)
+{
+    struct csinn_tensor **t = shl_mem_alloc(num * sizeof(struct csinn_tensor *));
+    for (int i = 0; i < num; i++) {
+        t[i] = csinn_alloc_tensor(NULL);
+        csinn_tensor_copy(t[i], node[i]->data);
+        t[i]->data = shl_mem_alloc(csinn_tensor_byte_size(t[i]));
+    }
+    return t;
+}
+
+static void async_free_buffers(struct csinn_tensor **t, int num)
+{
+    for (int i = 0; i < num; i++) {
+        shl_mem_free(t[i]->data);
+        csinn_free_tensor(t[i]);
+    }
+    shl_mem_free(t);
+}
+
+/* copy the graph outputs of the last run into the slot */
+static void async_take_outputs(struct csinn_session *sess, struct shl_gref_async_slot *slot)
+{
+    struct shl_gref_target_data *td = sess->td;
+    struct shl_ref_graph *g = td->graph;
+    for (int i = 0; i < g->output_num; i++) {
+        struct csinn_tensor *t = g->output[i]->data;
+        struct csinn_tensor *dst = slot->user_output ? slot->user_output[i] : slot->output[i];
+        memcpy(dst->data, t->data, csinn_tensor_byte_size(slot->output[i]));
+        /* outside streaming mode the runtime allocates outputs on every run */
+        if (td->stream == NULL && !t->is_const) {
+            shl_mem_free(t->data);
+            t->data = NULL;
+        }
+    }
+}
+
+/* rough FLOPs of a top level layer, elementwise layers count one per output */
+static int64_t pipe_layer_cost(struct shl_node *n)
+{
+    if (n->type == CSINN_SUBGRAPH) {
+        struct shl_ref_graph *sgraph = n->data;
+        int64_t cost = 0;
+        for (int i = 0; i < sgraph->layer_index; i++) {
+            cost += pipe_layer_cost(sgraph->layer[i]);
+        }
+        return cost;
+    }
+    if (n->type < 0 || n->type >= CSINN_OP_SIZE || n->out_num == 0) {
+        return 0;
+    }
+    struct csinn_tensor *output = n->out[0]->data;
+    int64_t cost = csinn_tensor_size(output);
+    if ((n->type >= CSINN_OP_CONV1D && n->type <= CSINN_OP_CONV3D) ||
+        n->type == CSINN_OP_DECONV2D || n->type == CSINN_OP_DEPTHWISE_DECONV2D ||
+        n->type == CSINN_OP_DECONV3D || n->type == CSINN_OP_FULLYCONNECTED) {
+        /* multiply-adds per output: the kernel size over output channels */
+        struct csinn_tensor *kernel = n->in[1]->data;
+        cost *= 2 * (csinn_tensor_size(kernel) / kernel->dim[0]);
+    } else if (n->type == CSINN_OP_MATMUL) {
+        struct csinn_tensor *mat0 = n->in[0]->data;
+        struct csinn_matmul_params *params = n->data;
+        int k = params->trans_a ? mat0->dim[mat0->dim_count - 2] : mat0->dim[mat0->dim_count - 1];
+        cost *= 2 * k;
+    }
+    return cost;
+}
+
+/* greedy cut of layers into stages no costlier than max_cost, return the stage count */
+static int pipe_cut(int64_t *cost, int layer_num, int64_t max_cost, int *first)
+{
+    int stages = 0;
+    int64_t acc = 0;
+    for (int i = 0; i < layer_num; i++) {
+        if (i == 0 || acc + cost[i] > max_cost) {
+            if (first != NULL) {
+                first[stages] = i;
+            }
+            stages++;
+            acc = 0;
+        }
+        acc += cost[i];
+    }
+    return stages;
+}
+
+/* split layers into at most stage_num stages, minimizing the costliest one */
+static int pipe_partition(struct shl_gref_async *async, struct shl_ref_graph *g, int stage_num)
+{
+    int64_t *cost = shl_mem_alloc(g->layer_index * sizeof(int64_t));
+    int64_t lo = 0;
+    int64_t hi = 0;
+    for (int i = 0; i < g->layer_index; i++) {
+        cost[i] = pipe_layer_cost(g->layer[i]);
+        lo = cost[i] > lo ? cost[i] : lo;
+        hi += cost[i];
+    }
+    while (lo < hi) {
+        int64_t mid = lo + (hi - lo) / 2;
+        if (pipe_cut(cost, g->layer_index, mid, NULL) <= stage_num) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+
+    int *first = shl_mem_alloc(stage_num * sizeof(int));
+    async->stage_num = pipe_cut(cost, g->layer_index, lo, first);
+    async->stage = shl_mem_alloc(async->stage_num * sizeof(struct shl_gref_pipe_stage));
+    for (int s = 0; s < async->stage_num; s++) {
+        struct shl_gref_pipe_stage *stage = &async->stage[s];
+        stage->first = first[s];
+        stage->last = s + 1 < async->stage_num ? first[s + 1] : g->layer_index;
+        for (int i = stage->first; i < stage->last; i++) {
+            stage->cost += cost[i];
+        }
+        shl_debug_info("[pipeline]: stage %d, layers %d .. %d, %.2f MFLOPs\n", s, stage->first,
+                       stage->last - 1, stage->cost / 1000000.0f);
+    }
+    shl_mem_free(first);
+    shl_mem_free(cost);
+    return CSINN_TRUE;
+}
+
+/* room for one more element in a list of num */
+static void *pipe_grow(void *list, int num, size_t size)
+{
+    void *ret = shl_mem_alloc((num + 1) * size);
+    if (list != NULL) {
+        memcpy(ret, list, num * size);
+        shl_mem_free(list);
+    }
+    return ret;
+}
+
+static int pipe_stage_of(struct shl_gref_async *async, int layer)
+{
+    for (int s = 0; s < async->stage_num; s++) {
+        if (layer < async->stage[s].last) {
+            return s;
+        }
+    }
+    return -1;
+}
+
+static int pipe_find_cross(struct shl_gref_async *async, struct shl_ref_graph *g,
+                           struct shl_node *node, int producer)
+{
+    for (int c = 0; c < async->cross_num; c++) {
+        if (async->cross[c].node == node) {
+            return c;
+        }
+    }
+    async->cross = pipe_grow(async->cross, async->cross_num, sizeof(struct shl_gref_pipe_cross));
+    struct shl_gref_pipe_cross *cross = &async->cross[async->cross_num];
+    cross->node = node;
+    cross->producer = producer;
+    cross->input_index = shl_node_find(g->input, g->input_num, node);
+    cross->owned = false;
+    if (producer >= 0) {
+        int layer = shl_node_find(g->layer, g->layer_index, node->in[0]);
+        cross->owned = layer >= 0 && g->layer[layer]->type != CSINN_SUBGRAPH;
+    }
+    return async->cross_num++;
+}
+
+static struct shl_node *pipe_clone(struct shl_gref_pipe_stage *stage, int cross,
+                                   struct shl_node *node)
+{
+    for (int k = 0; k < stage->clone_num; k++) {
+        if (stage->clone[k].cross == cross) {
+            return stage->clone[k].node;
+        }
+    }
+    struct csinn_tensor *t = csinn_alloc_tensor(NULL);
+    csinn_tensor_copy(t, node->data);
+    struct shl_node *clone = shl_node_var_alloc(node->name, t);
+    clone->in[0] = node->in[0];
+    stage->clone = pipe_grow(stage->clone, stage->clone_num, sizeof(struct shl_gref_pipe_clone));
+    stage->clone[stage->clone_num].node = clone;
+    stage->clone[stage->clone_num].cross = cross;
+    stage->clone_num++;
+    return clone;
+}
+
+/* find the tensors that cross stage boundaries and give each reading stage its clone */
+static void pipe_bind(struct shl_gref_async *async, struct shl_ref_graph *g)
+{
+    for (int s = 0; s < async->stage_num; s++) {
+        struct shl_gref_pipe_stage *stage = &async->stage[s];
+        for (int i = stage->first; i < stage->last; i++) {
+            struct shl_node *n = g->layer[i];
+            for (int j = 0; j < n->in_num; j++) {
+                if (n->in[j] == NULL || ((struct csinn_tensor *)n->in[j]->data)->is_const) {
+                    continue;
+                }
+                struct shl_node *producer = shl_gref_get_input_subgraph(g, n, j);
+                int layer = shl_node_find(g->layer, g->layer_index, producer);
+                int producer_stage = layer >= 0 ? pipe_stage_of(async, layer) : -1;
+                if (producer_stage == s) {
+                    continue;
+                }
+                int c = pipe_find_cross(async, g, n->in[j], producer_stage);
+                async->bind =
+                    pipe_grow(async->bind, async->bind_num, sizeof(struct shl_gref_pipe_bind));
+                async->bind[async->bind_num].layer = n;
+                async->bind[async->bind_num].index = j;
+                async->bind[async->bind_num].orig = n->in[j];
+                async->bind_num++;
+                n->in[j] = pipe_clone(stage, c, n->in[j]);
+            }
+        }
+    }
+    /* graph outputs are carried to the end of the pipeline */
+    for (int i = 0; i < g->output_num; i++) {
+        struct shl_node *out = g->output[i];
+        if (((struct csinn_tensor *)out->data)->is_const) {
+            continue;
+        }
+        struct shl_node *producer = out->in[0];
+        if (producer != NULL && producer->type == CSINN_SUBGRAPH_RETURN) {
+            producer = g->layer[producer->subgraph_idx];
+        }
+        int layer = shl_node_find(g->layer, g->layer_index, producer);
+        pipe_find_cross(async, g, out, layer >= 0 ? pipe_stage_of(async, layer) : -1);
+    }
+}
+
+static void pipe_unbind(struct shl_gref_async *async)
+{
+    for (int b = async->bind_num - 1; b >= 0; b--) {
+        async->bind[b].layer->in[async->bind[b].index] = async->bind[b].orig;
+    }
+    for (int s = 0; s < async->stage_num; s++) {
+        struct shl_gref_pipe_stage *stage = &async->stage[s];
+        for (int k = 0; k < stage->clone_num; k++) {
+            csinn_free_tensor(stage->clone[k].node->data);
+            shl_node_free(stage->clone[k].node);
+        }
+        shl_mem_free(stage->clone);
+    }
+    shl_mem_free(async->bind);
+    shl_mem_free(async->cross);
+    shl_mem_free(async->stage);
+}
+
+static void pipe_run_stage(struct shl_gref_async *async, int s, struct shl_gref_async_slot *slot)
+{
+    struct shl_ref_graph *g = shl_gref_get_graph(async->sess);
+    struct shl_gref_pipe_stage *stage = &async->stage[s];
+    if (slot->status == CSINN_TRUE) {
+        uint64_t start_time = shl_get_timespec();
+        for (int k = 0; k < stage->clone_num; k++) {
+            struct csinn_tensor *t = stage->clone[k].node->data;
+            t->data = slot->cross[stage->clone[k].cross];
+        }
+        slot->status = shl_gref_run_layers(g, stage->first, stage->last);
+        for (int c = 0; c < async->cross_num; c++) {
+            if (async->cross[c].producer == s) {
+                struct csinn_tensor *t = async->cross[c].node->data;
+                slot->cross[c] = t->data;
+            }
+        }
+        stage->busy_time += shl_get_timespec() - start_time;
+    }
+    if (s < async->stage_num - 1) {
+        return;
+    }
+
+    for (int i = 0; i < g->output_num && slot->status == CSINN_TRUE; i++) {
+        struct csinn_tensor *t = g->output[i]->data;
+        struct csinn_tensor *dst = slot->user_output ? slot->user_output[i] : slot->output[i];
+        void *src = t->data;
+        for (int c = 0; c < async->cross_num; c++) {
+            if (async->cross[c].node == g->output[i]) {
+                src = slot->cross[c];
+            }
+        }
+        memcpy(dst->data, src, csinn_tensor_byte_size(slot->output[i]));
+    }
+    for (int c = 0; c < async->cross_num; c++) {
+        if (async->cross[c].owned) {
+            shl_mem_free(slot->cross[c]);
+            slot->cross[c] = NULL;
+        }
+    }
+}
+
+/* share the cores between the stages, each stage runs OpenMP on its own cores */
+static void pipe_pin_stage(struct shl_gref_async *async, int s)
+{
+    int procs = omp_get_num_procs();
+    int threads = procs / async->stage_num > 1 ? procs / async->stage_num : 1;
+    omp_set_num_threads(threads);
+#ifdef __linux__
+    if (procs >= async->stage_num) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int i = 0; i < threads; i++) {
+            CPU_SET(s * threads + i, &set);
+        }
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+#endif
+}
+
+static void *async_worker(void *arg)
+{
+    struct shl_gref_async_worker *worker = arg;
+    struct shl_gref_async *async = worker->async;
+    struct csinn_session *sess = async->sess;
+    struct shl_ref_graph *g = shl_gref_get_graph(sess);
+    int s = worker->stage;
+    if (async->stage != NULL) {
+        pipe_pin_stage(async, s);
+    }
+
+    pthread_mutex_lock(&async->mutex);
+    while (true) {
+        uint64_t *available = s == 0 ? &async->submitted : &async->finished[s - 1];
+        while (!async->stop && async->finished[s] == *available) {
+            pthread_cond_wait(&async->cond, &async->mutex);
+        }
+        if (async->finished[s] == *available) {
+            if (async->finished[s] == async->submitted) {
+                break;
+            }
+            /* stopping, wait for the earlier stages to drain the queue */
+            pthread_cond_wait(&async->cond, &async->mutex);
+            continue;
+        }
+        struct shl_gref_async_slot *slot = &async->slot[async->finished[s] % async->depth];
+        pthread_mutex_unlock(&async->mutex);
+
+        if (async->stage != NULL) {
+            pipe_run_stage(async, s, slot);
+        } else {
+            for (int i = 0; i < g->input_num; i++) {
+                shl_gref_update_input(i, slot->input[i], sess);
+            }
+            slot->status = shl_gref_session_run(sess);
+            if (slot->status == CSINN_TRUE) {
+                async_take_outputs(sess, slot);
+            }
+        }
+
+        pthread_mutex_lock(&async->mutex);
+        async->finished[s]++;
+        pthread_cond_broadcast(&async->cond);
+    }
+    pthread_mutex_unlock(&async->mutex);
+    return NULL;
+}
+
+static void *async_completer(void *arg)
+{
+    struct shl_gref_async *async = arg;
+    uint64_t *finished = &async->finished[async->stage_num - 1];
+    pthread_mutex_lock(&async->mutex);
+    while (true) {
+        while (!async->stop && async->completed == *finished) {
+            pthread_cond_wait(&async->cond, &async->mutex);
+        }
+        if (async->completed == *finished) {
+            if (async->completed == async->submitted) {
+                break;
+            }
+            pthread_cond_wait(&async->cond, &async->mutex);
+            continue;
+        }
+        struct shl_gref_async_slot *slot = &async->slot[async->completed % async->depth];
+        pthread_mutex_unlock(&async->mutex);
+
+        if (slot->callback != NULL) {
+            slot->callback(async->sess, slot->user_output ? slot->user_output : slot->output,
+                           slot->status, slot->user);
+        }
+
+        pthread_mutex_lock(&async->mutex);
+        async->completed++;
+        pthread_cond_broadcast(&async->cond);
+    }
+    pthread_mutex_unlock(&async->mutex);
+    return NULL;
+}
+
+/* run queued frames to completion, then release the threads and the buffers */
+static void async_free(struct shl_gref_async *async)
+{
+    struct shl_ref_graph *g = shl_gref_get_graph(async->sess);
+    pthread_mutex_lock(&async->mutex);
+    async->stop = true;
+    pthread_cond_broadcast(&async->cond);
+    pthread_mutex_unlock(&async->mutex);
+    for (int s = 0; s < async->worker_started; s++) {
+        pthread_join(async->worker[s].thread, NULL);
+    }
+    if (async->completer_started) {
+        pthread_join(async->completer, NULL);
+    }
+    pthread_mutex_destroy(&async->mutex);
+    pthread_cond_destroy(&async->cond);
+
+    if (async->stage != NULL) {
+        for (int s = 0; s < async->stage_num; s++) {
+            struct shl_gref_pipe_stage *stage = &async->stage[s];
+            shl_debug_info("[pipeline]: stage %d busy %f ms per frame\n", s,
+                           async->submitted ? stage->busy_time / 1000000.0f / async->submitted
+                                            : 0.0f);
+        }
+        pipe_unbind(async);
+    }
+    for (int i = 0; i < async->depth; i++) {
+        async_free_buffers(async->slot[i].input, g->input_num);
+        async_free_buffers(async->slot[i].output, g->output_num);
+        shl_mem_free(async->slot[i].cross);
+    }
+    /* the graph inputs still point to the last slot */
+    for (int i = 0; i < g->input_num; i++) {
+        struct csinn_tensor *t = g->input[i]->data;
+        t->data = NULL;
+    }
+    shl_mem_free(async->slot);
+    shl_mem_free(async->worker);
+    shl_mem_free(async->finished);
+    shl_mem_free(async);
+}
+
+/*
+ * Enable asynchronous runs with depth frames in flight, after
+ * csinn_session_setup. With more than one stage the graph runs as a
+ * pipeline, which needs depth >= stages to keep every stage busy.
+ * Depth 0 waits for queued frames and disables asynchronous runs.
+ * While enabled the session belongs to the workers, do not call
+ * csinn_session_run or csinn_update_input on it.
+ */
+int shl_gref_session_set_pipeline(struct csinn_session *sess, int stages, int depth)
+{
+    struct shl_gref_target_data *td = sess->td;
+    if (td->async != NULL) {
+        async_free(td->async);
+        td->async = NULL;
+    }
+    if (depth <= 0) {
+        return CSINN_TRUE;
+    }
+
+    struct shl_ref_graph *g = td->graph;
+    struct shl_gref_async *async = shl_mem_alloc(sizeof(struct shl_gref_async));
+    async->sess = sess;
+    async->depth = depth;
+    async->stage_num = 1;
+    if (stages > 1) {
+        if (td->stream != NULL || td->tiling != NULL || td->counters != NULL) {
+            shl_debug_error("%s: pipeline mode excludes streaming, tiling and counters\n",
+                            __func__);
+            shl_mem_free(async);
+            return CSINN_FALSE;
+        }
+        pipe_partition(async, g, stages < g->layer_index ? stages : g->layer_index);
+        pipe_bind(async, g);
+    }
+    async->slot = shl_mem_alloc(depth * sizeof(struct shl_gref_async_slot));
+    for (int i = 0; i < depth; i++) {
+        struct shl_gref_async_slot *slot = &async->slot[i];
+        slot->input = async_alloc_buffers(g->input, g->input_num);
+        slot->output = async_alloc_buffers(g->output, g->output_num);
+        slot->cross = shl_mem_alloc((async->cross_num + 1) * sizeof(void *));
+        for (int c = 0; c < async->cross_num; c++) {
+            if (async->cross[c].producer < 0) {
+                slot->cross[c] = slot->input[async->cross[c].input_index]->data;
+            }
+        }
+    }
+    async->finished = shl_mem_alloc(async->stage_num * sizeof(uint64_t));
+    async->worker = shl_mem_alloc(async->stage_num * sizeof(struct shl_gref_async_worker));
+    pthread_mutex_init(&async->mutex, NULL);
+    pthread_cond_init(&async->cond, NULL);
+    for (int s = 0; s < async->stage_num; s++) {
+        async->worker[s].async = async;
+        async->worker[s].stage = s;
+        if (pthread_create(&async->worker[s].thread, NULL, async_worker, &async->worker[s]) != 0) {
+            shl_debug_error("%s: cannot create the worker threads\n", __func__);
+            async_free(async);
+            return CSINN_FALSE;
+        }
+        async->worker_started++;
+    }
+    if (pthread_create(&async->completer, NULL, async_completer, async) != 0) {
+        shl_debug_error("%s: cannot create the completion thread\n", __func__);
+        async_free(async);
+        return CSINN_FALSE;
+    }
+    async->completer_started = true;
+    td->async = async;
+    return CSINN_TRUE;
+}
+
+int shl_gref_session_set_async(struct csinn_session *sess, int depth)
+{
+    return shl_gref_session_set_pipeline(sess, 1, depth);
+}
+
+/*
+ * Queue one frame. The inputs are copied before returning, so their buffers
+ * can be reused at once. Blocks while depth frames are in flight. The
+ * callback runs on the completion thread with the results in outputs, or in
+ * session owned tensors that stay valid until it returns if outputs is NULL.
+ */
+int shl_gref_session_run_async(struct csinn_session *sess, struct csinn_tensor **inputs,
+                               struct csinn_tensor **outputs, csinn_async_callback callback,
+                               void *user)
+{
+    struct shl_gref_target_data *td = sess->td;
+    struct shl_gref_async *async = td->async;
+    if (async == NULL) {
+        shl_debug_error("%s: call csinn_session_set_async first\n", __func__);
+        return CSINN_FALSE;
+    }
+
+    pthread_mutex_lock(&async->mutex);
+    while (async->submitted - async->completed == async->depth) {
+        pthread_cond_wait(&async->cond, &async->mutex);
+    }
+    struct shl_gref_async_slot *slot = &async->slot[async->submitted % async->depth];
+    pthread_mutex_unlock(&async->mutex);
+
+    /* only the caller writes a free slot */
+    for (int i = 0; i < td->graph->input_num; i++) {
+        memcpy(slot->input[i]->data, inputs[i]->data, csinn_tensor_byte_size(slot->input[i]));
+    }
+    slot->user_output = outputs;
+    slot->callback = callback;
+    slot->user = user;
+    slot->status = CSINN_TRUE;
+
+    pthread_mutex_lock(&async->mutex);
+    async->submitted++;
+    pthread_cond_broadcast(&async->cond);
+    pthread_mutex_unlock(&async->mutex);
+    return CSINN_TRUE;
+}
+
+/* whether runs go through the stage workers instead of shl_gref_session_run */
+bool shl_gref_session_pipelined(struct csinn_session *sess)
+{
+    struct shl_gref_target_data *td = sess->td;
+    return td->async != NULL && td->async->stage_num > 1;
+}
+
+/* block until every queued frame has been run and its callback has returned */
+int shl_gref_session_wait(struct csinn_session *sess)
+{
+    struct shl_gref_target_data *td = sess->td;
+    struct shl_gref_async *async = td->async;
+    if (async == NULL) {
+        return CSINN_TRUE;
+    }
+    pthread_mutex_lock(&async->mutex);
+    while (async->completed != async->submitted) {
+        pthread_cond_wait(&async->cond, &async->mutex);
+    }
+    pthread_mutex_unlock(&async->mutex);
+    return CSINN_TRUE;
+}
+#else
+int shl_gref_session_set_pipeline(struct csinn_session *sess, int stages, int depth)
+{
+    return depth > 0 ? CSINN_FALSE : CSINN_TRUE;
+}
+
+bool shl_gref_session_pipelined(struct csinn_session *sess) { return false; }
+
+int shl_gref_session_set_async(struct csinn_session *sess, int depth)
+{
+    return depth > 0 ? CSINN_FALSE : CSINN_TRUE;
+}
+
+int shl_gref_session_run_async(struct csinn_session *sess, struct csinn_tensor **inputs,
+                               struct csinn_tensor **outputs, csinn_async_callback callback,
+                               void *user)
+{
+    return CSINN_FALSE;
+}
+
+int shl_gref_session_wait(struct csinn_session *sess) { return CSINN_TRUE; }
+#endif
@@ -0,0 +1,311 @@
+/*
+ * Copyright (C) 2016-2022 T-Head Semiconductor Co., Ltd. All rights reserved.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* CSI-NN2 version 2.0.x */
+
+#include "shl_gref.h"
+
+static struct shl_node *attention_in_node(struct csinn_tensor *t)
+{
+    if (t->is_const) {
+        return shl_node_const_var_alloc(t->name, t);
+    }
+    return (struct shl_node *)t->data;
+}
+
+int shl_gref_attention(struct csinn_tensor *query, struct csinn_tensor *key,
+                       struct csinn_tensor *value, struct csinn_tensor *mask,
+                       struct csinn_tensor *output, struct csinn_attention_params *params)
+{
+    struct csinn_params_base *ptr = &params->base;
+    struct shl_node *layer =
+        shl_node_alloc(CSINN_OP_ATTENTION, ptr->name, mask != NULL ? 4 : 3, 1, params);
+    shl_node_add_in(layer, (struct shl_node *)query->data, 0);
+    shl_node_add_in(layer, attention_in_node(key), 1);
+    shl_node_add_in(layer, attention_in_node(value), 2);
+    if (mask != NULL) {
+        shl_node_add_in(layer, attention_in_node(mask), 3);
+    }
+    struct shl_node *out = shl_node_var_alloc(output->name, output);
+    shl_node_add_out(layer, out, 0);
+    output->data = out;
+    struct shl_ref_graph *graph = shl_gref_get_graph(query->sess);
+    shl_gref_graph_insert(layer, graph);
+    return CSINN_TRUE;
+}
+
+/* the only layer reading tensor, NULL if it has several readers or is a graph output */
+static struct shl_node *single_consumer(struct shl_ref_graph *graph, struct shl_node *tensor)
+{
+    for (int i = 0; i < graph->output_num; i++) {
+        if (graph->output[i] == tensor) {
+            return NULL;
+        }
+    }
+    struct shl_node *ret = NULL;
+    for (int i = 0; i < graph->layer_index; i++) {
+        struct shl_node *n = graph->layer[i];
+        if (n == NULL) {
+            continue;
+        }
+        for (int j = 0; j < n->in_num; j++) {
+            if (n->in[j] == tensor) {
+                if (ret != NULL) {
+                    return NULL;
+                }
+                ret = n;
+            }
+        }
+    }
+    return ret;
+}
+
+static bool produced_by(struct shl_node *tensor, int op)
+{
+    return tensor->in_num == 1 && tensor->in[0] != NULL && tensor->in[0]->type == op;
+}
+
+/* layer writing tensor if only `reader` consumes it, so the layer can be folded away */
+static struct shl_node *private_producer(struct shl_ref_graph *graph, struct shl_node *tensor,
+                                         struct shl_node *reader, int op)
+{
+    if (!produced_by(tensor, op)) {
+        return NULL;
+    }
+    struct csinn_params_base *params = tensor->in[0]->data;
+    if (params->api != params->sess->base_api) {
+        return NULL;
+    }
+    return single_consumer(graph, tensor) == reader ? tensor->in[0] : NULL;
+}
+
+static bool const_scalar(struct shl_node *tensor, float *value)
+{
+    struct csinn_tensor *t = tensor->data;
+    if (!t->is_const || t->dtype != CSINN_DTYPE_FLOAT32 || t->data == NULL) {
+        return false;
+    }
+    if (t->dim_count != 0 && csinn_tensor_size(t) != 1) {
+        return false;
+    }
+    *value = *(float *)t->data;
+    return true;
+}
+
+static bool swaps_last_two(struct csinn_transpose_params *params)
+{
+    int n = params->permute_num;
+    if (n < 2 || params->permute[n - 2] != n - 1 || params->permute[n - 1] != n - 2) {
+        return false;
+    }
+    for (int i = 0; i < n - 2; i++) {
+        if (params->permute[i] != i) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* mask broadcasts to scores and adding it does not grow the result */
+static bool mask_fits(struct csinn_tensor *mask, struct csinn_tensor *scores,
+                      struct csinn_tensor *sum)
+{
+    if (mask->dim_count > scores->dim_count || sum->dim_count != scores->dim_count) {
+        return false;
+    }
+    for (int i = 0; i < scores->dim_count; i++) {
+        if (sum->dim[i] != scores->dim[i]) {
+            return false;
+        }
+    }
+    int shift = scores->dim_count - mask->dim_count;
+    for (int i = 0; i < mask->dim_count; i++) {
+        if (mask->dim[i] != 1 && mask->dim[i] != scores->dim[i + shift]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* q [..., Sq, D], k [..., Sk, D], v [..., Sk, Dv] with identical leading dims */
+static bool qkv_fits(struct csinn_tensor *q, struct csinn_tensor *k, struct csinn_tensor *v)
+{
+    int rank = q->dim_count;
+    if (rank < 2 || k->dim_count != rank || v->dim_count != rank) {
+        return false;
+    }
+    for (int i = 0; i < rank - 2; i++) {
+        if (k->dim[i] != q->dim[i] || v->dim[i] != q->dim[i]) {
+            return false;
+        }
+    }
+    return k->dim[rank - 1] == q->dim[rank - 1] && v->dim[rank - 2] == k->dim[rank - 2];
+}
+
+/*
+ * Match MATMUL(q, k^T) -> [MUL/DIV by scalar] -> [ADD mask] -> SOFTMAX(last axis) -> MATMUL(., v)
+ * around the softmax at graph->layer[sm_idx]. k^T is either trans_b or a TRANSPOSE of the last
+ * two dims. On success the chain is replaced in place by one attention layer.
+ */
+static bool fuse_one(struct shl_ref_graph *graph, int sm_idx)
+{
+    struct shl_node *sm = graph->layer[sm_idx];
+    struct csinn_softmax_params *sm_params = sm->data;
+    struct csinn_tensor *sm_in = sm->in[0]->data;
+    if (sm_params->base.api != sm_params->base.sess->base_api ||
+        (sm_params->axis != sm_in->dim_count - 1 && sm_params->axis != -1)) {
+        return false;
+    }
+
+    /* forward to the value matmul */
+    struct shl_node *mm_v = single_consumer(graph, sm->out[0]);
+    if (mm_v == NULL || mm_v->type != CSINN_OP_MATMUL || mm_v->in[0] != sm->out[0]) {
+        return false;
+    }
+    struct csinn_matmul_params *mm_v_params = mm_v->data;
+    if (mm_v_params->trans_a || mm_v_params->trans_b ||
+        mm_v_params->base.api != mm_v_params->base.sess->base_api) {
+        return false;
+    }
+
+    /* backward through the optional mask add and scale */
+    struct shl_node *removed[5] = {sm, NULL, NULL, NULL, NULL};
+    int removed_num = 1;
+    struct shl_node *cur = sm->in[0];
+    struct shl_node *mask = NULL;
+    struct shl_node *add = private_producer(graph, cur, sm, CSINN_OP_ADD);
+    if (add != NULL) {
+        /* the scores side of the add comes from the scale or the q.k matmul */
+        int chain = 1;
+        if (produced_by(add->in[0], CSINN_OP_MATMUL) || produced_by(add->in[0], CSINN_OP_MUL) ||
+            produced_by(add->in[0], CSINN_OP_DIV)) {
+            chain = 0;
+        }
+        mask = add->in[1 - chain];
+        cur = add->in[chain];
+        removed[removed_num++] = add;
+    }
+    float scale = 1.0f;
+    float value;
+    struct shl_node *reader = add != NULL ? add : sm;
+    struct shl_node *mul = private_producer(graph, cur, reader, CSINN_OP_MUL);
+    struct shl_node *div = private_producer(graph, cur, reader, CSINN_OP_DIV);
+    if (mul != NULL) {
+        int s = const_scalar(mul->in[1], &value) ? 1 : 0;
+        if (!const_scalar(mul->in[s], &value)) {
+            return false;
+        }
+        scale = value;
+        cur = mul->in[1 - s];
+        reader = mul;
+        removed[removed_num++] = mul;
+    } else if (div != NULL) {
+        if (!const_scalar(div->in[1], &value)) {
+            return false;
+        }
+        scale = 1.0f / value;
+        cur = div->in[0];
+        reader = div;
+        removed[removed_num++] = div;
+    }
+    struct shl_node *mm_qk = private_producer(graph, cur, reader, CSINN_OP_MATMUL);
+    if (mm_qk == NULL) {
+        return false;
+    }
+    struct csinn_matmul_params *mm_qk_params = mm_qk->data;
+    if (mm_qk_params->trans_a) {
+        return false;
+    }
+    removed[removed_num++] = mm_qk;
+    struct shl_node *q = mm_qk->in[0];
+    struct shl_node *k = mm_qk->in[1];
+    if (!mm_qk_params->trans_b) {
+        struct shl_node *tp = private_producer(graph, k, mm_qk, CSINN_OP_TRANSPOSE);
+        if (tp == NULL || !swaps_last_two(tp->data)) {
+            return false;
+        }
+        k = tp->in[0];
+        removed[removed_num++] = tp;
+    }
+    struct shl_node *v = mm_v->in[1];
+
+    if (!qkv_fits(q->data, k->data, v->data)) {
+        return false;
+    }
+    if (mask != NULL && !mask_fits(mask->data, mm_qk->out[0]->data, add->out[0]->data)) {
+        return false;
+    }
+
+    struct csinn_session *sess = mm_v_params->base.sess;
+    struct csinn_attention_params *params =
+        csinn_alloc_params(sizeof(struct csinn_attention_params), sess);
+    struct csinn_callback *cb = params->base.cb;
+    params->base = mm_v_params->base;
+    params->base.cb = cb;
+    params->scale = scale;
+
+    struct shl_node *layer =
+        shl_node_alloc(CSINN_OP_ATTENTION, params->base.name, mask != NULL ? 4 : 3, 1, params);
+    shl_node_add_in(layer, q, 0);
+    shl_node_add_in(layer, k, 1);
+    shl_node_add_in(layer, v, 2);
+    if (mask != NULL) {
+        shl_node_add_in(layer, mask, 3);
+    }
+    shl_node_add_out(layer, mm_v->out[0], 0);
+
+    for (int i = 0; i < graph->layer_index; i++) {
+        if (graph->layer[i] == mm_v) {
+            graph->layer[i] = layer;
+        }
+        for (int j = 0; j < removed_num; j++) {
+            if (graph->layer[i] == removed[j]) {
+                graph->layer[i] = NULL;
+            }
+        }
+    }
+    for (int j = 0; j < removed_num; j++) {
+        shl_node_free(removed[j]->out[0]);
+        shl_node_free(removed[j]);
+    }
+    shl_node_free(mm_v);
+    return true;
+}
+
+int shl_gref_fuse_attention(struct shl_ref_graph *graph)
+{
+    int fused = 0;
+    for (int i = 0; i < graph->layer_index; i++) {
+        struct shl_node *n = graph->layer[i];
+        if (n != NULL && n->type == CSINN_OP_SOFTMAX && fuse_one(graph, i)) {
+            fused++;
+        }
+    }
+    if (fused == 0) {
+        return 0;
+    }
+    int j = 0;
+    for (int i = 0; i < graph->layer_index; i++) {
+        if (graph->layer[i] != NULL) {
+            graph->layer[j++] = graph->layer[i];
+        }
+    }
+    graph->layer_index = j;
+    shl_debug_info("fused %d attention blocks\n", fused);
+    return fused;
+}
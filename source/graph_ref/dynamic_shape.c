@@ -0,0 +1,598 @@
+/*
+ * Copyright (C) 2016-2022 T-Head Semiconductor Co., Ltd. All rights reserved.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* CSI-NN2 version 2.0.x */
+
+#include "shl_gref.h"
+
+/*
+ * Input shape changes after setup. The runtime allocates activations from
+ * the tensor dims on every run, so a shape change only needs new dims for
+ * every layer output and new kernel choices for the layers whose choice
+ * depends on the spatial size. Each input shape seen gets a plan holding
+ * both; the last SHAPE_PLAN_NUM plans are kept, least recently used first
+ * out, so switching back to a cached shape only rewrites the dims.
+ */
+#define SHAPE_PLAN_NUM 4
+
+struct shape_dims {
+    int32_t dim_count;
+    int32_t dim[MAX_DIM];
+};
+
+struct shape_plan {
+    struct shape_dims *input;   // graph inputs, the key of the plan
+    struct shape_dims *tensor;  // outputs of every layer, in layer order
+    struct csinn_tensor **kernel_tm;  // per layer, owned by the plan for reselected convs
+    enum csinn_conv_mode_enum *conv_mode;
+    uint64_t last_used;
+};
+
+struct shl_gref_shapes {
+    struct shape_plan plan[SHAPE_PLAN_NUM];
+    int plan_num;
+    int current;
+    int tensor_num;
+    uint64_t tick;
+};
+
+static void shape_save(struct shape_dims *d, struct csinn_tensor *t)
+{
+    d->dim_count = t->dim_count;
+    memcpy(d->dim, t->dim, sizeof(d->dim));
+}
+
+static void shape_load(struct shape_dims *d, struct csinn_tensor *t)
+{
+    t->dim_count = d->dim_count;
+    memcpy(t->dim, d->dim, sizeof(d->dim));
+}
+
+static bool shape_equal(struct shape_dims *d, struct csinn_tensor *t)
+{
+    if (d->dim_count != t->dim_count) {
+        return false;
+    }
+    for (int i = 0; i < d->dim_count; i++) {
+        if (d->dim[i] != t->dim[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * Reference convs pick winograd or direct from the output size and keep the
+ * original weights, so their init can run again. Other backends repack the
+ * weights in place at init and keep their setup time choice.
+ */
+static bool shape_reselect(struct shl_node *n)
+{
+    struct csinn_params_base *base = n->data;
+    return (n->type == CSINN_OP_CONV2D || n->type == CSINN_OP_CONV2D_RELU ||
+            n->type == CSINN_OP_CONV2D_RELU6) &&
+           base->api == CSINN_REF;
+}
+
+static void shape_plan_capture(struct shl_ref_graph *g, struct shape_plan *plan)
+{
+    for (int i = 0; i < g->input_num; i++) {
+        shape_save(&plan->input[i], g->input[i]->data);
+    }
+    int t = 0;
+    for (int i = 0; i < g->layer_index; i++) {
+        struct shl_node *n = g->layer[i];
+        for (int k = 0; k < n->out_num; k++) {
+            shape_save(&plan->tensor[t++], n->out[k]->data);
+        }
+        if (shape_reselect(n)) {
+            struct csinn_conv2d_params *params = n->data;
+            plan->kernel_tm[i] = params->conv_extra.kernel_tm;
+            plan->conv_mode[i] = params->conv_extra.conv_mode;
+        }
+    }
+}
+
+static void shape_plan_install(struct shl_ref_graph *g, struct shape_plan *plan)
+{
+    for (int i = 0; i < g->input_num; i++) {
+        shape_load(&plan->input[i], g->input[i]->data);
+    }
+    int t = 0;
+    for (int i = 0; i < g->layer_index; i++) {
+        struct shl_node *n = g->layer[i];
+        for (int k = 0; k < n->out_num; k++) {
+            shape_load(&plan->tensor[t++], n->out[k]->data);
+        }
+        if (shape_reselect(n)) {
+            struct csinn_conv2d_params *params = n->data;
+            params->conv_extra.kernel_tm = plan->kernel_tm[i];
+            params->conv_extra.conv_mode = plan->conv_mode[i];
+        }
+    }
+}
+
+static void shape_plan_alloc(struct shl_ref_graph *g, struct shl_gref_shapes *shapes,
+                             struct shape_plan *plan)
+{
+    plan->input = shl_mem_alloc(g->input_num * sizeof(struct shape_dims));
+    plan->tensor = shl_mem_alloc(shapes->tensor_num * sizeof(struct shape_dims));
+    plan->kernel_tm = shl_mem_alloc(g->layer_index * sizeof(struct csinn_tensor *));
+    plan->conv_mode = shl_mem_alloc(g->layer_index * sizeof(enum csinn_conv_mode_enum));
+}
+
+/* release the transformed kernels of a plan that is not installed */
+static void shape_plan_free_kernels(struct shl_ref_graph *g, struct shape_plan *plan)
+{
+    for (int i = 0; i < g->layer_index; i++) {
+        if (plan->kernel_tm[i] != NULL) {
+            shl_mem_free(plan->kernel_tm[i]->data);
+            csinn_free_tensor(plan->kernel_tm[i]);
+            plan->kernel_tm[i] = NULL;
+        }
+    }
+}
+
+static void shape_plan_free(struct shape_plan *plan)
+{
+    shl_mem_free(plan->input);
+    shl_mem_free(plan->tensor);
+    shl_mem_free(plan->kernel_tm);
+    shl_mem_free(plan->conv_mode);
+}
+
+/* output extent of a sliding window */
+static int32_t shape_window(int32_t in, int32_t pad, int32_t kernel, int32_t dilation,
+                            int32_t stride, bool ceil_mode)
+{
+    int32_t span = in + pad - ((kernel - 1) * dilation + 1);
+    if (span < 0) {
+        return 0;
+    }
+    return (ceil_mode ? (span + stride - 1) / stride : span / stride) + 1;
+}
+
+static bool shape_spatial_axes(int32_t layout, int *h, int *w)
+{
+    if (layout == CSINN_LAYOUT_NCHW) {
+        *h = 2;
+        *w = 3;
+    } else if (layout == CSINN_LAYOUT_NHWC) {
+        *h = 1;
+        *w = 2;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static int shape_conv2d(struct shl_node *n)
+{
+    struct csinn_conv2d_params *params = n->data;
+    struct csinn_tensor *input = n->in[0]->data;
+    struct csinn_tensor *output = n->out[0]->data;
+    struct csinn_tensor *kernel = n->in[1]->data;
+    int h, w;
+    if (!shape_spatial_axes(params->base.layout, &h, &w)) {
+        return CSINN_FALSE;
+    }
+    /* OIHW kernels with NCHW, OHWI or 1HWO with NHWC */
+    int kh = params->base.layout == CSINN_LAYOUT_NCHW ? kernel->dim[2] : kernel->dim[1];
+    int kw = params->base.layout == CSINN_LAYOUT_NCHW ? kernel->dim[3] : kernel->dim[2];
+    output->dim[0] = input->dim[0];
+    output->dim[h] = shape_window(input->dim[h], params->pad_top + params->pad_down, kh,
+                                  params->dilation_height, params->stride_height, false);
+    output->dim[w] = shape_window(input->dim[w], params->pad_left + params->pad_right, kw,
+                                  params->dilation_width, params->stride_width, false);
+    return output->dim[h] > 0 && output->dim[w] > 0;
+}
+
+static int shape_pool2d(struct shl_node *n, bool global)
+{
+    struct csinn_pool_params *params = n->data;
+    struct csinn_tensor *input = n->in[0]->data;
+    struct csinn_tensor *output = n->out[0]->data;
+    int h, w;
+    if (!shape_spatial_axes(params->base.layout, &h, &w)) {
+        return CSINN_FALSE;
+    }
+    output->dim[0] = input->dim[0];
+    if (global) {
+        output->dim[h] = 1;
+        output->dim[w] = 1;
+        return CSINN_TRUE;
+    }
+    output->dim[h] = shape_window(input->dim[h], params->pad_top + params->pad_down,
+                                  params->filter_height, 1, params->stride_height,
+                                  params->ceil_mode);
+    output->dim[w] = shape_window(input->dim[w], params->pad_left + params->pad_right,
+                                  params->filter_width, 1, params->stride_width, params->ceil_mode);
+    return output->dim[h] > 0 && output->dim[w] > 0;
+}
+
+/* numpy broadcasting, dims aligned from the innermost */
+static int shape_broadcast(struct shl_node *n)
+{
+    struct csinn_tensor *a = n->in[0]->data;
+    struct csinn_tensor *b = n->in[1]->data;
+    struct csinn_tensor *output = n->out[0]->data;
+    int dim_count = a->dim_count > b->dim_count ? a->dim_count : b->dim_count;
+    for (int i = 0; i < dim_count; i++) {
+        int ia = i - (dim_count - a->dim_count);
+        int ib = i - (dim_count - b->dim_count);
+        int da = ia >= 0 ? a->dim[ia] : 1;
+        int db = ib >= 0 ? b->dim[ib] : 1;
+        if (da != db && da != 1 && db != 1) {
+            return CSINN_FALSE;
+        }
+        output->dim[i] = da == 1 ? db : da;
+    }
+    output->dim_count = dim_count;
+    return CSINN_TRUE;
+}
+
+static int shape_concat(struct shl_node *n)
+{
+    struct csinn_concat_params *params = n->data;
+    struct csinn_tensor *output = n->out[0]->data;
+    struct csinn_tensor *first = n->in[0]->data;
+    int axis = params->axis < 0 ? params->axis + first->dim_count : params->axis;
+    output->dim_count = first->dim_count;
+    memcpy(output->dim, first->dim, sizeof(output->dim));
+    output->dim[axis] = 0;
+    for (int i = 0; i < params->inputs_count; i++) {
+        struct csinn_tensor *input = n->in[i]->data;
+        for (int d = 0; d < first->dim_count; d++) {
+            if (d != axis && input->dim[d] != first->dim[d]) {
+                return CSINN_FALSE;
+            }
+        }
+        output->dim[axis] += input->dim[axis];
+    }
+    return CSINN_TRUE;
+}
+
+static int shape_reshape(struct shl_node *n)
+{
+    struct csinn_reshape_params *params = n->data;
+    struct csinn_tensor *input = n->in[0]->data;
+    struct csinn_tensor *output = n->out[0]->data;
+    int64_t known = 1;
+    int infer = -1;
+    for (int i = 0; i < params->shape_num; i++) {
+        output->dim[i] = params->shape[i];
+        if (params->shape[i] == -1) {
+            infer = i;
+        } else {
+            known *= params->shape[i];
+        }
+    }
+    output->dim_count = params->shape_num;
+    if (infer >= 0 && known > 0) {
+        output->dim[infer] = csinn_tensor_size(input) / known;
+    }
+    return csinn_tensor_size(output) == csinn_tensor_size(input);
+}
+
+static int shape_matmul(struct shl_node *n)
+{
+    struct csinn_matmul_params *params = n->data;
+    struct csinn_tensor *a = n->in[0]->data;
+    struct csinn_tensor *b = n->in[1]->data;
+    struct csinn_tensor *output = n->out[0]->data;
+    if (params->kv_cache != NULL || a->dim_count < 2 || b->dim_count < 2 ||
+        output->dim_count != a->dim_count) {
+        return CSINN_FALSE;
+    }
+    int rank = a->dim_count;
+    int k_a = params->trans_a ? a->dim[rank - 2] : a->dim[rank - 1];
+    int k_b = params->trans_b ? b->dim[b->dim_count - 1] : b->dim[b->dim_count - 2];
+    if (k_a != k_b) {
+        return CSINN_FALSE;
+    }
+    memcpy(output->dim, a->dim, (rank - 2) * sizeof(int32_t));
+    output->dim[rank - 2] = params->trans_a ? a->dim[rank - 1] : a->dim[rank - 2];
+    output->dim[rank - 1] =
+        params->trans_b ? b->dim[b->dim_count - 2] : b->dim[b->dim_count - 1];
+    return CSINN_TRUE;
+}
+
+/* new output dims of a layer from the dims of its inputs */
+static int shape_infer(struct shl_node *n)
+{
+    struct csinn_tensor *input = n->in[0]->data;
+    struct csinn_tensor *output = n->out[0]->data;
+    switch (n->type) {
+        case CSINN_OP_CONV2D:
+        case CSINN_OP_CONV2D_RELU:
+        case CSINN_OP_CONV2D_RELU6:
+        case CSINN_OP_DEPTHWISE_CONV2D:
+        case CSINN_OP_DEPTHWISE_CONV2D_RELU:
+        case CSINN_OP_DEPTHWISE_CONV2D_RELU6:
+        case CSINN_OP_GROUP_CONV2D:
+        case CSINN_OP_GROUP_CONV2D_RELU:
+        case CSINN_OP_GROUP_CONV2D_RELU6:
+            return shape_conv2d(n);
+        case CSINN_OP_MAXPOOL2D:
+        case CSINN_OP_AVGPOOL2D:
+        case CSINN_OP_L2POOL2D:
+            return shape_pool2d(n, false);
+        case CSINN_OP_GLOBAL_MAXPOOL2D:
+        case CSINN_OP_GLOBAL_AVGPOOL2D:
+            return shape_pool2d(n, true);
+        case CSINN_OP_ADD:
+        case CSINN_OP_SUB:
+        case CSINN_OP_MUL:
+        case CSINN_OP_DIV:
+        case CSINN_OP_POWER:
+        case CSINN_OP_MAXIMUM:
+        case CSINN_OP_MINIMUM:
+        case CSINN_OP_MOD:
+        case CSINN_OP_FLOOR_DIVIDE:
+        case CSINN_OP_FLOOR_MOD:
+        case CSINN_OP_EQUANL:
+        case CSINN_OP_NOT_EQUAL:
+        case CSINN_OP_GREATHER:
+        case CSINN_OP_GREATHER_EQUAL:
+        case CSINN_OP_LESS:
+        case CSINN_OP_LESS_EQUAL:
+        case CSINN_OP_AND:
+        case CSINN_OP_OR:
+        case CSINN_OP_XOR:
+        case CSINN_OP_LOGICAL_AND:
+        case CSINN_OP_LOGICAL_OR:
+        case CSINN_OP_LOGICAL_XOR:
+            return shape_broadcast(n);
+        case CSINN_OP_CONCAT:
+            return shape_concat(n);
+        case CSINN_OP_RESHAPE:
+            return shape_reshape(n);
+        case CSINN_OP_MATMUL:
+            return shape_matmul(n);
+        case CSINN_OP_FULLYCONNECTED:
+            /* leading dims follow the input, the last one is the units */
+            if (output->dim_count != input->dim_count) {
+                return CSINN_FALSE;
+            }
+            memcpy(output->dim, input->dim, (input->dim_count - 1) * sizeof(int32_t));
+            return CSINN_TRUE;
+        case CSINN_OP_FLATTEN:
+            if (output->dim_count != 2) {
+                return CSINN_FALSE;
+            }
+            output->dim[0] = input->dim[0];
+            output->dim[1] = csinn_tensor_size(input) / input->dim[0];
+            return CSINN_TRUE;
+        case CSINN_OP_TRANSPOSE: {
+            struct csinn_transpose_params *params = n->data;
+            for (int i = 0; i < params->permute_num; i++) {
+                output->dim[i] = input->dim[params->permute[i]];
+            }
+            return CSINN_TRUE;
+        }
+        case CSINN_OP_PAD: {
+            struct csinn_pad_params *params = n->data;
+            if (params->pad_num != input->dim_count) {
+                return CSINN_FALSE;
+            }
+            for (int i = 0; i < input->dim_count; i++) {
+                output->dim[i] = input->dim[i] + params->pad_before[i] + params->pad_after[i];
+            }
+            return CSINN_TRUE;
+        }
+        case CSINN_OP_ABS:
+        case CSINN_OP_ACOS:
+        case CSINN_OP_ACOSH:
+        case CSINN_OP_ASIN:
+        case CSINN_OP_ASINH:
+        case CSINN_OP_ATAN:
+        case CSINN_OP_ATANH:
+        case CSINN_OP_BN:
+        case CSINN_OP_CEIL:
+        case CSINN_OP_CLIP:
+        case CSINN_OP_COS:
+        case CSINN_OP_COSH:
+        case CSINN_OP_CUMPROD:
+        case CSINN_OP_CUMSUM:
+        case CSINN_OP_DATA_CONVERT:
+        case CSINN_OP_ELU:
+        case CSINN_OP_ERF:
+        case CSINN_OP_EXP:
+        case CSINN_OP_EXPM1:
+        case CSINN_OP_FLOOR:
+        case CSINN_OP_HARD_SIGMOID:
+        case CSINN_OP_ISNAN:
+        case CSINN_OP_L2N:
+        case CSINN_OP_LAYER_NORM:
+        case CSINN_OP_LEAKY_RELU:
+        case CSINN_OP_LOG:
+        case CSINN_OP_LOG1P:
+        case CSINN_OP_LOG_SOFTMAX:
+        case CSINN_OP_LOGICAL_NOT:
+        case CSINN_OP_LRN:
+        case CSINN_OP_NEGATIIVE:
+        case CSINN_OP_NOT:
+        case CSINN_OP_PRELU:
+        case CSINN_OP_RELU:
+        case CSINN_OP_RELU1:
+        case CSINN_OP_RELU6:
+        case CSINN_OP_RELUN:
+        case CSINN_OP_ROUND:
+        case CSINN_OP_RSQRT:
+        case CSINN_OP_SIGMOID:
+        case CSINN_OP_SIGN:
+        case CSINN_OP_SIN:
+        case CSINN_OP_SINH:
+        case CSINN_OP_SOFTMAX:
+        case CSINN_OP_SOFTPLUS:
+        case CSINN_OP_SOFTRELU:
+        case CSINN_OP_SOFTSIGN:
+        case CSINN_OP_SQRT:
+        case CSINN_OP_SQUARE:
+        case CSINN_OP_TAN:
+        case CSINN_OP_TANH:
+        case CSINN_OP_THRESHOLD_RELU:
+        case CSINN_OP_TRUNC:
+            output->dim_count = input->dim_count;
+            memcpy(output->dim, input->dim, sizeof(output->dim));
+            return CSINN_TRUE;
+        default:
+            return CSINN_FALSE;
+    }
+}
+
+static int shape_find_plan(struct shl_ref_graph *g, struct shl_gref_shapes *shapes,
+                           struct csinn_tensor **inputs)
+{
+    for (int p = 0; p < shapes->plan_num; p++) {
+        bool match = true;
+        for (int i = 0; i < g->input_num && match; i++) {
+            match = shape_equal(&shapes->plan[p].input[i], inputs[i]);
+        }
+        if (match) {
+            return p;
+        }
+    }
+    return -1;
+}
+
+/* a free plan, or the least recently used one that is not installed */
+static int shape_take_plan(struct shl_ref_graph *g, struct shl_gref_shapes *shapes)
+{
+    if (shapes->plan_num < SHAPE_PLAN_NUM) {
+        shape_plan_alloc(g, shapes, &shapes->plan[shapes->plan_num]);
+        return shapes->plan_num++;
+    }
+    int lru = -1;
+    for (int p = 0; p < shapes->plan_num; p++) {
+        if (p != shapes->current &&
+            (lru < 0 || shapes->plan[p].last_used < shapes->plan[lru].last_used)) {
+            lru = p;
+        }
+    }
+    shape_plan_free_kernels(g, &shapes->plan[lru]);
+    return lru;
+}
+
+static struct shl_gref_shapes *shape_init(struct shl_ref_graph *g)
+{
+    struct shl_gref_shapes *shapes = shl_mem_alloc(sizeof(struct shl_gref_shapes));
+    for (int i = 0; i < g->layer_index; i++) {
+        shapes->tensor_num += g->layer[i]->out_num;
+    }
+    /* the shape of setup is the first plan */
+    shape_plan_alloc(g, shapes, &shapes->plan[0]);
+    shape_plan_capture(g, &shapes->plan[0]);
+    shapes->plan_num = 1;
+    return shapes;
+}
+
+/*
+ * Change the shapes of the graph inputs to the dims of inputs, one tensor
+ * per input, after csinn_session_setup. Later runs take inputs of the new
+ * shapes and csinn_get_output reports the new output shapes.
+ */
+int shl_gref_session_resize_input(struct csinn_session *sess, struct csinn_tensor **inputs)
+{
+    struct shl_gref_target_data *td = sess->td;
+    struct shl_ref_graph *g = td->graph;
+    if (td->async != NULL || td->stream != NULL || td->tiling != NULL) {
+        shl_debug_error("%s: not available with asynchronous, streaming or tiled runs\n",
+                        __func__);
+        return CSINN_FALSE;
+    }
+    if (td->layout != NULL) {
+        shl_debug_error("%s: graphs rewritten by the layout pass keep their shapes\n", __func__);
+        return CSINN_FALSE;
+    }
+    if (td->shapes == NULL) {
+        for (int i = 0; i < g->layer_index; i++) {
+            if (g->layer[i]->type == CSINN_SUBGRAPH) {
+                shl_debug_error("%s: graphs with subgraphs keep their shapes\n", __func__);
+                return CSINN_FALSE;
+            }
+        }
+        td->shapes = shape_init(g);
+    }
+    struct shl_gref_shapes *shapes = td->shapes;
+
+    int p = shape_find_plan(g, shapes, inputs);
+    if (p >= 0) {
+        if (p != shapes->current) {
+            shape_plan_install(g, &shapes->plan[p]);
+            shapes->current = p;
+        }
+        shapes->plan[p].last_used = ++shapes->tick;
+        return CSINN_TRUE;
+    }
+
+    for (int i = 0; i < g->input_num; i++) {
+        struct csinn_tensor *t = g->input[i]->data;
+        t->dim_count = inputs[i]->dim_count;
+        memcpy(t->dim, inputs[i]->dim, sizeof(t->dim));
+    }
+    for (int i = 0; i < g->layer_index; i++) {
+        struct shl_node *n = g->layer[i];
+        if (shape_infer(n) != CSINN_TRUE) {
+            shl_debug_error("%s: cannot infer the output shape of %s\n", __func__, n->name);
+            shape_plan_install(g, &shapes->plan[shapes->current]);
+            return CSINN_FALSE;
+        }
+    }
+
+    p = shape_take_plan(g, shapes);
+    for (int i = 0; i < g->layer_index; i++) {
+        struct shl_node *n = g->layer[i];
+        if (shape_reselect(n)) {
+            /* the transformed kernel of the old shape stays with its plan */
+            struct csinn_conv2d_params *params = n->data;
+            params->conv_extra.kernel_tm = NULL;
+            params->conv_extra.conv_mode = CSINN_DIRECT;
+            shl_gref_init_op(n);
+        }
+    }
+    shape_plan_capture(g, &shapes->plan[p]);
+    shapes->plan[p].last_used = ++shapes->tick;
+    shapes->current = p;
+    shl_debug_info("[resize]: new plan %d of %d\n", p, SHAPE_PLAN_NUM);
+
+    /* per layer counters hold the bytes of the old shapes */
+    if (td->counters != NULL) {
+        shl_gref_session_set_counters(sess, false);
+        shl_gref_session_set_counters(sess, true);
+    }
+    return CSINN_TRUE;
+}
+
+void shl_gref_shapes_free(struct csinn_session *sess)
+{
+    struct shl_gref_target_data *td = sess->td;
+    struct shl_gref_shapes *shapes = td->shapes;
+    if (shapes == NULL) {
+        return;
+    }
+    for (int p = 0; p < shapes->plan_num; p++) {
+        /* the installed kernels stay with the layers, as without resizing */
+        if (p != shapes->current) {
+            shape_plan_free_kernels(td->graph, &shapes->plan[p]);
+        }
+        shape_plan_free(&shapes->plan[p]);
+    }
+    shl_mem_free(shapes);
+    td->shapes = NULL;
+}
@@ -0,0 +1,600 @@
+/*
+ * Copyright (C) 2016-2022 T-Head Semiconductor Co., Ltd. All rights reserved.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* CSI-NN2 version 2.0.x */
+
+#include "shl_gref.h"
+#include "shl_ref.h"
+
+/*
+ * Layout propagation. Some reference kernels only exist for NHWC and their
+ * NCHW path transposes the operands around the NHWC kernel, so a chain of
+ * them converts every intermediate tensor twice. Layers that run natively
+ * in both layouts tie their operands to one layout; each group of tied
+ * tensors takes the layout that needs fewer conversions at its border, and
+ * a tensor read in both layouts gets one transpose layer shared by all its
+ * readers. Graph inputs and outputs keep their NCHW layout.
+ */
+
+enum layout_class {
+    LAYOUT_FIXED = 0,  // NCHW only, or unknown to the pass
+    LAYOUT_ANY,        // native in both layouts, operands share one layout
+    LAYOUT_NHWC,       // the NCHW path converts to NHWC and back around the kernel
+};
+
+struct layout_tensor {
+    struct shl_node *node;
+    int parent;      // union-find over tensors tied by LAYOUT_ANY layers
+    bool need_nchw;  // touched by an NCHW only layer, or a graph input or output
+    bool need_nhwc;  // touched by a layer with an NHWC only kernel
+};
+
+struct layout_insert {
+    int after;  // index of the producer in the graph, -1 for graph inputs
+    struct shl_node *layer;
+};
+
+struct layout_ctx {
+    struct csinn_session *sess;
+    struct shl_gref_layout *layout;
+    struct shl_ref_graph *g;
+    int *cls;    // per layer
+    bool *nhwc;  // per layer, runs in NHWC after the pass
+    struct layout_tensor *tensor;
+    int tensor_num;
+    struct layout_insert *insert;
+    int insert_num;
+};
+
+static void *layout_own(struct shl_gref_layout *layout, void *ptr)
+{
+    if (layout->owned_num % 64 == 0) {
+        void **owned = shl_mem_alloc((layout->owned_num + 64) * sizeof(void *));
+        memcpy(owned, layout->owned, layout->owned_num * sizeof(void *));
+        shl_mem_free(layout->owned);
+        layout->owned = owned;
+    }
+    layout->owned[layout->owned_num++] = ptr;
+    return ptr;
+}
+
+static void layout_own_tensor(struct shl_gref_layout *layout, struct csinn_tensor *t)
+{
+    if (layout->tensor_num % 64 == 0) {
+        struct csinn_tensor **tensor =
+            shl_mem_alloc((layout->tensor_num + 64) * sizeof(struct csinn_tensor *));
+        memcpy(tensor, layout->tensor, layout->tensor_num * sizeof(struct csinn_tensor *));
+        shl_mem_free(layout->tensor);
+        layout->tensor = tensor;
+    }
+    layout->tensor[layout->tensor_num++] = t;
+}
+
+static bool layout_activation(struct shl_node *node)
+{
+    struct csinn_tensor *t = node->data;
+    return !t->is_const && t->dim_count == 4 && t->dtype == CSINN_DTYPE_FLOAT32;
+}
+
+/* weights that can be rewritten once at setup */
+static bool layout_const_kernel(struct shl_node *node)
+{
+    struct csinn_tensor *kernel = node->data;
+    return kernel->is_const && kernel->data != NULL && kernel->dim_count == 4 &&
+           kernel->dtype == CSINN_DTYPE_FLOAT32 && !shl_ref_is_sparse_weight(kernel);
+}
+
+static bool layout_same_dims(struct csinn_tensor *a, struct csinn_tensor *b)
+{
+    return a->dim_count == b->dim_count && memcmp(a->dim, b->dim, a->dim_count * 4) == 0;
+}
+
+/* class of a layer, and the conversions its NCHW path runs per call */
+static int layout_class(struct shl_node *n, int *cost)
+{
+    struct csinn_params_base *base = n->data;
+    *cost = 0;
+    if (base->api != CSINN_REF || n->in_num < 1 || n->out_num != 1 ||
+        !layout_activation(n->in[0]) || !layout_activation(n->out[0])) {
+        return LAYOUT_FIXED;
+    }
+    switch (n->type) {
+        case CSINN_OP_CONV2D: {
+            struct csinn_conv2d_params *params = n->data;
+            if (base->layout != CSINN_LAYOUT_NCHW || params->group != 1 ||
+                !layout_const_kernel(n->in[1])) {
+                return LAYOUT_FIXED;
+            }
+            /* winograd transforms the kernel for either layout */
+            if (shl_ref_conv2d_winograd_support(n->in[0]->data, n->in[1]->data, params)) {
+                return LAYOUT_ANY;
+            }
+#ifdef SHL_AVX_OPT
+            /* the AVX implicit GEMM path is NCHW */
+            return LAYOUT_FIXED;
+#else
+            /* input, kernel and output in, output back */
+            *cost = 4;
+            return LAYOUT_NHWC;
+#endif
+        }
+        case CSINN_OP_DEPTHWISE_CONV2D: {
+            struct csinn_tensor *kernel = n->in[1]->data;
+            if (base->layout != CSINN_LAYOUT_NCHW || !layout_const_kernel(n->in[1]) ||
+                kernel->dim[1] != 1) {
+                return LAYOUT_FIXED;
+            }
+            return LAYOUT_ANY;
+        }
+        case CSINN_OP_AVGPOOL2D:
+        case CSINN_OP_MAXPOOL2D:
+        case CSINN_OP_GLOBAL_AVGPOOL2D:
+        case CSINN_OP_GLOBAL_MAXPOOL2D:
+            return base->layout == CSINN_LAYOUT_NCHW ? LAYOUT_ANY : LAYOUT_FIXED;
+        case CSINN_OP_RESIZE: {
+            struct csinn_resize_params *params = n->data;
+            if (base->layout != CSINN_LAYOUT_NCHW ||
+                (params->resize_mode != CSINN_RESIZE_BILINEAR &&
+                 params->resize_mode != CSINN_RESIZE_NEAREST_NEIGHBOR)) {
+                return LAYOUT_FIXED;
+            }
+            /* input and output in, output back */
+            *cost = 3;
+            return LAYOUT_NHWC;
+        }
+        case CSINN_OP_SHUFFLE_CHANNEL:
+            if (base->layout != CSINN_LAYOUT_NCHW) {
+                return LAYOUT_FIXED;
+            }
+            *cost = 3;
+            return LAYOUT_NHWC;
+        case CSINN_OP_CLIP:
+        case CSINN_OP_ELU:
+        case CSINN_OP_HARD_SIGMOID:
+        case CSINN_OP_LEAKY_RELU:
+        case CSINN_OP_RELU:
+        case CSINN_OP_RELU1:
+        case CSINN_OP_RELU6:
+        case CSINN_OP_SIGMOID:
+        case CSINN_OP_TANH:
+            return n->in_num == 1 ? LAYOUT_ANY : LAYOUT_FIXED;
+        case CSINN_OP_ADD:
+        case CSINN_OP_SUB:
+        case CSINN_OP_MUL:
+        case CSINN_OP_DIV:
+        case CSINN_OP_MAXIMUM:
+        case CSINN_OP_MINIMUM:
+            /* elementwise without broadcasting */
+            if (n->in_num != 2 || !layout_activation(n->in[1]) ||
+                !layout_same_dims(n->in[0]->data, n->in[1]->data) ||
+                !layout_same_dims(n->in[0]->data, n->out[0]->data)) {
+                return LAYOUT_FIXED;
+            }
+            return LAYOUT_ANY;
+        default:
+            return LAYOUT_FIXED;
+    }
+}
+
+/* input j of n follows the layout of the layer, rather than being a weight */
+static bool layout_operand(struct shl_node *n, int j)
+{
+    if (n->type == CSINN_OP_CONV2D || n->type == CSINN_OP_DEPTHWISE_CONV2D) {
+        return j == 0;
+    }
+    return layout_activation(n->in[j]);
+}
+
+static int layout_find(struct layout_ctx *ctx, struct shl_node *node)
+{
+    for (int i = 0; i < ctx->tensor_num; i++) {
+        if (ctx->tensor[i].node == node) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static int layout_add(struct layout_ctx *ctx, struct shl_node *node)
+{
+    int id = layout_find(ctx, node);
+    if (id < 0) {
+        id = ctx->tensor_num++;
+        ctx->tensor[id].node = node;
+        ctx->tensor[id].parent = id;
+    }
+    return id;
+}
+
+static int layout_root(struct layout_ctx *ctx, int id)
+{
+    while (ctx->tensor[id].parent != id) {
+        ctx->tensor[id].parent = ctx->tensor[ctx->tensor[id].parent].parent;
+        id = ctx->tensor[id].parent;
+    }
+    return id;
+}
+
+static int layout_layer_index(struct shl_ref_graph *g, struct shl_node *layer)
+{
+    for (int i = 0; i < g->layer_index; i++) {
+        if (g->layer[i] == layer) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static bool layout_is_output(struct shl_ref_graph *g, struct shl_node *node)
+{
+    for (int i = 0; i < g->output_num; i++) {
+        if (g->output[i] == node) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void layout_dims_to_nhwc(struct csinn_tensor *t)
+{
+    int32_t c = t->dim[1];
+    t->dim[1] = t->dim[2];
+    t->dim[2] = t->dim[3];
+    t->dim[3] = c;
+    t->layout = CSINN_LAYOUT_NHWC;
+}
+
+static char *layout_name(struct shl_gref_layout *layout, const char *name, const char *suffix)
+{
+    if (name == NULL) {
+        name = "layout";
+    }
+    int size = strlen(name) + strlen(suffix) + 2;
+    char *ret = layout_own(layout, shl_mem_alloc(size));
+    snprintf(ret, size, "%s_%s", name, suffix);
+    return ret;
+}
+
+/* an NHWC copy of an NCHW activation tensor node */
+static struct shl_node *layout_nhwc_tensor(struct layout_ctx *ctx, struct shl_node *node)
+{
+    struct csinn_tensor *t = node->data;
+    struct csinn_tensor *alt = csinn_alloc_tensor(ctx->sess);
+    csinn_tensor_copy(alt, t);
+    alt->name = layout_name(ctx->layout, t->name, "nhwc");
+    layout_dims_to_nhwc(alt);
+    struct shl_node *alt_node = shl_node_var_alloc(alt->name, alt);
+    alt->data = alt_node;
+    layout_own_tensor(ctx->layout, alt);
+    return alt_node;
+}
+
+static void layout_add_transpose(struct layout_ctx *ctx, struct shl_node *from,
+                                 struct shl_node *to, bool to_nhwc, int after)
+{
+    struct csinn_transpose_params *params =
+        csinn_alloc_params(sizeof(struct csinn_transpose_params), ctx->sess);
+    int32_t *permute = layout_own(ctx->layout, shl_mem_alloc(4 * sizeof(int32_t)));
+    permute[0] = 0;
+    permute[1] = to_nhwc ? 2 : 3;
+    permute[2] = to_nhwc ? 3 : 1;
+    permute[3] = to_nhwc ? 1 : 2;
+    params->permute = permute;
+    params->permute_num = 4;
+    params->base.api = CSINN_REF;
+    params->base.layout = to_nhwc ? CSINN_LAYOUT_NHWC : CSINN_LAYOUT_NCHW;
+    params->base.name = ((struct csinn_tensor *)to->data)->name;
+
+    struct shl_node *layer = shl_node_alloc(CSINN_OP_TRANSPOSE, params->base.name, 1, 1, params);
+    shl_node_add_in(layer, from, 0);
+    shl_node_add_out(layer, to, 0);
+    ctx->insert[ctx->insert_num].after = after;
+    ctx->insert[ctx->insert_num].layer = layer;
+    ctx->insert_num++;
+}
+
+/*
+ * Store a tensor in the layout of its producer. Readers wanting the other
+ * layout share one transpose; the original node always ends up NCHW when
+ * anything reads it as NCHW, so graph outputs keep their tensors.
+ */
+static void layout_place_tensor(struct layout_ctx *ctx, struct shl_node *node)
+{
+    struct shl_ref_graph *g = ctx->g;
+    struct shl_node *producer = node->in_num == 1 ? node->in[0] : NULL;
+    int p = producer != NULL ? layout_layer_index(g, producer) : -1;
+    bool stored_nhwc = p >= 0 && ctx->nhwc[p];
+    bool read_nchw = layout_is_output(g, node);
+    bool read_nhwc = false;
+    for (int i = 0; i < g->layer_index; i++) {
+        struct shl_node *n = g->layer[i];
+        for (int j = 0; j < n->in_num; j++) {
+            if (n->in[j] == node) {
+                bool nhwc = ctx->nhwc[i] && layout_operand(n, j);
+                read_nhwc |= nhwc;
+                read_nchw |= !nhwc;
+            }
+        }
+    }
+
+    if (stored_nhwc && !read_nchw) {
+        layout_dims_to_nhwc(node->data);
+        return;
+    }
+    if (!stored_nhwc && !read_nhwc) {
+        return;
+    }
+    struct shl_node *alt = layout_nhwc_tensor(ctx, node);
+    for (int i = 0; i < g->layer_index; i++) {
+        struct shl_node *n = g->layer[i];
+        for (int j = 0; j < n->in_num; j++) {
+            if (n->in[j] == node && ctx->nhwc[i] && layout_operand(n, j)) {
+                shl_node_add_in(n, alt, j);
+            }
+        }
+    }
+    if (stored_nhwc) {
+        for (int k = 0; k < producer->out_num; k++) {
+            if (producer->out[k] == node) {
+                shl_node_add_out(producer, alt, k);
+            }
+        }
+        layout_add_transpose(ctx, alt, node, false, p);
+    } else {
+        layout_add_transpose(ctx, node, alt, true, p);
+    }
+}
+
+/* OIHW to OHWI, or O1HW to 1HWO for depthwise kernels, into a new const node */
+static struct shl_node *layout_kernel(struct layout_ctx *ctx, struct shl_node *node,
+                                      bool depthwise)
+{
+    struct csinn_tensor *kernel = node->data;
+    struct csinn_tensor *t = csinn_alloc_tensor(ctx->sess);
+    csinn_tensor_copy(t, kernel);
+    int out_c = kernel->dim[0];
+    int in_c = kernel->dim[1];
+    int h = kernel->dim[2];
+    int w = kernel->dim[3];
+    float *src = kernel->data;
+    float *dst = layout_own(ctx->layout, shl_mem_alloc(csinn_tensor_byte_size(kernel)));
+    for (int o = 0; o < out_c; o++) {
+        for (int i = 0; i < in_c; i++) {
+            for (int y = 0; y < h; y++) {
+                for (int x = 0; x < w; x++) {
+                    float v = src[((o * in_c + i) * h + y) * w + x];
+                    if (depthwise) {
+                        dst[(y * w + x) * out_c + o] = v;
+                    } else {
+                        dst[((o * h + y) * w + x) * in_c + i] = v;
+                    }
+                }
+            }
+        }
+    }
+    if (depthwise) {
+        t->dim[0] = 1;
+        t->dim[3] = out_c;
+        t->layout = CSINN_LAYOUT_1HWO;
+    } else {
+        t->dim[3] = in_c;
+        t->layout = CSINN_LAYOUT_OHWI;
+    }
+    t->dim[1] = h;
+    t->dim[2] = w;
+    t->data = dst;
+    layout_own_tensor(ctx->layout, t);
+    ctx->layout->stats.kernels++;
+    return shl_node_const_var_alloc(t->name, t);
+}
+
+static void layout_switch_layer(struct layout_ctx *ctx, struct shl_node *n)
+{
+    struct csinn_params_base *base = n->data;
+    base->layout = CSINN_LAYOUT_NHWC;
+    if (n->type == CSINN_OP_CONV2D || n->type == CSINN_OP_DEPTHWISE_CONV2D) {
+        shl_node_add_in(n, layout_kernel(ctx, n->in[1], n->type == CSINN_OP_DEPTHWISE_CONV2D), 1);
+    }
+    ctx->layout->stats.nhwc_layers++;
+}
+
+/* pick the layout of every group and of every layer */
+static void layout_choose(struct layout_ctx *ctx)
+{
+    struct shl_ref_graph *g = ctx->g;
+    for (int i = 0; i < g->layer_index; i++) {
+        struct shl_node *n = g->layer[i];
+        for (int j = 0; j < n->in_num + n->out_num; j++) {
+            struct shl_node *node = j < n->in_num ? n->in[j] : n->out[j - n->in_num];
+            int id = layout_find(ctx, node);
+            if (id < 0) {
+                continue;
+            }
+            bool operand = j >= n->in_num || layout_operand(n, j);
+            if (ctx->cls[i] == LAYOUT_FIXED || !operand) {
+                ctx->tensor[id].need_nchw = true;
+            } else if (ctx->cls[i] == LAYOUT_NHWC) {
+                ctx->tensor[id].need_nhwc = true;
+            }
+        }
+    }
+    for (int i = 0; i < g->input_num + g->output_num; i++) {
+        struct shl_node *node = i < g->input_num ? g->input[i] : g->output[i - g->input_num];
+        int id = layout_find(ctx, node);
+        if (id >= 0) {
+            ctx->tensor[id].need_nchw = true;
+        }
+    }
+
+    /* a group goes NHWC when fewer of its tensors then need a transpose */
+    int *vote = shl_mem_alloc(ctx->tensor_num * sizeof(int));
+    for (int t = 0; t < ctx->tensor_num; t++) {
+        int r = layout_root(ctx, t);
+        vote[r] += ctx->tensor[t].need_nhwc;
+        vote[r] -= ctx->tensor[t].need_nchw;
+    }
+    for (int i = 0; i < g->layer_index; i++) {
+        struct shl_node *n = g->layer[i];
+        if (ctx->cls[i] == LAYOUT_ANY) {
+            ctx->nhwc[i] = vote[layout_root(ctx, layout_find(ctx, n->out[0]))] > 0;
+        } else if (ctx->cls[i] == LAYOUT_NHWC) {
+            /* at most one transpose per operand, fewer than its NCHW path runs */
+            ctx->nhwc[i] = true;
+        }
+    }
+    shl_mem_free(vote);
+}
+
+/* splice the transposes in after their producers, graph input ones first */
+static void layout_insert_layers(struct layout_ctx *ctx)
+{
+    struct shl_ref_graph *g = ctx->g;
+    int size = g->layer_size + ctx->insert_num;
+    struct shl_node **layer = shl_mem_alloc(size * sizeof(struct shl_node *));
+    int count = 0;
+    for (int i = -1; i < g->layer_index; i++) {
+        if (i >= 0) {
+            layer[count++] = g->layer[i];
+        }
+        for (int k = 0; k < ctx->insert_num; k++) {
+            if (ctx->insert[k].after == i) {
+                layer[count++] = ctx->insert[k].layer;
+            }
+        }
+    }
+    shl_mem_free(g->layer);
+    g->layer = layer;
+    g->layer_size = size;
+    g->layer_index = count;
+}
+
+/*
+ * Run by csinn_session_setup before the layers are initialized, when the
+ * pass is enabled with csinn_session_set_layout_opt.
+ */
+int shl_gref_layout_opt(struct csinn_session *sess)
+{
+    struct shl_gref_target_data *td = sess->td;
+    struct shl_ref_graph *g = td->graph;
+    struct layout_ctx ctx = {0};
+    ctx.sess = sess;
+    ctx.layout = td->layout;
+    ctx.g = g;
+    ctx.cls = shl_mem_alloc(g->layer_index * sizeof(int));
+    ctx.nhwc = shl_mem_alloc(g->layer_index * sizeof(bool));
+    int operand_num = 0;
+    for (int i = 0; i < g->layer_index; i++) {
+        operand_num += g->layer[i]->in_num + g->layer[i]->out_num;
+    }
+    ctx.tensor = shl_mem_alloc(operand_num * sizeof(struct layout_tensor));
+    ctx.insert = shl_mem_alloc(operand_num * sizeof(struct layout_insert));
+
+    struct csinn_layout_stats *stats = &td->layout->stats;
+    memset(stats, 0, sizeof(struct csinn_layout_stats));
+    for (int i = 0; i < g->layer_index; i++) {
+        struct shl_node *n = g->layer[i];
+        int cost = 0;
+        ctx.cls[i] = n->type == CSINN_SUBGRAPH ? LAYOUT_FIXED : layout_class(n, &cost);
+        if (ctx.cls[i] == LAYOUT_FIXED) {
+            continue;
+        }
+        stats->conversions_before += cost;
+        int out = layout_add(&ctx, n->out[0]);
+        for (int j = 0; j < n->in_num; j++) {
+            if (!layout_operand(n, j)) {
+                continue;
+            }
+            int in = layout_add(&ctx, n->in[j]);
+            if (ctx.cls[i] == LAYOUT_ANY) {
+                ctx.tensor[layout_root(&ctx, in)].parent = layout_root(&ctx, out);
+            }
+        }
+    }
+
+    if (stats->conversions_before > 0) {
+        layout_choose(&ctx);
+        for (int t = 0; t < ctx.tensor_num; t++) {
+            layout_place_tensor(&ctx, ctx.tensor[t].node);
+        }
+        for (int i = 0; i < g->layer_index; i++) {
+            if (ctx.nhwc[i]) {
+                layout_switch_layer(&ctx, g->layer[i]);
+            }
+        }
+        layout_insert_layers(&ctx);
+    }
+    stats->transposes = ctx.insert_num;
+    stats->conversions_after = ctx.insert_num;
+    stats->conversions_removed = stats->conversions_before - stats->conversions_after;
+    td->layout->applied = true;
+    shl_debug_info("[layout]: %d layers in NHWC, %d transposes, %d of %d conversions removed\n",
+                   stats->nhwc_layers, stats->transposes, stats->conversions_removed,
+                   stats->conversions_before);
+
+    shl_mem_free(ctx.cls);
+    shl_mem_free(ctx.nhwc);
+    shl_mem_free(ctx.tensor);
+    shl_mem_free(ctx.insert);
+    return CSINN_TRUE;
+}
+
+/* enable or disable the layout pass of csinn_session_setup, before setup */
+int shl_gref_session_set_layout_opt(struct csinn_session *sess, bool enable)
+{
+    struct shl_gref_target_data *td = sess->td;
+    if (td->layout != NULL && td->layout->applied) {
+        shl_debug_error("%s: the graph was already rewritten by setup\n", __func__);
+        return CSINN_FALSE;
+    }
+    if (enable && td->layout == NULL) {
+        td->layout = shl_mem_alloc(sizeof(struct shl_gref_layout));
+    } else if (!enable && td->layout != NULL) {
+        shl_mem_free(td->layout);
+        td->layout = NULL;
+    }
+    return CSINN_TRUE;
+}
+
+int shl_gref_session_layout_stats(struct csinn_session *sess, struct csinn_layout_stats *stats)
+{
+    struct shl_gref_target_data *td = sess->td;
+    if (td->layout == NULL || !td->layout->applied) {
+        return CSINN_FALSE;
+    }
+    *stats = td->layout->stats;
+    return CSINN_TRUE;
+}
+
+void shl_gref_layout_free(struct csinn_session *sess)
+{
+    struct shl_gref_target_data *td = sess->td;
+    struct shl_gref_layout *layout = td->layout;
+    if (layout == NULL) {
+        return;
+    }
+    for (int i = 0; i < layout->owned_num; i++) {
+        shl_mem_free(layout->owned[i]);
+    }
+    for (int i = 0; i < layout->tensor_num; i++) {
+        csinn_free_tensor(layout->tensor[i]);
+    }
+    shl_mem_free(layout->owned);
+    shl_mem_free(layout->tensor);
+    shl_mem_free(layout);
+    td->layout = NULL;
+}
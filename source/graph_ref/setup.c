@@ -19,6 +19,7 @@
 /* CSI-NN2 version 2.0.x */
 
 #include "shl_gref.h"
+#include "shl_ref.h"
 
 void shl_gref_set_output_number(int number, struct csinn_session *sess)
 {
@@ -183,6 +184,7 @@ static int call_layer_func(void *fn, struct shl_node *node)
         case CSINN_OP_TRUNC:
         case CSINN_OP_UNPOOLING:
         case CSINN_OP_UNSTACK:
+        case CSINN_OP_YUV_PREPROCESS:
         case CSINN_OP_YUV_RGB_SCALE:
             ret = func(node->in[0]->data, node->out[0]->data, params);
             break;
@@ -259,6 +261,10 @@ static int call_layer_func(void *fn, struct shl_node *node)
             ret = func(node->in[0]->data, node->in[1]->data, node->in[2]->data, node->in[3]->data,
                        node->in[4]->data, node->out[0]->data, params);
             break;
+        case CSINN_OP_ATTENTION:
+            ret = func(node->in[0]->data, node->in[1]->data, node->in[2]->data,
+                       node->in_num > 3 ? node->in[3]->data : NULL, node->out[0]->data, params);
+            break;
         case CSINN_OP_CONCAT:
             inputs = shl_mem_alloc(sizeof(struct csinn_tensor *) *
                                    ((struct csinn_concat_params *)params)->inputs_count);
@@ -361,7 +367,7 @@ static struct shl_ref_graph *transform_graph(struct shl_ref_graph *ograph)
     return ggraph;
 }
 
-static int init_op(struct shl_node *node)
+int shl_gref_init_op(struct shl_node *node)
 {
     /* base has same address with params */
     struct csinn_params_base *params = node->data;
@@ -457,8 +463,20 @@ static struct shl_ref_graph *convert_graph(struct shl_ref_graph *ograph)
 void shl_gref_session_setup(struct csinn_session *sess)
 {
     struct shl_ref_graph *graph = shl_gref_get_graph(sess);
+    struct shl_gref_target_data *td = sess->td;
     struct shl_node *n;
 
+    /*
+     * only the reference backend has an attention kernel, other targets would trade their own
+     * matmul/softmax kernels for the scalar reference one through the shl_cb_map_ref fallback
+     */
+    if (sess->base_api == CSINN_REF) {
+        shl_gref_fuse_attention(graph);
+    }
+    if (td->layout != NULL) {
+        shl_gref_layout_opt(sess);
+    }
+
     for (int i = 0; i < graph->layer_index; i++) {
         n = graph->layer[i];
         for (int j = 0; j < n->in_num; j++) {
@@ -482,13 +500,12 @@ void shl_gref_session_setup(struct csinn_session *sess)
         if (n->type == CSINN_SUBGRAPH) {
             shl_subgraph_setup(n);
         } else if (n->type >= 0 && n->type < CSINN_OP_SIZE) {
-            init_op(n);
+            shl_gref_init_op(n);
         } else {
             shl_debug_error("Unknown layer\n");
             return;
         }
     }
-    struct shl_gref_target_data *td = sess->td;
     td->graph = ggraph;
 }
 
@@ -524,11 +541,18 @@ static int op_run_deinit(struct shl_node *node)
             if (node->in[i]->ref_count == 0) {
                 struct csinn_tensor *t = node->in[i]->data;
                 shl_mem_free(t->data);
+                t->data = NULL;
             }
         }
     }
     for (int i = 0; i < node->out_num; i++) {
         node->out[i]->ref_count--;
+        /* neither consumed nor a graph output */
+        if (node->out[i]->ref_count == 0) {
+            struct csinn_tensor *t = node->out[i]->data;
+            shl_mem_free(t->data);
+            t->data = NULL;
+        }
     }
     return CSINN_TRUE;
 }
@@ -543,19 +567,953 @@ static int op_run(struct shl_node *node)
     return call_layer_func(func, node);
 }
 
+static bool stream_is_stateful_op(struct shl_node *node)
+{
+    return node->type == CSINN_OP_CACHE_MATMUL || node->type == CSINN_OP_CACHE_CONV1D ||
+           node->type == CSINN_OP_FSMN;
+}
+
+/*
+ * Classify layers and pin every intermediate buffer for streaming mode.
+ * A layer is static when all of its inputs are constants or outputs of
+ * other static layers, so its result is the same for every chunk. Stateful
+ * layers (cache_matmul, cache_conv1d, fsmn) are never static.
+ */
+static int stream_build(struct shl_ref_graph *g, struct shl_gref_stream *stream)
+{
+    for (int i = 0; i < g->layer_index; i++) {
+        if (g->layer[i]->type == CSINN_SUBGRAPH) {
+            shl_debug_error("%s: streaming mode does not support subgraphs\n", __func__);
+            return CSINN_FALSE;
+        }
+    }
+
+    stream->is_static = shl_mem_alloc(g->layer_index * sizeof(bool));
+    stream->static_ready = false;
+    stream->stats.static_layers = 0;
+    stream->stats.stream_layers = 0;
+    for (int i = 0; i < g->layer_index; i++) {
+        struct shl_node *n = g->layer[i];
+        bool is_static = !stream_is_stateful_op(n);
+        for (int j = 0; j < n->in_num && is_static; j++) {
+            if (n->in[j] == NULL) continue;
+            struct csinn_tensor *t = n->in[j]->data;
+            if (t->is_const) continue;
+            /* graph inputs have no producer */
+            int producer = shl_node_find(g->layer, i, n->in[j]->in[0]);
+            is_static = producer >= 0 && stream->is_static[producer];
+        }
+        stream->is_static[i] = is_static;
+        if (is_static) {
+            stream->stats.static_layers++;
+        } else {
+            stream->stats.stream_layers++;
+        }
+
+        for (int k = 0; k < n->out_num; k++) {
+            struct csinn_tensor *t = n->out[k]->data;
+            t->data = shl_mem_alloc(csinn_tensor_byte_size(t));
+        }
+    }
+    return CSINN_TRUE;
+}
+
+static void stream_free(struct shl_ref_graph *g, struct shl_gref_stream *stream)
+{
+    if (stream->is_static != NULL) {
+        for (int i = 0; i < g->layer_index; i++) {
+            struct shl_node *n = g->layer[i];
+            for (int k = 0; k < n->out_num; k++) {
+                struct csinn_tensor *t = n->out[k]->data;
+                shl_mem_free(t->data);
+                t->data = NULL;
+            }
+        }
+        shl_mem_free(stream->is_static);
+    }
+    shl_mem_free(stream);
+}
+
+/*
+ * Run one chunk: no output (re)allocation and no reference counting, the
+ * pinned buffers and the per-layer state are carried over to the next call.
+ */
+static int stream_run(struct csinn_session *sess, struct shl_gref_stream *stream)
+{
+    struct shl_ref_graph *g = shl_gref_get_graph(sess);
+    if (stream->is_static == NULL && stream_build(g, stream) != CSINN_TRUE) {
+        return CSINN_FALSE;
+    }
+
+    uint64_t start_time = shl_get_timespec();
+    for (int i = 0; i < g->layer_index; i++) {
+        struct shl_node *n = g->layer[i];
+        if (stream->is_static[i] && stream->static_ready) {
+            continue;
+        }
+        if (op_run(n) != CSINN_TRUE) {
+            return CSINN_FALSE;
+        }
+    }
+    stream->static_ready = true;
+    uint64_t chunk_time = shl_get_timespec() - start_time;
+
+    struct csinn_stream_stats *stats = &stream->stats;
+    if (stats->chunk_count == 0) {
+        stats->first_chunk_time = chunk_time;
+        stats->min_chunk_time = chunk_time;
+        stats->max_chunk_time = chunk_time;
+    }
+    stats->chunk_count++;
+    stats->last_chunk_time = chunk_time;
+    stats->total_time += chunk_time;
+    if (chunk_time < stats->min_chunk_time) stats->min_chunk_time = chunk_time;
+    if (chunk_time > stats->max_chunk_time) stats->max_chunk_time = chunk_time;
+    shl_debug_info("[stream]: chunk %d exec time = %f\n", stats->chunk_count,
+                   chunk_time / 1000000.0f);
+    return CSINN_TRUE;
+}
+
+int shl_gref_session_set_stream(struct csinn_session *sess, bool enable)
+{
+    struct shl_gref_target_data *td = sess->td;
+    if (td->stream != NULL) {
+        stream_free(td->graph, td->stream);
+        td->stream = NULL;
+    }
+    if (enable && td->counters != NULL) {
+        shl_debug_error("%s: streaming excludes counters\n", __func__);
+        return CSINN_FALSE;
+    }
+    if (enable) {
+        td->stream = shl_mem_alloc(sizeof(struct shl_gref_stream));
+    }
+    return CSINN_TRUE;
+}
+
+/*
+ * Start a new stream: clear the state of stateful layers and the latency
+ * statistics. Results of static layers only depend on constants and are kept.
+ */
+int shl_gref_session_stream_reset(struct csinn_session *sess)
+{
+    struct shl_gref_target_data *td = sess->td;
+    struct shl_gref_stream *stream = td->stream;
+    if (stream == NULL) {
+        return CSINN_FALSE;
+    }
+
+    struct shl_ref_graph *g = td->graph;
+    for (int i = 0; i < g->layer_index; i++) {
+        struct shl_node *n = g->layer[i];
+        struct csinn_asr_buffer_t *buffer = NULL;
+        if (n->type == CSINN_OP_CACHE_MATMUL) {
+            buffer = &((struct csinn_cache_matmul_params *)n->data)->asr_buffer;
+        } else if (n->type == CSINN_OP_CACHE_CONV1D) {
+            buffer = &((struct csinn_cache_conv1d_params *)n->data)->asr_buffer;
+        } else if (n->type == CSINN_OP_FSMN) {
+            /* frame_sequence and frame_counter are updated in place */
+            for (int j = 3; j <= 4; j++) {
+                struct csinn_tensor *t = n->in[j]->data;
+                memset(t->data, 0, csinn_tensor_byte_size(t));
+            }
+        }
+        if (buffer != NULL && buffer->buffer != NULL) {
+            memset(buffer->buffer, 0, buffer->buffer_lenth);
+            buffer->writer_index = buffer->buffer_lenth - buffer->data_lenth;
+            buffer->flag = 0;
+        }
+    }
+
+    int32_t static_layers = stream->stats.static_layers;
+    int32_t stream_layers = stream->stats.stream_layers;
+    memset(&stream->stats, 0, sizeof(struct csinn_stream_stats));
+    stream->stats.static_layers = static_layers;
+    stream->stats.stream_layers = stream_layers;
+    return CSINN_TRUE;
+}
+
+int shl_gref_session_stream_stats(struct csinn_session *sess, struct csinn_stream_stats *stats)
+{
+    struct shl_gref_target_data *td = sess->td;
+    if (td->stream == NULL) {
+        return CSINN_FALSE;
+    }
+    *stats = td->stream->stats;
+    return CSINN_TRUE;
+}
+
+/*
+ * Depth-first tiling: chains of spatially local layers run band by band
+ * along the output height of the last layer, so the intermediate feature
+ * maps of a chain only ever exist as bands of a few rows. Each band pulls
+ * the rows it needs, including the halo of every window, back through the
+ * chain; halo rows are recomputed by neighbouring bands.
+ */
+#define TILING_BAND_BYTES (512 * 1024)
+#define TILING_MIN_ROWS 8
+
+enum tiling_kind {
+    TILING_NONE = 0,
+    TILING_WINDOW,     // conv or pool, reads a window of input rows
+    TILING_POINTWISE,  // output row y only reads input row y
+};
+
+static int tiling_kind(struct shl_node *n)
+{
+    switch (n->type) {
+        case CSINN_OP_CONV2D:
+        case CSINN_OP_CONV2D_RELU:
+        case CSINN_OP_CONV2D_RELU6:
+        case CSINN_OP_DEPTHWISE_CONV2D:
+        case CSINN_OP_DEPTHWISE_CONV2D_RELU:
+        case CSINN_OP_DEPTHWISE_CONV2D_RELU6:
+        case CSINN_OP_GROUP_CONV2D:
+        case CSINN_OP_GROUP_CONV2D_RELU:
+        case CSINN_OP_GROUP_CONV2D_RELU6:
+        case CSINN_OP_AVGPOOL2D:
+        case CSINN_OP_MAXPOOL2D:
+            return TILING_WINDOW;
+        case CSINN_OP_ADD:
+        case CSINN_OP_SUB:
+        case CSINN_OP_MUL:
+        case CSINN_OP_DIV:
+        case CSINN_OP_MAXIMUM:
+        case CSINN_OP_MINIMUM:
+        case CSINN_OP_BN:
+        case CSINN_OP_CLIP:
+        case CSINN_OP_ELU:
+        case CSINN_OP_HARD_SIGMOID:
+        case CSINN_OP_LEAKY_RELU:
+        case CSINN_OP_PRELU:
+        case CSINN_OP_RELU:
+        case CSINN_OP_RELU1:
+        case CSINN_OP_RELU6:
+        case CSINN_OP_SIGMOID:
+        case CSINN_OP_TANH:
+            return TILING_POINTWISE;
+        default:
+            return TILING_NONE;
+    }
+}
+
+/* output row y reads input rows [y * stride - *pad_top, y * stride - *pad_top + extent) */
+static void tiling_window(struct shl_node *n, int *extent, int *stride, int32_t **pad_top,
+                          int32_t **pad_down)
+{
+    *extent = 1;
+    *stride = 1;
+    *pad_top = NULL;
+    *pad_down = NULL;
+    if (tiling_kind(n) != TILING_WINDOW) {
+        return;
+    }
+    if (n->type == CSINN_OP_AVGPOOL2D || n->type == CSINN_OP_MAXPOOL2D) {
+        struct csinn_pool_params *params = n->data;
+        *extent = params->filter_height;
+        *stride = params->stride_height;
+        *pad_top = &params->pad_top;
+        *pad_down = &params->pad_down;
+    } else {
+        struct csinn_conv2d_params *params = n->data;
+        struct csinn_tensor *kernel = n->in[1]->data;
+        *extent = (kernel->dim[2] - 1) * params->dilation_height + 1;
+        *stride = params->stride_height;
+        *pad_top = &params->pad_top;
+        *pad_down = &params->pad_down;
+    }
+}
+
+static bool tiling_same_shape(struct csinn_tensor *a, struct csinn_tensor *b)
+{
+    if (a->dim_count != b->dim_count) {
+        return false;
+    }
+    for (int i = 0; i < a->dim_count; i++) {
+        if (a->dim[i] != b->dim[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* bytes of one row of one image of an NCHW tensor, over all channels */
+static int64_t tiling_row_bytes(struct csinn_tensor *t)
+{
+    return csinn_tensor_byte_size(t) / ((int64_t)t->dim[0] * t->dim[2]);
+}
+
+/*
+ * Operand j of a chain layer: the band of the previous layer (primary),
+ * a full tensor cut into the same band as the output (banded), or a
+ * tensor without a height axis that is passed through.
+ */
+enum tiling_operand {
+    TILING_PASS = 0,
+    TILING_PRIMARY,
+    TILING_BANDED,
+};
+
+static int tiling_operand(struct shl_node *n, int j, struct shl_node *primary)
+{
+    if (n->in[j] == NULL) {
+        return TILING_PASS;
+    }
+    if (n->in[j] == primary) {
+        return TILING_PRIMARY;
+    }
+    if (tiling_kind(n) == TILING_POINTWISE) {
+        struct csinn_tensor *t = n->in[j]->data;
+        struct csinn_tensor *output = n->out[0]->data;
+        if (tiling_same_shape(t, output)) {
+            return TILING_BANDED;
+        }
+    }
+    return TILING_PASS;
+}
+
+/* whether n can run on bands of its primary input */
+static bool tiling_layer_supported(struct shl_node *n, struct shl_node *primary)
+{
+    if (tiling_kind(n) == TILING_NONE || n->out_num != 1 || primary == NULL) {
+        return false;
+    }
+    struct csinn_tensor *input = primary->data;
+    struct csinn_tensor *output = n->out[0]->data;
+    if (input->dim_count != 4 || output->dim_count != 4 || input->dim[0] != output->dim[0] ||
+        output->dim[2] <= 0 || input->dim[2] <= 0 ||
+        csinn_tensor_byte_size(input) % ((int64_t)input->dim[0] * input->dim[2]) != 0) {
+        return false;
+    }
+    if (tiling_kind(n) == TILING_POINTWISE && !tiling_same_shape(input, output)) {
+        return false;
+    }
+    /* bands are cut along dim 2, the height of NCHW tensors */
+    if (input->layout == CSINN_LAYOUT_NHWC || output->layout == CSINN_LAYOUT_NHWC) {
+        return false;
+    }
+    bool has_primary = false;
+    for (int j = 0; j < n->in_num; j++) {
+        int operand = tiling_operand(n, j, primary);
+        has_primary |= operand == TILING_PRIMARY;
+        if (operand != TILING_PASS || tiling_kind(n) != TILING_POINTWISE) {
+            continue;
+        }
+        /* passed through operands must broadcast along the batch and the height */
+        struct csinn_tensor *t = n->in[j]->data;
+        if ((t->dim_count >= 2 && t->dim[t->dim_count - 2] != 1) ||
+            (t->dim_count == 4 && t->dim[0] != 1)) {
+            return false;
+        }
+    }
+    return has_primary;
+}
+
+/*
+ * Walk a band of output rows [y0, y1) of the last layer back through the
+ * group: out[k] is the band of rows produced by layer k and in[k] the band
+ * of its primary input, with pad[k] the padding left at the real borders.
+ */
+struct tiling_band {
+    int out0, out1;
+    int in0, in1;
+    int pad_top, pad_down;
+};
+
+static void tiling_bands(struct shl_ref_graph *g, struct shl_gref_tile_group *grp, int y0, int y1,
+                         struct tiling_band *band)
+{
+    for (int k = grp->count - 1; k >= 0; k--) {
+        struct shl_node *n = g->layer[grp->first + k];
+        struct shl_node *primary = k == 0 ? n->in[0] : g->layer[grp->first + k - 1]->out[0];
+        struct csinn_tensor *input = primary->data;
+        int extent, stride;
+        int32_t *pad_top, *pad_down;
+        tiling_window(n, &extent, &stride, &pad_top, &pad_down);
+
+        band[k].out0 = y0;
+        band[k].out1 = y1;
+        int start = y0 * stride - (pad_top ? *pad_top : 0);
+        int end = (y1 - 1) * stride - (pad_top ? *pad_top : 0) + extent;
+        band[k].in0 = start > 0 ? start : 0;
+        band[k].in1 = end < input->dim[2] ? end : input->dim[2];
+        if (band[k].in1 < band[k].in0) {
+            band[k].in1 = band[k].in0;
+        }
+        band[k].pad_top = band[k].in0 - start;
+        band[k].pad_down = end - band[k].in1;
+        y0 = band[k].in0;
+        y1 = band[k].in1;
+    }
+}
+
+/* band buffers needed by one tile of rows output rows, at the largest tile */
+static int64_t tiling_band_bytes(struct shl_ref_graph *g, struct shl_gref_tile_group *grp, int rows,
+                                 int *max_in, int *max_out)
+{
+    struct shl_node *last = g->layer[grp->first + grp->count - 1];
+    int height = ((struct csinn_tensor *)last->out[0]->data)->dim[2];
+    struct tiling_band *band = shl_mem_alloc(grp->count * sizeof(struct tiling_band));
+    for (int k = 0; k < grp->count; k++) {
+        max_in[k] = 0;
+        max_out[k] = 0;
+    }
+    for (int y0 = 0; y0 < height; y0 += rows) {
+        tiling_bands(g, grp, y0, y0 + rows < height ? y0 + rows : height, band);
+        for (int k = 0; k < grp->count; k++) {
+            int in_rows = band[k].in1 - band[k].in0;
+            int out_rows = band[k].out1 - band[k].out0;
+            max_in[k] = in_rows > max_in[k] ? in_rows : max_in[k];
+            max_out[k] = out_rows > max_out[k] ? out_rows : max_out[k];
+        }
+    }
+    shl_mem_free(band);
+
+    struct shl_node *first = g->layer[grp->first];
+    int64_t bytes = tiling_row_bytes(first->in[0]->data) * max_in[0];
+    for (int k = 0; k < grp->count; k++) {
+        struct shl_node *n = g->layer[grp->first + k];
+        struct shl_node *primary = k == 0 ? n->in[0] : g->layer[grp->first + k - 1]->out[0];
+        /* pointwise layers run in place on the band of their primary input */
+        if (tiling_kind(n) != TILING_POINTWISE) {
+            bytes += tiling_row_bytes(n->out[0]->data) * max_out[k];
+        }
+        for (int j = 0; j < n->in_num; j++) {
+            if (tiling_operand(n, j, primary) == TILING_BANDED) {
+                bytes += tiling_row_bytes(n->in[j]->data) * max_out[k];
+            }
+        }
+    }
+    return bytes;
+}
+
+/*
+ * Estimated peak bytes of the buffers the runtime allocates for layer outputs, computed from
+ * the tensor sizes with the same reference counting as shl_gref_session_run. With tiled set,
+ * the intermediates of a group only exist as band buffers while the group runs.
+ */
+static int64_t tiling_peak_bytes(struct csinn_session *sess, struct shl_gref_tiling *tiling,
+                                 bool tiled)
+{
+    struct shl_ref_graph *g = shl_gref_get_graph(sess);
+    int64_t live = 0;
+    int64_t peak = 0;
+    int gi = 0;
+    node_ref_reset(sess);
+    for (int i = 0; i < g->layer_index;) {
+        struct shl_gref_tile_group *grp = NULL;
+        if (tiled && gi < tiling->group_num && tiling->group[gi].first == i) {
+            grp = &tiling->group[gi++];
+        }
+        int count = grp ? grp->count : 1;
+        struct shl_node *last = g->layer[i + count - 1];
+        for (int k = 0; k < last->out_num; k++) {
+            live += csinn_tensor_byte_size(last->out[k]->data);
+        }
+        int64_t busy = live + (grp ? grp->tile_bytes : 0);
+        peak = busy > peak ? busy : peak;
+
+        for (int k = 0; k < count; k++) {
+            struct shl_node *n = g->layer[i + k];
+            for (int j = 0; j < n->in_num; j++) {
+                if (n->in[j] == NULL || n->in[j]->ref_count <= 0) continue;
+                n->in[j]->ref_count--;
+                bool banded = grp && k > 0 && n->in[j] == g->layer[i + k - 1]->out[0];
+                if (n->in[j]->ref_count == 0 && !banded) {
+                    live -= csinn_tensor_byte_size(n->in[j]->data);
+                }
+            }
+            for (int j = 0; j < n->out_num; j++) {
+                n->out[j]->ref_count--;
+            }
+        }
+        i += count;
+    }
+    node_ref_reset(sess);
+    return peak;
+}
+
+/* group consecutive supported layers whose intermediate results have a single consumer */
+static int tiling_plan(struct csinn_session *sess, struct shl_gref_tiling *tiling)
+{
+    struct shl_ref_graph *g = shl_gref_get_graph(sess);
+    for (int i = 0; i < g->layer_index; i++) {
+        if (g->layer[i]->type == CSINN_SUBGRAPH) {
+            shl_debug_error("%s: tiling mode does not support subgraphs\n", __func__);
+            return CSINN_FALSE;
+        }
+    }
+
+    tiling->group = shl_mem_alloc(g->layer_index * sizeof(struct shl_gref_tile_group));
+    tiling->group_num = 0;
+    memset(&tiling->stats, 0, sizeof(struct csinn_tiling_stats));
+    int *max_in = shl_mem_alloc(g->layer_index * sizeof(int));
+    int *max_out = shl_mem_alloc(g->layer_index * sizeof(int));
+
+    for (int i = 0; i < g->layer_index && sess->base_layout == CSINN_LAYOUT_NCHW;) {
+        int count = 0;
+        struct shl_node *primary = g->layer[i]->in_num > 0 ? g->layer[i]->in[0] : NULL;
+        while (i + count < g->layer_index &&
+               tiling_layer_supported(g->layer[i + count], primary)) {
+            primary = g->layer[i + count]->out[0];
+            count++;
+            /* the next layer must be the only reader of this result */
+            if (primary->ref_count_init != 2) {
+                break;
+            }
+        }
+        if (count < 2) {
+            i += count > 0 ? count : 1;
+            continue;
+        }
+
+        /* the longest part of the chain whose bands fit the budget at the smallest tile */
+        struct shl_gref_tile_group *grp = &tiling->group[tiling->group_num];
+        grp->first = i;
+        int fit = 0;
+        for (grp->count = 2; grp->count <= count; grp->count++) {
+            struct csinn_tensor *output = g->layer[i + grp->count - 1]->out[0]->data;
+            int rows = output->dim[2] < TILING_MIN_ROWS ? output->dim[2] : TILING_MIN_ROWS;
+            if (tiling_band_bytes(g, grp, rows, max_in, max_out) > TILING_BAND_BYTES) {
+                break;
+            }
+            fit = grp->count;
+        }
+        if (fit == 0) {
+            i++;
+            continue;
+        }
+        count = fit;
+        grp->count = count;
+        struct csinn_tensor *output = g->layer[i + count - 1]->out[0]->data;
+        int height = output->dim[2];
+        int rows = height;
+        grp->tile_bytes = tiling_band_bytes(g, grp, rows, max_in, max_out);
+        while (rows > TILING_MIN_ROWS && grp->tile_bytes > TILING_BAND_BYTES) {
+            rows--;
+            grp->tile_bytes = tiling_band_bytes(g, grp, rows, max_in, max_out);
+        }
+        grp->tile_rows = rows;
+        i += count;
+        /* a single band would only add copies */
+        if (rows >= height) {
+            continue;
+        }
+        tiling->group_num++;
+        tiling->stats.groups++;
+        tiling->stats.fused_layers += count;
+        tiling->stats.tiles += output->dim[0] * ((height + rows - 1) / rows);
+        shl_debug_info("[tiling]: %s .. %s, %d layers, %d rows per tile, %ld band bytes\n",
+                       g->layer[i - count]->name, g->layer[i - 1]->name, count, rows,
+                       (long)grp->tile_bytes);
+    }
+    shl_mem_free(max_in);
+    shl_mem_free(max_out);
+
+    tiling->stats.peak_bytes = tiling_peak_bytes(sess, tiling, true);
+    tiling->stats.layer_peak_bytes = tiling_peak_bytes(sess, tiling, false);
+    tiling->planned = true;
+    return CSINN_TRUE;
+}
+
+/* copy rows [row0, row1) of every channel of image b between an NCHW tensor and a band */
+static void tiling_copy_rows(struct csinn_tensor *t, void *band, int b, int row0, int row1,
+                             bool to_band)
+{
+    int64_t row_bytes = tiling_row_bytes(t) / t->dim[1];
+    int64_t band_bytes = (row1 - row0) * row_bytes;
+    for (int64_t c = 0; c < t->dim[1]; c++) {
+        int64_t p = (int64_t)b * t->dim[1] + c;
+        char *full = (char *)t->data + (p * t->dim[2] + row0) * row_bytes;
+        char *part = (char *)band + c * band_bytes;
+        if (to_band) {
+            memcpy(part, full, band_bytes);
+        } else {
+            memcpy(full, part, band_bytes);
+        }
+    }
+}
+
+/*
+ * A tile only points a tensor at its band and rewrites the batch and height,
+ * dim[0] and dim[2]; tiling is limited to NCHW, where dim[2] is the height.
+ * The view saves and restores just those fields.
+ */
+struct tiling_view {
+    void *data;
+    int32_t batch;
+    int32_t height;
+};
+
+static void tiling_view_save(struct csinn_tensor *t, struct tiling_view *view)
+{
+    view->data = t->data;
+    view->batch = t->dim[0];
+    view->height = t->dim[2];
+}
+
+static void tiling_view_restore(struct csinn_tensor *t, struct tiling_view *view)
+{
+    t->data = view->data;
+    t->dim[0] = view->batch;
+    t->dim[2] = view->height;
+}
+
+static void tiling_run_group(struct shl_ref_graph *g, struct shl_gref_tile_group *grp)
+{
+    int count = grp->count;
+    struct shl_node *first = g->layer[grp->first];
+    struct shl_node *last = g->layer[grp->first + count - 1];
+    struct csinn_tensor *group_input = first->in[0]->data;
+    struct csinn_tensor *group_output = last->out[0]->data;
+    int height = group_output->dim[2];
+
+    int *max_in = shl_mem_alloc(count * sizeof(int));
+    int *max_out = shl_mem_alloc(count * sizeof(int));
+    tiling_band_bytes(g, grp, grp->tile_rows, max_in, max_out);
+    struct tiling_band *band = shl_mem_alloc(count * sizeof(struct tiling_band));
+
+    /* band of the group input, then per layer its output band and banded operands */
+    char *arena = shl_mem_alloc(grp->tile_bytes);
+    char *in_band = arena;
+    char **out_band = shl_mem_alloc(count * sizeof(char *));
+    char **operand_band = shl_mem_alloc(count * sizeof(char *));
+    int max_in_num = 0;
+    char *cur = in_band + tiling_row_bytes(group_input) * max_in[0];
+    for (int k = 0; k < count; k++) {
+        struct shl_node *n = g->layer[grp->first + k];
+        struct shl_node *primary = k == 0 ? n->in[0] : g->layer[grp->first + k - 1]->out[0];
+        if (tiling_kind(n) == TILING_POINTWISE) {
+            out_band[k] = k == 0 ? in_band : out_band[k - 1];
+        } else {
+            out_band[k] = cur;
+            cur += tiling_row_bytes(n->out[0]->data) * max_out[k];
+        }
+        operand_band[k] = cur;
+        for (int j = 0; j < n->in_num; j++) {
+            if (tiling_operand(n, j, primary) == TILING_BANDED) {
+                cur += tiling_row_bytes(n->in[j]->data) * max_out[k];
+            }
+        }
+        max_in_num = n->in_num > max_in_num ? n->in_num : max_in_num;
+    }
+    int *operand = shl_mem_alloc(max_in_num * sizeof(int));
+    struct tiling_view *saved = shl_mem_alloc(max_in_num * sizeof(struct tiling_view));
+
+    /* one image at a time, tile tensors have a batch of 1 */
+    int image_tiles = (height + grp->tile_rows - 1) / grp->tile_rows;
+    for (int tile = 0; tile < group_output->dim[0] * image_tiles; tile++) {
+        int b = tile / image_tiles;
+        int y0 = tile % image_tiles * grp->tile_rows;
+        int y1 = y0 + grp->tile_rows < height ? y0 + grp->tile_rows : height;
+        tiling_bands(g, grp, y0, y1, band);
+        tiling_copy_rows(group_input, in_band, b, band[0].in0, band[0].in1, true);
+
+        for (int k = 0; k < count; k++) {
+            struct shl_node *n = g->layer[grp->first + k];
+            struct shl_node *primary = k == 0 ? n->in[0] : g->layer[grp->first + k - 1]->out[0];
+            struct csinn_tensor *output = n->out[0]->data;
+            struct tiling_view saved_output;
+            tiling_view_save(output, &saved_output);
+
+            /* classify before any shape is changed */
+            for (int j = 0; j < n->in_num; j++) {
+                operand[j] = tiling_operand(n, j, primary);
+            }
+            char *next = operand_band[k];
+            for (int j = 0; j < n->in_num; j++) {
+                if (operand[j] == TILING_PASS) continue;
+                struct csinn_tensor *t = n->in[j]->data;
+                tiling_view_save(t, &saved[j]);
+                if (operand[j] == TILING_PRIMARY) {
+                    t->dim[0] = 1;
+                    t->dim[2] = band[k].in1 - band[k].in0;
+                    t->data = k == 0 ? in_band : out_band[k - 1];
+                } else {
+                    tiling_copy_rows(t, next, b, band[k].out0, band[k].out1, true);
+                    t->dim[0] = 1;
+                    t->dim[2] = band[k].out1 - band[k].out0;
+                    t->data = next;
+                    next += tiling_row_bytes(t) * max_out[k];
+                }
+            }
+            output->dim[0] = 1;
+            output->dim[2] = band[k].out1 - band[k].out0;
+            output->data = out_band[k];
+
+            int extent, stride;
+            int32_t *pad_top, *pad_down;
+            tiling_window(n, &extent, &stride, &pad_top, &pad_down);
+            int32_t saved_pad_top = pad_top ? *pad_top : 0;
+            int32_t saved_pad_down = pad_down ? *pad_down : 0;
+            if (pad_top != NULL) {
+                *pad_top = band[k].pad_top;
+                *pad_down = band[k].pad_down;
+            }
+
+            op_run(n);
+
+            if (pad_top != NULL) {
+                *pad_top = saved_pad_top;
+                *pad_down = saved_pad_down;
+            }
+            tiling_view_restore(output, &saved_output);
+            for (int j = n->in_num - 1; j >= 0; j--) {
+                if (operand[j] != TILING_PASS) {
+                    tiling_view_restore(n->in[j]->data, &saved[j]);
+                }
+            }
+        }
+        tiling_copy_rows(group_output, out_band[count - 1], b, y0, y1, false);
+    }
+
+    /* intermediates never own a full buffer, keep op_run_deinit from freeing stale pointers */
+    for (int k = 0; k < count - 1; k++) {
+        struct csinn_tensor *t = g->layer[grp->first + k]->out[0]->data;
+        t->data = NULL;
+    }
+    shl_mem_free(arena);
+    shl_mem_free(out_band);
+    shl_mem_free(operand_band);
+    shl_mem_free(operand);
+    shl_mem_free(saved);
+    shl_mem_free(band);
+    shl_mem_free(max_in);
+    shl_mem_free(max_out);
+}
+
+static int tiling_run(struct csinn_session *sess, struct shl_gref_tiling *tiling)
+{
+    struct shl_ref_graph *g = shl_gref_get_graph(sess);
+    if (!tiling->planned && tiling_plan(sess, tiling) != CSINN_TRUE) {
+        return CSINN_FALSE;
+    }
+
+    uint64_t start_time = shl_get_timespec();
+    node_ref_reset(sess);
+    int gi = 0;
+    for (int i = 0; i < g->layer_index;) {
+        struct shl_node *n = g->layer[i];
+        if (gi < tiling->group_num && tiling->group[gi].first == i) {
+            struct shl_gref_tile_group *grp = &tiling->group[gi++];
+            op_run_init(g->layer[i + grp->count - 1]);
+            tiling_run_group(g, grp);
+            for (int k = 0; k < grp->count; k++) {
+                op_run_deinit(g->layer[i + k]);
+            }
+            i += grp->count;
+            continue;
+        }
+        op_run_init(n);
+        op_run(n);
+        op_run_deinit(n);
+        i++;
+    }
+
+    struct csinn_tiling_stats *stats = &tiling->stats;
+    stats->last_run_time = shl_get_timespec() - start_time;
+    stats->run_count++;
+    shl_debug_info("[tiling]: exec time = %f, estimated peak activation %ld bytes "
+                   "(layer by layer %ld)\n", stats->last_run_time / 1000000.0f,
+                   (long)stats->peak_bytes, (long)stats->layer_peak_bytes);
+    return CSINN_TRUE;
+}
+
+static void tiling_free(struct shl_gref_tiling *tiling)
+{
+    shl_mem_free(tiling->group);
+    shl_mem_free(tiling);
+}
+
+int shl_gref_session_set_tiling(struct csinn_session *sess, bool enable)
+{
+    struct shl_gref_target_data *td = sess->td;
+    if (td->tiling != NULL) {
+        tiling_free(td->tiling);
+        td->tiling = NULL;
+    }
+    if (enable && td->counters != NULL) {
+        shl_debug_error("%s: tiling excludes counters\n", __func__);
+        return CSINN_FALSE;
+    }
+    if (enable) {
+        td->tiling = shl_mem_alloc(sizeof(struct shl_gref_tiling));
+    }
+    return CSINN_TRUE;
+}
+
+int shl_gref_session_tiling_stats(struct csinn_session *sess, struct csinn_tiling_stats *stats)
+{
+    struct shl_gref_target_data *td = sess->td;
+    if (td->tiling == NULL || !td->tiling->planned) {
+        return CSINN_FALSE;
+    }
+    *stats = td->tiling->stats;
+    return CSINN_TRUE;
+}
+
+/*
+ * Per node counters: each node run by shl_gref_session_run is bracketed by
+ * perf counter and clock reads, subgraph nodes are measured as a whole.
+ * LLC misses are reported per KB of tensor data the node touches, a node
+ * near 16 misses per KB (64 byte lines) streams everything from DRAM.
+ */
+static void counters_free(struct shl_gref_counters *counters)
+{
+    if (counters->pc != NULL) {
+        shl_perf_counters_close(counters->pc);
+    }
+    shl_mem_free(counters->stats.layer);
+    shl_mem_free(counters);
+}
+
+static int64_t counters_node_bytes(struct shl_node *n)
+{
+    int64_t bytes = 0;
+    for (int i = 0; i < n->in_num; i++) {
+        if (n->in[i] != NULL) {
+            bytes += csinn_tensor_byte_size(n->in[i]->data);
+        }
+    }
+    for (int i = 0; i < n->out_num; i++) {
+        bytes += csinn_tensor_byte_size(n->out[i]->data);
+    }
+    return bytes;
+}
+
+static void counters_build(struct shl_ref_graph *g, struct shl_gref_counters *counters)
+{
+    struct csinn_counter_stats *stats = &counters->stats;
+    stats->layer_num = g->layer_index;
+    stats->layer = shl_mem_alloc(g->layer_index * sizeof(struct csinn_layer_counters));
+    for (int i = 0; i < g->layer_index; i++) {
+        struct shl_node *n = g->layer[i];
+        stats->layer[i].name = n->name;
+        stats->layer[i].op = n->type;
+        stats->layer[i].bytes = counters_node_bytes(n);
+    }
+}
+
+/* counters are read before the clock on entry and after it on exit */
+static void counters_start(struct shl_gref_counters *counters, uint64_t *start)
+{
+    if (counters->pc != NULL) {
+        shl_perf_counters_read(counters->pc, start);
+    }
+    start[CSINN_COUNTER_SIZE] = shl_get_timespec();
+}
+
+static void counters_stop(struct shl_gref_counters *counters, int index, uint64_t *start)
+{
+    uint64_t end[CSINN_COUNTER_SIZE];
+    uint64_t end_time = shl_get_timespec();
+    struct csinn_layer_counters *layer = &counters->stats.layer[index];
+    layer->time += end_time - start[CSINN_COUNTER_SIZE];
+    if (counters->pc != NULL) {
+        shl_perf_counters_read(counters->pc, end);
+        for (int i = 0; i < CSINN_COUNTER_SIZE; i++) {
+            layer->value[i] += end[i] - start[i];
+        }
+    }
+}
+
+static void counters_report(struct shl_gref_counters *counters)
+{
+    struct csinn_counter_stats *stats = &counters->stats;
+    if (shl_debug_get_level() > CSINN_DEBUG_LEVEL_INFO) {
+        return;
+    }
+    for (int i = 0; i < stats->layer_num; i++) {
+        struct csinn_layer_counters *layer = &stats->layer[i];
+        shl_debug_info("[counters]: [%3d] %-24s %8.3fms", i, layer->name ? layer->name : "",
+                       layer->time / 1000000.0f / stats->run_count);
+        uint64_t *v = layer->value;
+        if (stats->events & (1 << CSINN_COUNTER_CYCLES) &&
+            stats->events & (1 << CSINN_COUNTER_INSTRUCTIONS)) {
+            float cycles = v[CSINN_COUNTER_CYCLES] > 0 ? v[CSINN_COUNTER_CYCLES] : 1;
+            shl_debug_info("  IPC %5.2f", v[CSINN_COUNTER_INSTRUCTIONS] / cycles);
+        }
+        float kbytes = (float)layer->bytes * stats->run_count / 1024;
+        if (stats->events & (1 << CSINN_COUNTER_LLC_MISSES) && kbytes > 0) {
+            shl_debug_info("  LLC miss/KB %7.2f", v[CSINN_COUNTER_LLC_MISSES] / kbytes);
+        }
+        if (stats->events & (1 << CSINN_COUNTER_BRANCH_MISSES) && kbytes > 0) {
+            shl_debug_info("  branch miss/KB %7.2f", v[CSINN_COUNTER_BRANCH_MISSES] / kbytes);
+        }
+        shl_debug_info("\n");
+    }
+}
+
+int shl_gref_session_set_counters(struct csinn_session *sess, bool enable)
+{
+    struct shl_gref_target_data *td = sess->td;
+    if (td->counters != NULL) {
+        counters_free(td->counters);
+        td->counters = NULL;
+    }
+    if (!enable) {
+        return CSINN_TRUE;
+    }
+    /* only the layer by layer run of shl_gref_session_run is instrumented */
+    if (td->stream != NULL || td->tiling != NULL || shl_gref_session_pipelined(sess)) {
+        shl_debug_error("%s: counters exclude streaming, tiling and pipelining\n", __func__);
+        return CSINN_FALSE;
+    }
+    td->counters = shl_mem_alloc(sizeof(struct shl_gref_counters));
+    td->counters->pc = shl_perf_counters_open();
+    if (td->counters->pc == NULL) {
+        shl_debug_warning("[counters]: perf_event_open is unavailable, wall time only\n");
+    } else {
+        td->counters->stats.events = td->counters->pc->events;
+    }
+    return CSINN_TRUE;
+}
+
+int shl_gref_session_counter_stats(struct csinn_session *sess, struct csinn_counter_stats *stats)
+{
+    struct shl_gref_target_data *td = sess->td;
+    if (td->counters == NULL || td->counters->stats.run_count == 0) {
+        return CSINN_FALSE;
+    }
+    *stats = td->counters->stats;
+    return CSINN_TRUE;
+}
+
+/* conv inits of the graph layers read sess->tuning when setup initializes them */
+int shl_gref_session_set_tuning(struct csinn_session *sess, bool enable, const char *path)
+{
+    return shl_session_set_tuning(sess, enable, path);
+}
+
 int shl_gref_session_run(struct csinn_session *sess)
 {
+    struct shl_gref_target_data *td = sess->td;
+    if (td->stream != NULL) {
+        return stream_run(sess, td->stream);
+    }
+    if (td->tiling != NULL) {
+        return tiling_run(sess, td->tiling);
+    }
+
     struct shl_ref_graph *g = shl_gref_get_graph(sess);
+    struct shl_gref_counters *counters = td->counters;
+    uint64_t counter_start[CSINN_COUNTER_SIZE + 1];
+    if (counters != NULL && counters->stats.layer == NULL) {
+        counters_build(g, counters);
+    }
     uint64_t time_acc = 0;
     node_ref_reset(sess);
     for (int i = 0; i < g->layer_index; i++) {
         struct shl_node *n = g->layer[i];
         if (n->type == CSINN_SUBGRAPH) {
             shl_subgraph_run_init(n);
+            if (counters != NULL) counters_start(counters, counter_start);
             shl_subgraph_run(n);
+            if (counters != NULL) counters_stop(counters, i, counter_start);
             shl_subgraph_run_deinit(n);
         } else if (n->type >= 0 && n->type < CSINN_OP_SIZE) {
             op_run_init(n);
+            if (counters != NULL) counters_start(counters, counter_start);
 #ifdef SHL_LAYER_BENCHMARK
             uint64_t start_time = shl_get_timespec();
             op_run(n);
@@ -565,6 +1523,7 @@ int shl_gref_session_run(struct csinn_session *sess)
 #else
             op_run(n);
 #endif
+            if (counters != NULL) counters_stop(counters, i, counter_start);
             op_run_deinit(n);
         } else {
             return CSINN_FALSE;
@@ -573,6 +1532,38 @@ int shl_gref_session_run(struct csinn_session *sess)
 #ifdef SHL_LAYER_BENCHMARK
     shl_debug_info("[layer-benchmark]: network exec time = %f\n", time_acc / 1000000.0f);
 #endif
+    if (counters != NULL) {
+        counters->stats.run_count++;
+        counters_report(counters);
+    }
+    return CSINN_TRUE;
+}
+
+/*
+ * Run layers first .. last - 1 of the top level graph, for callers that run
+ * a graph in parts. Reference counts of the outputs are reset as they are
+ * produced, so parts can run in any thread while later parts still read the
+ * previous run.
+ */
+int shl_gref_run_layers(struct shl_ref_graph *g, int first, int last)
+{
+    for (int i = first; i < last; i++) {
+        struct shl_node *n = g->layer[i];
+        if (n->type == CSINN_SUBGRAPH) {
+            shl_subgraph_run_init(n);
+            shl_subgraph_run(n);
+            shl_subgraph_run_deinit(n);
+        } else if (n->type >= 0 && n->type < CSINN_OP_SIZE) {
+            for (int k = 0; k < n->out_num; k++) {
+                n->out[k]->ref_count = n->out[k]->ref_count_init;
+            }
+            op_run_init(n);
+            op_run(n);
+            op_run_deinit(n);
+        } else {
+            return CSINN_FALSE;
+        }
+    }
     return CSINN_TRUE;
 }
 
@@ -603,11 +1594,29 @@ void shl_gref_set_output(int index, struct csinn_tensor *output, struct csinn_se
 void shl_gref_session_deinit(struct csinn_session *sess)
 {
     struct shl_ref_graph *g = shl_gref_get_graph(sess);
+    struct shl_gref_target_data *td = sess->td;
+    shl_gref_session_set_async(sess, 0);
+    shl_gref_shapes_free(sess);
+    shl_gref_layout_free(sess);
+    if (td->stream != NULL) {
+        stream_free(g, td->stream);
+        td->stream = NULL;
+    }
+    if (td->tiling != NULL) {
+        tiling_free(td->tiling);
+        td->tiling = NULL;
+    }
+    if (td->counters != NULL) {
+        counters_free(td->counters);
+        td->counters = NULL;
+    }
 
     for (int i = 0; i < g->layer_index; i++) {
         struct shl_node *n = g->layer[i];
         if (n->type == CSINN_SUBGRAPH) {
             shl_subgraph_deinit(n);
+        } else {
+            shl_ref_op_deinit(n->type, n->data);
         }
     }
     struct shl_ref_graph *graph = shl_gref_get_graph(sess);
@@ -808,6 +1817,7 @@ static void *setup_cb_map()
     cb_map[CSINN_OP_ASINH].est = shl_gref_asinh;
     cb_map[CSINN_OP_ATAN].est = shl_gref_atan;
     cb_map[CSINN_OP_ATANH].est = shl_gref_atanh;
+    cb_map[CSINN_OP_ATTENTION].est = shl_gref_attention;
     cb_map[CSINN_OP_AVGPOOL2D].est = shl_gref_avgpool2d;
     cb_map[CSINN_OP_AVGPOOL3D].est = shl_gref_avgpool3d;
     cb_map[CSINN_OP_BN].est = shl_gref_batch_normalization;
@@ -956,6 +1966,7 @@ static void *setup_cb_map()
     cb_map[CSINN_OP_UNSTACK].est = shl_gref_unstack;
     cb_map[CSINN_OP_WHERE].est = shl_gref_where;
     cb_map[CSINN_OP_XOR].est = shl_gref_xor;
+    cb_map[CSINN_OP_YUV_PREPROCESS].est = shl_gref_yuv_preprocess;
     cb_map[CSINN_OP_YUV_RGB_SCALE].est = shl_gref_yuv_rgb_scale;
 
     return cb_map;
@@ -1011,6 +2022,51 @@ void *shl_gref_runtime_callback(int api)
         case CSINN_TENSOR_ENTRY:
             return shl_gref_set_tensor;
             break;
+        case CSINN_SESSION_SET_STREAM:
+            return shl_gref_session_set_stream;
+            break;
+        case CSINN_SESSION_STREAM_RESET:
+            return shl_gref_session_stream_reset;
+            break;
+        case CSINN_SESSION_STREAM_STATS:
+            return shl_gref_session_stream_stats;
+            break;
+        case CSINN_SESSION_SET_TILING:
+            return shl_gref_session_set_tiling;
+            break;
+        case CSINN_SESSION_TILING_STATS:
+            return shl_gref_session_tiling_stats;
+            break;
+        case CSINN_SESSION_SET_COUNTERS:
+            return shl_gref_session_set_counters;
+            break;
+        case CSINN_SESSION_COUNTER_STATS:
+            return shl_gref_session_counter_stats;
+            break;
+        case CSINN_SESSION_SET_ASYNC:
+            return shl_gref_session_set_async;
+            break;
+        case CSINN_SESSION_SET_PIPELINE:
+            return shl_gref_session_set_pipeline;
+            break;
+        case CSINN_SESSION_RESIZE_INPUT:
+            return shl_gref_session_resize_input;
+            break;
+        case CSINN_SESSION_SET_LAYOUT_OPT:
+            return shl_gref_session_set_layout_opt;
+            break;
+        case CSINN_SESSION_LAYOUT_STATS:
+            return shl_gref_session_layout_stats;
+            break;
+        case CSINN_SESSION_SET_TUNING:
+            return shl_gref_session_set_tuning;
+            break;
+        case CSINN_SESSION_RUN_ASYNC:
+            return shl_gref_session_run_async;
+            break;
+        case CSINN_SESSION_WAIT:
+            return shl_gref_session_wait;
+            break;
         default:
             shl_debug_info("%s: Cannot find callback\n", __func__);
             break;
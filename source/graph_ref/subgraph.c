@@ -252,6 +252,7 @@ int shl_subgraph_setup(struct shl_node *n)
             case CSINN_OP_TRUNC:
             case CSINN_OP_UNPOOLING:
             case CSINN_OP_UNSTACK:
+            case CSINN_OP_YUV_PREPROCESS:
             case CSINN_OP_YUV_RGB_SCALE:
                 output = node->out[0]->data;
                 output->sess = sub_sess;
@@ -0,0 +1,342 @@
+/*
+ * Copyright (C) 2016-2022 T-Head Semiconductor Co., Ltd. All rights reserved.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* CSI-NN2 version 2.0.x */
+
+#include "csi_nn.h"
+#include "shl_utils.h"
+
+#ifndef SHL_BUILD_RTOS
+#include <pthread.h>
+#include <time.h>
+
+/*
+ * Dynamic batching: requests of batch 1 from any number of threads are
+ * stacked along dim 0 into the inputs of a session set up for batch B.
+ * A batch is dispatched when it holds B requests, or when its first request
+ * has waited the latency window. Batches run through the asynchronous
+ * session API, so the next batch fills while the previous one runs, and the
+ * completion callback scatters the output rows back to the requests.
+ */
+struct batcher_request {
+    struct csinn_tensor **outputs;
+    uint64_t arrival_time;
+    int status;
+    bool done;
+};
+
+struct batcher_batch {
+    struct csinn_batcher *batcher;
+    int count;
+    struct batcher_request **request;
+};
+
+struct csinn_batcher {
+    struct csinn_session *sess;
+    int max_batch;
+    uint64_t max_latency;  // nanoseconds
+    int input_num;
+    int output_num;
+    int64_t *input_row;   // bytes of one request per input
+    int64_t *output_row;  // bytes of one request per output
+    /*
+     * Two sets of batched inputs: requests fill the open one while the
+     * dispatcher hands the other to the session, which copies it.
+     */
+    struct csinn_tensor **staging[2];
+    int open;
+    struct batcher_batch *batch;  // requests of the open set
+    uint64_t first_arrival;       // of the open batch
+    struct csinn_batch_stats stats;
+    bool stop;
+    pthread_t dispatcher;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+};
+
+static struct batcher_batch *batcher_new_batch(struct csinn_batcher *b)
+{
+    struct batcher_batch *batch = shl_mem_alloc(sizeof(struct batcher_batch));
+    batch->batcher = b;
+    batch->request = shl_mem_alloc(b->max_batch * sizeof(struct batcher_request *));
+    return batch;
+}
+
+/* completion thread of the session: scatter the rows and wake the requests */
+static void batcher_complete(struct csinn_session *sess, struct csinn_tensor **outputs, int status,
+                             void *user)
+{
+    struct batcher_batch *batch = user;
+    struct csinn_batcher *b = batch->batcher;
+    for (int r = 0; r < batch->count; r++) {
+        struct batcher_request *req = batch->request[r];
+        for (int i = 0; i < b->output_num && status == CSINN_TRUE; i++) {
+            int8_t *src = outputs[i]->data;
+            memcpy(req->outputs[i]->data, src + r * b->output_row[i], b->output_row[i]);
+        }
+    }
+    pthread_mutex_lock(&b->mutex);
+    for (int r = 0; r < batch->count; r++) {
+        batch->request[r]->status = status;
+        batch->request[r]->done = true;
+    }
+    pthread_cond_broadcast(&b->cond);
+    pthread_mutex_unlock(&b->mutex);
+    shl_mem_free(batch->request);
+    shl_mem_free(batch);
+}
+
+static void batcher_deadline(uint64_t first_arrival, uint64_t max_latency, struct timespec *ts)
+{
+    /* shl_get_timespec is monotonic, the condition variable waits on the realtime clock */
+    uint64_t now = shl_get_timespec();
+    uint64_t left = first_arrival + max_latency > now ? first_arrival + max_latency - now : 0;
+    clock_gettime(CLOCK_REALTIME, ts);
+    uint64_t nsec = ts->tv_nsec + left;
+    ts->tv_sec += nsec / 1000000000;
+    ts->tv_nsec = nsec % 1000000000;
+}
+
+static void *batcher_dispatch(void *arg)
+{
+    struct csinn_batcher *b = arg;
+    pthread_mutex_lock(&b->mutex);
+    while (true) {
+        while (!b->stop && b->batch->count == 0) {
+            pthread_cond_wait(&b->cond, &b->mutex);
+        }
+        if (b->batch->count == 0) {
+            break;
+        }
+        /* a partial batch waits out the latency window of its first request */
+        while (!b->stop && b->batch->count < b->max_batch &&
+               shl_get_timespec() < b->first_arrival + b->max_latency) {
+            struct timespec deadline;
+            batcher_deadline(b->first_arrival, b->max_latency, &deadline);
+            pthread_cond_timedwait(&b->cond, &b->mutex, &deadline);
+        }
+
+        struct batcher_batch *batch = b->batch;
+        struct csinn_tensor **inputs = b->staging[b->open];
+        uint64_t now = shl_get_timespec();
+        b->stats.max_wait_time = now - b->first_arrival > b->stats.max_wait_time
+                                     ? now - b->first_arrival
+                                     : b->stats.max_wait_time;
+        b->stats.histogram[batch->count]++;
+        b->stats.run_count++;
+        b->stats.request_count += batch->count;
+        b->batch = batcher_new_batch(b);
+        b->open = 1 - b->open;
+        pthread_cond_broadcast(&b->cond);
+        pthread_mutex_unlock(&b->mutex);
+
+        /* rows past count keep an earlier batch's data, their results are not read */
+        if (csinn_session_run_async(b->sess, inputs, NULL, batcher_complete, batch) !=
+            CSINN_TRUE) {
+            batcher_complete(b->sess, NULL, CSINN_FALSE, batch);
+        }
+
+        pthread_mutex_lock(&b->mutex);
+    }
+    pthread_mutex_unlock(&b->mutex);
+    return NULL;
+}
+
+static void batcher_free_tensors(struct csinn_tensor **t, int num)
+{
+    if (t == NULL) {
+        return;
+    }
+    for (int i = 0; i < num; i++) {
+        shl_mem_free(t[i]->data);
+        csinn_free_tensor(t[i]);
+    }
+    shl_mem_free(t);
+}
+
+static void batcher_free(struct csinn_batcher *b)
+{
+    for (int s = 0; s < 2; s++) {
+        batcher_free_tensors(b->staging[s], b->input_num);
+    }
+    if (b->batch != NULL) {
+        shl_mem_free(b->batch->request);
+        shl_mem_free(b->batch);
+    }
+    shl_mem_free(b->input_row);
+    shl_mem_free(b->output_row);
+    shl_mem_free(b->stats.histogram);
+    shl_mem_free(b);
+}
+
+/*
+ * Put a batching front end on a session set up with batch max_batch, the
+ * dim 0 of every input and output. Requests wait at most max_latency_us
+ * for their batch to fill. The batcher runs the session asynchronously
+ * until it is freed, the session must not be run directly meanwhile.
+ */
+struct csinn_batcher *csinn_alloc_batcher(struct csinn_session *sess, int max_latency_us)
+{
+    struct csinn_batcher *b = shl_mem_alloc(sizeof(struct csinn_batcher));
+    b->sess = sess;
+    b->max_latency = (uint64_t)max_latency_us * 1000;
+    b->input_num = csinn_get_input_number(sess);
+    b->output_num = csinn_get_output_number(sess);
+    b->input_row = shl_mem_alloc(b->input_num * sizeof(int64_t));
+    b->output_row = shl_mem_alloc(b->output_num * sizeof(int64_t));
+
+    struct csinn_tensor *t = csinn_alloc_tensor(NULL);
+    for (int i = 0; i < b->output_num + b->input_num; i++) {
+        bool is_input = i < b->input_num;
+        if (is_input) {
+            csinn_get_input(i, t, sess);
+        } else {
+            csinn_get_output(i - b->input_num, t, sess);
+        }
+        if (i == 0) {
+            b->max_batch = t->dim[0];
+        }
+        if (t->dim_count == 0 || t->dim[0] != b->max_batch) {
+            shl_debug_error("%s: dim 0 of every input and output must be the batch size %d\n",
+                            __func__, b->max_batch);
+            csinn_free_tensor(t);
+            batcher_free(b);
+            return NULL;
+        }
+        int64_t row = csinn_tensor_byte_size(t) / b->max_batch;
+        if (is_input) {
+            b->input_row[i] = row;
+        } else {
+            b->output_row[i - b->input_num] = row;
+        }
+    }
+
+    for (int s = 0; s < 2; s++) {
+        b->staging[s] = shl_mem_alloc(b->input_num * sizeof(struct csinn_tensor *));
+        for (int i = 0; i < b->input_num; i++) {
+            b->staging[s][i] = csinn_alloc_tensor(NULL);
+            csinn_get_input(i, b->staging[s][i], sess);
+            b->staging[s][i]->data = shl_mem_alloc(b->input_row[i] * b->max_batch);
+        }
+    }
+    csinn_free_tensor(t);
+    b->batch = batcher_new_batch(b);
+    b->stats.max_batch = b->max_batch;
+    b->stats.histogram = shl_mem_alloc((b->max_batch + 1) * sizeof(int32_t));
+
+    if (csinn_session_set_async(sess, 2) != CSINN_TRUE) {
+        shl_debug_error("%s: the session does not support asynchronous runs\n", __func__);
+        batcher_free(b);
+        return NULL;
+    }
+    pthread_mutex_init(&b->mutex, NULL);
+    pthread_cond_init(&b->cond, NULL);
+    if (pthread_create(&b->dispatcher, NULL, batcher_dispatch, b) != 0) {
+        shl_debug_error("%s: cannot create the dispatch thread\n", __func__);
+        csinn_session_set_async(sess, 0);
+        pthread_mutex_destroy(&b->mutex);
+        pthread_cond_destroy(&b->cond);
+        batcher_free(b);
+        return NULL;
+    }
+    return b;
+}
+
+/* dispatch the requests still waiting, run them, then release the session */
+void csinn_free_batcher(struct csinn_batcher *b)
+{
+    pthread_mutex_lock(&b->mutex);
+    b->stop = true;
+    pthread_cond_broadcast(&b->cond);
+    pthread_mutex_unlock(&b->mutex);
+    pthread_join(b->dispatcher, NULL);
+    csinn_session_wait(b->sess);
+    csinn_session_set_async(b->sess, 0);
+    pthread_mutex_destroy(&b->mutex);
+    pthread_cond_destroy(&b->cond);
+    batcher_free(b);
+}
+
+/*
+ * Run one request of batch 1, from any thread. Blocks until its batch has
+ * run and the results are in outputs, which the caller allocates.
+ */
+int csinn_batcher_run(struct csinn_batcher *b, struct csinn_tensor **inputs,
+                      struct csinn_tensor **outputs)
+{
+    struct batcher_request req = {0};
+    req.outputs = outputs;
+    req.arrival_time = shl_get_timespec();
+
+    pthread_mutex_lock(&b->mutex);
+    if (b->stop) {
+        pthread_mutex_unlock(&b->mutex);
+        return CSINN_FALSE;
+    }
+    /* requests arriving while the dispatcher drains a full batch wait for the next one */
+    while (b->batch->count == b->max_batch) {
+        pthread_cond_wait(&b->cond, &b->mutex);
+    }
+    struct batcher_batch *batch = b->batch;
+    int row = batch->count;
+    for (int i = 0; i < b->input_num; i++) {
+        int8_t *dst = b->staging[b->open][i]->data;
+        memcpy(dst + row * b->input_row[i], inputs[i]->data, b->input_row[i]);
+    }
+    batch->request[row] = &req;
+    batch->count++;
+    if (row == 0) {
+        b->first_arrival = req.arrival_time;
+    }
+    if (row == 0 || batch->count == b->max_batch) {
+        pthread_cond_broadcast(&b->cond);
+    }
+    while (!req.done) {
+        pthread_cond_wait(&b->cond, &b->mutex);
+    }
+    pthread_mutex_unlock(&b->mutex);
+    return req.status;
+}
+
+/* the histogram stays owned by the batcher */
+int csinn_batcher_stats(struct csinn_batcher *b, struct csinn_batch_stats *stats)
+{
+    pthread_mutex_lock(&b->mutex);
+    *stats = b->stats;
+    pthread_mutex_unlock(&b->mutex);
+    return CSINN_TRUE;
+}
+#else
+struct csinn_batcher *csinn_alloc_batcher(struct csinn_session *sess, int max_latency_us)
+{
+    return NULL;
+}
+
+void csinn_free_batcher(struct csinn_batcher *b) {}
+
+int csinn_batcher_run(struct csinn_batcher *b, struct csinn_tensor **inputs,
+                      struct csinn_tensor **outputs)
+{
+    return CSINN_FALSE;
+}
+
+int csinn_batcher_stats(struct csinn_batcher *b, struct csinn_batch_stats *stats)
+{
+    return CSINN_FALSE;
+}
+#endif
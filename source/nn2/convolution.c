@@ -60,17 +60,26 @@ int csinn_conv2d(struct csinn_tensor *input, struct csinn_tensor *output,
     SHL_DEBUG_CALL(shl_conv2d_debug_info(input, output, kernel, bias, params, __func__));
     int (*func)() = shl_get_p0_cb(&params->base);
     if (func != NULL) {
+        /* winograd kernels read the transformed weights from params->conv_extra.kernel_tm */
+        func(input, output, kernel, bias, params);
+        /* as before, a layer-mode winograd conv drops its transformed kernel after the run */
         struct csinn_callback *cb = params->base.cb;
-        if ((cb->exec == func) && (params->conv_extra.kernel_tm != NULL &&
-                                   params->conv_extra.conv_mode == CSINN_WINOGRAD)) {
-            cb->exec(input, output, params->conv_extra.kernel_tm, bias, params);
-            shl_mem_free(params->conv_extra.kernel_tm->data);
-            csinn_free_tensor(params->conv_extra.kernel_tm);
-        } else {
-            func(input, output, kernel, bias, params);
+        if (cb->exec == func && params->conv_extra.conv_mode == CSINN_WINOGRAD) {
+            csinn_conv2d_deinit(params);
         }
     } else {
         return CSINN_CALLBACK_UNSET;
     }
     return CSINN_TRUE;
 }
+
+/* release the transformed kernel that init attached to params, if no run has dropped it yet */
+void csinn_conv2d_deinit(struct csinn_conv2d_params *params)
+{
+    struct csinn_tensor *kernel_tm = params->conv_extra.kernel_tm;
+    if (kernel_tm != NULL) {
+        shl_mem_free(kernel_tm->data);
+        csinn_free_tensor(kernel_tm);
+        params->conv_extra.kernel_tm = NULL;
+    }
+}
@@ -25,11 +25,15 @@ int csinn_deconv2d_init(struct csinn_tensor *input, struct csinn_tensor *output,
                         struct csinn_tensor *kernel, struct csinn_tensor *bias,
                         struct csinn_conv2d_params *params)
 {
+    int channel_axis = params->base.layout == CSINN_LAYOUT_NHWC ? 3 : 1;
     if (params->group == 1) {
         shl_op_callback_map(&params->base, CSINN_OP_DECONV2D, input->dtype);
-    } else if ((params->group == output->dim[1] && params->base.layout == CSINN_LAYOUT_NCHW) ||
-               (params->group == output->dim[3] && params->base.layout == CSINN_LAYOUT_NHWC)) {
+    } else if (params->group == output->dim[channel_axis]) {
         shl_op_callback_map(&params->base, CSINN_OP_DEPTHWISE_DECONV2D, input->dtype);
+    } else if (params->group > 1 && input->dim[channel_axis] % params->group == 0 &&
+               output->dim[channel_axis] % params->group == 0) {
+        /* group deconvolution shares the deconv2d kernels, which split channels by group */
+        shl_op_callback_map(&params->base, CSINN_OP_DECONV2D, input->dtype);
     } else {
         return CSINN_FALSE;
     }
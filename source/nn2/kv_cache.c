@@ -0,0 +1,265 @@
+/*
+ * Copyright (C) 2016-2022 T-Head Semiconductor Co., Ltd. All rights reserved.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* CSI-NN2 version 2.0.x */
+
+#include "csi_nn.h"
+#include "shl_utils.h"
+
+/* leading positions (product of dims before the sequence axis) and bytes per position */
+static int64_t kv_lead(struct csinn_tensor *t)
+{
+    int64_t lead = 1;
+    for (int i = 0; i < t->dim_count - 2; i++) {
+        lead *= t->dim[i];
+    }
+    return lead;
+}
+
+static int64_t kv_row_bytes(struct csinn_tensor *t)
+{
+    int64_t rows = kv_lead(t) * t->dim[t->dim_count - 2];
+    return rows > 0 ? csinn_tensor_byte_size(t) / rows : 0;
+}
+
+static struct csinn_tensor *kv_storage_alloc(struct csinn_tensor *tmpl, int32_t max_len)
+{
+    struct csinn_tensor *t = csinn_alloc_tensor(NULL);
+    csinn_tensor_copy(t, tmpl);
+    t->dim[t->dim_count - 2] = max_len;
+    t->is_const = 0;
+    t->data = shl_mem_alloc(csinn_tensor_byte_size(t));
+    return t;
+}
+
+static void kv_tensor_free(struct csinn_tensor *t)
+{
+    shl_mem_free(t->data);
+    csinn_free_tensor(t);
+}
+
+static void kv_register(struct csinn_kv_cache *cache, struct csinn_session *sess)
+{
+    cache->sess = sess;
+    if (sess == NULL) {
+        return;
+    }
+    struct csinn_kv_cache **list =
+        shl_mem_alloc((sess->kv_cache_num + 1) * sizeof(struct csinn_kv_cache *));
+    if (sess->kv_cache != NULL) {
+        memcpy(list, sess->kv_cache, sess->kv_cache_num * sizeof(struct csinn_kv_cache *));
+        shl_mem_free(sess->kv_cache);
+    }
+    list[sess->kv_cache_num++] = cache;
+    sess->kv_cache = list;
+}
+
+static bool kv_same_encoding(struct csinn_tensor *a, struct csinn_tensor *b)
+{
+    if (a->dtype != b->dtype) {
+        return false;
+    }
+    if (a->dtype == CSINN_DTYPE_FLOAT16 || a->dtype == CSINN_DTYPE_BFLOAT16 ||
+        a->dtype == CSINN_DTYPE_FLOAT32 || a->dtype == CSINN_DTYPE_FLOAT64) {
+        return true;
+    }
+    return a->quant_channel == b->quant_channel &&
+           memcmp(a->qinfo, b->qinfo, a->quant_channel * sizeof(struct csinn_quant_info)) == 0;
+}
+
+/* same shape apart from the sequence axis */
+static bool kv_shape_match(struct csinn_tensor *a, struct csinn_tensor *b)
+{
+    if (a->dim_count != b->dim_count || a->dim_count < 2) {
+        return false;
+    }
+    for (int i = 0; i < a->dim_count; i++) {
+        if (i != a->dim_count - 2 && a->dim[i] != b->dim[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * key/value describe one step: dtype, quantization and every dim except the sequence axis
+ * (dim_count - 2) are taken from them. The cache belongs to sess and is released with it.
+ */
+struct csinn_kv_cache *csinn_alloc_kv_cache(struct csinn_tensor *key, struct csinn_tensor *value,
+                                            int32_t max_len, enum csinn_kv_cache_mode_enum mode,
+                                            struct csinn_session *sess)
+{
+    if (max_len <= 0 || key->dim_count < 2 || value->dim_count != key->dim_count ||
+        kv_lead(key) != kv_lead(value) || key->dtype == CSINN_DTYPE_INT4 ||
+        value->dtype == CSINN_DTYPE_INT4) {
+        shl_debug_error("kv cache: unsupported key/value layout\n");
+        return NULL;
+    }
+    struct csinn_kv_cache *cache = shl_mem_alloc(sizeof(struct csinn_kv_cache));
+    cache->key = kv_storage_alloc(key, max_len);
+    cache->value = kv_storage_alloc(value, max_len);
+    cache->max_len = max_len;
+    cache->mode = mode;
+    kv_register(cache, sess);
+    return cache;
+}
+
+void csinn_free_kv_cache(struct csinn_kv_cache *cache)
+{
+    struct csinn_session *sess = cache->sess;
+    if (sess != NULL) {
+        for (int i = 0; i < sess->kv_cache_num; i++) {
+            if (sess->kv_cache[i] == cache) {
+                sess->kv_cache[i] = sess->kv_cache[--sess->kv_cache_num];
+                break;
+            }
+        }
+    }
+    kv_tensor_free(cache->key);
+    kv_tensor_free(cache->value);
+    shl_mem_free(cache);
+}
+
+/* fork a sequence, e.g. for beam search */
+struct csinn_kv_cache *csinn_kv_cache_clone(struct csinn_kv_cache *cache)
+{
+    struct csinn_kv_cache *ret = shl_mem_alloc(sizeof(struct csinn_kv_cache));
+    *ret = *cache;
+    ret->key = kv_storage_alloc(cache->key, cache->max_len);
+    ret->value = kv_storage_alloc(cache->value, cache->max_len);
+    memcpy(ret->key->data, cache->key->data, csinn_tensor_byte_size(cache->key));
+    memcpy(ret->value->data, cache->value->data, csinn_tensor_byte_size(cache->value));
+    kv_register(ret, cache->sess);
+    return ret;
+}
+
+void csinn_kv_cache_reset(struct csinn_kv_cache *cache)
+{
+    cache->cur_len = 0;
+    cache->new_len = 0;
+    cache->start = 0;
+}
+
+void csinn_session_kv_cache_reset(struct csinn_session *sess)
+{
+    for (int i = 0; i < sess->kv_cache_num; i++) {
+        csinn_kv_cache_reset(sess->kv_cache[i]);
+    }
+}
+
+/*
+ * Write the positions of the step in flight. The first write of a step reserves room: in ring
+ * mode the oldest positions are evicted, in append mode a full cache fails. Key and value of
+ * one step must carry the same number of positions.
+ */
+int csinn_kv_cache_write(struct csinn_kv_cache *cache, struct csinn_tensor *rows, bool value)
+{
+    struct csinn_tensor *storage = value ? cache->value : cache->key;
+    if (!kv_shape_match(storage, rows)) {
+        shl_debug_error("kv cache: %s rows do not match the cache shape\n",
+                        value ? "value" : "key");
+        return CSINN_FALSE;
+    }
+    int32_t n = rows->dim[rows->dim_count - 2];
+    if (cache->new_len == 0) {
+        int32_t overflow = cache->cur_len + n - cache->max_len;
+        if (n > cache->max_len || (overflow > 0 && cache->mode != CSINN_KV_CACHE_RING)) {
+            shl_debug_error("kv cache: %d + %d positions exceed max_len %d\n", cache->cur_len, n,
+                            cache->max_len);
+            return CSINN_FALSE;
+        }
+        if (overflow > 0) {
+            cache->start = (cache->start + overflow) % cache->max_len;
+            cache->cur_len -= overflow;
+        }
+        cache->new_len = n;
+    } else if (n != cache->new_len) {
+        shl_debug_error("kv cache: key and value steps have different lengths\n");
+        return CSINN_FALSE;
+    }
+
+    /* bring the rows to the storage dtype and quantization */
+    struct csinn_tensor *src = rows;
+    if (!kv_same_encoding(rows, storage)) {
+        src = csinn_alloc_tensor(NULL);
+        csinn_tensor_copy(src, storage);
+        src->dim[src->dim_count - 2] = n;
+        src->data = shl_mem_alloc(csinn_tensor_byte_size(src));
+        if (csinn_tensor_data_convert(src, rows) != CSINN_TRUE) {
+            kv_tensor_free(src);
+            return CSINN_FALSE;
+        }
+    }
+
+    int64_t lead = kv_lead(storage);
+    int64_t row_bytes = kv_row_bytes(storage);
+    for (int64_t l = 0; l < lead; l++) {
+        for (int32_t r = 0; r < n; r++) {
+            int32_t row = (cache->start + cache->cur_len + r) % cache->max_len;
+            memcpy((char *)storage->data + (l * cache->max_len + row) * row_bytes,
+                   (char *)src->data + (l * n + r) * row_bytes, row_bytes);
+        }
+    }
+    if (src != rows) {
+        kv_tensor_free(src);
+    }
+    return CSINN_TRUE;
+}
+
+void csinn_kv_cache_commit(struct csinn_kv_cache *cache)
+{
+    cache->cur_len += cache->new_len;
+    cache->new_len = 0;
+}
+
+int csinn_kv_cache_append(struct csinn_kv_cache *cache, struct csinn_tensor *key,
+                          struct csinn_tensor *value)
+{
+    if (csinn_kv_cache_write(cache, key, false) != CSINN_TRUE ||
+        csinn_kv_cache_write(cache, value, true) != CSINN_TRUE) {
+        cache->new_len = 0;
+        return CSINN_FALSE;
+    }
+    csinn_kv_cache_commit(cache);
+    return CSINN_TRUE;
+}
+
+/*
+ * Copy the cached positions, including the step in flight, oldest first into dest. dest takes
+ * the storage dtype and shape with the sequence axis set to the cached length; dest->data is
+ * allocated here and released with shl_mem_free.
+ */
+int csinn_kv_cache_read(struct csinn_kv_cache *cache, struct csinn_tensor *dest, bool value)
+{
+    struct csinn_tensor *storage = value ? cache->value : cache->key;
+    int32_t len = cache->cur_len + cache->new_len;
+    csinn_tensor_copy(dest, storage);
+    dest->dim[dest->dim_count - 2] = len;
+    dest->data = shl_mem_alloc(csinn_tensor_byte_size(dest));
+
+    int64_t lead = kv_lead(storage);
+    int64_t row_bytes = kv_row_bytes(storage);
+    for (int64_t l = 0; l < lead; l++) {
+        int32_t first = cache->max_len - cache->start < len ? cache->max_len - cache->start : len;
+        char *src = (char *)storage->data + l * cache->max_len * row_bytes;
+        char *dst = (char *)dest->data + l * len * row_bytes;
+        memcpy(dst, src + cache->start * row_bytes, first * row_bytes);
+        memcpy(dst + first * row_bytes, src, (len - first) * row_bytes);
+    }
+    return CSINN_TRUE;
+}
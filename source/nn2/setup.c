@@ -81,7 +81,15 @@ struct csinn_session *csinn_alloc_session()
     return shl_mem_alloc(sizeof(struct csinn_session));
 }
 
-void csinn_free_session(struct csinn_session *sess) { shl_mem_free(sess); }
+void csinn_free_session(struct csinn_session *sess)
+{
+    while (sess->kv_cache_num > 0) {
+        csinn_free_kv_cache(sess->kv_cache[0]);
+    }
+    shl_mem_free(sess->kv_cache);
+    shl_session_set_tuning(sess, false, NULL);
+    shl_mem_free(sess);
+}
 
 static void *shl_cb_func_table[CSINN_API_SIZE];
 void shl_register_op_callback(int api, void *cb) { shl_cb_func_table[api] = cb; }
@@ -306,6 +314,167 @@ int csinn_session_run(struct csinn_session *sess)
     return CSINN_FALSE;
 }
 
+int csinn_session_set_stream(struct csinn_session *sess, bool enable)
+{
+    int (*func)();
+    func = shl_get_runtime_callback(sess, CSINN_SESSION_SET_STREAM);
+    if (func != NULL) {
+        return func(sess, enable);
+    }
+    return CSINN_FALSE;
+}
+
+int csinn_session_stream_reset(struct csinn_session *sess)
+{
+    int (*func)();
+    func = shl_get_runtime_callback(sess, CSINN_SESSION_STREAM_RESET);
+    if (func != NULL) {
+        return func(sess);
+    }
+    return CSINN_FALSE;
+}
+
+int csinn_session_stream_stats(struct csinn_session *sess, struct csinn_stream_stats *stats)
+{
+    int (*func)();
+    func = shl_get_runtime_callback(sess, CSINN_SESSION_STREAM_STATS);
+    if (func != NULL) {
+        return func(sess, stats);
+    }
+    return CSINN_FALSE;
+}
+
+int csinn_session_set_tiling(struct csinn_session *sess, bool enable)
+{
+    int (*func)();
+    func = shl_get_runtime_callback(sess, CSINN_SESSION_SET_TILING);
+    if (func != NULL) {
+        return func(sess, enable);
+    }
+    return CSINN_FALSE;
+}
+
+int csinn_session_tiling_stats(struct csinn_session *sess, struct csinn_tiling_stats *stats)
+{
+    int (*func)();
+    func = shl_get_runtime_callback(sess, CSINN_SESSION_TILING_STATS);
+    if (func != NULL) {
+        return func(sess, stats);
+    }
+    return CSINN_FALSE;
+}
+
+int csinn_session_set_counters(struct csinn_session *sess, bool enable)
+{
+    int (*func)();
+    func = shl_get_runtime_callback(sess, CSINN_SESSION_SET_COUNTERS);
+    if (func != NULL) {
+        return func(sess, enable);
+    }
+    return CSINN_FALSE;
+}
+
+int csinn_session_counter_stats(struct csinn_session *sess, struct csinn_counter_stats *stats)
+{
+    int (*func)();
+    func = shl_get_runtime_callback(sess, CSINN_SESSION_COUNTER_STATS);
+    if (func != NULL) {
+        return func(sess, stats);
+    }
+    return CSINN_FALSE;
+}
+
+int csinn_session_set_async(struct csinn_session *sess, int depth)
+{
+    int (*func)();
+    func = shl_get_runtime_callback(sess, CSINN_SESSION_SET_ASYNC);
+    if (func != NULL) {
+        return func(sess, depth);
+    }
+    return CSINN_FALSE;
+}
+
+int csinn_session_run_async(struct csinn_session *sess, struct csinn_tensor **inputs,
+                            struct csinn_tensor **outputs, csinn_async_callback callback,
+                            void *user)
+{
+    int (*func)();
+    func = shl_get_runtime_callback(sess, CSINN_SESSION_RUN_ASYNC);
+    if (func != NULL) {
+        return func(sess, inputs, outputs, callback, user);
+    }
+    return CSINN_FALSE;
+}
+
+int csinn_session_wait(struct csinn_session *sess)
+{
+    int (*func)();
+    func = shl_get_runtime_callback(sess, CSINN_SESSION_WAIT);
+    if (func != NULL) {
+        return func(sess);
+    }
+    return CSINN_FALSE;
+}
+
+int csinn_session_set_pipeline(struct csinn_session *sess, int stages, int depth)
+{
+    int (*func)();
+    func = shl_get_runtime_callback(sess, CSINN_SESSION_SET_PIPELINE);
+    if (func != NULL) {
+        return func(sess, stages, depth);
+    }
+    return CSINN_FALSE;
+}
+
+int csinn_session_resize_input(struct csinn_session *sess, struct csinn_tensor **inputs)
+{
+    int (*func)();
+    func = shl_get_runtime_callback(sess, CSINN_SESSION_RESIZE_INPUT);
+    if (func != NULL) {
+        return func(sess, inputs);
+    }
+    return CSINN_FALSE;
+}
+
+int csinn_session_set_layout_opt(struct csinn_session *sess, bool enable)
+{
+    int (*func)();
+    func = shl_get_runtime_callback(sess, CSINN_SESSION_SET_LAYOUT_OPT);
+    if (func != NULL) {
+        return func(sess, enable);
+    }
+    return CSINN_FALSE;
+}
+
+int csinn_session_layout_stats(struct csinn_session *sess, struct csinn_layout_stats *stats)
+{
+    int (*func)();
+    func = shl_get_runtime_callback(sess, CSINN_SESSION_LAYOUT_STATS);
+    if (func != NULL) {
+        return func(sess, stats);
+    }
+    return CSINN_FALSE;
+}
+
+/*
+ * Let backends time their conv algorithms when layers are initialized and keep the fastest.
+ * Call it before csinn_session_setup, or before the layer init functions in layer mode.
+ * Decisions in the tuning file at path are reused without measuring; path may be NULL.
+ */
+int csinn_session_set_tuning(struct csinn_session *sess, bool enable, const char *path)
+{
+    int (*func)();
+    func = shl_get_runtime_callback(sess, CSINN_SESSION_SET_TUNING);
+    if (func != NULL) {
+        return func(sess, enable, path);
+    }
+    /* layer mode has no runtime callbacks, its init functions read sess->tuning directly */
+    if (sess->base_run_mode == CSINN_RM_LAYER) {
+        return shl_session_set_tuning(sess, enable, path);
+    }
+    return CSINN_FALSE;
+}
+
 int csinn_set_tensor_entry(struct csinn_tensor *t, struct csinn_session *sess)
 {
     int (*func)();
@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2016-2022 T-Head Semiconductor Co., Ltd. All rights reserved.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* CSI-NN2 version 2.0.x */
+
+#include "csi_nn.h"
+#include "shl_utils.h"
+
+/*
+ * Structured sparse weights keep n of every 4 consecutive elements along the reduction axis,
+ * n = 2 for CSINN_MEM_TYPE_ASP42 and 1 for CSINN_MEM_TYPE_ASP41. dim[0] is the output
+ * channel, the remaining dims are flattened in memory order into a row of k elements. The
+ * dims stay dense, data holds
+ *
+ *   values [dim[0]][kept]          kept = ceil(k / 4) * n, in group order
+ *   index  [dim[0]][ceil(kept/4)]  2-bit lane of each value, four per byte, low bits first
+ *
+ * so element e of a row multiplies column (e / n) * 4 + lane(e).
+ */
+int csinn_sparse_weight_kept(struct csinn_tensor *weight)
+{
+    int n = weight->mtype == CSINN_MEM_TYPE_ASP42 ? 2 : weight->mtype == CSINN_MEM_TYPE_ASP41;
+    int k = csinn_tensor_size(weight) / weight->dim[0];
+    return (k + 3) / 4 * n;
+}
+
+int csinn_sparse_weight_byte_size(struct csinn_tensor *weight)
+{
+    int kept = csinn_sparse_weight_kept(weight);
+    return weight->dim[0] * (kept * sizeof(float) + (kept + 3) / 4);
+}
+
+/*
+ * Compress a pruned float32 weight in place and mark it with mtype. Every group of four must
+ * hold at most n nonzeros. weight->data is replaced by a shl_mem_alloc buffer, the dense data
+ * still belongs to the caller.
+ */
+int csinn_sparse_weight_compress(struct csinn_tensor *weight, enum csinn_mem_type_enum mtype)
+{
+    if (weight->dtype != CSINN_DTYPE_FLOAT32 || weight->dim_count < 1 || weight->dim[0] <= 0 ||
+        (mtype != CSINN_MEM_TYPE_ASP42 && mtype != CSINN_MEM_TYPE_ASP41)) {
+        shl_debug_error("sparse weight: only float32 weights compress to ASP42/ASP41\n");
+        return CSINN_FALSE;
+    }
+    const int n = mtype == CSINN_MEM_TYPE_ASP42 ? 2 : 1;
+    const int rows = weight->dim[0];
+    const int k = csinn_tensor_size(weight) / rows;
+    const int groups = (k + 3) / 4;
+    const int kept = groups * n;
+    const int index_bytes = (kept + 3) / 4;
+    float *dense = weight->data;
+
+    float *values = shl_mem_alloc(rows * (kept * sizeof(float) + index_bytes));
+    uint8_t *index = (uint8_t *)(values + rows * kept);
+    for (int r = 0; r < rows; r++) {
+        for (int g = 0; g < groups; g++) {
+            const float *lanes = dense + r * k + g * 4;
+            int valid = k - g * 4 < 4 ? k - g * 4 : 4;
+            int lane_of[4];
+            float value_of[4];
+            int used = 0;
+            for (int l = 0; l < valid; l++) {
+                if (lanes[l] == 0.0f) {
+                    continue;
+                }
+                if (used == n) {
+                    shl_debug_error("sparse weight: row %d group %d has more than %d nonzeros\n",
+                                    r, g, n);
+                    shl_mem_free(values);
+                    return CSINN_FALSE;
+                }
+                lane_of[used] = l;
+                value_of[used++] = lanes[l];
+            }
+            /* pad with zero values on lanes that stay inside the row */
+            for (int l = 0; used < n; l++) {
+                if (l >= valid || lanes[l] == 0.0f) {
+                    lane_of[used] = l < valid ? l : 0;
+                    value_of[used++] = 0.0f;
+                }
+            }
+            for (int j = 0; j < n; j++) {
+                int e = g * n + j;
+                values[r * kept + e] = value_of[j];
+                index[r * index_bytes + e / 4] |= lane_of[j] << (2 * (e % 4));
+            }
+        }
+    }
+    weight->data = values;
+    weight->mtype = mtype;
+    return CSINN_TRUE;
+}
@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2016-2022 T-Head Semiconductor Co., Ltd. All rights reserved.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* CSI-NN2 version 2.0.x */
+
+#include "csi_nn.h"
+#include "shl_utils.h"
+
+/*
+ * The tuning file is plain text, one decision per line:
+ *
+ *   <key> <algorithm> <microseconds>
+ *
+ * Lines starting with '#' are comments. A key seen twice keeps its last
+ * decision, so appending a re-measurement overrides the older one.
+ */
+#define TUNING_LINE_SIZE 512
+
+static const char *tuning_dtype_name[] = {"bool",   "int4",  "uint8", "int8", "uint16", "int16",
+                                          "uint32", "int32", "fp16",  "bf16", "fp32",   "fp64"};
+
+static char *tuning_strdup(const char *s)
+{
+    char *ret = shl_mem_alloc(strlen(s) + 1);
+    strcpy(ret, s);
+    return ret;
+}
+
+struct csinn_tuning_entry *shl_tuning_find(struct csinn_tuning *tuning, const char *key)
+{
+    for (int i = 0; i < tuning->entry_num; i++) {
+        if (strcmp(tuning->entry[i].key, key) == 0) {
+            return &tuning->entry[i];
+        }
+    }
+    return NULL;
+}
+
+static void tuning_insert(struct csinn_tuning *tuning, const char *key, const char *algo,
+                          float time)
+{
+    struct csinn_tuning_entry *e = shl_tuning_find(tuning, key);
+    if (e == NULL) {
+        struct csinn_tuning_entry *list =
+            shl_mem_alloc((tuning->entry_num + 1) * sizeof(struct csinn_tuning_entry));
+        if (tuning->entry != NULL) {
+            memcpy(list, tuning->entry, tuning->entry_num * sizeof(struct csinn_tuning_entry));
+            shl_mem_free(tuning->entry);
+        }
+        tuning->entry = list;
+        e = &list[tuning->entry_num++];
+        e->key = tuning_strdup(key);
+    } else {
+        shl_mem_free(e->algo);
+    }
+    e->algo = tuning_strdup(algo);
+    e->time = time;
+}
+
+static void tuning_load(struct csinn_tuning *tuning)
+{
+    FILE *fp = fopen(tuning->path, "r");
+    if (fp == NULL) {
+        return;
+    }
+    char line[TUNING_LINE_SIZE];
+    char key[TUNING_LINE_SIZE];
+    char algo[TUNING_LINE_SIZE];
+    float time;
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        if (line[0] == '#') {
+            continue;
+        }
+        if (sscanf(line, "%s %s %f", key, algo, &time) == 3) {
+            tuning_insert(tuning, key, algo, time);
+        }
+    }
+    fclose(fp);
+    shl_debug_info("[autotune]: %d decisions loaded from %s\n", tuning->entry_num, tuning->path);
+}
+
+/* record a measured decision, and append it to the tuning file if there is one */
+void shl_tuning_add(struct csinn_tuning *tuning, const char *key, const char *algo, float time)
+{
+    tuning_insert(tuning, key, algo, time);
+    if (tuning->path == NULL) {
+        return;
+    }
+    FILE *fp = fopen(tuning->path, "a");
+    if (fp == NULL) {
+        shl_debug_warning("[autotune]: cannot write %s\n", tuning->path);
+        return;
+    }
+    if (ftell(fp) == 0) {
+        fprintf(fp, "# key algorithm microseconds\n");
+    }
+    fprintf(fp, "%s %s %.1f\n", key, algo, time);
+    fclose(fp);
+}
+
+/* backend:dtype:layout:input:output:kernel:stride:dilation:pad:group */
+void shl_tuning_conv2d_key(char *key, int size, const char *backend, struct csinn_tensor *input,
+                           struct csinn_tensor *output, struct csinn_tensor *kernel,
+                           struct csinn_conv2d_params *params)
+{
+    const char *dtype = input->dtype >= 0 && input->dtype < CSINN_DTYPE_SIZE
+                            ? tuning_dtype_name[input->dtype]
+                            : "unknown";
+    const char *layout = params->base.layout == CSINN_LAYOUT_NHWC ? "nhwc" : "nchw";
+    snprintf(key, size,
+             "%s:%s:%s:%dx%dx%dx%d:%dx%dx%dx%d:%dx%dx%dx%d:s%dx%d:d%dx%d:p%dx%dx%dx%d:g%d", backend,
+             dtype, layout, input->dim[0], input->dim[1], input->dim[2], input->dim[3],
+             output->dim[0], output->dim[1], output->dim[2], output->dim[3], kernel->dim[0],
+             kernel->dim[1], kernel->dim[2], kernel->dim[3], params->stride_height,
+             params->stride_width, params->dilation_height, params->dilation_width,
+             params->pad_top, params->pad_down, params->pad_left, params->pad_right,
+             params->group);
+}
+
+static void tuning_free(struct csinn_tuning *tuning)
+{
+    for (int i = 0; i < tuning->entry_num; i++) {
+        shl_mem_free(tuning->entry[i].key);
+        shl_mem_free(tuning->entry[i].algo);
+    }
+    shl_mem_free(tuning->entry);
+    shl_mem_free(tuning->path);
+    shl_mem_free(tuning);
+}
+
+/* replace the tuning state of sess, see csinn_session_set_tuning */
+int shl_session_set_tuning(struct csinn_session *sess, bool enable, const char *path)
+{
+    if (sess->tuning != NULL) {
+        tuning_free(sess->tuning);
+        sess->tuning = NULL;
+    }
+    if (!enable) {
+        return CSINN_TRUE;
+    }
+    sess->tuning = shl_mem_alloc(sizeof(struct csinn_tuning));
+    if (path != NULL) {
+        sess->tuning->path = tuning_strdup(path);
+        tuning_load(sess->tuning);
+    }
+    return CSINN_TRUE;
+}
@@ -282,9 +282,16 @@ struct csinn_tensor *csinn_alloc_tensor(struct csinn_session *session)
 
 void csinn_realloc_quant_info(struct csinn_tensor *tensor, int quant_info_num)
 {
+    /* shl_mem_realloc copies the new size out of the old block, so grow by hand */
+    struct csinn_quant_info *qinfo =
+        shl_mem_alloc(quant_info_num * sizeof(struct csinn_quant_info));
+    if (tensor->qinfo != NULL) {
+        int keep = tensor->quant_channel < quant_info_num ? tensor->quant_channel : quant_info_num;
+        memcpy(qinfo, tensor->qinfo, keep * sizeof(struct csinn_quant_info));
+        shl_mem_free(tensor->qinfo);
+    }
     tensor->quant_channel = quant_info_num;
-    tensor->qinfo =
-        shl_mem_realloc(tensor->qinfo, quant_info_num * sizeof(struct csinn_quant_info));
+    tensor->qinfo = qinfo;
 }
 
 void csinn_tensor_copy(struct csinn_tensor *dest, struct csinn_tensor *src)
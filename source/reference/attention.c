@@ -0,0 +1,353 @@
+/*
+ * Copyright (C) 2016-2022 T-Head Semiconductor Co., Ltd. All rights reserved.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* CSI-NN2 version 2.0.x */
+
+#include "ref_mathfun.h"
+
+/*
+ * Attention views a [..., seq, dim] tensor (or [batch, seq, heads * dim] when num_heads is set)
+ * as lead_count independent heads. Rows of one head are row_stride floats apart. A kv cache
+ * is viewed in place: a head spans seq_stride (max_len) storage rows and position j lives in
+ * row ring_start + j, wrapping once past seq_stride.
+ */
+struct attn_layout {
+    int64_t lead_count;
+    int32_t heads;  // size of the head axis, 1 when there is none
+    int32_t seq;
+    int32_t dim;
+    int64_t row_stride;
+    int32_t seq_stride;  // storage rows per head, seq unless viewing a kv cache
+    int32_t ring_start;  // storage row of position 0, 0 unless viewing a kv cache
+};
+
+static int attn_get_layout(struct csinn_tensor *t, int32_t num_heads, struct attn_layout *l)
+{
+    int rank = t->dim_count;
+    if (num_heads > 0) {
+        if (rank != 3 || t->dim[2] % num_heads != 0) {
+            return CSINN_FALSE;
+        }
+        l->heads = num_heads;
+        l->lead_count = (int64_t)t->dim[0] * num_heads;
+        l->seq = t->dim[1];
+        l->dim = t->dim[2] / num_heads;
+        l->row_stride = t->dim[2];
+        l->seq_stride = l->seq;
+        l->ring_start = 0;
+        return CSINN_TRUE;
+    }
+    if (rank < 2) {
+        return CSINN_FALSE;
+    }
+    l->heads = rank >= 3 ? t->dim[rank - 3] : 1;
+    l->lead_count = 1;
+    for (int i = 0; i < rank - 2; i++) {
+        l->lead_count *= t->dim[i];
+    }
+    l->seq = t->dim[rank - 2];
+    l->dim = t->dim[rank - 1];
+    l->row_stride = l->dim;
+    l->seq_stride = l->seq;
+    l->ring_start = 0;
+    return CSINN_TRUE;
+}
+
+/* offset of row 0 of head `lead` in a tensor described by l */
+static int64_t attn_head_offset(const struct attn_layout *l, int64_t lead, int32_t packed)
+{
+    if (packed) {
+        int64_t b = lead / l->heads;
+        return b * l->seq_stride * l->row_stride + (lead % l->heads) * l->dim;
+    }
+    return lead * l->seq_stride * l->dim;
+}
+
+/* row j of a head, the ring of a kv cache splits the rows into at most two spans */
+static const float *attn_row(const float *head, const struct attn_layout *l, int32_t j)
+{
+    int32_t row = l->ring_start + j;
+    if (row >= l->seq_stride) {
+        row -= l->seq_stride;
+    }
+    return head + row * l->row_stride;
+}
+
+/*
+ * Mask strides against the score shape [lead dims..., seq_q, seq_k], right aligned with
+ * numpy broadcasting; broadcast dims get stride 0.
+ */
+static int attn_mask_strides(struct csinn_tensor *mask, const int32_t *score_dim, int score_rank,
+                             int64_t *stride)
+{
+    if (mask->dim_count > score_rank) {
+        return CSINN_FALSE;
+    }
+    int64_t s = 1;
+    for (int i = score_rank - 1; i >= 0; i--) {
+        int mi = i - (score_rank - mask->dim_count);
+        if (mi < 0 || mask->dim[mi] == 1) {
+            stride[i] = 0;
+        } else if (mask->dim[mi] == score_dim[i]) {
+            stride[i] = s;
+        } else {
+            return CSINN_FALSE;
+        }
+        if (mi >= 0) {
+            s *= mask->dim[mi];
+        }
+    }
+    return CSINN_TRUE;
+}
+
+/* with cache set, key/value are its max_len storage and only the cached positions are read */
+static int attention_f32(struct csinn_tensor *query, struct csinn_tensor *key,
+                         struct csinn_tensor *value, struct csinn_tensor *mask,
+                         struct csinn_tensor *output, struct csinn_attention_params *params,
+                         struct csinn_kv_cache *cache)
+{
+    struct attn_layout lq, lk, lv, lo;
+    int32_t packed = params->num_heads > 0;
+    int32_t kv_heads = 0;
+    if (packed) {
+        /* grouped heads: key/value may carry fewer heads of the same head_dim */
+        int32_t head_dim = query->dim_count == 3 ? query->dim[2] / params->num_heads : 0;
+        if (head_dim > 0 && key->dim_count == 3 && key->dim[2] % head_dim == 0) {
+            kv_heads = key->dim[2] / head_dim;
+        }
+        if (kv_heads <= 0) {
+            shl_debug_error("attention: key does not split into heads of the query head_dim\n");
+            return CSINN_FALSE;
+        }
+    }
+    if (attn_get_layout(query, params->num_heads, &lq) != CSINN_TRUE ||
+        attn_get_layout(key, kv_heads, &lk) != CSINN_TRUE ||
+        attn_get_layout(value, kv_heads, &lv) != CSINN_TRUE ||
+        attn_get_layout(output, params->num_heads, &lo) != CSINN_TRUE) {
+        shl_debug_error("attention: unsupported tensor rank or head split\n");
+        return CSINN_FALSE;
+    }
+    if (cache != NULL) {
+        lk.seq = lv.seq = cache->cur_len + cache->new_len;
+        lk.ring_start = lv.ring_start = cache->start;
+    }
+    if (lk.dim != lq.dim || lv.seq != lk.seq || lk.lead_count != lv.lead_count ||
+        lk.heads != lv.heads || lo.lead_count != lq.lead_count || lo.seq != lq.seq ||
+        lo.dim != lv.dim || lq.heads % lk.heads != 0 ||
+        lq.lead_count / lq.heads != lk.lead_count / lk.heads) {
+        shl_debug_error("attention: query/key/value/output shapes do not match\n");
+        return CSINN_FALSE;
+    }
+
+    const int32_t seq_q = lq.seq, seq_k = lk.seq, dim = lq.dim, dim_v = lv.dim;
+    const int32_t group = lq.heads / lk.heads;
+    const int32_t bs = params->block_size > 0 ? params->block_size : 64;
+    const int32_t causal_shift = seq_k - seq_q;
+    const float scale = params->scale != 0.0f ? params->scale : 1.0f / sqrtf((float)dim);
+    bool fast = shl_ref_fast_math_enabled(params);
+
+    /* score shape for mask broadcasting */
+    int32_t score_dim[MAX_DIM + 2];
+    int score_rank = 0;
+    if (packed) {
+        score_dim[score_rank++] = query->dim[0];
+        score_dim[score_rank++] = lq.heads;
+    } else {
+        for (int i = 0; i < query->dim_count - 2; i++) {
+            score_dim[score_rank++] = query->dim[i];
+        }
+    }
+    score_dim[score_rank++] = seq_q;
+    score_dim[score_rank++] = seq_k;
+    int64_t mask_stride[MAX_DIM + 2];
+    if (mask != NULL && attn_mask_strides(mask, score_dim, score_rank, mask_stride) != CSINN_TRUE) {
+        shl_debug_error("attention: mask does not broadcast to the score shape\n");
+        return CSINN_FALSE;
+    }
+    const float *mask_f32 = mask != NULL && mask->dtype != CSINN_DTYPE_BOOL ? mask->data : NULL;
+    const bool *mask_bool = mask != NULL && mask->dtype == CSINN_DTYPE_BOOL ? mask->data : NULL;
+
+    const float *q_data = query->data;
+    const float *k_data = key->data;
+    const float *v_data = value->data;
+    float *o_data = output->data;
+
+    /* per query block: scores, running max, running sum and the unnormalized output */
+    float *score = shl_mem_alloc((int64_t)bs * bs * sizeof(float));
+    float *row_max = shl_mem_alloc(bs * sizeof(float));
+    float *row_sum = shl_mem_alloc(bs * sizeof(float));
+    float *acc = shl_mem_alloc((int64_t)bs * dim_v * sizeof(float));
+
+    for (int64_t lead = 0; lead < lq.lead_count; lead++) {
+        int64_t kv_lead = lead / lq.heads * lk.heads + lead % lq.heads / group;
+        const float *q_head = q_data + attn_head_offset(&lq, lead, packed);
+        const float *k_head = k_data + attn_head_offset(&lk, kv_lead, packed);
+        const float *v_head = v_data + attn_head_offset(&lv, kv_lead, packed);
+        float *o_head = o_data + attn_head_offset(&lo, lead, packed);
+
+        int64_t m_head = 0;
+        if (mask != NULL) {
+            int64_t rem = lead;
+            for (int i = score_rank - 3; i >= 0; i--) {
+                m_head += rem % score_dim[i] * mask_stride[i];
+                rem /= score_dim[i];
+            }
+        }
+        const int64_t ms_q = mask != NULL ? mask_stride[score_rank - 2] : 0;
+        const int64_t ms_k = mask != NULL ? mask_stride[score_rank - 1] : 0;
+
+        for (int32_t i0 = 0; i0 < seq_q; i0 += bs) {
+            int32_t nq = seq_q - i0 < bs ? seq_q - i0 : bs;
+            for (int32_t r = 0; r < nq; r++) {
+                row_max[r] = -INFINITY;
+                row_sum[r] = 0.0f;
+            }
+            memset(acc, 0, (int64_t)nq * dim_v * sizeof(float));
+
+            for (int32_t j0 = 0; j0 < seq_k; j0 += bs) {
+                if (params->causal && j0 > i0 + nq - 1 + causal_shift) {
+                    break;
+                }
+                int32_t nk = seq_k - j0 < bs ? seq_k - j0 : bs;
+
+                for (int32_t r = 0; r < nq; r++) {
+                    int32_t qi = i0 + r;
+                    const float *q_row = q_head + qi * lq.row_stride;
+                    float *s_row = score + (int64_t)r * bs;
+                    for (int32_t c = 0; c < nk; c++) {
+                        int32_t kj = j0 + c;
+                        const float *k_row = attn_row(k_head, &lk, kj);
+                        float dot = 0.0f;
+                        for (int32_t d = 0; d < dim; d++) {
+                            dot += q_row[d] * k_row[d];
+                        }
+                        float s = dot * scale;
+                        int64_t m_idx = m_head + qi * ms_q + kj * ms_k;
+                        if (mask_f32 != NULL) {
+                            s += mask_f32[m_idx];
+                        } else if (mask_bool != NULL && !mask_bool[m_idx]) {
+                            s = -INFINITY;
+                        }
+                        if (params->causal && kj > qi + causal_shift) {
+                            s = -INFINITY;
+                        }
+                        s_row[c] = s;
+                    }
+                }
+
+                /* online softmax: rescale what was accumulated under the old running max */
+                for (int32_t r = 0; r < nq; r++) {
+                    float *s_row = score + (int64_t)r * bs;
+                    float block_max = -INFINITY;
+                    for (int32_t c = 0; c < nk; c++) {
+                        block_max = fmaxf(block_max, s_row[c]);
+                    }
+                    float new_max = fmaxf(row_max[r], block_max);
+                    if (new_max == -INFINITY) {
+                        continue;
+                    }
+                    float *acc_row = acc + (int64_t)r * dim_v;
+                    float diff = row_max[r] - new_max;
+                    float corr = fast ? shl_ref_fast_expf(diff) : expf(diff);
+                    row_sum[r] *= corr;
+                    for (int32_t d = 0; d < dim_v; d++) {
+                        acc_row[d] *= corr;
+                    }
+                    for (int32_t c = 0; c < nk; c++) {
+                        float x = s_row[c] - new_max;
+                        float p = fast ? shl_ref_fast_expf(x) : expf(x);
+                        row_sum[r] += p;
+                        const float *v_row = attn_row(v_head, &lv, j0 + c);
+                        for (int32_t d = 0; d < dim_v; d++) {
+                            acc_row[d] += p * v_row[d];
+                        }
+                    }
+                    row_max[r] = new_max;
+                }
+            }
+
+            for (int32_t r = 0; r < nq; r++) {
+                /* a fully masked row has no valid key and produces zeros */
+                float inv = row_sum[r] > 0.0f ? 1.0f / row_sum[r] : 0.0f;
+                const float *acc_row = acc + (int64_t)r * dim_v;
+                float *o_row = o_head + (i0 + r) * lo.row_stride;
+                for (int32_t d = 0; d < dim_v; d++) {
+                    o_row[d] = acc_row[d] * inv;
+                }
+            }
+        }
+    }
+
+    shl_mem_free(score);
+    shl_mem_free(row_max);
+    shl_mem_free(row_sum);
+    shl_mem_free(acc);
+    return CSINN_TRUE;
+}
+
+/*
+ * With a kv cache, key/value hold the new positions only: they are appended and the query
+ * attends to every cached position, so a decode step costs O(cached length).
+ */
+int shl_ref_attention_f32(struct csinn_tensor *query, struct csinn_tensor *key,
+                          struct csinn_tensor *value, struct csinn_tensor *mask,
+                          struct csinn_tensor *output, struct csinn_attention_params *params)
+{
+    if (params->kv_cache == NULL) {
+        return attention_f32(query, key, value, mask, output, params, NULL);
+    }
+    struct csinn_kv_cache *cache = params->kv_cache;
+    if (csinn_kv_cache_append(cache, key, value) != CSINN_TRUE) {
+        return CSINN_FALSE;
+    }
+    struct csinn_tensor *cached_key = shl_ref_kv_cache_storage_f32(cache, false);
+    struct csinn_tensor *cached_value = shl_ref_kv_cache_storage_f32(cache, true);
+    int ret = attention_f32(query, cached_key, cached_value, mask, output, params, cache);
+    shl_ref_kv_cache_storage_free_f32(cache, cached_key);
+    shl_ref_kv_cache_storage_free_f32(cache, cached_value);
+    return ret;
+}
+
+int shl_ref_attention_quant(struct csinn_tensor *query, struct csinn_tensor *key,
+                            struct csinn_tensor *value, struct csinn_tensor *mask,
+                            struct csinn_tensor *output, struct csinn_attention_params *params)
+{
+    struct csinn_tensor *float_query = shl_ref_tensor_transform_f32(query);
+    struct csinn_tensor *float_key = shl_ref_tensor_transform_f32(key);
+    struct csinn_tensor *float_value = shl_ref_tensor_transform_f32(value);
+    struct csinn_tensor *float_output = shl_ref_tensor_transform_f32(output);
+    struct csinn_tensor *float_mask = NULL;
+    if (mask != NULL && mask->dtype != CSINN_DTYPE_BOOL) {
+        float_mask = shl_ref_tensor_transform_f32(mask);
+    }
+
+    int ret = shl_ref_attention_f32(float_query, float_key, float_value,
+                                    float_mask != NULL ? float_mask : mask, float_output, params);
+
+    csinn_tensor_data_convert(output, float_output);
+
+    shl_ref_tensor_transform_free_f32(float_query);
+    shl_ref_tensor_transform_free_f32(float_key);
+    shl_ref_tensor_transform_free_f32(float_value);
+    shl_ref_tensor_transform_free_f32(float_output);
+    if (float_mask != NULL) {
+        shl_ref_tensor_transform_free_f32(float_mask);
+    }
+
+    return ret;
+}
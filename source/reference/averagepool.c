@@ -20,113 +20,151 @@
 
 #include "shl_ref.h"
 
-int shl_ref_avgpool2d_nhwc_f32(struct csinn_tensor *input, struct csinn_tensor *output,
-                               struct csinn_pool_params *params)
+/* windows of more elements than this are summed from prefix sums instead of directly */
+#define AVGPOOL_DIRECT_WINDOW 16
+
+static bool avgpool2d_plane_finite(const float *data, int size)
 {
-    float *input_data = input->data;
-    float *output_data = output->data;
-    const int batches = input->dim[0];
-    const int depth = input->dim[3];
-    const int input_height = input->dim[1];
-    const int input_width = input->dim[2];
-    const int output_height = output->dim[1];
-    const int output_width = output->dim[2];
-
-    for (int batch = 0; batch < batches; ++batch) {
-        for (int out_y = 0; out_y < output_height; ++out_y) {
-            for (int out_x = 0; out_x < output_width; ++out_x) {
-                for (int channel = 0; channel < depth; ++channel) {
-                    const int in_x_origin = (out_x * params->stride_width) - params->pad_left;
-                    const int in_y_origin = (out_y * params->stride_height) - params->pad_top;
-                    // Compute the boundaries of the filter region clamped so as to
-                    // ensure that the filter window fits in the input array.
-                    const int filter_x_start = shl_ref_max_internal_s32(0, -in_x_origin);
-                    const int filter_x_end =
-                        shl_ref_min_internal_s32(params->filter_width, input_width - in_x_origin);
-                    const int filter_y_start = shl_ref_max_internal_s32(0, -in_y_origin);
-                    const int filter_y_end =
-                        shl_ref_min_internal_s32(params->filter_height, input_height - in_y_origin);
-                    float total = 0.f;
-                    float filter_count = 0;
-                    for (int filter_y = filter_y_start; filter_y < filter_y_end; ++filter_y) {
-                        for (int filter_x = filter_x_start; filter_x < filter_x_end; ++filter_x) {
-                            const int in_x = in_x_origin + filter_x;
-                            const int in_y = in_y_origin + filter_y;
-                            total += input_data[shl_ref_get_index(input->dim, batch, in_y, in_x,
-                                                                  channel)];
-                            filter_count++;
-                        }
-                    }
-                    if (params->count_include_pad) {
-                        filter_count = params->filter_height * params->filter_width;
-                    }
-                    const float average = total / filter_count;
-                    output_data[shl_ref_get_index(output->dim, batch, out_y, out_x, channel)] =
-                        average;
-                }
-            }
+    for (int i = 0; i < size; ++i) {
+        if (!isfinite(data[i])) {
+            return false;
         }
     }
-    return CSINN_TRUE;
+    return true;
 }
 
-static int shl_ref_avgpool2d_nchw_f32(struct csinn_tensor *input, struct csinn_tensor *output,
-                                      struct csinn_pool_params *params)
+/*
+ * Average pooling of one spatial plane, element (y, x, i) is at (y * width + x) * inner + i.
+ * NHWC passes the whole channel vector as inner, NCHW runs plane by plane with inner = 1,
+ * so the innermost loop is contiguous for both layouts.
+ *
+ * Small windows are summed from scratch in the same (y, x) order and float precision as the
+ * per-element loop, so results stay bit-exact and an Inf/NaN only reaches the outputs whose
+ * window contains it; the output vector itself is the accumulator. Large windows of a finite
+ * plane take double prefix sums instead: col_pre over the rows of the plane, then row_pre
+ * over the column sums of each output row, so a window costs the same whatever its size.
+ */
+static void avgpool2d_plane_f32(const float *input_data, float *output_data, int in_h, int in_w,
+                                int out_h, int out_w, int inner, struct csinn_pool_params *params,
+                                double *col_pre, double *row_pre)
 {
-    float *input_data = input->data;
-    float *output_data = output->data;
-    const int batches = input->dim[0];
-    const int depth = input->dim[1];
-    const int input_height = input->dim[2];
-    const int input_width = input->dim[3];
-    const int output_height = output->dim[2];
-    const int output_width = output->dim[3];
-
-    for (int batch = 0; batch < batches; ++batch) {
-        for (int out_y = 0; out_y < output_height; ++out_y) {
-            for (int out_x = 0; out_x < output_width; ++out_x) {
-                for (int channel = 0; channel < depth; ++channel) {
-                    const int in_x_origin = (out_x * params->stride_width) - params->pad_left;
-                    const int in_y_origin = (out_y * params->stride_height) - params->pad_top;
-                    // Compute the boundaries of the filter region clamped so as to
-                    // ensure that the filter window fits in the input array.
-                    const int filter_x_start = shl_ref_max_internal_s32(0, -in_x_origin);
-                    const int filter_x_end =
-                        shl_ref_min_internal_s32(params->filter_width, input_width - in_x_origin);
-                    const int filter_y_start = shl_ref_max_internal_s32(0, -in_y_origin);
-                    const int filter_y_end =
-                        shl_ref_min_internal_s32(params->filter_height, input_height - in_y_origin);
-                    float total = 0.f;
-                    float filter_count = 0;
-                    for (int filter_y = filter_y_start; filter_y < filter_y_end; ++filter_y) {
-                        for (int filter_x = filter_x_start; filter_x < filter_x_end; ++filter_x) {
-                            const int in_x = in_x_origin + filter_x;
-                            const int in_y = in_y_origin + filter_y;
-                            total += input_data[shl_ref_get_index(input->dim, batch, channel, in_y,
-                                                                  in_x)];
-                            filter_count++;
+    const int row_size = in_w * inner;
+    const bool prefix = col_pre != NULL && avgpool2d_plane_finite(input_data, in_h * row_size);
+
+    if (prefix) {
+        memset(col_pre, 0, row_size * sizeof(double));
+        for (int y = 0; y < in_h; ++y) {
+            const float *in = input_data + y * row_size;
+            const double *prev = col_pre + y * row_size;
+            double *next = col_pre + (y + 1) * row_size;
+            for (int j = 0; j < row_size; ++j) {
+                next[j] = prev[j] + in[j];
+            }
+        }
+    }
+
+    for (int out_y = 0; out_y < out_h; ++out_y) {
+        const int in_y_origin = (out_y * params->stride_height) - params->pad_top;
+        const int y_start = shl_ref_max_internal_s32(0, in_y_origin);
+        const int y_end = shl_ref_max_internal_s32(
+            y_start, shl_ref_min_internal_s32(in_h, in_y_origin + params->filter_height));
+
+        if (prefix) {
+            const double *top = col_pre + y_start * row_size;
+            const double *bottom = col_pre + y_end * row_size;
+            memset(row_pre, 0, inner * sizeof(double));
+            for (int x = 0; x < in_w; ++x) {
+                for (int i = 0; i < inner; ++i) {
+                    const int j = x * inner + i;
+                    row_pre[j + inner] = row_pre[j] + (bottom[j] - top[j]);
+                }
+            }
+        }
+
+        for (int out_x = 0; out_x < out_w; ++out_x) {
+            const int in_x_origin = (out_x * params->stride_width) - params->pad_left;
+            const int x_start = shl_ref_max_internal_s32(0, in_x_origin);
+            const int x_end = shl_ref_max_internal_s32(
+                x_start, shl_ref_min_internal_s32(in_w, in_x_origin + params->filter_width));
+            float *out = output_data + (out_y * out_w + out_x) * inner;
+
+            if (prefix) {
+                for (int i = 0; i < inner; ++i) {
+                    out[i] = row_pre[x_end * inner + i] - row_pre[x_start * inner + i];
+                }
+            } else {
+                for (int i = 0; i < inner; ++i) {
+                    out[i] = 0.f;
+                }
+                for (int y = y_start; y < y_end; ++y) {
+                    for (int x = x_start; x < x_end; ++x) {
+                        const float *in = input_data + (y * in_w + x) * inner;
+                        for (int i = 0; i < inner; ++i) {
+                            out[i] += in[i];
                         }
                     }
-                    if (params->count_include_pad) {
-                        filter_count = params->filter_height * params->filter_width;
-                    }
-                    const float average = total / filter_count;
-                    output_data[shl_ref_get_index(output->dim, batch, channel, out_y, out_x)] =
-                        average;
                 }
             }
+
+            float filter_count = (y_end - y_start) * (x_end - x_start);
+            if (params->count_include_pad) {
+                filter_count = params->filter_height * params->filter_width;
+            }
+            for (int i = 0; i < inner; ++i) {
+                out[i] = out[i] / filter_count;
+            }
         }
     }
+}
+
+static int shl_ref_avgpool2d_planes_f32(float *input_data, float *output_data, int planes,
+                                        int in_h, int in_w, int out_h, int out_w, int inner,
+                                        struct csinn_pool_params *params)
+{
+    double *col_pre = NULL;
+    double *row_pre = NULL;
+
+    if (params->filter_height * params->filter_width > AVGPOOL_DIRECT_WINDOW) {
+        col_pre = shl_mem_alloc((in_h + 1) * in_w * inner * sizeof(double));
+        row_pre = shl_mem_alloc((in_w + 1) * inner * sizeof(double));
+    }
+
+    for (int plane = 0; plane < planes; ++plane) {
+        avgpool2d_plane_f32(input_data + plane * in_h * in_w * inner,
+                            output_data + plane * out_h * out_w * inner, in_h, in_w, out_h, out_w,
+                            inner, params, col_pre, row_pre);
+    }
+
+    if (col_pre != NULL) {
+        shl_mem_free(col_pre);
+        shl_mem_free(row_pre);
+    }
     return CSINN_TRUE;
 }
 
+int shl_ref_avgpool2d_nhwc_f32(struct csinn_tensor *input, struct csinn_tensor *output,
+                               struct csinn_pool_params *params)
+{
+    return shl_ref_avgpool2d_planes_f32(input->data, output->data, input->dim[0], input->dim[1],
+                                        input->dim[2], output->dim[1], output->dim[2],
+                                        input->dim[3], params);
+}
+
+static int shl_ref_avgpool2d_nchw_f32(struct csinn_tensor *input, struct csinn_tensor *output,
+                                      struct csinn_pool_params *params)
+{
+    return shl_ref_avgpool2d_planes_f32(input->data, output->data, input->dim[0] * input->dim[1],
+                                        input->dim[2], input->dim[3], output->dim[2],
+                                        output->dim[3], 1, params);
+}
+
 int shl_ref_avgpool2d_f32(struct csinn_tensor *input, struct csinn_tensor *output,
                           struct csinn_pool_params *params)
 {
     if (params->base.layout == CSINN_LAYOUT_NCHW) {
-        shl_ref_avgpool2d_nchw_f32(input, output, params);
-    } else if (params->base.layout = CSINN_LAYOUT_NHWC) {
-        shl_ref_avgpool2d_nhwc_f32(input, output, params);
+        return shl_ref_avgpool2d_nchw_f32(input, output, params);
+    } else if (params->base.layout == CSINN_LAYOUT_NHWC) {
+        return shl_ref_avgpool2d_nhwc_f32(input, output, params);
     } else {
         return CSINN_UNSUPPORT_LAYOUT;
     }
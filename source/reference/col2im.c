@@ -20,6 +20,80 @@
 
 #include "shl_ref.h"
 
+/*
+ * Accumulate rows [h_start, h_end) of a column buffer laid out as
+ * [height_col][width_col][filter_h][filter_w][depth] into an NHWC image plane.
+ * col points at row h_start.
+ */
+void shl_ref_col2im_nhwc_acc_f32(const float *col, float *im, int height, int width, int depth,
+                                 int filter_h, int filter_w, int pad_t, int pad_l, int stride_h,
+                                 int stride_w, int h_start, int h_end, int width_col)
+{
+    const int patch_size = filter_h * filter_w * depth;
+    for (int h = h_start; h < h_end; ++h) {
+        const int h_pad = h * stride_h - pad_t;
+        const int kh_start = shl_ref_max_internal_s32(0, -h_pad);
+        const int kh_end = shl_ref_min_internal_s32(filter_h, height - h_pad);
+        for (int w = 0; w < width_col; ++w) {
+            const int w_pad = w * stride_w - pad_l;
+            const int kw_start = shl_ref_max_internal_s32(0, -w_pad);
+            const int kw_end = shl_ref_min_internal_s32(filter_w, width - w_pad);
+            const float *patch = col + ((h - h_start) * width_col + w) * patch_size;
+            for (int kh = kh_start; kh < kh_end; ++kh) {
+                float *im_row = im + ((h_pad + kh) * width + w_pad) * depth;
+                const float *col_row = patch + kh * filter_w * depth;
+                for (int kw = kw_start; kw < kw_end; ++kw) {
+                    float *dst = im_row + kw * depth;
+                    const float *src = col_row + kw * depth;
+                    for (int i = 0; i < depth; ++i) {
+                        dst[i] += src[i];
+                    }
+                }
+            }
+        }
+    }
+}
+
+/*
+ * Accumulate rows [h_start, h_end) of a column buffer laid out as
+ * [depth][filter_h][filter_w][h_end - h_start][width_col] into a CHW image.
+ */
+void shl_ref_col2im_nchw_acc_f32(const float *col, float *im, int height, int width, int depth,
+                                 int filter_h, int filter_w, int pad_t, int pad_l, int stride_h,
+                                 int stride_w, int h_start, int h_end, int width_col)
+{
+    const int col_plane = (h_end - h_start) * width_col;
+    for (int c = 0; c < depth; ++c) {
+        float *im_plane = im + c * height * width;
+        for (int kh = 0; kh < filter_h; ++kh) {
+            for (int kw = 0; kw < filter_w; ++kw) {
+                const float *col_kernel =
+                    col + ((c * filter_h + kh) * filter_w + kw) * col_plane;
+                /* columns w whose output x = w * stride_w - pad_l + kw lies in [0, width) */
+                const int x_off = kw - pad_l;
+                const int w_start =
+                    x_off >= 0 ? 0 : shl_ref_min_internal_s32(width_col,
+                                                              (-x_off + stride_w - 1) / stride_w);
+                const int w_end = x_off >= width
+                                      ? 0
+                                      : shl_ref_min_internal_s32(
+                                            width_col, (width - 1 - x_off) / stride_w + 1);
+                for (int h = h_start; h < h_end; ++h) {
+                    const int y = h * stride_h - pad_t + kh;
+                    if (y < 0 || y >= height) {
+                        continue;
+                    }
+                    const float *src = col_kernel + (h - h_start) * width_col;
+                    float *dst = im_plane + y * width;
+                    for (int w = w_start; w < w_end; ++w) {
+                        dst[w * stride_w + x_off] += src[w];
+                    }
+                }
+            }
+        }
+    }
+}
+
 int shl_ref_col2im_f32(struct csinn_tensor *input, struct csinn_tensor *output,
                        struct csinn_tensor *kernel, struct csinn_col2im_params *params)
 {
@@ -32,31 +106,11 @@ int shl_ref_col2im_f32(struct csinn_tensor *input, struct csinn_tensor *output,
     int32_t pad_b = params->pad_h;
     int32_t pad_l = params->pad_w;
     int32_t pad_r = params->pad_w;
-    float *col_data = input->data;
     int height_col = (height + pad_t + pad_b - filter_h) / params->stride_h + 1;
     int width_col = (width + pad_l + pad_r - filter_w) / params->stride_w + 1;
-    int h_pad = -pad_t;
-    for (int h = 0; h < height_col; ++h) {
-        int w_pad = -pad_l;
-        for (int w = 0; w < width_col; ++w) {
-            float *im_patch_data = output->data + (h_pad * width + w_pad) * depth;
-            for (int ih = h_pad; ih < h_pad + filter_h; ++ih) {
-                for (int iw = w_pad; iw < w_pad + filter_w; ++iw) {
-                    if (ih >= 0 && ih < height && iw >= 0 && iw < width) {
-                        // TODO(andydavis) Vectorize this loop (if compiler does not).
-                        for (int i = 0; i < depth; ++i) {
-                            im_patch_data[i] += col_data[i];
-                        }
-                    }
-                    im_patch_data += depth;
-                    col_data += depth;
-                }
-                // Jump over remaining number of depth.
-                im_patch_data += depth * (width - filter_w);
-            }
-            w_pad += params->stride_w;
-        }
-        h_pad += params->stride_h;
-    }
+
+    shl_ref_col2im_nhwc_acc_f32(input->data, output->data, height, width, depth, filter_h,
+                                filter_w, pad_t, pad_l, params->stride_h, params->stride_w, 0,
+                                height_col, width_col);
     return CSINN_TRUE;
 }
@@ -20,33 +20,60 @@
 
 #include "shl_ref.h"
 
-int shl_ref_concat_f32(struct csinn_tensor **input, struct csinn_tensor *output,
-                       struct csinn_concat_params *params)
+int shl_ref_concat_init(struct csinn_tensor **input, struct csinn_tensor *output,
+                        struct csinn_concat_params *params)
+{
+    struct csinn_callback *cb = params->base.cb;
+    for (int i = 0; i < params->inputs_count; i++) {
+        if (!shl_ref_is_same_quant(input[i], output)) {
+            cb->exec = shl_ref_concat_quant;
+            return CSINN_TRUE;
+        }
+    }
+    cb->exec = shl_ref_concat;
+    return CSINN_TRUE;
+}
+
+static int concat_copy(struct csinn_tensor **input, struct csinn_tensor *output,
+                       struct csinn_concat_params *params, int elem_size)
 {
+    int axis = params->axis < 0 ? params->axis + output->dim_count : params->axis;
     int64_t outer_size = 1;
-    for (int i = 0; i < params->axis; ++i) {
+    for (int i = 0; i < axis; ++i) {
         outer_size *= output->dim[i];
     }
 
     int64_t base_inner_size = 1;
-    for (int i = params->axis + 1; i < output->dim_count; ++i) {
+    for (int i = axis + 1; i < output->dim_count; ++i) {
         base_inner_size *= output->dim[i];
     }
 
-    float *output_ptr = output->data;
+    char *output_ptr = output->data;
     for (int k = 0; k < outer_size; k++) {
         for (int i = 0; i < params->inputs_count; ++i) {
             struct csinn_tensor *input_item = input[i];
-            float *input_item_data = input_item->data;
-            const int copy_size = input_item->dim[params->axis] * base_inner_size;
-            const float *input_ptr = input_item_data + k * copy_size;
-            memcpy(output_ptr, input_ptr, copy_size * sizeof(float));
+            const int64_t copy_size = input_item->dim[axis] * base_inner_size * elem_size;
+            const char *input_ptr = (char *)input_item->data + k * copy_size;
+            memcpy(output_ptr, input_ptr, copy_size);
             output_ptr += copy_size;
         }
     }
     return CSINN_TRUE;
 }
 
+int shl_ref_concat_f32(struct csinn_tensor **input, struct csinn_tensor *output,
+                       struct csinn_concat_params *params)
+{
+    return concat_copy(input, output, params, sizeof(float));
+}
+
+/* inputs and output share dtype and quantization, move raw elements */
+int shl_ref_concat(struct csinn_tensor **input, struct csinn_tensor *output,
+                   struct csinn_concat_params *params)
+{
+    return concat_copy(input, output, params, shl_ref_get_dtype_size(output->dtype));
+}
+
 int shl_ref_concat_quant(struct csinn_tensor **input, struct csinn_tensor *output,
                          struct csinn_concat_params *params)
 {
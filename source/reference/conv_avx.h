@@ -106,118 +106,117 @@ static void conv_trans_kernel_avx(struct csinn_tensor* o_kernel, struct csinn_te
     }
 }
 
-static void conv_im2col_sgemm_avx(struct csinn_tensor* input, struct csinn_tensor* output,
-                                  struct csinn_tensor* kernel_tm, struct csinn_tensor* o_bias,
-                                  int64_t kernel_w, int64_t kernel_h, int64_t stride_w,
-                                  int64_t stride_h)
+/*
+ * Implicit GEMM: the output pixels are walked in tiles and only the current
+ * tile of the [inch * kh * kw][outh * outw] im2col matrix is packed, straight
+ * from the unpadded input. Padding taps read as zero, so neither the padded
+ * input copy nor the full im2col matrix is ever built and the scratch buffer
+ * stays within an L2 sized budget however large the feature map is.
+ */
+#define CONV_IMPLICIT_GEMM_TILE_BYTES (256 * 1024)
+
+/* output pixels per tile, a multiple of the 8 column panel width */
+static int64_t conv_implicit_gemm_tile(int64_t L, int64_t N)
 {
-    int64_t w = input->dim[3];
-    int64_t inch = input->dim[1];
+    int64_t tile_n = CONV_IMPLICIT_GEMM_TILE_BYTES / (L * (int64_t)sizeof(float)) / 8 * 8;
+    if (tile_n < 8) {
+        tile_n = 8;
+    }
+    return tile_n < N ? tile_n : N;
+}
 
-    int64_t outw = output->dim[3];
-    int64_t outh = output->dim[2];
-    int64_t outch = output->dim[1];
+/* packed B panel bytes for n output pixels */
+static int64_t conv_implicit_gemm_panel_bytes(int64_t L, int64_t n)
+{
+    return 8 * L * (n / 8 + n % 8) * (int64_t)sizeof(float);
+}
 
-    float* bias = o_bias->data;
-    if (o_bias->dim_count == 0) {
-        bias = NULL;
-    }
+static void conv_implicit_gemm_report(struct csinn_tensor* input, struct csinn_tensor* output,
+                                      struct csinn_conv2d_params* params, int64_t L, int64_t tile_n)
+{
+    int64_t N = output->dim[2] * output->dim[3];
+    int64_t padded = (int64_t)input->dim[0] * input->dim[1] *
+                     (input->dim[2] + params->pad_top + params->pad_down) *
+                     (input->dim[3] + params->pad_left + params->pad_right) * sizeof(float);
+    int64_t im2col = padded + L * N * sizeof(float) + conv_implicit_gemm_panel_bytes(L, N);
+    shl_debug_info("%s: implicit gemm scratch %ld bytes (tile %ld pixels), im2col path %ld bytes\n",
+                   params->base.name, (long)conv_implicit_gemm_panel_bytes(L, tile_n),
+                   (long)tile_n, (long)im2col);
+}
 
-    // im2col
-    struct csinn_tensor* bottom_im2col = csinn_alloc_tensor(NULL);
-    csinn_tensor_copy(bottom_im2col, input);
-    bottom_im2col->data = shl_mem_alloc(outw * outh * kernel_h * kernel_w * inch * sizeof(float));
-    bottom_im2col->dim[0] = 0;
-    bottom_im2col->dim[1] = 0;
-    bottom_im2col->dim[2] = kernel_h * kernel_w * inch;
-    bottom_im2col->dim[3] = outw * outh;
-    {
-        const int64_t stride = kernel_h * kernel_w * outw * outh;
-        float* ret = (float*)bottom_im2col->data;
+/* pack output pixels [col, col + n) of one image into bottom_tm */
+static void conv_implicit_gemm_pack_avx(const float* in, struct csinn_tensor* bottom_tm,
+                                        int64_t col, int64_t n, int64_t inch, int64_t h, int64_t w,
+                                        int64_t outw, int64_t kernel_h, int64_t kernel_w,
+                                        struct csinn_conv2d_params* params)
+{
+    const int64_t stride_h = params->stride_height;
+    const int64_t stride_w = params->stride_width;
+    const int64_t dilation_h = params->dilation_height;
+    const int64_t dilation_w = params->dilation_width;
+    const int64_t nn_size = n >> 3;
+    const int64_t remain_size_start = nn_size << 3;
 
 #pragma omp parallel for num_threads(8)
+    for (int64_t ii = 0; ii < nn_size; ii++) {
+        int64_t iy0[8], ix0[8];
+        for (int64_t k = 0; k < 8; k++) {
+            int64_t p = col + ii * 8 + k;
+            iy0[k] = p / outw * stride_h - params->pad_top;
+            ix0[k] = p % outw * stride_w - params->pad_left;
+        }
+        /* all 8 pixels on one output row with unit stride read contiguous input */
+        bool same_row = iy0[0] == iy0[7] && stride_w == 1;
+
+        float* tmpptr = channel(bottom_tm, ii);
         for (int64_t p = 0; p < inch; p++) {
-            const float* in = channel(input, p);
-            int64_t retID = stride * p;
+            const float* img = in + p * h * w;
             for (int64_t u = 0; u < kernel_h; u++) {
                 for (int64_t v = 0; v < kernel_w; v++) {
-                    for (int64_t i = 0; i < outh; i++) {
-                        for (int64_t j = 0; j < outw; j++) {
-                            int64_t row = u + i * stride_h;
-                            int64_t col = v + j * stride_w;
-                            int64_t index = row * w + col;
-                            ret[retID] = in[index];
-                            retID++;
+                    int64_t iy = iy0[0] + u * dilation_h;
+                    int64_t ix = ix0[0] + v * dilation_w;
+                    if (same_row && iy >= 0 && iy < h && ix >= 0 && ix + 7 < w) {
+                        _mm256_storeu_ps(tmpptr, _mm256_loadu_ps(img + iy * w + ix));
+                    } else {
+                        for (int64_t k = 0; k < 8; k++) {
+                            iy = iy0[k] + u * dilation_h;
+                            ix = ix0[k] + v * dilation_w;
+                            bool inside = iy >= 0 && iy < h && ix >= 0 && ix < w;
+                            tmpptr[k] = inside ? img[iy * w + ix] : 0.0f;
                         }
                     }
+                    tmpptr += 8;
                 }
             }
         }
     }
 
-    int64_t kernel_size = kernel_w * kernel_h;
-    int64_t out_size = outw * outh;
-
-    // bottom_im2col memory packed 8 x 8
-    struct csinn_tensor* bottom_tm = csinn_alloc_tensor(NULL);
-    csinn_tensor_copy(bottom_tm, input);
-    bottom_tm->data = shl_mem_alloc(8 * kernel_size * inch * (out_size / 8 + out_size % 8) * 4);
-    bottom_tm->dim[0] = 0;
-    bottom_tm->dim[1] = out_size / 8 + out_size % 8;
-    bottom_tm->dim[2] = inch;
-    bottom_tm->dim[3] = 8 * kernel_size;
-    {
-        int64_t nn_size = out_size >> 3;
-        int64_t remain_size_start = nn_size << 3;
-
-#pragma omp parallel for num_threads(8)
-        for (int64_t ii = 0; ii < nn_size; ii++) {
-            int64_t i = ii * 8;
-
-            const float* img0 = channel(bottom_im2col, 0);
-            img0 += i;
-
-            float* tmpptr = channel(bottom_tm, (i / 8));
-
-            for (int64_t q = 0; q < inch * kernel_size; q++) {
-#ifdef SHL_AVX_OPT
-                _mm256_storeu_ps(tmpptr, _mm256_loadu_ps(img0));
-#else
-                tmpptr[0] = img0[0];
-                tmpptr[1] = img0[1];
-                tmpptr[2] = img0[2];
-                tmpptr[3] = img0[3];
-                tmpptr[4] = img0[4];
-                tmpptr[5] = img0[5];
-                tmpptr[6] = img0[6];
-                tmpptr[7] = img0[7];
-#endif  // __SSE__
-                tmpptr += 8;
-                img0 += out_size;
-            }
-        }
-
-#pragma omp parallel for num_threads(8)
-        for (int64_t i = remain_size_start; i < out_size; i++) {
-            const float* img0 = channel(bottom_im2col, 0);
-            img0 += i;
-
-            float* tmpptr = channel(bottom_tm, (i / 8 + i % 8));
+    for (int64_t i = remain_size_start; i < n; i++) {
+        int64_t iy0 = (col + i) / outw * stride_h - params->pad_top;
+        int64_t ix0 = (col + i) % outw * stride_w - params->pad_left;
 
-            for (int64_t q = 0; q < inch * kernel_size; q++) {
-                tmpptr[0] = img0[0];
-
-                tmpptr += 1;
-                img0 += out_size;
+        float* tmpptr = channel(bottom_tm, (i / 8 + i % 8));
+        for (int64_t p = 0; p < inch; p++) {
+            const float* img = in + p * h * w;
+            for (int64_t u = 0; u < kernel_h; u++) {
+                for (int64_t v = 0; v < kernel_w; v++) {
+                    int64_t iy = iy0 + u * dilation_h;
+                    int64_t ix = ix0 + v * dilation_w;
+                    bool inside = iy >= 0 && iy < h && ix >= 0 && ix < w;
+                    *tmpptr++ = inside ? img[iy * w + ix] : 0.0f;
+                }
             }
         }
     }
+}
 
-    // sgemm(int64_t M, int64_t N, int64_t L, float* A, float* B, float* C)
+// sgemm(int64_t M, int64_t N, int64_t L, float* A, float* B, float* C)
+static void conv_sgemm_avx(struct csinn_tensor* output, struct csinn_tensor* bottom_tm,
+                           struct csinn_tensor* kernel_tm, float* bias, int64_t N, int64_t L)
+{
+    int64_t outch = output->dim[1];
     {
         // int64_t M = outch;                    // outch
-        int64_t N = outw * outh;                 // outsize or out stride
-        int64_t L = kernel_w * kernel_h * inch;  // ksize * inch
 
         int64_t nn_outch = 0;
         int64_t remain_outch_start = 0;
@@ -1000,8 +999,57 @@ static void conv_im2col_sgemm_avx(struct csinn_tensor* input, struct csinn_tenso
             }
         }
     }
+}
+
+static void conv_implicit_sgemm_avx(struct csinn_tensor* input, struct csinn_tensor* output,
+                                    struct csinn_tensor* kernel_tm, struct csinn_tensor* o_bias,
+                                    int64_t kernel_h, int64_t kernel_w,
+                                    struct csinn_conv2d_params* params)
+{
+    int64_t batch = input->dim[0];
+    int64_t inch = input->dim[1];
+    int64_t h = input->dim[2];
+    int64_t w = input->dim[3];
+
+    int64_t outch = output->dim[1];
+    int64_t outw = output->dim[3];
+    int64_t out_size = output->dim[2] * outw;
+
+    float* bias = o_bias->data;
+    if (o_bias->dim_count == 0) {
+        bias = NULL;
+    }
+
+    int64_t L = kernel_h * kernel_w * inch;
+    int64_t tile_n = conv_implicit_gemm_tile(L, out_size);
+    conv_implicit_gemm_report(input, output, params, L, tile_n);
+
+    // one tile of the im2col matrix, packed 8 x 8
+    struct csinn_tensor* bottom_tm = csinn_alloc_tensor(NULL);
+    csinn_tensor_copy(bottom_tm, input);
+    bottom_tm->data = shl_mem_alloc(conv_implicit_gemm_panel_bytes(L, tile_n));
+    bottom_tm->dim[0] = 0;
+    bottom_tm->dim[1] = tile_n / 8 + tile_n % 8;
+    bottom_tm->dim[2] = inch;
+    bottom_tm->dim[3] = 8 * kernel_h * kernel_w;
+
+    // output rows of a tile keep the full out_size stride
+    struct csinn_tensor out_tile = *output;
+    out_tile.dim[2] = 1;
+    out_tile.dim[3] = out_size;
+
+    for (int64_t b = 0; b < batch; b++) {
+        const float* in = (float*)input->data + b * inch * h * w;
+        float* out = (float*)output->data + b * outch * out_size;
+        for (int64_t col = 0; col < out_size; col += tile_n) {
+            int64_t n = out_size - col < tile_n ? out_size - col : tile_n;
+            conv_implicit_gemm_pack_avx(in, bottom_tm, col, n, inch, h, w, outw, kernel_h,
+                                        kernel_w, params);
+            out_tile.data = out + col;
+            conv_sgemm_avx(&out_tile, bottom_tm, kernel_tm, bias, n, L);
+        }
+    }
+
     shl_mem_free(bottom_tm->data);
-    shl_mem_free(bottom_tm);
-    shl_mem_free(bottom_im2col->data);
-    shl_mem_free(bottom_im2col);
+    csinn_free_tensor(bottom_tm);
 }
@@ -95,32 +95,12 @@ static int shl_ref_conv2d_nchw_f32(struct csinn_tensor *input, struct csinn_tens
                                    struct csinn_conv2d_params *params)
 {
 #ifdef SHL_AVX_OPT
-    struct csinn_tensor *t_input = csinn_alloc_tensor(NULL);
-    csinn_tensor_copy(t_input, input);
-    int32_t pad_b[4] = {0, 0, params->pad_top, params->pad_left};
-    int32_t pad_a[4] = {0, 0, params->pad_down, params->pad_right};
-    t_input->dim[2] = input->dim[2] + params->pad_top + params->pad_down;
-    t_input->dim[3] = input->dim[3] + params->pad_left + params->pad_right;
-    t_input->data =
-        shl_mem_alloc(t_input->dim[0] * t_input->dim[1] * t_input->dim[2] * t_input->dim[3] * 4);
-    struct csinn_pad_params pparams;
-    pparams.base.layout = CSINN_LAYOUT_NCHW;
-    pparams.base.api = CSINN_REF;
-    pparams.pad_before = pad_b;
-    pparams.pad_after = pad_a;
-    pparams.pad_num = 4;
-    pparams.pad_mode = 0;
-    pparams.pad_value = 0;
-    pparams.base.name = "tmp_pad";
-    shl_ref_pad_f32(input, t_input, &pparams);
-
     struct csinn_tensor *t_kernel = csinn_alloc_tensor(NULL);
     conv_trans_kernel_avx(kernel, t_kernel);
-    conv_im2col_sgemm_avx(t_input, output, t_kernel, bias, kernel->dim[3], kernel->dim[2],
-                          params->stride_width, params->stride_height);
+    conv_implicit_sgemm_avx(input, output, t_kernel, bias, kernel->dim[2], kernel->dim[3], params);
 
-    shl_mem_free(t_input->data);
     shl_mem_free(t_kernel->data);
+    csinn_free_tensor(t_kernel);
 #else
     struct csinn_tensor *t_input;
     struct csinn_tensor *t_output;
@@ -347,14 +327,238 @@ static int shl_ref_group_conv2d_nchw_f32(struct csinn_tensor *o_input,
     return CSINN_TRUE;
 }
 
+/* 1x1 stride 1 convolution without padding is one GEMM per image: out[oc, hw] = k[oc, ic] * in */
+static int shl_ref_conv2d_1x1_gemm_nchw_f32(struct csinn_tensor *input,
+                                            struct csinn_tensor *output,
+                                            struct csinn_tensor *kernel, struct csinn_tensor *bias,
+                                            struct csinn_conv2d_params *params)
+{
+    float *input_data = input->data;
+    float *output_data = output->data;
+    float *kernel_data = kernel->data;
+    float *bias_data = bias->data;
+    const int in_c = input->dim[1];
+    const int out_c = output->dim[1];
+    const int size = output->dim[2] * output->dim[3];
+
+    for (int b = 0; b < input->dim[0]; b++) {
+        float *out = output_data + b * out_c * size;
+        shl_ref_gemm_f32(out, kernel_data, input_data + b * in_c * size, out_c, in_c, size, in_c,
+                         size, size);
+        if (bias_data && bias->dim_count != 0) {
+            for (int oc = 0; oc < out_c; oc++) {
+                for (int i = 0; i < size; i++) {
+                    out[oc * size + i] += bias_data[oc];
+                }
+            }
+        }
+    }
+    return CSINN_TRUE;
+}
+
+/* algorithms shl_ref_conv2d_f32 can run a layer with */
+enum conv2d_algo {
+    CONV2D_ALGO_DIRECT = 0,
+    CONV2D_ALGO_GEMM_1X1,
+    CONV2D_ALGO_WINOGRAD_F4,
+    CONV2D_ALGO_WINOGRAD_F6,
+    CONV2D_ALGO_NUM,
+};
+
+static const char *conv2d_algo_name[CONV2D_ALGO_NUM] = {"direct", "gemm_1x1", "winograd_f4",
+                                                        "winograd_f6"};
+
+static bool conv2d_algo_support(enum conv2d_algo algo, struct csinn_tensor *input,
+                                struct csinn_tensor *kernel, struct csinn_conv2d_params *params)
+{
+    switch (algo) {
+        case CONV2D_ALGO_DIRECT:
+            return true;
+        case CONV2D_ALGO_GEMM_1X1:
+            return params->base.layout == CSINN_LAYOUT_NCHW && params->group == 1 &&
+                   kernel->dim[2] == 1 && kernel->dim[3] == 1 && params->stride_height == 1 &&
+                   params->stride_width == 1 && params->pad_top == 0 && params->pad_down == 0 &&
+                   params->pad_left == 0 && params->pad_right == 0;
+        case CONV2D_ALGO_WINOGRAD_F4:
+        case CONV2D_ALGO_WINOGRAD_F6:
+            return shl_ref_conv2d_winograd_support(input, kernel, params);
+        default:
+            return false;
+    }
+}
+
+static void conv2d_free_kernel_tm(struct csinn_conv2d_params *params)
+{
+    if (params->conv_extra.kernel_tm != NULL) {
+        shl_mem_free(params->conv_extra.kernel_tm->data);
+        csinn_free_tensor(params->conv_extra.kernel_tm);
+        params->conv_extra.kernel_tm = NULL;
+    }
+}
+
+static void conv2d_set_algo(enum conv2d_algo algo, struct csinn_tensor *kernel,
+                            struct csinn_conv2d_params *params)
+{
+    conv2d_free_kernel_tm(params);
+    params->conv_extra.conv_mode = CSINN_DIRECT;
+    if (algo == CONV2D_ALGO_GEMM_1X1) {
+        params->conv_extra.conv_mode = CSINN_GEMM;
+    } else if (algo == CONV2D_ALGO_WINOGRAD_F4 || algo == CONV2D_ALGO_WINOGRAD_F6) {
+        int m = algo == CONV2D_ALGO_WINOGRAD_F4 ? 4 : 6;
+        struct csinn_tensor *t_kernel = csinn_alloc_tensor(NULL);
+        if (kernel->dtype == CSINN_DTYPE_FLOAT32) {
+            shl_ref_wg_f3s1_trans_kernel_f32(kernel, t_kernel, m, params->base.layout);
+        } else {
+            struct csinn_tensor *float_kernel = shl_ref_tensor_transform_f32(kernel);
+            shl_ref_wg_f3s1_trans_kernel_f32(float_kernel, t_kernel, m, params->base.layout);
+            shl_ref_tensor_transform_free_f32(float_kernel);
+        }
+        params->conv_extra.kernel_tm = t_kernel;
+        params->conv_extra.conv_mode = CSINN_WINOGRAD;
+    }
+}
+
+static struct csinn_tensor *conv2d_tune_tensor(struct csinn_tensor *t)
+{
+    struct csinn_tensor *ret = csinn_alloc_tensor(NULL);
+    csinn_tensor_copy(ret, t);
+    ret->dtype = CSINN_DTYPE_FLOAT32;
+    ret->data = shl_mem_alloc(csinn_tensor_size(t) * sizeof(float));
+    float *data = ret->data;
+    uint32_t seed = 1;
+    for (int i = 0; i < csinn_tensor_size(t); i++) {
+        seed = seed * 1664525 + 1013904223;
+        data[i] = (float)(seed >> 8) / 16777216.0f - 0.5f;
+    }
+    return ret;
+}
+
+/* best of a few runs after a warm up, in microseconds */
+static float conv2d_time_algo(enum conv2d_algo algo, struct csinn_tensor *input,
+                              struct csinn_tensor *output, struct csinn_tensor *kernel,
+                              struct csinn_tensor *bias, struct csinn_conv2d_params *params)
+{
+    conv2d_set_algo(algo, kernel, params);
+    shl_ref_conv2d_f32(input, output, kernel, bias, params);
+    uint64_t best = UINT64_MAX;
+    for (int i = 0; i < 3; i++) {
+        uint64_t start = shl_get_timespec();
+        shl_ref_conv2d_f32(input, output, kernel, bias, params);
+        uint64_t time = shl_get_timespec() - start;
+        best = time < best ? time : best;
+    }
+    return best / 1000.0f;
+}
+
+/*
+ * Pick the algorithm of a layer for a session with autotuning enabled. A decision for the same
+ * key is reused, otherwise every supported algorithm runs on synthetic data of the layer shape
+ * with the layer's own weights, and the fastest one is recorded.
+ */
+static enum conv2d_algo conv2d_autotune(struct csinn_tensor *input, struct csinn_tensor *output,
+                                        struct csinn_tensor *kernel, struct csinn_tensor *bias,
+                                        struct csinn_conv2d_params *params)
+{
+    struct csinn_tuning *tuning = params->base.sess->tuning;
+    char key[256];
+#ifdef SHL_AVX_OPT
+    shl_tuning_conv2d_key(key, sizeof(key), "ref_avx", input, output, kernel, params);
+#else
+    shl_tuning_conv2d_key(key, sizeof(key), "ref", input, output, kernel, params);
+#endif
+
+    struct csinn_tuning_entry *entry = shl_tuning_find(tuning, key);
+    if (entry != NULL) {
+        for (int algo = 0; algo < CONV2D_ALGO_NUM; algo++) {
+            if (strcmp(entry->algo, conv2d_algo_name[algo]) == 0 &&
+                conv2d_algo_support(algo, input, kernel, params)) {
+                tuning->reused++;
+                return algo;
+            }
+        }
+    }
+
+    struct csinn_tensor *t_input = conv2d_tune_tensor(input);
+    struct csinn_tensor *t_output = conv2d_tune_tensor(output);
+    struct csinn_tensor *t_kernel = shl_ref_tensor_transform_f32(kernel);
+    struct csinn_tensor *t_bias = csinn_alloc_tensor(NULL);
+    t_bias->dim[0] = kernel->dim[0];
+    t_bias->dim_count = 1;
+    t_bias->dtype = CSINN_DTYPE_FLOAT32;
+    t_bias->data = shl_mem_alloc(kernel->dim[0] * sizeof(float));
+
+    enum conv2d_algo best = CONV2D_ALGO_DIRECT;
+    float best_time = 0;
+    for (int algo = 0; algo < CONV2D_ALGO_NUM; algo++) {
+        if (!conv2d_algo_support(algo, input, kernel, params)) {
+            continue;
+        }
+        float time = conv2d_time_algo(algo, t_input, t_output, t_kernel, t_bias, params);
+        shl_debug_info("[autotune]: %s %s %.1f us\n", key, conv2d_algo_name[algo], time);
+        if (algo == CONV2D_ALGO_DIRECT || time < best_time) {
+            best = algo;
+            best_time = time;
+        }
+    }
+    shl_ref_tensor_transform_free_f32(t_input);
+    shl_ref_tensor_transform_free_f32(t_output);
+    shl_ref_tensor_transform_free_f32(t_kernel);
+    shl_ref_tensor_transform_free_f32(t_bias);
+
+    tuning->measured++;
+    shl_tuning_add(tuning, key, conv2d_algo_name[best], best_time);
+    return best;
+}
+
+/*
+ * Pick the algorithm once the kernel is known: 3x3 stride 1 convolutions get their Winograd
+ * transformed kernel cached in conv_extra.kernel_tm, everything else stays on the direct path.
+ * With autotuning enabled on the session the choice is measured instead.
+ */
+int shl_ref_conv2d_init(struct csinn_tensor *input, struct csinn_tensor *output,
+                        struct csinn_tensor *kernel, struct csinn_tensor *bias,
+                        struct csinn_conv2d_params *params)
+{
+    if (kernel->data == NULL || shl_ref_is_sparse_weight(kernel)) {
+        return CSINN_TRUE;
+    }
+    struct csinn_session *sess = params->base.sess;
+    if (sess != NULL && sess->tuning != NULL) {
+        conv2d_set_algo(conv2d_autotune(input, output, kernel, bias, params), kernel, params);
+        return CSINN_TRUE;
+    }
+    if (!shl_ref_conv2d_winograd_support(input, kernel, params)) {
+        return CSINN_TRUE;
+    }
+
+    int out_h = params->base.layout == CSINN_LAYOUT_NCHW ? output->dim[2] : output->dim[1];
+    int out_w = params->base.layout == CSINN_LAYOUT_NCHW ? output->dim[3] : output->dim[2];
+    int m = shl_ref_wg_f3s1_select_tile(out_h, out_w);
+    conv2d_set_algo(m == 4 ? CONV2D_ALGO_WINOGRAD_F4 : CONV2D_ALGO_WINOGRAD_F6, kernel, params);
+    return CSINN_TRUE;
+}
+
+void shl_ref_conv2d_deinit(struct csinn_conv2d_params *params) { conv2d_free_kernel_tm(params); }
+
 int shl_ref_conv2d_f32(struct csinn_tensor *input, struct csinn_tensor *output,
                        struct csinn_tensor *kernel, struct csinn_tensor *bias,
                        struct csinn_conv2d_params *params)
 {
+    if (shl_ref_is_sparse_weight(kernel)) {
+        return shl_ref_conv2d_sparse_f32(input, output, kernel, bias, params);
+    }
+    if (params->conv_extra.conv_mode == CSINN_WINOGRAD && params->conv_extra.kernel_tm != NULL) {
+        return shl_ref_conv2d_winograd_f32(input, output, kernel, bias, params);
+    }
+    /* other backends set CSINN_GEMM too, the 1x1 GEMM kernel only covers its own case */
+    if (params->conv_extra.conv_mode == CSINN_GEMM &&
+        conv2d_algo_support(CONV2D_ALGO_GEMM_1X1, input, kernel, params)) {
+        return shl_ref_conv2d_1x1_gemm_nchw_f32(input, output, kernel, bias, params);
+    }
     if (params->base.layout == CSINN_LAYOUT_NHWC) {
-        shl_ref_conv2d_nhwc_f32(input, output, kernel, bias, params);
+        return shl_ref_conv2d_nhwc_f32(input, output, kernel, bias, params);
     } else if (params->base.layout == CSINN_LAYOUT_NCHW) {
-        shl_ref_conv2d_nchw_f32(input, output, kernel, bias, params);
+        return shl_ref_conv2d_nchw_f32(input, output, kernel, bias, params);
     } else {
         return CSINN_UNSUPPORT_LAYOUT;
     }
@@ -455,6 +659,9 @@ int shl_ref_group_conv2d_f32(struct csinn_tensor *input, struct csinn_tensor *ou
                              struct csinn_tensor *kernel, struct csinn_tensor *bias,
                              struct csinn_conv2d_params *params)
 {
+    if (shl_ref_is_sparse_weight(kernel)) {
+        return shl_ref_conv2d_sparse_f32(input, output, kernel, bias, params);
+    }
     if (params->base.layout == CSINN_LAYOUT_NHWC) {
         shl_ref_group_conv2d_nhwc_f32(input, output, kernel, bias, params);
     } else if (params->base.layout == CSINN_LAYOUT_NCHW) {
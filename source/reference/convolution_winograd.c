@@ -0,0 +1,357 @@
+/*
+ * Copyright (C) 2016-2022 T-Head Semiconductor Co., Ltd. All rights reserved.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* CSI-NN2 version 2.0.x */
+
+#include "shl_ref.h"
+
+/*
+ * Winograd F(m, 3) for 3x3 stride 1 convolution, m = 4 (tile 6x6) or m = 6 (tile 8x8).
+ * kernel_tm holds U = G g G^T laid out as [tile * tile][in_c][out_c], so every transformed
+ * position is an independent (tiles x in_c) * (in_c x out_c) GEMM running along out_c.
+ * That keeps the GEMM efficient for late layers where only a handful of tiles exist.
+ * Input tiles are read through strides, so NCHW and NHWC share the same code.
+ */
+#define WINOGRAD_BUF_SIZE (1 << 19)
+#define WINOGRAD_MIN_TILES 16
+#define WINOGRAD_MIN_CHANNEL 4
+#define WINOGRAD_MAX_TILE 8
+
+/* F(4, 3), interpolation points 0, +-1, +-2, inf */
+static const float wg_b4f3_g[6][3] = {{1.0f / 4, 0.0f, 0.0f},
+                                      {-1.0f / 6, -1.0f / 6, -1.0f / 6},
+                                      {-1.0f / 6, 1.0f / 6, -1.0f / 6},
+                                      {1.0f / 24, 1.0f / 12, 1.0f / 6},
+                                      {1.0f / 24, -1.0f / 12, 1.0f / 6},
+                                      {0.0f, 0.0f, 1.0f}};
+
+static const float wg_b4f3_bt[6][6] = {
+    {4, 0, -5, 0, 1, 0},  {0, -4, -4, 1, 1, 0}, {0, 4, -4, -1, 1, 0},
+    {0, -2, -1, 2, 1, 0}, {0, 2, -1, -2, 1, 0}, {0, 4, 0, -5, 0, 1}};
+
+static const float wg_b4f3_at[4][6] = {
+    {1, 1, 1, 1, 1, 0}, {0, 1, -1, 2, -2, 0}, {0, 1, 1, 4, 4, 0}, {0, 1, -1, 8, -8, 1}};
+
+/* F(6, 3), interpolation points 0, +-1, +-2, +-1/2, inf */
+static const float wg_b6f3_g[8][3] = {{1.0f, 0.0f, 0.0f},
+                                      {-2.0f / 9, -2.0f / 9, -2.0f / 9},
+                                      {-2.0f / 9, 2.0f / 9, -2.0f / 9},
+                                      {1.0f / 90, 1.0f / 45, 2.0f / 45},
+                                      {1.0f / 90, -1.0f / 45, 2.0f / 45},
+                                      {32.0f / 45, 16.0f / 45, 8.0f / 45},
+                                      {32.0f / 45, -16.0f / 45, 8.0f / 45},
+                                      {0.0f, 0.0f, 1.0f}};
+
+static const float wg_b6f3_bt[8][8] = {{1, 0, -5.25f, 0, 5.25f, 0, -1, 0},
+                                       {0, 1, 1, -4.25f, -4.25f, 1, 1, 0},
+                                       {0, -1, 1, 4.25f, -4.25f, -1, 1, 0},
+                                       {0, 0.5f, 0.25f, -2.5f, -1.25f, 2, 1, 0},
+                                       {0, -0.5f, 0.25f, 2.5f, -1.25f, -2, 1, 0},
+                                       {0, 2, 4, -2.5f, -5, 0.5f, 1, 0},
+                                       {0, -2, 4, 2.5f, -5, -0.5f, 1, 0},
+                                       {0, -1, 0, 5.25f, 0, -5.25f, 0, 1}};
+
+static const float wg_b6f3_at[6][8] = {{1, 1, 1, 1, 1, 1, 1, 0},
+                                       {0, 1, -1, 2, -2, 0.5f, -0.5f, 0},
+                                       {0, 1, 1, 4, 4, 0.25f, 0.25f, 0},
+                                       {0, 1, -1, 8, -8, 0.125f, -0.125f, 0},
+                                       {0, 1, 1, 16, 16, 0.0625f, 0.0625f, 0},
+                                       {0, 1, -1, 32, -32, 0.03125f, -0.03125f, 1}};
+
+struct wg_f3s1_matrix {
+    int m;    /* output tile size */
+    int tile; /* input tile size, m + 2 */
+    const float *g;
+    const float *bt;
+    const float *at;
+};
+
+static void wg_f3s1_get_matrix(int m, struct wg_f3s1_matrix *mat)
+{
+    mat->m = m;
+    mat->tile = m + 2;
+    if (m == 4) {
+        mat->g = &wg_b4f3_g[0][0];
+        mat->bt = &wg_b4f3_bt[0][0];
+        mat->at = &wg_b4f3_at[0][0];
+    } else {
+        mat->g = &wg_b6f3_g[0][0];
+        mat->bt = &wg_b6f3_bt[0][0];
+        mat->at = &wg_b6f3_at[0][0];
+    }
+}
+
+/*
+ * Both tile sizes do the same GEMM work per transformed position, so the cost is roughly
+ * tiles * tile^2. F(6, 3) needs fewer multiplies per output but wastes more on ragged edges
+ * and loses a little accuracy, so F(4, 3) wins ties.
+ */
+int shl_ref_wg_f3s1_select_tile(int out_h, int out_w)
+{
+    int cost4 = ((out_h + 3) / 4) * ((out_w + 3) / 4) * 36;
+    int cost6 = ((out_h + 5) / 6) * ((out_w + 5) / 6) * 64;
+    return cost6 < cost4 ? 6 : 4;
+}
+
+bool shl_ref_conv2d_winograd_support(struct csinn_tensor *input, struct csinn_tensor *kernel,
+                                     struct csinn_conv2d_params *params)
+{
+    int kernel_h, kernel_w, in_c, out_c;
+    if (params->base.layout == CSINN_LAYOUT_NCHW) {
+        kernel_h = kernel->dim[2];
+        kernel_w = kernel->dim[3];
+        in_c = input->dim[1];
+    } else if (params->base.layout == CSINN_LAYOUT_NHWC) {
+        kernel_h = kernel->dim[1];
+        kernel_w = kernel->dim[2];
+        in_c = input->dim[3];
+    } else {
+        return false;
+    }
+    out_c = kernel->dim[0];
+    return kernel->dim_count == 4 && kernel_h == 3 && kernel_w == 3 && params->group == 1 &&
+           params->stride_height == 1 && params->stride_width == 1 &&
+           params->dilation_height == 1 && params->dilation_width == 1 &&
+           in_c >= WINOGRAD_MIN_CHANNEL && out_c >= WINOGRAD_MIN_CHANNEL;
+}
+
+/* U = G * g * G^T, stored as [tile * tile][in_c][out_c] */
+void shl_ref_wg_f3s1_trans_kernel_f32(struct csinn_tensor *src_kernel,
+                                      struct csinn_tensor *dst_kernel, int m,
+                                      enum csinn_layout_enum layout)
+{
+    struct wg_f3s1_matrix mat;
+    wg_f3s1_get_matrix(m, &mat);
+    const int tile = mat.tile;
+    const int out_c = src_kernel->dim[0];
+    const int in_c = layout == CSINN_LAYOUT_NCHW ? src_kernel->dim[1] : src_kernel->dim[3];
+    /* element (oc, ic, y, x) of the 3x3 kernel */
+    const int ic_stride = layout == CSINN_LAYOUT_NCHW ? 9 : 1;
+    const int y_stride = layout == CSINN_LAYOUT_NCHW ? 3 : 3 * in_c;
+    const int x_stride = layout == CSINN_LAYOUT_NCHW ? 1 : in_c;
+    float *kernel_data = src_kernel->data;
+    float *kernel_tm = shl_mem_alloc(tile * tile * out_c * in_c * sizeof(float));
+
+    float tmp[WINOGRAD_MAX_TILE][3];
+    for (int oc = 0; oc < out_c; oc++) {
+        for (int ic = 0; ic < in_c; ic++) {
+            const float *k0 = kernel_data + oc * in_c * 9 + ic * ic_stride;
+            /* tmp = G * g */
+            for (int i = 0; i < tile; i++) {
+                for (int x = 0; x < 3; x++) {
+                    float acc = 0.0f;
+                    for (int y = 0; y < 3; y++) {
+                        acc += mat.g[i * 3 + y] * k0[y * y_stride + x * x_stride];
+                    }
+                    tmp[i][x] = acc;
+                }
+            }
+            /* U = tmp * G^T */
+            for (int i = 0; i < tile; i++) {
+                for (int j = 0; j < tile; j++) {
+                    float acc = 0.0f;
+                    for (int x = 0; x < 3; x++) {
+                        acc += tmp[i][x] * mat.g[j * 3 + x];
+                    }
+                    kernel_tm[((i * tile + j) * in_c + ic) * out_c + oc] = acc;
+                }
+            }
+        }
+    }
+
+    dst_kernel->data = kernel_tm;
+    dst_kernel->dtype = CSINN_DTYPE_FLOAT32;
+    dst_kernel->layout = layout;
+    dst_kernel->is_const = 1;
+    dst_kernel->dim_count = 3;
+    dst_kernel->dim[0] = tile * tile;
+    dst_kernel->dim[1] = in_c;
+    dst_kernel->dim[2] = out_c;
+}
+
+/*
+ * V = B^T * d * B for one input tile of one channel, d is zero outside the image.
+ * The result is scattered to dst[pos * pos_stride].
+ */
+static void wg_f3s1_trans_input_tile(const float *src, float *dst, const struct wg_f3s1_matrix *mat,
+                                     int y0, int x0, int in_h, int in_w, int y_stride,
+                                     int x_stride, int pos_stride)
+{
+    const int tile = mat->tile;
+    float d[WINOGRAD_MAX_TILE][WINOGRAD_MAX_TILE];
+    float tmp[WINOGRAD_MAX_TILE][WINOGRAD_MAX_TILE];
+
+    for (int i = 0; i < tile; i++) {
+        const int y = y0 + i;
+        for (int j = 0; j < tile; j++) {
+            const int x = x0 + j;
+            d[i][j] = (y >= 0 && y < in_h && x >= 0 && x < in_w) ? src[y * y_stride + x * x_stride]
+                                                                   : 0.0f;
+        }
+    }
+    for (int i = 0; i < tile; i++) {
+        const float *bt = mat->bt + i * tile;
+        for (int j = 0; j < tile; j++) {
+            float acc = 0.0f;
+            for (int k = 0; k < tile; k++) {
+                acc += bt[k] * d[k][j];
+            }
+            tmp[i][j] = acc;
+        }
+    }
+    for (int i = 0; i < tile; i++) {
+        for (int j = 0; j < tile; j++) {
+            const float *bt = mat->bt + j * tile;
+            float acc = 0.0f;
+            for (int k = 0; k < tile; k++) {
+                acc += tmp[i][k] * bt[k];
+            }
+            dst[(i * tile + j) * pos_stride] = acc;
+        }
+    }
+}
+
+/* Y = A^T * M * A + bias for one output tile of one channel, cropped to the output */
+static void wg_f3s1_trans_output_tile(const float *src, float *dst,
+                                      const struct wg_f3s1_matrix *mat, float bias, int y0, int x0,
+                                      int out_h, int out_w, int y_stride, int x_stride,
+                                      int pos_stride)
+{
+    const int tile = mat->tile;
+    const int m = mat->m;
+    float tmp[WINOGRAD_MAX_TILE][WINOGRAD_MAX_TILE];
+
+    for (int i = 0; i < m; i++) {
+        const float *at = mat->at + i * tile;
+        for (int j = 0; j < tile; j++) {
+            float acc = 0.0f;
+            for (int k = 0; k < tile; k++) {
+                acc += at[k] * src[(k * tile + j) * pos_stride];
+            }
+            tmp[i][j] = acc;
+        }
+    }
+    const int h = shl_ref_min_internal_s32(m, out_h - y0);
+    const int w = shl_ref_min_internal_s32(m, out_w - x0);
+    for (int i = 0; i < h; i++) {
+        for (int j = 0; j < w; j++) {
+            const float *at = mat->at + j * tile;
+            float acc = bias;
+            for (int k = 0; k < tile; k++) {
+                acc += tmp[i][k] * at[k];
+            }
+            dst[(y0 + i) * y_stride + (x0 + j) * x_stride] = acc;
+        }
+    }
+}
+
+int shl_ref_conv2d_winograd_f32(struct csinn_tensor *input, struct csinn_tensor *output,
+                                struct csinn_tensor *kernel, struct csinn_tensor *bias,
+                                struct csinn_conv2d_params *params)
+{
+    struct csinn_tensor *kernel_tm = params->conv_extra.kernel_tm;
+    float *input_data = input->data;
+    float *output_data = output->data;
+    float *kernel_data = kernel_tm->data;
+    float *bias_data = bias->data;
+    bool has_bias = bias_data != NULL && bias->dim_count != 0;
+
+    struct wg_f3s1_matrix mat;
+    wg_f3s1_get_matrix(kernel_tm->dim[0] == 36 ? 4 : 6, &mat);
+    const int m = mat.m;
+    const int npos = kernel_tm->dim[0];
+    const int in_c = kernel_tm->dim[1];
+    const int out_c = kernel_tm->dim[2];
+
+    const int batch = input->dim[0];
+    int in_h, in_w, out_h, out_w;
+    int in_c_stride, in_y_stride, in_x_stride;
+    int out_c_stride, out_y_stride, out_x_stride;
+    if (params->base.layout == CSINN_LAYOUT_NCHW) {
+        in_h = input->dim[2];
+        in_w = input->dim[3];
+        out_h = output->dim[2];
+        out_w = output->dim[3];
+        in_c_stride = in_h * in_w;
+        in_y_stride = in_w;
+        in_x_stride = 1;
+        out_c_stride = out_h * out_w;
+        out_y_stride = out_w;
+        out_x_stride = 1;
+    } else {
+        in_h = input->dim[1];
+        in_w = input->dim[2];
+        out_h = output->dim[1];
+        out_w = output->dim[2];
+        in_c_stride = 1;
+        in_y_stride = in_w * in_c;
+        in_x_stride = in_c;
+        out_c_stride = 1;
+        out_y_stride = out_w * out_c;
+        out_x_stride = out_c;
+    }
+
+    const int tiles_w = (out_w + m - 1) / m;
+    const int tiles = ((out_h + m - 1) / m) * tiles_w;
+    int nt = WINOGRAD_BUF_SIZE / (npos * (in_c + out_c));
+    nt = shl_ref_max_internal_s32(nt, WINOGRAD_MIN_TILES);
+    nt = shl_ref_min_internal_s32(nt, tiles);
+
+    /* transformed input [pos][nt][in_c] and GEMM result [pos][nt][out_c] for a block of tiles */
+    float *input_tm = shl_mem_alloc(npos * in_c * nt * sizeof(float));
+    float *output_tm = shl_mem_alloc(npos * out_c * nt * sizeof(float));
+
+    for (int b = 0; b < batch; b++) {
+        const float *in_b = input_data + b * in_c * in_h * in_w;
+        float *out_b = output_data + b * out_c * out_h * out_w;
+        for (int t0 = 0; t0 < tiles; t0 += nt) {
+            const int tn = shl_ref_min_internal_s32(nt, tiles - t0);
+
+            for (int t = 0; t < tn; t++) {
+                const int y0 = (t0 + t) / tiles_w * m - params->pad_top;
+                const int x0 = (t0 + t) % tiles_w * m - params->pad_left;
+                for (int ic = 0; ic < in_c; ic++) {
+                    wg_f3s1_trans_input_tile(in_b + ic * in_c_stride, input_tm + t * in_c + ic,
+                                             &mat, y0, x0, in_h, in_w, in_y_stride, in_x_stride,
+                                             tn * in_c);
+                }
+            }
+
+            for (int p = 0; p < npos; p++) {
+                shl_ref_gemm_f32(output_tm + p * tn * out_c, input_tm + p * tn * in_c,
+                                 kernel_data + p * in_c * out_c, tn, in_c, out_c, in_c, out_c,
+                                 out_c);
+            }
+
+            for (int t = 0; t < tn; t++) {
+                const int y0 = (t0 + t) / tiles_w * m;
+                const int x0 = (t0 + t) % tiles_w * m;
+                for (int oc = 0; oc < out_c; oc++) {
+                    wg_f3s1_trans_output_tile(output_tm + t * out_c + oc, out_b + oc * out_c_stride,
+                                              &mat, has_bias ? bias_data[oc] : 0.0f, y0, x0,
+                                              out_h, out_w, out_y_stride, out_x_stride,
+                                              tn * out_c);
+                }
+            }
+        }
+    }
+
+    shl_mem_free(input_tm);
+    shl_mem_free(output_tm);
+    return CSINN_TRUE;
+}
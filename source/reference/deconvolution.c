@@ -20,215 +20,346 @@
 
 #include "shl_ref.h"
 
-static int shl_ref_deconv2d_nhwc_f32(struct csinn_tensor *input, struct csinn_tensor *output,
-                                     struct csinn_tensor *kernel, struct csinn_tensor *bias,
-                                     struct csinn_conv2d_params *params)
+/* upper bound of the column buffer in floats, input rows are processed in chunks that fit */
+#define DECONV_COL_BUF_SIZE (1 << 18)
+
+/*
+ * Deconvolution is a GEMM of the input with the reshaped kernel, followed by col2im that
+ * scatters every kernel tap back to the output. The reshaped kernel is built once in
+ * shl_ref_deconv2d_init and kept in params->conv_extra.kernel_tm:
+ *   NHWC kernel [o, kh, kw, i / g]  -> [g][i / g][kh * kw * o / g]  (right operand)
+ *   NCHW kernel [i, o / g, kh, kw]  -> [g][o / g * kh * kw][i / g]  (left operand)
+ *   NHWC depthwise [1, kh, kw, c]   -> [kh * kw][c]                 (elementwise)
+ */
+static bool deconv2d_is_nhwc_depthwise(struct csinn_tensor *kernel,
+                                       struct csinn_conv2d_params *params)
 {
-    float *input_data = input->data;
-    float *output_data = output->data;
-    float *filter_data = kernel->data;
-    float *bias_data = bias->data;
-    const int batches = input->dim[0];
-    const int input_depth = input->dim[3];
-    const int output_depth = output->dim[3];
-    const int input_height = input->dim[1];
-    const int input_width = input->dim[2];
-    const int filter_height = kernel->dim[1];
-    const int filter_width = kernel->dim[2];
-    const int output_height = output->dim[1];
-    const int output_width = output->dim[2];
-    const int output_batch = output->dim[0];
-
-    int num_elements = csinn_tensor_size(output);
-    memset(output_data, 0, num_elements * sizeof(float));
-
-    // Loop through input elements one at a time.
-    for (int batch = 0; batch < batches; ++batch) {
-        for (int in_y = 0; in_y < input_height; ++in_y) {
-            for (int in_x = 0; in_x < input_width; ++in_x) {
-                for (int in_channel = 0; in_channel < input_depth; ++in_channel) {
-                    // Loop through the output elements it will influence.
-                    const int out_x_origin = (in_x * params->stride_width) - params->pad_left;
-                    const int out_y_origin = (in_y * params->stride_height) - params->pad_top;
-                    for (int filter_y = 0; filter_y < filter_height; ++filter_y) {
-                        for (int filter_x = 0; filter_x < filter_width; ++filter_x) {
-                            for (int out_channel = 0; out_channel < output_depth; ++out_channel) {
-                                // Compute output element location.
-                                const int out_x = out_x_origin + filter_x;
-                                const int out_y = out_y_origin + filter_y;
-                                // We cannot accumulate out of bounds.
-                                if ((out_x >= 0) && (out_x < output_width) && (out_y >= 0) &&
-                                    (out_y < output_height)) {
-                                    float input_value = input_data[shl_ref_get_index(
-                                        input->dim, batch, in_y, in_x, in_channel)];
-                                    float filter_value = filter_data[shl_ref_get_index(
-                                        kernel->dim, out_channel, filter_y, filter_x, in_channel)];
-                                    output_data[shl_ref_get_index(output->dim, batch, out_y, out_x,
-                                                                  out_channel)] +=
-                                        input_value * filter_value;
-                                }
-                            }
-                        }
+    return params->base.layout == CSINN_LAYOUT_NHWC && params->group > 1 && kernel->dim[0] == 1 &&
+           kernel->dim[3] == params->group;
+}
+
+static struct csinn_tensor *deconv2d_trans_kernel_f32(struct csinn_tensor *kernel,
+                                                      struct csinn_conv2d_params *params)
+{
+    float *kernel_data = kernel->data;
+    const int group = params->group;
+    struct csinn_tensor *kernel_tm = csinn_alloc_tensor(NULL);
+    kernel_tm->dtype = CSINN_DTYPE_FLOAT32;
+    kernel_tm->layout = kernel->layout;
+    kernel_tm->is_const = 1;
+    kernel_tm->data = shl_mem_alloc(csinn_tensor_size(kernel) * sizeof(float));
+    float *tm_data = kernel_tm->data;
+
+    if (deconv2d_is_nhwc_depthwise(kernel, params)) {
+        kernel_tm->dim_count = 2;
+        kernel_tm->dim[0] = kernel->dim[1] * kernel->dim[2];
+        kernel_tm->dim[1] = kernel->dim[3];
+        memcpy(tm_data, kernel_data, csinn_tensor_size(kernel) * sizeof(float));
+    } else if (params->base.layout == CSINN_LAYOUT_NHWC) {
+        const int out_c = kernel->dim[0];
+        const int ksize = kernel->dim[1] * kernel->dim[2];
+        const int in_cg = kernel->dim[3];
+        const int out_cg = out_c / group;
+        kernel_tm->dim_count = 3;
+        kernel_tm->dim[0] = group;
+        kernel_tm->dim[1] = in_cg;
+        kernel_tm->dim[2] = ksize * out_cg;
+        for (int g = 0; g < group; g++) {
+            float *dst = tm_data + g * in_cg * ksize * out_cg;
+            for (int oc = 0; oc < out_cg; oc++) {
+                const float *src = kernel_data + (g * out_cg + oc) * ksize * in_cg;
+                for (int k = 0; k < ksize; k++) {
+                    for (int ic = 0; ic < in_cg; ic++) {
+                        dst[ic * ksize * out_cg + k * out_cg + oc] = src[k * in_cg + ic];
                     }
                 }
             }
         }
-    }
-
-    if (bias->dim_count != 0) {
-        for (int batch = 0; batch < output_batch; batch++) {
-            for (int o_y = 0; o_y < output_height; o_y++) {
-                for (int o_x = 0; o_x < output_width; o_x++) {
-                    for (int o_channel = 0; o_channel < output_depth; ++o_channel) {
-                        output_data[shl_ref_get_index(output->dim, batch, o_y, o_x, o_channel)] +=
-                            bias_data[o_channel];
-                    }
+    } else {
+        const int in_c = kernel->dim[0];
+        const int out_cg = kernel->dim[1];
+        const int ksize = kernel->dim[2] * kernel->dim[3];
+        const int in_cg = in_c / group;
+        kernel_tm->dim_count = 3;
+        kernel_tm->dim[0] = group;
+        kernel_tm->dim[1] = out_cg * ksize;
+        kernel_tm->dim[2] = in_cg;
+        for (int g = 0; g < group; g++) {
+            float *dst = tm_data + g * out_cg * ksize * in_cg;
+            for (int ic = 0; ic < in_cg; ic++) {
+                const float *src = kernel_data + (g * in_cg + ic) * out_cg * ksize;
+                for (int r = 0; r < out_cg * ksize; r++) {
+                    dst[r * in_cg + ic] = src[r];
                 }
             }
         }
     }
-
-    return CSINN_TRUE;
+    return kernel_tm;
 }
 
-static int shl_ref_deconv2d_nchw_f32(struct csinn_tensor *o_input, struct csinn_tensor *o_output,
-                                     struct csinn_tensor *o_kernel, struct csinn_tensor *o_bias,
-                                     struct csinn_conv2d_params *params)
+static void deconv2d_free_kernel_tm(struct csinn_tensor *kernel_tm)
 {
-    struct csinn_tensor *input = shl_ref_nchw_to_nhwc_f32(o_input);
-    struct csinn_tensor *output = shl_ref_nchw_to_nhwc_f32(o_output);
-    int32_t permute[4] = {1, 2, 3, 0};
-    struct csinn_tensor *kernel = shl_ref_deconv_kernel_nchw_to_nhwc_f32(o_kernel, permute);
-    struct csinn_tensor *bias = o_bias;
+    shl_mem_free(kernel_tm->data);
+    csinn_free_tensor(kernel_tm);
+}
 
-    shl_ref_deconv2d_nhwc_f32(input, output, kernel, bias, params);
+int shl_ref_deconv2d_init(struct csinn_tensor *input, struct csinn_tensor *output,
+                          struct csinn_tensor *kernel, struct csinn_tensor *bias,
+                          struct csinn_conv2d_params *params)
+{
+    if (params->base.layout != CSINN_LAYOUT_NCHW && params->base.layout != CSINN_LAYOUT_NHWC) {
+        return CSINN_UNSUPPORT_LAYOUT;
+    }
+    if (kernel->data == NULL) {
+        return CSINN_TRUE;
+    }
+    if (params->conv_extra.kernel_tm != NULL) {
+        deconv2d_free_kernel_tm(params->conv_extra.kernel_tm);
+    }
 
-    shl_ref_nhwc_to_nchw_f32(o_output, output);
-    shl_ref_free_float_tensor(input);
+    if (kernel->dtype == CSINN_DTYPE_FLOAT32) {
+        params->conv_extra.kernel_tm = deconv2d_trans_kernel_f32(kernel, params);
+    } else {
+        struct csinn_tensor *float_kernel = shl_ref_tensor_transform_f32(kernel);
+        params->conv_extra.kernel_tm = deconv2d_trans_kernel_f32(float_kernel, params);
+        shl_ref_tensor_transform_free_f32(float_kernel);
+    }
+    params->conv_extra.conv_mode = CSINN_GEMM;
     return CSINN_TRUE;
 }
 
-int shl_ref_depthwise_deconv2d_nhwc_f32(struct csinn_tensor *input, struct csinn_tensor *output,
-                                        struct csinn_tensor *kernel, struct csinn_tensor *bias,
-                                        struct csinn_conv2d_params *params)
+void shl_ref_deconv2d_deinit(struct csinn_conv2d_params *params)
+{
+    if (params->conv_extra.kernel_tm != NULL) {
+        deconv2d_free_kernel_tm(params->conv_extra.kernel_tm);
+        params->conv_extra.kernel_tm = NULL;
+    }
+}
+
+static void deconv2d_add_bias_f32(float *output_data, float *bias_data, int outer, int inner,
+                                  int channel, bool channel_last)
+{
+    for (int o = 0; o < outer; o++) {
+        float *out = output_data + o * inner * channel;
+        if (channel_last) {
+            for (int i = 0; i < inner; i++) {
+                for (int c = 0; c < channel; c++) {
+                    out[i * channel + c] += bias_data[c];
+                }
+            }
+        } else {
+            for (int c = 0; c < channel; c++) {
+                for (int i = 0; i < inner; i++) {
+                    out[c * inner + i] += bias_data[c];
+                }
+            }
+        }
+    }
+}
+
+static void deconv2d_gemm_nhwc_f32(struct csinn_tensor *input, struct csinn_tensor *output,
+                                   struct csinn_tensor *kernel, struct csinn_tensor *kernel_tm,
+                                   struct csinn_conv2d_params *params)
 {
     float *input_data = input->data;
     float *output_data = output->data;
-    float *filter_data = kernel->data;
-    float *bias_data = bias->data;
+    float *tm_data = kernel_tm->data;
     const int batches = input->dim[0];
-    const int input_depth = input->dim[3];
-    const int output_depth = output->dim[3];
     const int input_height = input->dim[1];
     const int input_width = input->dim[2];
-    const int filter_height = kernel->dim[1];
-    const int filter_width = kernel->dim[2];
+    const int input_depth = input->dim[3];
     const int output_height = output->dim[1];
     const int output_width = output->dim[2];
-    const int output_batch = output->dim[0];
-
-    int num_elements = csinn_tensor_size(output);
-    memset(output_data, 0, num_elements * sizeof(float));
-
-    // Loop through input elements one at a time.
-    for (int batch = 0; batch < batches; ++batch) {
-        for (int in_y = 0; in_y < input_height; ++in_y) {
-            for (int in_x = 0; in_x < input_width; ++in_x) {
-                for (int in_channel = 0; in_channel < input_depth; ++in_channel) {
-                    // Loop through the output elements it will influence.
-                    const int out_x_origin = (in_x * params->stride_width) - params->pad_left;
-                    const int out_y_origin = (in_y * params->stride_height) - params->pad_top;
-                    for (int filter_y = 0; filter_y < filter_height; ++filter_y) {
-                        for (int filter_x = 0; filter_x < filter_width; ++filter_x) {
-                            // Compute output element location.
-                            const int out_x = out_x_origin + filter_x;
-                            const int out_y = out_y_origin + filter_y;
-                            // We cannot accumulate out of bounds.
-                            if ((out_x >= 0) && (out_x < output_width) && (out_y >= 0) &&
-                                (out_y < output_height)) {
-                                float input_value = input_data[shl_ref_get_index(
-                                    input->dim, batch, in_y, in_x, in_channel)];
-                                float filter_value = filter_data[shl_ref_get_index(
-                                    kernel->dim, 0, filter_y, filter_x, in_channel)];
-                                output_data[shl_ref_get_index(output->dim, batch, out_y, out_x,
-                                                              in_channel)] +=
-                                    input_value * filter_value;
-                            }
+    const int output_depth = output->dim[3];
+    const int filter_height = kernel->dim[1];
+    const int filter_width = kernel->dim[2];
+    const int ksize = filter_height * filter_width;
+    const int group = params->group;
+    const bool depthwise = deconv2d_is_nhwc_depthwise(kernel, params);
+    const int in_cg = input_depth / group;
+    const int out_cg = output_depth / group;
+    const int col_stride = ksize * output_depth;
+
+    int chunk_rows = DECONV_COL_BUF_SIZE / (input_width * col_stride);
+    chunk_rows = shl_ref_min_internal_s32(shl_ref_max_internal_s32(chunk_rows, 1), input_height);
+    float *col = shl_mem_alloc(chunk_rows * input_width * col_stride * sizeof(float));
+    float *col_g = NULL;
+    if (group > 1 && !depthwise) {
+        col_g = shl_mem_alloc(chunk_rows * input_width * ksize * out_cg * sizeof(float));
+    }
+
+    for (int b = 0; b < batches; b++) {
+        float *in_b = input_data + b * input_height * input_width * input_depth;
+        float *out_b = output_data + b * output_height * output_width * output_depth;
+        for (int h0 = 0; h0 < input_height; h0 += chunk_rows) {
+            const int h1 = shl_ref_min_internal_s32(h0 + chunk_rows, input_height);
+            const int pixels = (h1 - h0) * input_width;
+            float *in_rows = in_b + h0 * input_width * input_depth;
+
+            if (depthwise) {
+                for (int p = 0; p < pixels; p++) {
+                    const float *in_p = in_rows + p * input_depth;
+                    for (int k = 0; k < ksize; k++) {
+                        const float *k_p = tm_data + k * output_depth;
+                        float *col_p = col + p * col_stride + k * output_depth;
+                        for (int c = 0; c < output_depth; c++) {
+                            col_p[c] = in_p[c] * k_p[c];
                         }
                     }
                 }
-            }
-        }
-    }
-    if (bias->dim_count != 0) {
-        for (int batch = 0; batch < output_batch; batch++) {
-            for (int o_y = 0; o_y < output_height; o_y++) {
-                for (int o_x = 0; o_x < output_width; o_x++) {
-                    for (int o_channel = 0; o_channel < output_depth; ++o_channel) {
-                        output_data[shl_ref_get_index(output->dim, batch, o_y, o_x, o_channel)] +=
-                            bias_data[o_channel];
+            } else if (group == 1) {
+                shl_ref_gemm_f32(col, in_rows, tm_data, pixels, input_depth, col_stride,
+                                 input_depth, col_stride, col_stride);
+            } else {
+                for (int g = 0; g < group; g++) {
+                    float *tm_g = tm_data + g * in_cg * ksize * out_cg;
+                    shl_ref_gemm_f32(col_g, in_rows + g * in_cg, tm_g, pixels, in_cg,
+                                     ksize * out_cg, input_depth, ksize * out_cg, ksize * out_cg);
+                    for (int r = 0; r < pixels * ksize; r++) {
+                        memcpy(col + r * output_depth + g * out_cg, col_g + r * out_cg,
+                               out_cg * sizeof(float));
                     }
                 }
             }
+
+            shl_ref_col2im_nhwc_acc_f32(col, out_b, output_height, output_width, output_depth,
+                                        filter_height, filter_width, params->pad_top,
+                                        params->pad_left, params->stride_height,
+                                        params->stride_width, h0, h1, input_width);
         }
     }
 
-    return CSINN_TRUE;
+    shl_mem_free(col);
+    if (col_g != NULL) {
+        shl_mem_free(col_g);
+    }
 }
 
-int shl_ref_depthwise_deconv2d_nchw_f32(struct csinn_tensor *o_input, struct csinn_tensor *o_output,
-                                        struct csinn_tensor *o_kernel, struct csinn_tensor *o_bias,
-                                        struct csinn_conv2d_params *params)
+static void deconv2d_gemm_nchw_f32(struct csinn_tensor *input, struct csinn_tensor *output,
+                                   struct csinn_tensor *kernel, struct csinn_tensor *kernel_tm,
+                                   struct csinn_conv2d_params *params)
 {
-    struct csinn_tensor *input = shl_ref_nchw_to_nhwc_f32(o_input);
-    struct csinn_tensor *output = shl_ref_nchw_to_nhwc_f32(o_output);
-    int32_t permute[4] = {1, 2, 3, 0};
-    struct csinn_tensor *kernel = shl_ref_deconv_kernel_nchw_to_nhwc_f32(o_kernel, permute);
-    struct csinn_tensor *bias = o_bias;
-    shl_ref_depthwise_deconv2d_nhwc_f32(input, output, kernel, bias, params);
-
-    shl_ref_nhwc_to_nchw_f32(o_output, output);
-    shl_ref_free_float_tensor(input);
-    return CSINN_TRUE;
+    float *input_data = input->data;
+    float *output_data = output->data;
+    float *tm_data = kernel_tm->data;
+    const int batches = input->dim[0];
+    const int input_depth = input->dim[1];
+    const int input_height = input->dim[2];
+    const int input_width = input->dim[3];
+    const int output_depth = output->dim[1];
+    const int output_height = output->dim[2];
+    const int output_width = output->dim[3];
+    const int filter_height = kernel->dim[2];
+    const int filter_width = kernel->dim[3];
+    const int ksize = filter_height * filter_width;
+    const int group = params->group;
+    const int in_cg = input_depth / group;
+    const int out_cg = output_depth / group;
+    const int in_plane = input_height * input_width;
+    const int out_plane = output_height * output_width;
+
+    int chunk_rows = DECONV_COL_BUF_SIZE / (input_width * out_cg * ksize);
+    chunk_rows = shl_ref_min_internal_s32(shl_ref_max_internal_s32(chunk_rows, 1), input_height);
+    float *col = shl_mem_alloc(out_cg * ksize * chunk_rows * input_width * sizeof(float));
+
+    for (int b = 0; b < batches; b++) {
+        float *in_b = input_data + b * input_depth * in_plane;
+        float *out_b = output_data + b * output_depth * out_plane;
+        for (int h0 = 0; h0 < input_height; h0 += chunk_rows) {
+            const int h1 = shl_ref_min_internal_s32(h0 + chunk_rows, input_height);
+            const int cols = (h1 - h0) * input_width;
+            for (int g = 0; g < group; g++) {
+                shl_ref_gemm_f32(col, tm_data + g * out_cg * ksize * in_cg,
+                                 in_b + g * in_cg * in_plane + h0 * input_width, out_cg * ksize,
+                                 in_cg, cols, in_cg, in_plane, cols);
+                shl_ref_col2im_nchw_acc_f32(col, out_b + g * out_cg * out_plane, output_height,
+                                            output_width, out_cg, filter_height, filter_width,
+                                            params->pad_top, params->pad_left,
+                                            params->stride_height, params->stride_width, h0, h1,
+                                            input_width);
+            }
+        }
+    }
+
+    shl_mem_free(col);
 }
 
-int shl_ref_depthwise_deconv2d_f32(struct csinn_tensor *input, struct csinn_tensor *output,
-                                   struct csinn_tensor *kernel, struct csinn_tensor *bias,
-                                   struct csinn_conv2d_params *params)
+static int deconv2d_gemm_f32(struct csinn_tensor *input, struct csinn_tensor *output,
+                             struct csinn_tensor *kernel, struct csinn_tensor *bias,
+                             struct csinn_conv2d_params *params)
 {
+    struct csinn_tensor *kernel_tm = params->conv_extra.kernel_tm;
+    if (kernel_tm == NULL) {
+        kernel_tm = deconv2d_trans_kernel_f32(kernel, params);
+    }
+    memset(output->data, 0, csinn_tensor_size(output) * sizeof(float));
+
+    int ret = CSINN_TRUE;
     if (params->base.layout == CSINN_LAYOUT_NCHW) {
-        shl_ref_depthwise_deconv2d_nchw_f32(input, output, kernel, bias, params);
+        deconv2d_gemm_nchw_f32(input, output, kernel, kernel_tm, params);
+        if (bias->dim_count != 0) {
+            deconv2d_add_bias_f32(output->data, bias->data, output->dim[0],
+                                  output->dim[2] * output->dim[3], output->dim[1], false);
+        }
     } else if (params->base.layout == CSINN_LAYOUT_NHWC) {
-        shl_ref_depthwise_deconv2d_nhwc_f32(input, output, kernel, bias, params);
+        deconv2d_gemm_nhwc_f32(input, output, kernel, kernel_tm, params);
+        if (bias->dim_count != 0) {
+            deconv2d_add_bias_f32(output->data, bias->data, output->dim[0],
+                                  output->dim[1] * output->dim[2], output->dim[3], true);
+        }
     } else {
-        return CSINN_UNSUPPORT_LAYOUT;
+        ret = CSINN_UNSUPPORT_LAYOUT;
+    }
+
+    if (kernel_tm != params->conv_extra.kernel_tm) {
+        deconv2d_free_kernel_tm(kernel_tm);
+    }
+    return ret;
+}
+
+/* the quantized kernel is already dequantized into kernel_tm, only convert activations */
+static int deconv2d_gemm_quant(struct csinn_tensor *input, struct csinn_tensor *output,
+                               struct csinn_tensor *kernel, struct csinn_tensor *bias,
+                               struct csinn_conv2d_params *params)
+{
+    if (params->conv_extra.kernel_tm == NULL) {
+        return shl_ref_conv_callback_base(input, output, kernel, bias, params, deconv2d_gemm_f32);
     }
+    struct csinn_tensor *float_input = shl_ref_tensor_transform_f32(input);
+    struct csinn_tensor *float_bias = shl_ref_tensor_transform_f32(bias);
+    struct csinn_tensor *float_output = shl_ref_tensor_transform_f32(output);
+    int ret = deconv2d_gemm_f32(float_input, float_output, kernel, float_bias, params);
+    csinn_tensor_data_convert(output, float_output);
+    shl_ref_tensor_transform_free_f32(float_input);
+    shl_ref_tensor_transform_free_f32(float_output);
+    shl_ref_tensor_transform_free_f32(float_bias);
+    return ret;
+}
+
+int shl_ref_depthwise_deconv2d_f32(struct csinn_tensor *input, struct csinn_tensor *output,
+                                   struct csinn_tensor *kernel, struct csinn_tensor *bias,
+                                   struct csinn_conv2d_params *params)
+{
+    return deconv2d_gemm_f32(input, output, kernel, bias, params);
 }
 
 int shl_ref_depthwise_deconv2d_quant(struct csinn_tensor *input, struct csinn_tensor *output,
                                      struct csinn_tensor *kernel, struct csinn_tensor *bias,
                                      struct csinn_conv2d_params *params)
 {
-    return shl_ref_conv_callback_base(input, output, kernel, bias, params,
-                                      shl_ref_depthwise_deconv2d_f32);
+    return deconv2d_gemm_quant(input, output, kernel, bias, params);
 }
 
 int shl_ref_deconv2d_f32(struct csinn_tensor *input, struct csinn_tensor *output,
                          struct csinn_tensor *kernel, struct csinn_tensor *bias,
                          struct csinn_conv2d_params *params)
 {
-    if (params->base.layout == CSINN_LAYOUT_NCHW) {
-        shl_ref_deconv2d_nchw_f32(input, output, kernel, bias, params);
-    } else if (params->base.layout == CSINN_LAYOUT_NHWC) {
-        shl_ref_deconv2d_nhwc_f32(input, output, kernel, bias, params);
-    } else {
-        return CSINN_UNSUPPORT_LAYOUT;
-    }
+    return deconv2d_gemm_f32(input, output, kernel, bias, params);
 }
 
 int shl_ref_deconv2d_quant(struct csinn_tensor *input, struct csinn_tensor *output,
                            struct csinn_tensor *kernel, struct csinn_tensor *bias,
                            struct csinn_conv2d_params *params)
 {
-    return shl_ref_conv_callback_base(input, output, kernel, bias, params, shl_ref_deconv2d_f32);
+    return deconv2d_gemm_quant(input, output, kernel, bias, params);
 }
@@ -18,10 +18,12 @@
 
 /* CSI-NN2 version 2.0.x */
 
-#include "shl_ref.h"
+#include "ref_mathfun.h"
 
 static float elu(float x) { return x < 0.0 ? exp(x) - 1 : x; }
 
+static float elu_fast(float x) { return x < 0.0f ? shl_ref_fast_expf(x) - 1.0f : x; }
+
 int shl_ref_elu_f32(struct csinn_tensor *input, struct csinn_tensor *output,
                     struct csinn_relu_params *params)
 {
@@ -31,6 +33,12 @@ int shl_ref_elu_f32(struct csinn_tensor *input, struct csinn_tensor *output,
     for (int i = 0; i < input->dim_count; i++) {
         size = size * input->dim[i];
     }
+    if (shl_ref_fast_math_enabled(params)) {
+        for (int i = 0; i < size; i++) {
+            output_data[i] = elu_fast(input_data[i]);
+        }
+        return CSINN_TRUE;
+    }
 
     for (int i = 0; i < size; i++) {
         output_data[i] = elu(input_data[i]);
@@ -43,3 +51,21 @@ int shl_ref_elu_quant(struct csinn_tensor *input, struct csinn_tensor *output,
 {
     return shl_ref_siso_callback_base(input, output, params, shl_ref_elu_f32);
 }
+
+static int elu_lut(struct csinn_tensor *input, struct csinn_tensor *output,
+                   struct csinn_relu_params *params)
+{
+    return shl_ref_siso_lut(input, output, params->lut);
+}
+
+int shl_ref_elu_init(struct csinn_tensor *input, struct csinn_tensor *output,
+                     struct csinn_relu_params *params)
+{
+    struct csinn_callback *cb = params->base.cb;
+    shl_mem_free(params->lut);
+    params->lut = shl_ref_siso_lut_init(input, output, params, shl_ref_elu_f32);
+    if (params->lut != NULL) {
+        cb->exec = elu_lut;
+    }
+    return CSINN_TRUE;
+}
@@ -18,7 +18,7 @@
 
 /* CSI-NN2 version 2.0.x */
 
-#include "shl_ref.h"
+#include "ref_mathfun.h"
 
 int shl_ref_erf_f32(struct csinn_tensor *input, struct csinn_tensor *output,
                     struct csinn_siso_params *params)
@@ -29,6 +29,10 @@ int shl_ref_erf_f32(struct csinn_tensor *input, struct csinn_tensor *output,
     for (int i = 0; i < input->dim_count; i++) {
         size = size * input->dim[i];
     }
+    if (shl_ref_fast_math_enabled(params)) {
+        shl_ref_fast_erf_f32(input_data, output_data, size);
+        return CSINN_TRUE;
+    }
 
     for (int i = 0; i < size; i++) {
         output_data[i] = erf(input_data[i]);
@@ -41,3 +45,21 @@ int shl_ref_erf_quant(struct csinn_tensor *input, struct csinn_tensor *output,
 {
     return shl_ref_siso_callback_base(input, output, params, shl_ref_erf_f32);
 }
+
+static int erf_lut(struct csinn_tensor *input, struct csinn_tensor *output,
+                   struct csinn_siso_params *params)
+{
+    return shl_ref_siso_lut(input, output, params->lut);
+}
+
+int shl_ref_erf_init(struct csinn_tensor *input, struct csinn_tensor *output,
+                     struct csinn_siso_params *params)
+{
+    struct csinn_callback *cb = params->base.cb;
+    shl_mem_free(params->lut);
+    params->lut = shl_ref_siso_lut_init(input, output, params, shl_ref_erf_f32);
+    if (params->lut != NULL) {
+        cb->exec = erf_lut;
+    }
+    return CSINN_TRUE;
+}
@@ -41,3 +41,21 @@ int shl_ref_exp_quant(struct csinn_tensor *input, struct csinn_tensor *output,
 {
     return shl_ref_siso_callback_base(input, output, params, shl_ref_exp_f32);
 }
+
+static int exp_lut(struct csinn_tensor *input, struct csinn_tensor *output,
+                   struct csinn_siso_params *params)
+{
+    return shl_ref_siso_lut(input, output, params->lut);
+}
+
+int shl_ref_exp_init(struct csinn_tensor *input, struct csinn_tensor *output,
+                     struct csinn_siso_params *params)
+{
+    struct csinn_callback *cb = params->base.cb;
+    shl_mem_free(params->lut);
+    params->lut = shl_ref_siso_lut_init(input, output, params, shl_ref_exp_f32);
+    if (params->lut != NULL) {
+        cb->exec = exp_lut;
+    }
+    return CSINN_TRUE;
+}
@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2016-2022 T-Head Semiconductor Co., Ltd. All rights reserved.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* CSI-NN2 version 2.0.x */
+
+#include "ref_mathfun.h"
+#ifdef SHL_AVX_OPT
+#include <immintrin.h>
+
+/*
+ * 8-lane version of shl_ref_fast_expf, same polynomial and special cases, AVX and FMA only:
+ * the exponent bits (n + 127) << 23 are formed as the exact float (n + 127) * 2^23.
+ */
+static inline __m256 fast_exp_avx(__m256 x)
+{
+    __m256 xc = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(c_ref_exp_lo)),
+                              _mm256_set1_ps(c_ref_exp_hi));
+    __m256 n = _mm256_floor_ps(
+        _mm256_fmadd_ps(xc, _mm256_set1_ps(c_ref_LOG2EF), _mm256_set1_ps(0.5f)));
+    __m256 r = _mm256_fnmadd_ps(n, _mm256_set1_ps(c_ref_ln2_hi), xc);
+    r = _mm256_fnmadd_ps(n, _mm256_set1_ps(c_ref_ln2_lo), r);
+    __m256 p = _mm256_set1_ps(1.9875691500E-4f);
+    p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(1.3981999507E-3f));
+    p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(8.3334519073E-3f));
+    p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(4.1665795894E-2f));
+    p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(1.6666665459E-1f));
+    p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(5.0000001201E-1f));
+    p = _mm256_fmadd_ps(_mm256_mul_ps(p, r), r, _mm256_add_ps(r, _mm256_set1_ps(1.0f)));
+    __m256 big = _mm256_cmp_ps(n, _mm256_set1_ps(127.0f), _CMP_GT_OQ);
+    __m256 extra = _mm256_blendv_ps(_mm256_set1_ps(1.0f), _mm256_set1_ps(2.0f), big);
+    __m256 e = _mm256_add_ps(_mm256_min_ps(n, _mm256_set1_ps(127.0f)), _mm256_set1_ps(127.0f));
+    __m256 bits = _mm256_mul_ps(e, _mm256_set1_ps(8388608.0f));
+    __m256 scale = _mm256_castsi256_ps(_mm256_cvttps_epi32(bits));
+    __m256 y = _mm256_mul_ps(_mm256_mul_ps(p, scale), extra);
+    y = _mm256_blendv_ps(y, _mm256_set1_ps(INFINITY),
+                         _mm256_cmp_ps(x, _mm256_set1_ps(c_ref_exp_hi), _CMP_GT_OQ));
+    y = _mm256_blendv_ps(y, _mm256_setzero_ps(),
+                         _mm256_cmp_ps(x, _mm256_set1_ps(c_ref_exp_lo), _CMP_LT_OQ));
+    return _mm256_blendv_ps(y, x, _mm256_cmp_ps(x, x, _CMP_UNORD_Q));
+}
+#endif
+
+void shl_ref_fast_exp_f32(const float *src, float *dst, int64_t size)
+{
+    int64_t i = 0;
+#ifdef SHL_AVX_OPT
+    for (; i + 8 <= size; i += 8) {
+        _mm256_storeu_ps(dst + i, fast_exp_avx(_mm256_loadu_ps(src + i)));
+    }
+#endif
+    for (; i < size; i++) {
+        dst[i] = shl_ref_fast_expf(src[i]);
+    }
+}
+
+void shl_ref_fast_log_f32(const float *src, float *dst, int64_t size)
+{
+    for (int64_t i = 0; i < size; i++) {
+        dst[i] = shl_ref_fast_logf(src[i]);
+    }
+}
+
+void shl_ref_fast_tanh_f32(const float *src, float *dst, int64_t size)
+{
+    for (int64_t i = 0; i < size; i++) {
+        dst[i] = shl_ref_fast_tanhf(src[i]);
+    }
+}
+
+void shl_ref_fast_sigmoid_f32(const float *src, float *dst, int64_t size)
+{
+    int64_t i = 0;
+#ifdef SHL_AVX_OPT
+    __m256 one = _mm256_set1_ps(1.0f);
+    __m256 sign = _mm256_set1_ps(-0.0f);
+    for (; i + 8 <= size; i += 8) {
+        __m256 e = fast_exp_avx(_mm256_xor_ps(_mm256_loadu_ps(src + i), sign));
+        _mm256_storeu_ps(dst + i, _mm256_div_ps(one, _mm256_add_ps(one, e)));
+    }
+#endif
+    for (; i < size; i++) {
+        dst[i] = shl_ref_fast_sigmoidf(src[i]);
+    }
+}
+
+void shl_ref_fast_erf_f32(const float *src, float *dst, int64_t size)
+{
+    for (int64_t i = 0; i < size; i++) {
+        dst[i] = shl_ref_fast_erff(src[i]);
+    }
+}
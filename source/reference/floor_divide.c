@@ -20,18 +20,15 @@
 
 #include "shl_ref.h"
 
+SHL_REF_DISO_LOOP(element_floor_divide_f32, floor(x / y))
+
 int shl_ref_floor_divide_f32(struct csinn_tensor *input0, struct csinn_tensor *input1,
                              struct csinn_tensor *output, struct csinn_diso_params *params)
 {
-    float *input0_data = input0->data;
-    float *input1_data = input1->data;
-    float *output_data = output->data;
-    int size = csinn_tensor_size(input0);
+    struct shl_ref_diso_callback cb;
 
-    for (int i = 0; i < size; i++) {
-        output_data[i] = floor(input0_data[i] / input1_data[i]);
-    }
-    return CSINN_TRUE;
+    cb.bc = element_floor_divide_f32;
+    return shl_ref_diso_broadcast_base(input0, input1, output, params, &cb);
 }
 
 int shl_ref_floor_divide_quant(struct csinn_tensor *input0, struct csinn_tensor *input1,
@@ -20,23 +20,15 @@
 
 #include "shl_ref.h"
 
+SHL_REF_DISO_LOOP(element_floor_mod_f32, x - floor(x / y) * y)
+
 int shl_ref_floor_mod_f32(struct csinn_tensor *input0, struct csinn_tensor *input1,
                           struct csinn_tensor *output, struct csinn_diso_params *params)
 {
-    float *input0_data = input0->data;
-    float *input1_data = input1->data;
-    float *output_data = output->data;
-    int size = 1;
-    for (int i = 0; i < input0->dim_count; i++) {
-        size = size * input0->dim[i];
-    }
+    struct shl_ref_diso_callback cb;
 
-    for (int i = 0; i < size; i++) {
-        float res = input0_data[i] - floor(input0_data[i] / input1_data[i]) * input1_data[i];
-        // res = floor(res);
-        output_data[i] = res;
-    }
-    return CSINN_TRUE;
+    cb.bc = element_floor_mod_f32;
+    return shl_ref_diso_broadcast_base(input0, input1, output, params, &cb);
 }
 
 int shl_ref_floor_mod_quant(struct csinn_tensor *input0, struct csinn_tensor *input1,
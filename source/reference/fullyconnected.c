@@ -20,10 +20,130 @@
 
 #include "shl_ref.h"
 
+#define FC_WEIGHT_BLOCK 256
+
+/* eight partial sums keep the loop free of a serial dependency so it vectorizes */
+static float fc_dot_block(const float *x, const float *w, int n)
+{
+    float acc[8] = {0.f};
+    int d = 0;
+    for (; d + 8 <= n; d += 8) {
+        for (int l = 0; l < 8; l++) {
+            acc[l] += x[d + l] * w[d + l];
+        }
+    }
+    for (; d < n; d++) {
+        acc[0] += x[d] * w[d];
+    }
+    return ((acc[0] + acc[4]) + (acc[1] + acc[5])) + ((acc[2] + acc[6]) + (acc[3] + acc[7]));
+}
+
+/* quantized weights are widened a block at a time into a buffer that stays in L1 */
+static float fc_dot_int8(const float *x, const int8_t *w, int n)
+{
+    float block[FC_WEIGHT_BLOCK];
+    float total = 0.f;
+    for (int d = 0; d < n; d += FC_WEIGHT_BLOCK) {
+        int len = n - d < FC_WEIGHT_BLOCK ? n - d : FC_WEIGHT_BLOCK;
+        for (int l = 0; l < len; l++) {
+            block[l] = w[d + l];
+        }
+        total += fc_dot_block(x + d, block, len);
+    }
+    return total;
+}
+
+/* int4 little endian: even elements in the low nibble */
+static inline int8_t fc_int4_lo(int8_t b) { return (int8_t)((b & 0xf) << 4) >> 4; }
+
+static inline int8_t fc_int4_hi(int8_t b) { return b >> 4; }
+
+/* element `first` of the packed buffer starts the row */
+static float fc_dot_int4(const float *x, const int8_t *w, int64_t first, int n)
+{
+    float block[FC_WEIGHT_BLOCK];
+    const int8_t *p = w + first / 2;
+    float total = 0.f;
+    int d = 0;
+    if (first % 2) {
+        total += x[0] * fc_int4_hi(*p++);
+        d = 1;
+    }
+    while (d < n) {
+        int len = n - d < FC_WEIGHT_BLOCK ? n - d : FC_WEIGHT_BLOCK;
+        int pairs = len / 2;
+        for (int l = 0; l < pairs; l++) {
+            block[2 * l] = fc_int4_lo(p[l]);
+            block[2 * l + 1] = fc_int4_hi(p[l]);
+        }
+        if (len % 2) {
+            block[len - 1] = fc_int4_lo(p[pairs]);
+        }
+        total += fc_dot_block(x + d, block, len);
+        p += pairs;
+        d += len;
+    }
+    return total;
+}
+
+/*
+ * Float activations with int8/int4 weights, per-tensor or per output channel quantization.
+ * Weights are dequantized inside the dot product: w = (q - zp) * scale, so
+ * sum(x * w) = scale * (sum(x * q) - zp * sum(x)). Each weight row is streamed once and
+ * reused for every batch, so a token reads 1/4 (int8) or 1/8 (int4) of the float bytes.
+ */
+static int fullyconnected_weight_only_f32(struct csinn_tensor *input, struct csinn_tensor *output,
+                                          struct csinn_tensor *weights, struct csinn_tensor *bias,
+                                          struct csinn_fc_params *params)
+{
+    float *input_data = input->data;
+    float *output_data = output->data;
+    int8_t *weights_data = weights->data;
+    float *bias_data = bias->data;
+    const int output_dims_count = output->dim_count;
+    const int weights_dims_count = weights->dim_count;
+    int batches = 1;
+    for (int i = 0; i < output_dims_count - 1; i++) {
+        batches *= output->dim[i];
+    }
+    const int output_depth = weights->dim[weights_dims_count - 2];
+    const int accum_depth = weights->dim[weights_dims_count - 1];
+    const bool per_channel = weights->quant_channel > 1;
+
+    float *input_sum = shl_mem_alloc(batches * sizeof(float));
+    for (int b = 0; b < batches; ++b) {
+        for (int d = 0; d < accum_depth; ++d) {
+            input_sum[b] += input_data[b * accum_depth + d];
+        }
+    }
+
+    for (int out_c = 0; out_c < output_depth; ++out_c) {
+        struct csinn_quant_info *qinfo = &weights->qinfo[per_channel ? out_c : 0];
+        float bias_value = bias->dim_count != 0 ? bias_data[out_c] : 0.0f;
+        int64_t row = (int64_t)out_c * accum_depth;
+        for (int b = 0; b < batches; ++b) {
+            const float *x = input_data + b * accum_depth;
+            float total = weights->dtype == CSINN_DTYPE_INT4
+                              ? fc_dot_int4(x, weights_data, row, accum_depth)
+                              : fc_dot_int8(x, weights_data + row, accum_depth);
+            total = (total - qinfo->zero_point * input_sum[b]) * qinfo->scale;
+            output_data[out_c + output_depth * b] = total + bias_value;
+        }
+    }
+    shl_mem_free(input_sum);
+    return CSINN_TRUE;
+}
+
 int shl_ref_fullyconnected_f32(struct csinn_tensor *input, struct csinn_tensor *output,
                                struct csinn_tensor *weights, struct csinn_tensor *bias,
                                struct csinn_fc_params *params)
 {
+    if (shl_ref_is_sparse_weight(weights)) {
+        return shl_ref_fullyconnected_sparse_f32(input, output, weights, bias, params);
+    }
+    if (weights->dtype == CSINN_DTYPE_INT8 || weights->dtype == CSINN_DTYPE_INT4) {
+        return fullyconnected_weight_only_f32(input, output, weights, bias, params);
+    }
     float *input_data = input->data;
     float *output_data = output->data;
     float *weights_data = weights->data;
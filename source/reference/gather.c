@@ -20,11 +20,25 @@
 
 #include "shl_ref.h"
 
-int shl_ref_gather_f32(struct csinn_tensor *input, struct csinn_tensor *indices,
-                       struct csinn_tensor *output, struct csinn_gather_params *params)
+int shl_ref_gather_init(struct csinn_tensor *input, struct csinn_tensor *indices,
+                        struct csinn_tensor *output, struct csinn_gather_params *params)
+{
+    struct csinn_callback *cb = params->base.cb;
+    char zero[sizeof(double)];
+    if (shl_ref_is_same_quant(input, output) && shl_ref_scalar_to_dtype(output, 0.0f, zero)) {
+        cb->exec = shl_ref_gather;
+    } else {
+        cb->exec = shl_ref_gather_quant;
+    }
+    return CSINN_TRUE;
+}
+
+static int gather_copy(struct csinn_tensor *input, struct csinn_tensor *indices,
+                       struct csinn_tensor *output, struct csinn_gather_params *params,
+                       int elem_size, const char *zero)
 {
-    float *input_data = (float *)input->data;
-    float *output_data = (float *)output->data;
+    char *input_data = input->data;
+    char *output_data = output->data;
     int32_t *indices_data = (int32_t *)indices->data;
 
     int inner_size = 1;
@@ -40,21 +54,42 @@ int shl_ref_gather_f32(struct csinn_tensor *input, struct csinn_tensor *indices,
         indices_size *= indices->dim[i];
     }
 
+    const int inner_bytes = inner_size * elem_size;
     for (int i = 0; i < outer_size; i++) {
         for (int j = 0; j < indices_size; j++) {
             if (indices_data[j] < input->dim[params->axis]) {
-                memcpy(output_data, input_data + indices_data[j] * inner_size,
-                       inner_size * sizeof(float));
+                memcpy(output_data, input_data + (int64_t)indices_data[j] * inner_bytes,
+                       inner_bytes);
             } else {
-                memset(output_data, 0, inner_size * sizeof(float));
+                /* out of range indices produce zeros */
+                for (int k = 0; k < inner_bytes; k += elem_size) {
+                    memcpy(output_data + k, zero, elem_size);
+                }
             }
-            output_data += inner_size;
+            output_data += inner_bytes;
         }
-        input_data += inner_size * input->dim[params->axis];
+        input_data += inner_bytes * input->dim[params->axis];
     }
     return CSINN_TRUE;
 }
 
+int shl_ref_gather_f32(struct csinn_tensor *input, struct csinn_tensor *indices,
+                       struct csinn_tensor *output, struct csinn_gather_params *params)
+{
+    const float zero = 0.0f;
+    return gather_copy(input, indices, output, params, sizeof(float), (const char *)&zero);
+}
+
+/* input and output share dtype and quantization, move raw elements */
+int shl_ref_gather(struct csinn_tensor *input, struct csinn_tensor *indices,
+                   struct csinn_tensor *output, struct csinn_gather_params *params)
+{
+    char zero[sizeof(double)];
+    shl_ref_scalar_to_dtype(output, 0.0f, zero);
+    return gather_copy(input, indices, output, params, shl_ref_get_dtype_size(input->dtype),
+                       zero);
+}
+
 int shl_ref_gather_quant(struct csinn_tensor *input, struct csinn_tensor *indices,
                          struct csinn_tensor *output, struct csinn_gather_params *params)
 {
@@ -65,4 +100,5 @@ int shl_ref_gather_quant(struct csinn_tensor *input, struct csinn_tensor *indice
     csinn_tensor_data_convert(output, foutput);
     shl_ref_tensor_transform_free_f32(finput);
     shl_ref_tensor_transform_free_f32(foutput);
+    return ret;
 }
@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2016-2022 T-Head Semiconductor Co., Ltd. All rights reserved.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* CSI-NN2 version 2.0.x */
+
+#include "shl_ref.h"
+
+/* block sizes chosen so that one panel of B stays in L2 and a row strip of A in L1 */
+#define GEMM_BLOCK_M 64
+#define GEMM_BLOCK_N 256
+#define GEMM_BLOCK_K 128
+
+/*
+ * dst[m, n] = sa[m, k] * sb[k, n], all row major with leading dimensions lda/ldb/ldc.
+ * Blocked over m/n/k, the innermost loop runs along contiguous n so it auto-vectorizes.
+ */
+void shl_ref_gemm_f32(float *dst, const float *sa, const float *sb, int m, int k, int n, int lda,
+                      int ldb, int ldc)
+{
+    for (int i = 0; i < m; i++) {
+        memset(dst + i * ldc, 0, n * sizeof(float));
+    }
+
+    for (int j0 = 0; j0 < n; j0 += GEMM_BLOCK_N) {
+        const int nb = shl_ref_min_internal_s32(GEMM_BLOCK_N, n - j0);
+        for (int p0 = 0; p0 < k; p0 += GEMM_BLOCK_K) {
+            const int kb = shl_ref_min_internal_s32(GEMM_BLOCK_K, k - p0);
+            for (int i0 = 0; i0 < m; i0 += GEMM_BLOCK_M) {
+                const int mb = shl_ref_min_internal_s32(GEMM_BLOCK_M, m - i0);
+                for (int i = i0; i < i0 + mb; i++) {
+                    float *c = dst + i * ldc + j0;
+                    const float *a = sa + i * lda + p0;
+                    for (int p = 0; p < kb; p++) {
+                        const float av = a[p];
+                        const float *b = sb + (p0 + p) * ldb + j0;
+                        for (int j = 0; j < nb; j++) {
+                            c[j] += av * b[j];
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
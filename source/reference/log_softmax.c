@@ -18,7 +18,7 @@
 
 /* CSI-NN2 version 2.0.x */
 
-#include "shl_ref.h"
+#include "ref_mathfun.h"
 
 /* logsoftmax = logits - log(reduce_sum(exp(logits), axis)) */
 int shl_ref_log_softmax_f32(struct csinn_tensor *input, struct csinn_tensor *output,
@@ -44,6 +44,31 @@ int shl_ref_log_softmax_f32(struct csinn_tensor *input, struct csinn_tensor *out
     }
     int axis_dim = input->dim[params->axis];
 
+    if (shl_ref_fast_math_enabled(params) && input_inner_size == 1) {
+        /* stabilized by the row max, which the exact path below does not need */
+        for (int i = 0; i < input_outer_size; i++) {
+            float max = -FLT_MAX;
+            for (int j = 0; j < axis_dim; j++) {
+                max = fmaxf(max, input_data[j]);
+            }
+            for (int j = 0; j < axis_dim; j++) {
+                output_data[j] = input_data[j] - max;
+            }
+            shl_ref_fast_exp_f32(output_data, output_data, axis_dim);
+            float acc = 0.0f;
+            for (int j = 0; j < axis_dim; j++) {
+                acc += output_data[j];
+            }
+            acc = max + shl_ref_fast_logf(acc);
+            for (int j = 0; j < axis_dim; j++) {
+                output_data[j] = input_data[j] - acc;
+            }
+            input_data += axis_dim;
+            output_data += axis_dim;
+        }
+        return CSINN_TRUE;
+    }
+
     for (int i = 0; i < input_outer_size; i++) {
         for (int k = 0; k < input_inner_size; k++) {
             float acc = 0.0f;
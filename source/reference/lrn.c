@@ -18,7 +18,37 @@
 
 /* CSI-NN2 version 2.0.x */
 
-#include "shl_ref.h"
+#include "ref_mathfun.h"
+
+/* base^-beta; the common beta = 0.75 is 1 / (sqrt(base) * sqrt(sqrt(base))) */
+static inline float lrn_scale(float base, float beta, bool fast)
+{
+    if (beta == 0.75f) {
+        float root = sqrtf(base);
+        return 1.0f / (root * sqrtf(root));
+    }
+    return fast ? shl_ref_fast_powf(base, -beta) : pow(base, -beta);
+}
+
+/*
+ * Both layouts keep a running sum of squares over the window of range + 1
+ * channels: the channel entering the window is added and the one leaving
+ * it subtracted, so each input is squared twice whatever the range. The
+ * sum is kept in double, where the square of a float is exact, and clamped
+ * at zero against cancellation. An Inf or NaN input poisons the running
+ * sum for good, so a non-finite sum is recomputed from the window itself,
+ * which also recovers the running sum once that input has left.
+ */
+static double lrn_window_sum(const float *in, int stride, int c, int half_range, int depth)
+{
+    const int start = c - half_range > 0 ? c - half_range : 0;
+    const int end = c + half_range < depth - 1 ? c + half_range : depth - 1;
+    double sum = 0;
+    for (int k = start; k <= end; ++k) {
+        sum += (double)in[k * stride] * in[k * stride];
+    }
+    return sum;
+}
 
 static int shl_ref_lrn_nhwc_f32(struct csinn_tensor *input, struct csinn_tensor *output,
                                 struct csinn_lrn_params *params)
@@ -29,28 +59,41 @@ static int shl_ref_lrn_nhwc_f32(struct csinn_tensor *input, struct csinn_tensor
     int outer_size = 1;
     const int depth = input->dim[trailing_dim];
     int half_range = params->range / 2;
+    float beta = params->beta;
+    bool fast = shl_ref_fast_math_enabled(params);
 
     for (int i = 0; i < trailing_dim; i++) {
         outer_size *= input->dim[i];
     }
 
     for (int i = 0; i < outer_size; ++i) {
+        const float *in = input_data + i * depth;
+        float *out = output_data + i * depth;
+        double accum = 0;
+        for (int c = 0; c < depth && c <= half_range; ++c) {
+            accum += (double)in[c] * in[c];
+        }
         for (int c = 0; c < depth; ++c) {
-            const int begin_input_c = shl_ref_max_internal_s32(0, c - half_range);
-            const int end_input_c = shl_ref_min_internal_s32(depth, c + half_range + 1);
-            float accum = 0.f;
-            for (int input_c = begin_input_c; input_c < end_input_c; ++input_c) {
-                const float input_val = input_data[i * depth + input_c];
-                accum += input_val * input_val;
+            if (!isfinite(accum)) {
+                accum = lrn_window_sum(in, 1, c, half_range, depth);
+            }
+            double window = accum < 0 ? 0 : accum;
+            out[c] = in[c] * lrn_scale(params->bias + params->alpha * window / params->range, beta,
+                                       fast);
+            const int enter = c + half_range + 1;
+            const int leave = c - half_range;
+            if (enter < depth) {
+                accum += (double)in[enter] * in[enter];
+            }
+            if (leave >= 0) {
+                accum -= (double)in[leave] * in[leave];
             }
-            const float multiplier =
-                pow(params->bias + params->alpha * accum / params->range, -params->beta);
-            output_data[i * depth + c] = input_data[i * depth + c] * multiplier;
         }
     }
     return CSINN_TRUE;
 }
 
+/* the same window, one H * W plane of sums moving through the channels */
 static int shl_ref_lrn_nchw_f32(struct csinn_tensor *input, struct csinn_tensor *output,
                                 struct csinn_lrn_params *params)
 {
@@ -59,28 +102,51 @@ static int shl_ref_lrn_nchw_f32(struct csinn_tensor *input, struct csinn_tensor
     int inner_size = 1;
     const int depth = input->dim[1];
     int half_range = params->range / 2;
+    float beta = params->beta;
+    bool fast = shl_ref_fast_math_enabled(params);
 
     /* inner_size = H * W */
     inner_size = input->dim[2] * input->dim[3];
+    double *accum = shl_mem_alloc(inner_size * sizeof(double));
 
     for (int j = 0; j < input->dim[0]; j++) {
+        const float *in = input_data + j * depth * inner_size;
+        float *out = output_data + j * depth * inner_size;
+        memset(accum, 0, inner_size * sizeof(double));
+        for (int c = 0; c < depth && c <= half_range; ++c) {
+            const float *plane = in + c * inner_size;
+            for (int i = 0; i < inner_size; ++i) {
+                accum[i] += (double)plane[i] * plane[i];
+            }
+        }
         for (int c = 0; c < depth; ++c) {
-            const int begin_input_c = shl_ref_max_internal_s32(0, c - half_range);
-            const int end_input_c = shl_ref_min_internal_s32(depth, c + half_range + 1);
+            const float *src = in + c * inner_size;
+            float *dst = out + c * inner_size;
             for (int i = 0; i < inner_size; ++i) {
-                float accum = 0.f;
-                for (int input_c = begin_input_c; input_c < end_input_c; ++input_c) {
-                    const float input_val =
-                        input_data[j * depth * inner_size + input_c * inner_size + i];
-                    accum += input_val * input_val;
+                if (!isfinite(accum[i])) {
+                    accum[i] = lrn_window_sum(in + i, inner_size, c, half_range, depth);
+                }
+                double window = accum[i] < 0 ? 0 : accum[i];
+                dst[i] = src[i] * lrn_scale(params->bias + params->alpha * window / params->range,
+                                            beta, fast);
+            }
+            const int enter = c + half_range + 1;
+            const int leave = c - half_range;
+            if (enter < depth) {
+                const float *plane = in + enter * inner_size;
+                for (int i = 0; i < inner_size; ++i) {
+                    accum[i] += (double)plane[i] * plane[i];
+                }
+            }
+            if (leave >= 0) {
+                const float *plane = in + leave * inner_size;
+                for (int i = 0; i < inner_size; ++i) {
+                    accum[i] -= (double)plane[i] * plane[i];
                 }
-                const float multiplier =
-                    pow(params->bias + params->alpha * accum / params->range, -params->beta);
-                output_data[j * depth * inner_size + c * inner_size + i] =
-                    input_data[j * depth * inner_size + c * inner_size + i] * multiplier;
             }
         }
     }
+    shl_mem_free(accum);
     return CSINN_TRUE;
 }
 
@@ -88,9 +154,9 @@ int shl_ref_lrn_f32(struct csinn_tensor *input, struct csinn_tensor *output,
                     struct csinn_lrn_params *params)
 {
     if (params->base.layout == CSINN_LAYOUT_NCHW) {
-        shl_ref_lrn_nchw_f32(input, output, params);
+        return shl_ref_lrn_nchw_f32(input, output, params);
     } else if (params->base.layout == CSINN_LAYOUT_NHWC) {
-        shl_ref_lrn_nhwc_f32(input, output, params);
+        return shl_ref_lrn_nhwc_f32(input, output, params);
     } else {
         return CSINN_UNSUPPORT_LAYOUT;
     }
@@ -20,9 +20,99 @@
 
 #include "shl_ref.h"
 
+/*
+ * mat1 carries the step's new key/value rows. The product runs over the cached positions only,
+ * while the tensors between the two matmuls keep a static max_len extent. The ring is read in
+ * place: position j lives in storage row start + j, wrapping once past max_len.
+ */
+static int matmul_kv_cache_f32(struct csinn_tensor *mat0, struct csinn_tensor *mat1,
+                               struct csinn_tensor *output, struct csinn_matmul_params *params)
+{
+    struct csinn_kv_cache *cache = params->kv_cache;
+    bool value = params->kv_cache_value;
+    const int dims_count = mat0->dim_count;
+    if (params->trans_a || params->trans_b == value ||
+        mat0->dim[dims_count - 1] != (value ? cache->max_len : mat1->dim[dims_count - 1]) ||
+        (!value && output->dim[dims_count - 1] != cache->max_len)) {
+        shl_debug_error("matmul: kv cache needs q x k^T with trans_b and p x v without, "
+                        "scores sized to max_len\n");
+        return CSINN_FALSE;
+    }
+    if (csinn_kv_cache_write(cache, mat1, value) != CSINN_TRUE) {
+        return CSINN_FALSE;
+    }
+    if (value) {
+        csinn_kv_cache_commit(cache);
+    }
+    struct csinn_tensor *storage = shl_ref_kv_cache_storage_f32(cache, value);
+
+    float *mat0_data = mat0->data;
+    float *storage_data = storage->data;
+    float *output_data = output->data;
+    int batches = 1;
+    for (int i = 0; i < dims_count - 2; i++) {
+        batches *= mat0->dim[i];
+    }
+    const int dim_i = mat0->dim[dims_count - 2];
+    const int max_len = cache->max_len;
+    const int len = cache->cur_len + cache->new_len;
+    const int dim_d = storage->dim[dims_count - 1];
+    /* the cached positions as at most two contiguous spans of storage rows */
+    const int first = max_len - cache->start < len ? max_len - cache->start : len;
+    const int span_row[2] = {cache->start, 0};
+    const int span_pos[2] = {0, first};
+    const int span_len[2] = {first, len - first};
+
+    for (int b = 0; b < batches; ++b) {
+        const float *storage_b = storage_data + (int64_t)b * max_len * dim_d;
+        for (int i = 0; i < dim_i; ++i) {
+            if (value) {
+                /* out[i, :] = sum over cached positions j of p[i, j] * v[j, :] */
+                const float *p_row = mat0_data + ((int64_t)b * dim_i + i) * max_len;
+                float *out_row = output_data + ((int64_t)b * dim_i + i) * dim_d;
+                for (int d = 0; d < dim_d; ++d) {
+                    out_row[d] = 0.f;
+                }
+                for (int s = 0; s < 2; ++s) {
+                    const float *p_span = p_row + span_pos[s];
+                    const float *v_span = storage_b + (int64_t)span_row[s] * dim_d;
+                    for (int j = 0; j < span_len[s]; ++j) {
+                        for (int d = 0; d < dim_d; ++d) {
+                            out_row[d] += p_span[j] * v_span[j * dim_d + d];
+                        }
+                    }
+                }
+            } else {
+                /* scores[i, j] = q[i, :] . k[j, :], empty positions never win the softmax */
+                const float *q_row = mat0_data + ((int64_t)b * dim_i + i) * dim_d;
+                float *out_row = output_data + ((int64_t)b * dim_i + i) * max_len;
+                for (int s = 0; s < 2; ++s) {
+                    float *out_span = out_row + span_pos[s];
+                    const float *k_span = storage_b + (int64_t)span_row[s] * dim_d;
+                    for (int j = 0; j < span_len[s]; ++j) {
+                        float total = 0.f;
+                        for (int d = 0; d < dim_d; ++d) {
+                            total += q_row[d] * k_span[j * dim_d + d];
+                        }
+                        out_span[j] = total;
+                    }
+                }
+                for (int j = len; j < max_len; ++j) {
+                    out_row[j] = -INFINITY;
+                }
+            }
+        }
+    }
+    shl_ref_kv_cache_storage_free_f32(cache, storage);
+    return CSINN_TRUE;
+}
+
 int shl_ref_matmul_f32(struct csinn_tensor *mat0, struct csinn_tensor *mat1,
                        struct csinn_tensor *output, struct csinn_matmul_params *params)
 {
+    if (params->kv_cache != NULL) {
+        return matmul_kv_cache_f32(mat0, mat1, output, params);
+    }
     float *mat0_data = mat0->data;
     float *mat1_data = mat1->data;
     float *output_data = output->data;
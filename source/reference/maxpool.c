@@ -20,111 +20,197 @@
 
 #include "shl_ref.h"
 
-static int shl_ref_maxpool2d_nhwc_f32(struct csinn_tensor *input, struct csinn_tensor *output,
-                                      struct csinn_pool_params *params)
+/* windows larger than this use block prefix/suffix maxima instead of a direct scan */
+#define MAXPOOL_DIRECT_WINDOW 3
+
+/*
+ * van Herk/Gil-Werman block maxima over n vectors of length len: blocks of k vectors start at
+ * vector 0, pre holds the running max from the block start and suf the running max to the
+ * block end (clipped to n). Like the per-element loop every max starts from -FLT_MAX, so an
+ * all -inf or all NaN window still yields -FLT_MAX.
+ */
+static void block_max_f32(const float *src, float *pre, float *suf, int n, int len, int k)
 {
-    float *input_data = input->data;
-    float *output_data = output->data;
-    const int batches = input->dim[0];
-    const int depth = input->dim[3];
-    const int input_height = input->dim[1];
-    const int input_width = input->dim[2];
-    const int output_height = output->dim[1];
-    const int output_width = output->dim[2];
-
-    for (int batch = 0; batch < batches; ++batch) {
-        for (int out_y = 0; out_y < output_height; ++out_y) {
-            for (int out_x = 0; out_x < output_width; ++out_x) {
-                for (int channel = 0; channel < depth; ++channel) {
-                    const int in_x_origin = (out_x * params->stride_width) - params->pad_left;
-                    const int in_y_origin = (out_y * params->stride_height) - params->pad_top;
-                    // Compute the boundaries of the filter region clamped so as to
-                    // ensure that the filter window fits in the input array.
-                    const int filter_x_start = shl_ref_max_internal_s32(0, -in_x_origin);
-                    const int filter_x_end =
-                        shl_ref_min_internal_s32(params->filter_width, input_width - in_x_origin);
-                    const int filter_y_start = shl_ref_max_internal_s32(0, -in_y_origin);
-                    const int filter_y_end =
-                        shl_ref_min_internal_s32(params->filter_height, input_height - in_y_origin);
-                    float max = -FLT_MAX;
-                    int filter_cnt = 0;
-                    for (int filter_y = filter_y_start; filter_y < filter_y_end; ++filter_y) {
-                        for (int filter_x = filter_x_start; filter_x < filter_x_end; ++filter_x) {
-                            const int in_x = in_x_origin + filter_x;
-                            const int in_y = in_y_origin + filter_y;
-                            max = fmax(max, input_data[shl_ref_get_index(input->dim, batch, in_y,
-                                                                         in_x, channel)]);
-                            filter_cnt++;
-                        }
-                    }
-                    // consider padding with constant 0
-                    if (filter_cnt != params->filter_height * params->filter_width) {
-                        max = fmax(max, 0);
-                    }
-                    output_data[shl_ref_get_index(output->dim, batch, out_y, out_x, channel)] = max;
-                }
+    for (int start = 0; start < n; start += k) {
+        const int end = shl_ref_min_internal_s32(start + k, n);
+        for (int i = 0; i < len; ++i) {
+            pre[start * len + i] = fmaxf(-FLT_MAX, src[start * len + i]);
+        }
+        for (int p = start + 1; p < end; ++p) {
+            for (int i = 0; i < len; ++i) {
+                pre[p * len + i] = fmaxf(pre[(p - 1) * len + i], src[p * len + i]);
+            }
+        }
+        for (int i = 0; i < len; ++i) {
+            suf[(end - 1) * len + i] = fmaxf(-FLT_MAX, src[(end - 1) * len + i]);
+        }
+        for (int p = end - 2; p >= start; --p) {
+            for (int i = 0; i < len; ++i) {
+                suf[p * len + i] = fmaxf(suf[(p + 1) * len + i], src[p * len + i]);
             }
         }
     }
-    return CSINN_TRUE;
 }
 
-static int shl_ref_maxpool2d_nchw_f32(struct csinn_tensor *input, struct csinn_tensor *output,
-                                      struct csinn_pool_params *params)
+/*
+ * Max of vectors [lo, hi) from block maxima. A clamped pooling window is either exactly k long
+ * or touches 0 or n, so it is covered by at most one suffix and one prefix.
+ */
+static void window_max_f32(const float *pre, const float *suf, float *dst, int lo, int hi, int len,
+                           int k)
 {
-    float *input_data = input->data;
-    float *output_data = output->data;
-    const int batches = input->dim[0];
-    const int depth = input->dim[1];
-    const int input_height = input->dim[2];
-    const int input_width = input->dim[3];
-    const int output_height = output->dim[2];
-    const int output_width = output->dim[3];
-
-    for (int batch = 0; batch < batches; ++batch) {
-        for (int out_y = 0; out_y < output_height; ++out_y) {
-            for (int out_x = 0; out_x < output_width; ++out_x) {
-                for (int channel = 0; channel < depth; ++channel) {
-                    const int in_x_origin = (out_x * params->stride_width) - params->pad_left;
-                    const int in_y_origin = (out_y * params->stride_height) - params->pad_top;
-                    // Compute the boundaries of the filter region clamped so as to
-                    // ensure that the filter window fits in the input array.
-                    const int filter_x_start = shl_ref_max_internal_s32(0, -in_x_origin);
-                    const int filter_x_end =
-                        shl_ref_min_internal_s32(params->filter_width, input_width - in_x_origin);
-                    const int filter_y_start = shl_ref_max_internal_s32(0, -in_y_origin);
-                    const int filter_y_end =
-                        shl_ref_min_internal_s32(params->filter_height, input_height - in_y_origin);
-                    float max = -FLT_MAX;
-                    int filter_cnt = 0;
-                    for (int filter_y = filter_y_start; filter_y < filter_y_end; ++filter_y) {
-                        for (int filter_x = filter_x_start; filter_x < filter_x_end; ++filter_x) {
-                            const int in_x = in_x_origin + filter_x;
-                            const int in_y = in_y_origin + filter_y;
-                            max = fmax(max, input_data[shl_ref_get_index(input->dim, batch, channel,
-                                                                         in_y, in_x)]);
-                            filter_cnt++;
-                        }
-                    }
-                    // consider padding with constant 0
-                    if (filter_cnt != params->filter_height * params->filter_width) {
-                        max = fmax(max, 0);
-                    }
-                    output_data[shl_ref_get_index(output->dim, batch, channel, out_y, out_x)] = max;
+    const float *head = suf + lo * len;
+    const float *tail = pre + (hi - 1) * len;
+    if (lo / k != (hi - 1) / k) {
+        for (int i = 0; i < len; ++i) {
+            dst[i] = fmaxf(head[i], tail[i]);
+        }
+    } else if (lo % k == 0) {
+        memcpy(dst, tail, len * sizeof(float));
+    } else {
+        memcpy(dst, head, len * sizeof(float));
+    }
+}
+
+/* direct max of vectors [lo, hi) spaced stride apart */
+static void scan_max_f32(const float *src, float *dst, int lo, int hi, int len, int stride)
+{
+    for (int i = 0; i < len; ++i) {
+        dst[i] = -FLT_MAX;
+    }
+    for (int p = lo; p < hi; ++p) {
+        const float *cur = src + p * stride;
+        for (int i = 0; i < len; ++i) {
+            dst[i] = fmaxf(dst[i], cur[i]);
+        }
+    }
+}
+
+/*
+ * Max pooling of one spatial plane, element (y, x, i) is at (y * width + x) * inner + i.
+ * NHWC passes the whole channel vector as inner, NCHW runs plane by plane with inner = 1.
+ * The window is separated into a vertical pass producing one row of column maxima and a
+ * horizontal pass over that row; both are contiguous, and large windows go through block
+ * maxima so their cost does not grow with the filter size.
+ */
+static void maxpool2d_plane_f32(const float *input_data, float *output_data, int in_h, int in_w,
+                                int out_h, int out_w, int inner, struct csinn_pool_params *params,
+                                float *col_max, float *row_pre, float *row_suf, float *plane_pre,
+                                float *plane_suf)
+{
+    const int row_size = in_w * inner;
+    const int filter_h = params->filter_height;
+    const int filter_w = params->filter_width;
+
+    if (filter_h > MAXPOOL_DIRECT_WINDOW) {
+        block_max_f32(input_data, plane_pre, plane_suf, in_h, row_size, filter_h);
+    }
+
+    for (int out_y = 0; out_y < out_h; ++out_y) {
+        const int in_y_origin = (out_y * params->stride_height) - params->pad_top;
+        const int y_start = shl_ref_max_internal_s32(0, in_y_origin);
+        const int y_end = shl_ref_min_internal_s32(in_h, in_y_origin + filter_h);
+        float *out_row = output_data + out_y * out_w * inner;
+
+        if (y_end <= y_start) {
+            memset(out_row, 0, out_w * inner * sizeof(float));
+            continue;
+        }
+        if (filter_h > MAXPOOL_DIRECT_WINDOW) {
+            window_max_f32(plane_pre, plane_suf, col_max, y_start, y_end, row_size, filter_h);
+        } else {
+            scan_max_f32(input_data, col_max, y_start, y_end, row_size, row_size);
+        }
+        if (filter_w > MAXPOOL_DIRECT_WINDOW) {
+            block_max_f32(col_max, row_pre, row_suf, in_w, inner, filter_w);
+        }
+
+        for (int out_x = 0; out_x < out_w; ++out_x) {
+            const int in_x_origin = (out_x * params->stride_width) - params->pad_left;
+            const int x_start = shl_ref_max_internal_s32(0, in_x_origin);
+            const int x_end = shl_ref_min_internal_s32(in_w, in_x_origin + filter_w);
+            float *out = out_row + out_x * inner;
+
+            if (x_end <= x_start) {
+                memset(out, 0, inner * sizeof(float));
+                continue;
+            }
+            if (filter_w > MAXPOOL_DIRECT_WINDOW) {
+                window_max_f32(row_pre, row_suf, out, x_start, x_end, inner, filter_w);
+            } else {
+                scan_max_f32(col_max, out, x_start, x_end, inner, inner);
+            }
+            // consider padding with constant 0
+            if ((y_end - y_start) * (x_end - x_start) != filter_h * filter_w) {
+                for (int i = 0; i < inner; ++i) {
+                    out[i] = fmaxf(out[i], 0);
                 }
             }
         }
     }
+}
+
+static int shl_ref_maxpool2d_planes_f32(float *input_data, float *output_data, int planes,
+                                        int in_h, int in_w, int out_h, int out_w, int inner,
+                                        struct csinn_pool_params *params)
+{
+    const int row_size = in_w * inner;
+    float *col_max = shl_mem_alloc(row_size * sizeof(float));
+    float *row_pre = NULL;
+    float *row_suf = NULL;
+    float *plane_pre = NULL;
+    float *plane_suf = NULL;
+
+    if (params->filter_width > MAXPOOL_DIRECT_WINDOW) {
+        row_pre = shl_mem_alloc(row_size * sizeof(float));
+        row_suf = shl_mem_alloc(row_size * sizeof(float));
+    }
+    if (params->filter_height > MAXPOOL_DIRECT_WINDOW) {
+        plane_pre = shl_mem_alloc(in_h * row_size * sizeof(float));
+        plane_suf = shl_mem_alloc(in_h * row_size * sizeof(float));
+    }
+
+    for (int plane = 0; plane < planes; ++plane) {
+        maxpool2d_plane_f32(input_data + plane * in_h * row_size,
+                            output_data + plane * out_h * out_w * inner, in_h, in_w, out_h, out_w,
+                            inner, params, col_max, row_pre, row_suf, plane_pre, plane_suf);
+    }
+
+    shl_mem_free(col_max);
+    if (row_pre != NULL) {
+        shl_mem_free(row_pre);
+        shl_mem_free(row_suf);
+    }
+    if (plane_pre != NULL) {
+        shl_mem_free(plane_pre);
+        shl_mem_free(plane_suf);
+    }
     return CSINN_TRUE;
 }
 
+static int shl_ref_maxpool2d_nhwc_f32(struct csinn_tensor *input, struct csinn_tensor *output,
+                                      struct csinn_pool_params *params)
+{
+    return shl_ref_maxpool2d_planes_f32(input->data, output->data, input->dim[0], input->dim[1],
+                                        input->dim[2], output->dim[1], output->dim[2],
+                                        input->dim[3], params);
+}
+
+static int shl_ref_maxpool2d_nchw_f32(struct csinn_tensor *input, struct csinn_tensor *output,
+                                      struct csinn_pool_params *params)
+{
+    return shl_ref_maxpool2d_planes_f32(input->data, output->data, input->dim[0] * input->dim[1],
+                                        input->dim[2], input->dim[3], output->dim[2],
+                                        output->dim[3], 1, params);
+}
+
 int shl_ref_maxpool2d_f32(struct csinn_tensor *input, struct csinn_tensor *output,
                           struct csinn_pool_params *params)
 {
     if (params->base.layout == CSINN_LAYOUT_NCHW) {
-        shl_ref_maxpool2d_nchw_f32(input, output, params);
+        return shl_ref_maxpool2d_nchw_f32(input, output, params);
     } else if (params->base.layout == CSINN_LAYOUT_NHWC) {
-        shl_ref_maxpool2d_nhwc_f32(input, output, params);
+        return shl_ref_maxpool2d_nhwc_f32(input, output, params);
     } else {
         return CSINN_UNSUPPORT_LAYOUT;
     }
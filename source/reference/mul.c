@@ -20,10 +20,7 @@
 
 #include "shl_ref.h"
 
-static void element_mul_f32(float *src0, float *src1, float *dest, int input_idx, int output_idx)
-{
-    dest[output_idx] = src0[output_idx] * src1[input_idx];
-}
+SHL_REF_DISO_LOOP(element_mul_f32, x * y)
 
 int shl_ref_mul_f32(struct csinn_tensor *input0, struct csinn_tensor *input1,
                     struct csinn_tensor *output, struct csinn_diso_params *params)
@@ -31,8 +28,7 @@ int shl_ref_mul_f32(struct csinn_tensor *input0, struct csinn_tensor *input1,
     struct shl_ref_diso_callback cb;
 
     cb.bc = element_mul_f32;
-    shl_ref_diso_broadcast_base(input0, input1, output, params, &cb);
-    return CSINN_TRUE;
+    return shl_ref_diso_broadcast_base(input0, input1, output, params, &cb);
 }
 
 int shl_ref_mul_quant(struct csinn_tensor *input0, struct csinn_tensor *input1,
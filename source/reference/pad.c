@@ -134,6 +134,91 @@ int shl_ref_pad_f32(struct csinn_tensor *input, struct csinn_tensor *output,
     }
 }
 
+int shl_ref_pad_init(struct csinn_tensor *input, struct csinn_tensor *output,
+                     struct csinn_pad_params *params)
+{
+    struct csinn_callback *cb = params->base.cb;
+    char value[sizeof(double)];
+    if (shl_ref_is_same_quant(input, output) && params->pad_mode == CSINN_PAD_CONSTANT &&
+        input->dim_count > 0 && params->pad_num == input->dim_count &&
+        shl_ref_scalar_to_dtype(output, params->pad_value, value)) {
+        cb->exec = shl_ref_pad;
+    } else {
+        cb->exec = shl_ref_pad_quant;
+    }
+    return CSINN_TRUE;
+}
+
+static char *pad_fill(char *dst, int64_t num, const char *value, int elem_size)
+{
+    if (num <= 0) {
+        return dst;
+    }
+    if (elem_size == 1) {
+        memset(dst, value[0], num);
+        return dst + num;
+    }
+    /* grow the filled prefix by doubling */
+    memcpy(dst, value, elem_size);
+    int64_t done = 1;
+    while (done < num) {
+        int64_t n = done < num - done ? done : num - done;
+        memcpy(dst + done * elem_size, dst, n * elem_size);
+        done += n;
+    }
+    return dst + num * elem_size;
+}
+
+static char *pad_dim(const char *src, char *dst, const int32_t *in_dim,
+                     struct csinn_pad_params *params, const int64_t *in_stride,
+                     const int64_t *out_stride, const char *value, int elem_size, int d,
+                     int dim_count)
+{
+    dst = pad_fill(dst, params->pad_before[d] * out_stride[d], value, elem_size);
+    if (d == dim_count - 1) {
+        memcpy(dst, src, in_dim[d] * elem_size);
+        dst += in_dim[d] * elem_size;
+    } else {
+        for (int i = 0; i < in_dim[d]; i++) {
+            dst = pad_dim(src + i * in_stride[d] * elem_size, dst, in_dim, params, in_stride,
+                          out_stride, value, elem_size, d + 1, dim_count);
+        }
+    }
+    return pad_fill(dst, params->pad_after[d] * out_stride[d], value, elem_size);
+}
+
+/*
+ * input and output share dtype and quantization, constant padding with raw elements.
+ * pad_before/pad_after follow the tensor's own dimension order, so layout does not matter.
+ */
+int shl_ref_pad(struct csinn_tensor *input, struct csinn_tensor *output,
+                struct csinn_pad_params *params)
+{
+    const int dim_count = input->dim_count;
+    const int elem_size = shl_ref_get_dtype_size(input->dtype);
+    char value[sizeof(double)];
+    shl_ref_scalar_to_dtype(output, params->pad_value, value);
+
+    /* strides in elements */
+    int64_t in_stride[MAX_DIM];
+    int64_t out_stride[MAX_DIM];
+    int64_t in_acc = 1;
+    int64_t out_acc = 1;
+    for (int d = dim_count - 1; d >= 0; d--) {
+        in_stride[d] = in_acc;
+        out_stride[d] = out_acc;
+        in_acc *= input->dim[d];
+        out_acc *= input->dim[d] + params->pad_before[d] + params->pad_after[d];
+    }
+    if (in_acc == 0) {
+        pad_fill(output->data, out_acc, value, elem_size);
+        return CSINN_TRUE;
+    }
+    pad_dim(input->data, output->data, input->dim, params, in_stride, out_stride, value,
+            elem_size, 0, dim_count);
+    return CSINN_TRUE;
+}
+
 int shl_ref_pad_quant(struct csinn_tensor *input, struct csinn_tensor *output,
                       struct csinn_pad_params *params)
 {
@@ -82,44 +82,138 @@ static struct bbox generate_anchor(float ratio, float scale, int32_t base_size)
     return _bbox;
 }
 
-static float *predict_bbox(struct csinn_tensor *cls_prob_tensor,
-                           struct csinn_tensor *bbox_pred_tensor,
-                           struct csinn_tensor *im_info_tensor, float *ratios, int32_t ratios_num,
-                           float *scales, int32_t scales_num, int32_t feature_stride,
-                           int32_t iou_loss, int32_t rpn_min_size)
+/*
+ * Everything that only depends on the shapes and parameters lives in the
+ * plan: anchor extents for every feature-map column and row, and the
+ * buffers of one batch, so a run allocates nothing.
+ */
+struct proposal_plan {
+    int32_t num_anchors;
+    int32_t height;
+    int32_t width;
+    int32_t pre_nms_top_n;
+    int32_t *anchor_x1;  // [num_anchors][width], anchor x1 shifted to each column
+    int32_t *anchor_x2;
+    int32_t *anchor_y1;  // [num_anchors][height], anchor y1 shifted to each row
+    int32_t *anchor_y2;
+    float *bbox;     // [height * width * num_anchors][5], x1, y1, x2, y2 and score
+    int32_t *order;  // the pre_nms_top_n best boxes, best first
+    int32_t *keep;   // boxes surviving nms, in order
+    float *x1;       // coordinates of the ordered boxes, one array each for the iou pass
+    float *y1;
+    float *x2;
+    float *y2;
+    uint8_t *removed;
+};
+
+/* the plan belongs to params: released here, by a later init, or by session deinit */
+void shl_ref_proposal_deinit(struct csinn_proposal_params *params)
 {
-    int len_scales = scales_num;
-    int len_ratios = ratios_num;
-    int batch = cls_prob_tensor->dim[0];
-    int num_anchors = cls_prob_tensor->dim[1];
-    int height = cls_prob_tensor->dim[2];
-    int width = cls_prob_tensor->dim[3];
-    num_anchors = num_anchors / 2;
+    shl_mem_free(params->plan);
+    params->plan = NULL;
+}
 
+int shl_ref_proposal_init(struct csinn_tensor *cls_prob, struct csinn_tensor *bbox_pred,
+                          struct csinn_tensor *im_info, struct csinn_tensor *output,
+                          struct csinn_proposal_params *params)
+{
+    shl_ref_proposal_deinit(params);
+
+    int num_anchors = cls_prob->dim[1] / 2;
+    int height = cls_prob->dim[2];
+    int width = cls_prob->dim[3];
+    int num_bbox = height * width * num_anchors;
+    int pre_nms_top_n =
+        params->rpn_pre_nms_top_n > 0 ? MIN(params->rpn_pre_nms_top_n, num_bbox) : num_bbox;
+
+    float *ratios = params->ratios;
+    float *scales = params->scales;
+    if (output->dtype != CSINN_DTYPE_FLOAT32) {
+        ratios = shl_mem_alloc(params->ratios_num * sizeof(float));
+        scales = shl_mem_alloc(params->scales_num * sizeof(float));
+        for (int i = 0; i < params->ratios_num; i++) {
+            ratios[i] = shl_ref_get_scale(params->ratio_multipliers[i], params->ratio_shifts[i]);
+        }
+        for (int i = 0; i < params->scales_num; i++) {
+            scales[i] = shl_ref_get_scale(params->scale_multipliers[i], params->scale_shifts[i]);
+        }
+        params->threshold =
+            shl_ref_get_scale(params->threshold_multiplier, params->threshold_shift);
+    }
+
+    int64_t words = 2 * num_anchors * (width + height) + (int64_t)num_bbox * 5 + 6 * pre_nms_top_n;
+    struct proposal_plan *plan =
+        shl_mem_alloc(sizeof(struct proposal_plan) + words * 4 + pre_nms_top_n);
+    plan->num_anchors = num_anchors;
+    plan->height = height;
+    plan->width = width;
+    plan->pre_nms_top_n = pre_nms_top_n;
+    plan->anchor_x1 = (int32_t *)(plan + 1);
+    plan->anchor_x2 = plan->anchor_x1 + num_anchors * width;
+    plan->anchor_y1 = plan->anchor_x2 + num_anchors * width;
+    plan->anchor_y2 = plan->anchor_y1 + num_anchors * height;
+    plan->bbox = (float *)(plan->anchor_y2 + num_anchors * height);
+    plan->order = (int32_t *)(plan->bbox + num_bbox * 5);
+    plan->keep = plan->order + pre_nms_top_n;
+    plan->x1 = (float *)(plan->keep + pre_nms_top_n);
+    plan->y1 = plan->x1 + pre_nms_top_n;
+    plan->x2 = plan->y1 + pre_nms_top_n;
+    plan->y2 = plan->x2 + pre_nms_top_n;
+    plan->removed = (uint8_t *)(plan->y2 + pre_nms_top_n);
+
+    int stride = params->feature_stride;
+    for (int k = 0; k < num_anchors; k++) {
+        float ratio = ratios[k / params->scales_num];
+        float scale = scales[k % params->scales_num];
+        struct bbox anchor = generate_anchor(ratio, scale, stride);
+        for (int w = 0; w < width; w++) {
+            plan->anchor_x1[k * width + w] = anchor.x1 + w * stride;
+            plan->anchor_x2[k * width + w] = anchor.x2 + w * stride;
+        }
+        for (int h = 0; h < height; h++) {
+            plan->anchor_y1[k * height + h] = anchor.y1 + h * stride;
+            plan->anchor_y2[k * height + h] = anchor.y2 + h * stride;
+        }
+    }
+    if (ratios != params->ratios) {
+        shl_mem_free(ratios);
+        shl_mem_free(scales);
+    }
+    params->plan = plan;
+    return CSINN_TRUE;
+}
+
+/* decoded and clipped boxes of batch b, [height * width * num_anchors][5] */
+static void predict_bbox(struct proposal_plan *plan, struct csinn_tensor *cls_prob_tensor,
+                         struct csinn_tensor *bbox_pred_tensor, struct csinn_tensor *im_info_tensor,
+                         int b, int32_t feature_stride, int32_t iou_loss, int32_t rpn_min_size)
+{
+    int num_anchors = plan->num_anchors;
+    int height = plan->height;
+    int width = plan->width;
     float *cls_prob = cls_prob_tensor->data;
     float *bbox_pred = bbox_pred_tensor->data;
     float *im_info = im_info_tensor->data;
+    float *output = plan->bbox;
 
-    float *output = shl_mem_alloc(batch * height * width * num_anchors * 5 * sizeof(float));
+    int im_height = im_info[b * 3];
+    int im_width = im_info[b * 3 + 1];
+    int real_height = im_height / feature_stride;
+    int real_width = im_width / feature_stride;
+    int min_size = im_info[b * 3 + 2] * rpn_min_size;
 
-    for (int i = 0; i < batch * height * width; i++) {
+    for (int i = 0; i < height * width; i++) {
         int w = i % width;
-        int h = (i / width) % height;
-        int b = (i / width) / height;
+        int h = i / width;
 
         for (int k = 0; k < num_anchors; k++) {
             int out_index = i * num_anchors + k;
-            float ratio = ratios[k / scales_num];
-            float scale = scales[k % scales_num];
-            struct bbox anchor = generate_anchor(ratio, scale, feature_stride);
-            int im_height = im_info[b * 3];
-            int im_width = im_info[b * 3 + 1];
-            int x1 = anchor.x1 + w * feature_stride;
-            int y1 = anchor.y1 + h * feature_stride;
-            int x2 = anchor.x2 + w * feature_stride;
-            int y2 = anchor.y2 + h * feature_stride;
-
-            float *delta = shl_mem_alloc(4 * sizeof(float));
+            int x1 = plan->anchor_x1[k * width + w];
+            int y1 = plan->anchor_y1[k * height + h];
+            int x2 = plan->anchor_x2[k * width + w];
+            int y2 = plan->anchor_y2[k * height + h];
+
+            float delta[4];
             for (int j = 0; j < 4; j++) {
                 delta[j] = bbox_pred[(((b * num_anchors + k) * 4 + j) * height + h) * width + w];
             }
@@ -134,12 +228,8 @@ static float *predict_bbox(struct csinn_tensor *cls_prob_tensor,
             pred.x2 = MAX(MIN(pred.x2, im_width - 1.0), 0.0);
             pred.y2 = MAX(MIN(pred.y2, im_height - 1.0), 0.0);
 
-            int real_height = im_height / feature_stride;
-            int real_width = im_width / feature_stride;
-
             float bbox_w = pred.x2 - pred.x1 + 1.0;
             float bbox_h = pred.y2 - pred.y1 + 1.0;
-            int min_size = im_info[b * 3 + 2] * rpn_min_size;
 
             float pred_score =
                 cls_prob[(int)(((b * num_anchors * 2 + num_anchors + k) * height + h) * width + w)];
@@ -160,150 +250,137 @@ static float *predict_bbox(struct csinn_tensor *cls_prob_tensor,
             }
         }
     }
-    return output;
 }
 
-typedef struct {
-    int index;
-    float data;
-} index_value;
-
-static int argsort(const void *a, const void *b)
+/*
+ * Box a ranks before box b: higher score first and, on equal scores, the
+ * later box first, which is the order the qsort-based version produced.
+ */
+static inline int rank_before(const float *bbox, int a, int b)
 {
-    return ((((index_value *)a)->data - ((index_value *)b)->data > 0) ? -1 : 1);
+    float score_a = bbox[a * 5 + 4];
+    float score_b = bbox[b * 5 + 4];
+    return score_a > score_b || (score_a == score_b && a > b);
 }
 
-static float calculate_overlap(float *out_tensor, int box_a_idx, int box_b_idx)
+/* keep the worst ranked box at the root of the heap */
+static void heap_sift_down(const float *bbox, int32_t *heap, int size, int i)
 {
-    float w = MAX(0.0, MIN(out_tensor[box_a_idx + 2], out_tensor[box_b_idx + 2]) -
-                           MAX(out_tensor[box_a_idx], out_tensor[box_b_idx]) + 1.0);
-    float h = MAX(0.0, MIN(out_tensor[box_a_idx + 3], out_tensor[box_b_idx + 3]) -
-                           MAX(out_tensor[box_a_idx + 1], out_tensor[box_b_idx + 1]) + 1.0);
-    float i = w * h;
-    float u = (out_tensor[box_a_idx + 2] - out_tensor[box_a_idx] + 1.0) *
-                  (out_tensor[box_a_idx + 3] - out_tensor[box_a_idx + 1] + 1.0) +
-              (out_tensor[box_b_idx + 2] - out_tensor[box_b_idx] + 1.0) *
-                  (out_tensor[box_b_idx + 3] - out_tensor[box_b_idx + 1] + 1.0) -
-              i;
-    return i / u;
+    while (2 * i + 1 < size) {
+        int child = 2 * i + 1;
+        if (child + 1 < size && rank_before(bbox, heap[child], heap[child + 1])) {
+            child++;
+        }
+        if (!rank_before(bbox, heap[i], heap[child])) {
+            break;
+        }
+        int tmp = heap[i];
+        heap[i] = heap[child];
+        heap[child] = tmp;
+        i = child;
+    }
 }
 
-static float *compute_nms(int batch, int num_bbox, float *sorted_bbox, float threshold)
+/* the top_n best ranked of num_bbox boxes in order, without sorting the rest */
+static void select_top_n(const float *bbox, int num_bbox, int top_n, int32_t *order)
 {
-    float *out = shl_mem_alloc(batch * num_bbox * sizeof(float));
-    for (int b = 0; b < batch; b++) {
-        int base_idx = b * num_bbox;
-        for (int i = 0; i < num_bbox; i++) {
-            out[base_idx + i] = 0;
-        }
-        for (int l = 0; l < num_bbox - 1; l++) {
-            for (int i = 0; i < num_bbox; i++) {
-                if ((i < num_bbox) && (i > l)) {
-                    if (out[base_idx + l] == 0) {
-                        float iou =
-                            calculate_overlap(sorted_bbox, (base_idx + l) * 5, (base_idx + i) * 5);
-                        if (iou > threshold) {
-                            out[base_idx + i] = 1;
-                        }
-                    }
-                }
-            }
+    for (int i = 0; i < top_n; i++) {
+        order[i] = i;
+    }
+    for (int i = top_n / 2 - 1; i >= 0; i--) {
+        heap_sift_down(bbox, order, top_n, i);
+    }
+    for (int i = top_n; i < num_bbox; i++) {
+        if (rank_before(bbox, i, order[0])) {
+            order[0] = i;
+            heap_sift_down(bbox, order, top_n, 0);
         }
     }
-    return out;
+    for (int size = top_n - 1; size > 0; size--) {
+        int tmp = order[0];
+        order[0] = order[size];
+        order[size] = tmp;
+        heap_sift_down(bbox, order, size, 0);
+    }
 }
 
-static float *prepare_output(float *sorted_bbox, float *remove_mask, int batch, int num_bbox,
-                             int rpn_post_nms_top_n)
+/* greedy nms over the ordered boxes, returns how many are kept */
+static int compute_nms(struct proposal_plan *plan, int num_bbox, float threshold)
 {
-    int *i = shl_mem_alloc(batch * sizeof(int));
-    int *nkeep = shl_mem_alloc(batch * sizeof(int));
-    float *output = shl_mem_alloc(batch * rpn_post_nms_top_n * 5 * sizeof(int));
-
-    for (int b = 0; b < batch; b++) {
-        nkeep[b] = 0;
-        i[b] = 0;
+    float *x1 = plan->x1;
+    float *y1 = plan->y1;
+    float *x2 = plan->x2;
+    float *y2 = plan->y2;
+    uint8_t *restrict removed = plan->removed;
+    for (int i = 0; i < num_bbox; i++) {
+        const float *box = plan->bbox + plan->order[i] * 5;
+        x1[i] = box[0];
+        y1[i] = box[1];
+        x2[i] = box[2];
+        y2[i] = box[3];
+        removed[i] = 0;
     }
-    for (int j = 0; j < num_bbox; j++) {
-        for (int b = 0; b < batch; b++) {
-            if (remove_mask[b * num_bbox + j] == 0) {
-                nkeep[b] = nkeep[b] + 1;
-            }
+
+    int kept = 0;
+    for (int l = 0; l < num_bbox; l++) {
+        if (removed[l]) {
+            continue;
         }
-    }
-    for (int b = 0; b < batch; b++) {
-        if (nkeep[b] > 0) {
-            int ceil_idx = ceil((float)rpn_post_nms_top_n / nkeep[b]);
-            for (int m = 0; m < ceil_idx; m++) {
-                for (int j = 0; j < num_bbox; j++) {
-                    int offset_j = (b * num_bbox + j) * 5;
-                    int offset_i = (b * rpn_post_nms_top_n + i[b]) * 5;
-                    if ((i[b] < rpn_post_nms_top_n) && (remove_mask[(b * num_bbox + j)] == 0)) {
-                        output[offset_i] = b;
-                        for (int k = 0; k < 4; k++) {
-                            output[offset_i + k + 1] = sorted_bbox[offset_j + k];
-                        }
-                        i[b] = i[b] + 1;
-                    }
-                }
-            }
+        plan->keep[kept++] = l;
+        float lx1 = x1[l];
+        float ly1 = y1[l];
+        float lx2 = x2[l];
+        float ly2 = y2[l];
+        /* branch free so the compiler can vectorize it */
+        for (int i = l + 1; i < num_bbox; i++) {
+            float w = MIN(lx2, x2[i]) - MAX(lx1, x1[i]) + 1.0;
+            float h = MIN(ly2, y2[i]) - MAX(ly1, y1[i]) + 1.0;
+            float inter = MAX(w, 0.0f) * MAX(h, 0.0f);
+            float u = (lx2 - lx1 + 1.0) * (ly2 - ly1 + 1.0) +
+                      (x2[i] - x1[i] + 1.0) * (y2[i] - y1[i] + 1.0) - inter;
+            removed[i] |= inter / u > threshold;
         }
     }
-    return output;
+    return kept;
 }
 
 int shl_ref_proposal_f32(struct csinn_tensor *cls_prob, struct csinn_tensor *bbox_pred,
                          struct csinn_tensor *im_info, struct csinn_tensor *output,
                          struct csinn_proposal_params *params)
 {
+    struct proposal_plan *plan = params->plan;
+    if (plan == NULL || plan->num_anchors != cls_prob->dim[1] / 2 ||
+        plan->height != cls_prob->dim[2] || plan->width != cls_prob->dim[3]) {
+        shl_debug_error("proposal: plan missing or built for another shape\n");
+        return CSINN_FALSE;
+    }
     float *output_data = output->data;
-
-    int num_anchors = params->scales_num * params->ratios_num;
-
     int batch = cls_prob->dim[0];
-    int height = cls_prob->dim[2];
-    int width = cls_prob->dim[3];
+    int num_bbox = plan->height * plan->width * plan->num_anchors;
+    int post_nms_top_n = params->rpn_post_nms_top_n;
 
-    int num_bbox = height * width * num_anchors;
-    params->rpn_pre_nms_top_n =
-        params->rpn_pre_nms_top_n > 0 ? MIN(params->rpn_pre_nms_top_n, num_bbox) : num_bbox;
-
-    float *bbox = predict_bbox(cls_prob, bbox_pred, im_info, params->ratios, params->ratios_num,
-                               params->scales, params->scales_num, params->feature_stride,
-                               params->iou_loss, params->rpn_min_size);
-    index_value *score = shl_mem_alloc(batch * num_bbox * sizeof(index_value));
-    for (int i = 0; i < batch; i++) {
-        for (int j = 0; j < num_bbox; j++) {
-            int id = j + i * num_bbox;
-            int lid = j * 5 + 4 + i * num_bbox;
-            score[id].index = id;
-            score[id].data = bbox[lid];
-        }
-    }
-
-    qsort(score, batch * num_bbox, sizeof(index_value), argsort);
-
-    float *sorted_bbox = shl_mem_alloc(batch * params->rpn_pre_nms_top_n * 5 * sizeof(float));
     for (int b = 0; b < batch; b++) {
-        for (int i = 0; i < params->rpn_pre_nms_top_n; i++) {
-            int sorted_index = score[b * params->rpn_pre_nms_top_n + i].index;
-            for (int j = 0; j < 5; j++) {
-                int bbox_index = b * params->rpn_pre_nms_top_n + sorted_index * 5 + j;
-                int id = b * params->rpn_pre_nms_top_n + i * 5 + j;
-                sorted_bbox[id] = bbox[bbox_index];
+        predict_bbox(plan, cls_prob, bbox_pred, im_info, b, params->feature_stride,
+                     params->iou_loss, params->rpn_min_size);
+        select_top_n(plan->bbox, num_bbox, plan->pre_nms_top_n, plan->order);
+        int kept = compute_nms(plan, plan->pre_nms_top_n, params->threshold);
+
+        /* the kept boxes repeat until there are post_nms_top_n of them */
+        float *out = output_data + b * post_nms_top_n * 5;
+        for (int i = 0; i < post_nms_top_n; i++) {
+            if (kept == 0) {
+                memset(out + i * 5, 0, 5 * sizeof(float));
+                continue;
             }
+            int j = plan->keep[i % kept];
+            out[i * 5] = b;
+            out[i * 5 + 1] = plan->x1[j];
+            out[i * 5 + 2] = plan->y1[j];
+            out[i * 5 + 3] = plan->x2[j];
+            out[i * 5 + 4] = plan->y2[j];
         }
     }
 
-    float *nms_remove_mask =
-        compute_nms(batch, params->rpn_pre_nms_top_n, sorted_bbox, params->threshold);
-    float *nms_out = prepare_output(sorted_bbox, nms_remove_mask, batch, params->rpn_pre_nms_top_n,
-                                    params->rpn_post_nms_top_n);
-
-    for (int i = 0; i < batch * params->rpn_post_nms_top_n * 5; i++) {
-        output_data[i] = nms_out[i];
-    }
-
     return CSINN_TRUE;
 }
 
@@ -311,28 +388,13 @@ int shl_ref_proposal_quant(struct csinn_tensor *cls_prob, struct csinn_tensor *b
                            struct csinn_tensor *im_info, struct csinn_tensor *output,
                            struct csinn_proposal_params *params)
 {
-    float *scales = (float *)shl_mem_alloc(params->scales_num * sizeof(float));
-    for (int i = 0; i < params->scales_num; i++) {
-        scales[i] = shl_ref_get_scale(params->scale_multipliers[i], params->scale_shifts[i]);
-    }
-
-    float *ratios = (float *)shl_mem_alloc(params->scales_num * sizeof(float));
-    for (int i = 0; i < params->ratios_num; i++) {
-        ratios[i] = shl_ref_get_scale(params->ratio_multipliers[i], params->ratio_shifts[i]);
-    }
-    float threshold = shl_ref_get_scale(params->threshold_multiplier, params->threshold_shift);
-
-    params->ratios = ratios;
-    params->scales = scales;
-    params->threshold = threshold;
-
     struct csinn_tensor *fcls = shl_ref_tensor_transform_f32(cls_prob);
     struct csinn_tensor *fbbox = shl_ref_tensor_transform_f32(bbox_pred);
     struct csinn_tensor *foutput = shl_ref_tensor_transform_f32(output);
-    shl_ref_proposal_f32(fcls, fbbox, im_info, foutput, params);
+    int ret = shl_ref_proposal_f32(fcls, fbbox, im_info, foutput, params);
     csinn_tensor_data_convert(output, foutput);
     shl_ref_tensor_transform_free_f32(fcls);
     shl_ref_tensor_transform_free_f32(fbbox);
     shl_ref_tensor_transform_free_f32(foutput);
-    return CSINN_TRUE;
+    return ret;
 }
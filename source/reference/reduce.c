@@ -0,0 +1,240 @@
+/*
+ * Copyright (C) 2016-2022 T-Head Semiconductor Co., Ltd. All rights reserved.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* CSI-NN2 version 2.0.x */
+
+#include "shl_ref.h"
+
+/*
+ * Generic reduction core. Reduced axes are turned into a mask, size-1 dims
+ * are dropped and adjacent dims with the same mask are merged, leaving at
+ * most MAX_DIM alternating reduced/kept groups. The input is then walked
+ * once in memory order: an innermost reduced group is folded to a scalar
+ * per row, an innermost kept group is accumulated as a whole contiguous row
+ * of the output, so no loop ever strides through the input.
+ */
+
+static float reduce_identity(enum shl_ref_reduce_type type)
+{
+    switch (type) {
+        case SHL_REF_REDUCE_PROD:
+            return 1.0f;
+        case SHL_REF_REDUCE_MAX:
+            return -INFINITY;
+        case SHL_REF_REDUCE_MIN:
+            return INFINITY;
+        default:
+            return 0.0f;
+    }
+}
+
+/* fold a contiguous row into one value */
+static float reduce_row(const float *src, int64_t size, enum shl_ref_reduce_type type)
+{
+    float acc = reduce_identity(type);
+    switch (type) {
+        case SHL_REF_REDUCE_PROD:
+            for (int64_t i = 0; i < size; i++) acc *= src[i];
+            break;
+        case SHL_REF_REDUCE_MAX:
+            for (int64_t i = 0; i < size; i++) acc = fmaxf(acc, src[i]);
+            break;
+        case SHL_REF_REDUCE_MIN:
+            for (int64_t i = 0; i < size; i++) acc = fminf(acc, src[i]);
+            break;
+        case SHL_REF_REDUCE_LOGSUMEXP:
+            for (int64_t i = 0; i < size; i++) acc += expf(src[i]);
+            break;
+        default:
+            for (int64_t i = 0; i < size; i++) acc += src[i];
+            break;
+    }
+    return acc;
+}
+
+/* accumulate a contiguous row into the same-sized output row */
+static void reduce_acc_row(float *dst, const float *src, int64_t size,
+                           enum shl_ref_reduce_type type)
+{
+    switch (type) {
+        case SHL_REF_REDUCE_PROD:
+            for (int64_t i = 0; i < size; i++) dst[i] *= src[i];
+            break;
+        case SHL_REF_REDUCE_MAX:
+            for (int64_t i = 0; i < size; i++) dst[i] = fmaxf(dst[i], src[i]);
+            break;
+        case SHL_REF_REDUCE_MIN:
+            for (int64_t i = 0; i < size; i++) dst[i] = fminf(dst[i], src[i]);
+            break;
+        case SHL_REF_REDUCE_LOGSUMEXP:
+            for (int64_t i = 0; i < size; i++) dst[i] += expf(src[i]);
+            break;
+        default:
+            for (int64_t i = 0; i < size; i++) dst[i] += src[i];
+            break;
+    }
+}
+
+static float reduce_combine(float a, float b, enum shl_ref_reduce_type type)
+{
+    switch (type) {
+        case SHL_REF_REDUCE_PROD:
+            return a * b;
+        case SHL_REF_REDUCE_MAX:
+            return fmaxf(a, b);
+        case SHL_REF_REDUCE_MIN:
+            return fminf(a, b);
+        default:
+            return a + b;
+    }
+}
+
+int shl_ref_reduce_f32(struct csinn_tensor *input, struct csinn_tensor *output,
+                       const int32_t *axis, int32_t axis_count, enum shl_ref_reduce_type type)
+{
+    float *input_data = input->data;
+    float *output_data = output->data;
+    int dim_count = input->dim_count;
+    bool reduced[MAX_DIM] = {false};
+
+    /* no axis, or the single axis -1, reduces everything */
+    if (axis == NULL || axis_count == 0 || (axis_count == 1 && axis[0] == -1)) {
+        for (int i = 0; i < dim_count; i++) reduced[i] = true;
+    } else {
+        for (int i = 0; i < axis_count; i++) {
+            int a = axis[i] < 0 ? axis[i] + dim_count : axis[i];
+            if (a < 0 || a >= dim_count) {
+                shl_debug_error("%s: axis %d out of range\n", __func__, axis[i]);
+                return CSINN_FALSE;
+            }
+            reduced[a] = true;
+        }
+    }
+
+    /* collapse into alternating reduced/kept groups, outermost first */
+    int64_t extent[MAX_DIM];
+    bool is_reduced[MAX_DIM];
+    int groups = 0;
+    int64_t out_size = 1, count = 1;
+    for (int i = 0; i < dim_count; i++) {
+        if (input->dim[i] == 1) continue;
+        if (reduced[i]) {
+            count *= input->dim[i];
+        } else {
+            out_size *= input->dim[i];
+        }
+        if (groups > 0 && is_reduced[groups - 1] == reduced[i]) {
+            extent[groups - 1] *= input->dim[i];
+        } else {
+            extent[groups] = input->dim[i];
+            is_reduced[groups] = reduced[i];
+            groups++;
+        }
+    }
+    if (output->dim_count > 0 && csinn_tensor_size(output) != out_size) {
+        shl_debug_error("%s: output size does not match the reduced shape\n", __func__);
+        return CSINN_FALSE;
+    }
+
+    float init = reduce_identity(type);
+    for (int64_t i = 0; i < out_size; i++) {
+        output_data[i] = init;
+    }
+
+    if (groups > 0) {
+        /* output stride of every group, 0 for reduced ones */
+        int64_t out_stride[MAX_DIM];
+        int64_t acc = 1;
+        for (int g = groups - 1; g >= 0; g--) {
+            out_stride[g] = is_reduced[g] ? 0 : acc;
+            if (!is_reduced[g]) acc *= extent[g];
+        }
+
+        int64_t inner = extent[groups - 1];
+        int64_t rows = 1;
+        for (int g = 0; g < groups - 1; g++) rows *= extent[g];
+        int64_t index[MAX_DIM] = {0};
+        int64_t out_offset = 0;
+        const float *src = input_data;
+        for (int64_t r = 0; r < rows; r++, src += inner) {
+            if (is_reduced[groups - 1]) {
+                output_data[out_offset] = reduce_combine(output_data[out_offset],
+                                                         reduce_row(src, inner, type), type);
+            } else {
+                reduce_acc_row(output_data + out_offset, src, inner, type);
+            }
+            for (int g = groups - 2; g >= 0; g--) {
+                out_offset += out_stride[g];
+                if (++index[g] < extent[g]) {
+                    break;
+                }
+                out_offset -= out_stride[g] * extent[g];
+                index[g] = 0;
+            }
+        }
+    } else if (type == SHL_REF_REDUCE_LOGSUMEXP) {
+        output_data[0] = expf(input_data[0]);
+    } else {
+        output_data[0] = input_data[0];
+    }
+
+    if (type == SHL_REF_REDUCE_MEAN) {
+        for (int64_t i = 0; i < out_size; i++) output_data[i] /= count;
+    } else if (type == SHL_REF_REDUCE_LOGSUMEXP) {
+        for (int64_t i = 0; i < out_size; i++) output_data[i] = logf(output_data[i]);
+    }
+    return CSINN_TRUE;
+}
+
+/*
+ * mean/sum/prod/max/min take the reduced axes when they are given, and
+ * otherwise walk the precomputed out/inner stride tables of the params.
+ */
+int shl_ref_reduce_stride_f32(struct csinn_tensor *input, struct csinn_tensor *output,
+                              struct csinn_reduce_params *params, enum shl_ref_reduce_type type)
+{
+    if (params->axis != NULL && params->axis_count > 0) {
+        return shl_ref_reduce_f32(input, output, params->axis, params->axis_count, type);
+    }
+
+    float *input_data = input->data;
+    float *output_data = output->data;
+    int32_t inner_size = 1;
+    int32_t out_size = 1;
+
+    for (int32_t k = 0; k < params->n; k++) {
+        out_size *= params->out_extents[k];
+    }
+    for (int32_t k = 0; k < params->m; k++) {
+        inner_size *= params->inner_extents[k];
+    }
+
+    for (int32_t out = 0; out < out_size; out++) {
+        float result = reduce_identity(type);
+        int32_t out_index =
+            shl_ref_get_reduction_index(out, params->out_strides, params->out_extents, params->n);
+        for (int32_t inner = 0; inner < inner_size; inner++) {
+            int32_t index =
+                out_index + shl_ref_get_reduction_index(inner, params->inner_strides,
+                                                        params->inner_extents, params->m);
+            result = reduce_combine(result, input_data[index], type);
+        }
+        output_data[out] = type == SHL_REF_REDUCE_MEAN ? result / inner_size : result;
+    }
+    return CSINN_TRUE;
+}
@@ -23,46 +23,8 @@
 int shl_ref_reduce_logsumexp_f32(struct csinn_tensor *input, struct csinn_tensor *output,
                                  struct csinn_reduce_params *params)
 {
-    float *input_data = (float *)input->data;
-    float *output_data = (float *)output->data;
-    assert(params->axis_count == 1);  // the Function realization assumption axis_count=1
-    // axis=none
-    if (*(params->axis) == -1) {
-        int size = 1;
-        for (int i = 0; i < input->dim_count; i++) {
-            size = size * input->dim[i];
-        }
-        float res = exp(*input_data);
-        for (int j = 1; j < size; j++) {
-            res = res + exp(input_data[j]);
-        }
-        *output_data = log(res);
-    } else {
-        int axis = *(params->axis);
-        int64_t outer_size = 1;
-        for (int i = 0; i < axis; i++) {
-            outer_size *= input->dim[i];
-        }
-        int64_t inner_size = 1;
-        for (int i = axis + 1; i < input->dim_count; i++) {
-            inner_size *= input->dim[i];
-        }
-        int cnt = input->dim[axis];
-
-        for (int i = 0; i < outer_size; i++) {
-            for (int k = 0; k < inner_size; k++) {
-                float temp = 0.0f;
-                for (int j = 0; j < cnt; j++) {
-                    float input_val = *(input_data + j * inner_size + k);
-                    temp += exp(input_val);
-                }
-                *(output_data + k) = log(temp);
-            }
-            input_data += inner_size * cnt;
-            output_data += inner_size;
-        }
-    }
-    return CSINN_TRUE;
+    return shl_ref_reduce_f32(input, output, params->axis, params->axis_count,
+                              SHL_REF_REDUCE_LOGSUMEXP);
 }
 
 int shl_ref_reduce_logsumexp_quant(struct csinn_tensor *input, struct csinn_tensor *output,
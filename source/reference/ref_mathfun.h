@@ -0,0 +1,177 @@
+/*
+ * Copyright (C) 2016-2022 T-Head Semiconductor Co., Ltd. All rights reserved.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* CSI-NN2 version 2.0.x */
+
+#ifndef SOURCE_REFERENCE_REF_MATHFUN_H_
+#define SOURCE_REFERENCE_REF_MATHFUN_H_
+
+#include "shl_ref.h"
+
+/*
+ * Branch-free float approximations for the reference backend, used when
+ * the session enables fast_math. They only use arithmetic, selects and bit
+ * casts, so they map lane by lane onto SIMD (fast_math.c has AVX versions
+ * of exp and sigmoid). Error bounds were measured
+ * against double precision libm on a sweep over finite float inputs:
+ *
+ *   shl_ref_fast_expf     [-87.3, 88.7]   <= 1.5 ulp (0 below, inf above)
+ *   shl_ref_fast_logf     (0, FLT_MAX]    <= 1.5 ulp (-inf at 0, NaN below)
+ *   shl_ref_fast_tanhf    all             <= 5 ulp
+ *   shl_ref_fast_sigmoidf all             <= 3.5 ulp
+ *   shl_ref_fast_erff     all             <= 8 ulp, 4.5e-7 absolute
+ *
+ * shl_ref_fast_powf(x, y) is exp(y * log(x)) for x > 0, so its relative
+ * error grows with |y * log(x)|.
+ */
+
+static inline bool shl_ref_fast_math_enabled(void *params)
+{
+    struct csinn_params_base *base = params;
+    return base != NULL && base->sess != NULL && base->sess->fast_math;
+}
+
+#define c_ref_exp_hi 88.7228317f
+#define c_ref_exp_lo -87.3365479f
+#define c_ref_LOG2EF 1.44269504088896341f
+#define c_ref_ln2_hi 0.693359375f
+#define c_ref_ln2_lo -2.12194440e-4f
+
+static inline float shl_ref_fast_bits_to_float(int32_t i)
+{
+    float f;
+    memcpy(&f, &i, sizeof(f));
+    return f;
+}
+
+static inline int32_t shl_ref_fast_float_to_bits(float f)
+{
+    int32_t i;
+    memcpy(&i, &f, sizeof(i));
+    return i;
+}
+
+static inline float shl_ref_fast_expf(float x)
+{
+    float xc = fminf(fmaxf(x, c_ref_exp_lo), c_ref_exp_hi);
+    /* exp(x) = 2^n * exp(r), |r| <= ln2 / 2 */
+    float n = floorf(xc * c_ref_LOG2EF + 0.5f);
+    float r = xc - n * c_ref_ln2_hi - n * c_ref_ln2_lo;
+    float p = 1.9875691500E-4f;
+    p = p * r + 1.3981999507E-3f;
+    p = p * r + 8.3334519073E-3f;
+    p = p * r + 4.1665795894E-2f;
+    p = p * r + 1.6666665459E-1f;
+    p = p * r + 5.0000001201E-1f;
+    p = p * r * r + r + 1.0f;
+    /* n reaches 128 just below the overflow threshold, split off one factor of 2 */
+    int32_t e = (int32_t)n;
+    float extra = e > 127 ? 2.0f : 1.0f;
+    e = e > 127 ? 127 : e;
+    float y = p * shl_ref_fast_bits_to_float((e + 127) << 23) * extra;
+    y = x > c_ref_exp_hi ? INFINITY : y;
+    y = x < c_ref_exp_lo ? 0.0f : y;
+    return x != x ? x : y;
+}
+
+static inline float shl_ref_fast_logf(float x)
+{
+    int32_t bits = shl_ref_fast_float_to_bits(x);
+    /* scale denormals into the normal range */
+    float scaled = x * 8388608.0f;
+    int32_t is_denormal = x < 1.17549435e-38f;
+    bits = is_denormal ? shl_ref_fast_float_to_bits(scaled) : bits;
+    float e = (float)(((bits >> 23) & 0xff) - 127) - (is_denormal ? 23.0f : 0.0f);
+    /* mantissa in [sqrt(0.5), sqrt(2)) */
+    float m = shl_ref_fast_bits_to_float((bits & 0x007fffff) | 0x3f800000);
+    int32_t big = m > 1.41421356f;
+    m = big ? m * 0.5f : m;
+    e = big ? e + 1.0f : e;
+    float f = m - 1.0f;
+    float z = f * f;
+    float p = 7.0376836292E-2f;
+    p = p * f - 1.1514610310E-1f;
+    p = p * f + 1.1676998740E-1f;
+    p = p * f - 1.2420140846E-1f;
+    p = p * f + 1.4249322787E-1f;
+    p = p * f - 1.6668057665E-1f;
+    p = p * f + 2.0000714765E-1f;
+    p = p * f - 2.4999993993E-1f;
+    p = p * f + 3.3333331174E-1f;
+    float y = p * z * f + e * c_ref_ln2_lo - 0.5f * z;
+    y = f + y + e * c_ref_ln2_hi;
+    y = x == INFINITY ? x : y;
+    y = x == 0.0f ? -INFINITY : y;
+    y = x < 0.0f ? NAN : y;
+    return x != x ? x : y;
+}
+
+/* rational minimax approximation on [-7.9, 7.9], saturated outside */
+static inline float shl_ref_fast_tanhf(float x)
+{
+    float xc = fminf(fmaxf(x, -7.90531110763549805f), 7.90531110763549805f);
+    float x2 = xc * xc;
+    float p = -2.76076847742355e-16f;
+    p = p * x2 + 2.00018790482477e-13f;
+    p = p * x2 - 8.60467152213735e-11f;
+    p = p * x2 + 5.12229709037114e-08f;
+    p = p * x2 + 1.48572235717979e-05f;
+    p = p * x2 + 6.37261928875436e-04f;
+    p = p * x2 + 4.89352455891786e-03f;
+    p = p * xc;
+    float q = 1.19825839466702e-06f;
+    q = q * x2 + 1.18534705686654e-04f;
+    q = q * x2 + 2.26843463243900e-03f;
+    q = q * x2 + 4.89352518554385e-03f;
+    float y = p / q;
+    return fabsf(x) < 0.0004f ? x : y;
+}
+
+static inline float shl_ref_fast_sigmoidf(float x)
+{
+    return 1.0f / (1.0f + shl_ref_fast_expf(-x));
+}
+
+/* rational minimax approximation on [-4, 4], saturated outside */
+static inline float shl_ref_fast_erff(float x)
+{
+    float xc = fminf(fmaxf(x, -4.0f), 4.0f);
+    float x2 = xc * xc;
+    float p = -2.72614225801306e-10f;
+    p = p * x2 + 2.77068142495902e-08f;
+    p = p * x2 - 2.10102402082508e-06f;
+    p = p * x2 - 5.69250639462346e-05f;
+    p = p * x2 - 7.34990630326855e-04f;
+    p = p * x2 - 2.95459980854025e-03f;
+    p = p * x2 - 1.60960333262415e-02f;
+    p = p * xc;
+    float q = -1.45660718464996e-05f;
+    q = q * x2 - 2.13374055278905e-04f;
+    q = q * x2 - 1.68282697438203e-03f;
+    q = q * x2 - 7.37332916720468e-03f;
+    q = q * x2 - 1.42647390514189e-02f;
+    return p / q;
+}
+
+/* x > 0 */
+static inline float shl_ref_fast_powf(float x, float y)
+{
+    return shl_ref_fast_expf(y * shl_ref_fast_logf(x));
+}
+
+#endif  // SOURCE_REFERENCE_REF_MATHFUN_H_
@@ -222,6 +222,7 @@ static void *setup_cb_map()
         cb_map[CSINN_OP_ASINH][i].exec = shl_ref_asinh_quant;
         cb_map[CSINN_OP_ATAN][i].exec = shl_ref_atan_quant;
         cb_map[CSINN_OP_ATANH][i].exec = shl_ref_atanh_quant;
+        cb_map[CSINN_OP_ATTENTION][i].exec = shl_ref_attention_quant;
         cb_map[CSINN_OP_AVGPOOL2D][i].exec = shl_ref_avgpool2d_quant;
         cb_map[CSINN_OP_AVGPOOL3D][i].exec = shl_ref_avgpool3d_quant;
         cb_map[CSINN_OP_BN][i].exec = shl_ref_batch_normalization_quant;
@@ -234,6 +235,7 @@ static void *setup_cb_map()
         cb_map[CSINN_OP_CEIL][i].exec = shl_ref_ceil_quant;
         cb_map[CSINN_OP_CLIP][i].exec = shl_ref_clip_quant;
         cb_map[CSINN_OP_CONCAT][i].exec = shl_ref_concat_quant;
+        cb_map[CSINN_OP_CONCAT][i].init = shl_ref_concat_init;
         cb_map[CSINN_OP_COS][i].exec = shl_ref_cos_quant;
         cb_map[CSINN_OP_COSH][i].exec = shl_ref_cosh_quant;
         cb_map[CSINN_OP_CUMPROD][i].exec = shl_ref_cumprod_quant;
@@ -242,11 +244,15 @@ static void *setup_cb_map()
         cb_map[CSINN_OP_DEPTH_TO_SPACE][i].exec = shl_ref_depth_to_space_quant;
         cb_map[CSINN_OP_DIV][i].exec = shl_ref_div_quant;
         cb_map[CSINN_OP_ELU][i].exec = shl_ref_elu_quant;
+        cb_map[CSINN_OP_ELU][i].init = shl_ref_elu_init;
         cb_map[CSINN_OP_EQUANL][i].exec = shl_ref_equal_quant;
         cb_map[CSINN_OP_ERF][i].exec = shl_ref_erf_quant;
+        cb_map[CSINN_OP_ERF][i].init = shl_ref_erf_init;
         cb_map[CSINN_OP_EXP][i].exec = shl_ref_exp_quant;
+        cb_map[CSINN_OP_EXP][i].init = shl_ref_exp_init;
         cb_map[CSINN_OP_EXPAND_DIMS][i].exec = shl_ref_expand_dims_quant;
         cb_map[CSINN_OP_EXPM1][i].exec = shl_ref_expm1_quant;
+        cb_map[CSINN_OP_EXPM1][i].init = shl_ref_expm1_init;
         cb_map[CSINN_OP_FLATTEN][i].exec = shl_ref_flatten;
         cb_map[CSINN_OP_FLATTEN][i].init = shl_ref_flatten_init;
         cb_map[CSINN_OP_FLOOR_DIVIDE][i].exec = shl_ref_floor_divide_quant;
@@ -255,11 +261,13 @@ static void *setup_cb_map()
         cb_map[CSINN_OP_FSMN][i].exec = shl_ref_fsmn_quant;
         cb_map[CSINN_OP_GATHER_ND][i].exec = shl_ref_gather_nd_quant;
         cb_map[CSINN_OP_GATHER][i].exec = shl_ref_gather_quant;
+        cb_map[CSINN_OP_GATHER][i].init = shl_ref_gather_init;
         cb_map[CSINN_OP_GLOBAL_AVGPOOL2D][i].exec = shl_ref_global_avgpool2d_quant;
         cb_map[CSINN_OP_GLOBAL_MAXPOOL2D][i].exec = shl_ref_global_maxpool2d_quant;
         cb_map[CSINN_OP_GREATHER_EQUAL][i].exec = shl_ref_greater_equal_quant;
         cb_map[CSINN_OP_GREATHER][i].exec = shl_ref_greater_quant;
         cb_map[CSINN_OP_HARD_SIGMOID][i].exec = shl_ref_hard_sigmoid_quant;
+        cb_map[CSINN_OP_HARD_SIGMOID][i].init = shl_ref_hard_sigmoid_init;
         cb_map[CSINN_OP_IM2COL][i].exec = shl_ref_im2col_quant;
         cb_map[CSINN_OP_L2N][i].exec = shl_ref_l2_normalization_quant;
         cb_map[CSINN_OP_LEAKY_RELU][i].exec = shl_ref_leaky_relu_quant;
@@ -267,7 +275,9 @@ static void *setup_cb_map()
         cb_map[CSINN_OP_LESS][i].exec = shl_ref_less_quant;
         cb_map[CSINN_OP_LOG_SOFTMAX][i].exec = shl_ref_log_softmax_quant;
         cb_map[CSINN_OP_LOG][i].exec = shl_ref_log_quant;
+        cb_map[CSINN_OP_LOG][i].init = shl_ref_log_init;
         cb_map[CSINN_OP_LOG1P][i].exec = shl_ref_log1p_quant;
+        cb_map[CSINN_OP_LOG1P][i].init = shl_ref_log1p_init;
         cb_map[CSINN_OP_LOGICAL_AND][i].exec = shl_ref_logical_and_quant;
         cb_map[CSINN_OP_LOGICAL_NOT][i].exec = shl_ref_logical_not_quant;
         cb_map[CSINN_OP_LOGICAL_OR][i].exec = shl_ref_logical_or_quant;
@@ -288,10 +298,12 @@ static void *setup_cb_map()
         cb_map[CSINN_OP_NEGATIIVE][i].exec = shl_ref_negative_quant;
         cb_map[CSINN_OP_NOT_EQUAL][i].exec = shl_ref_not_equal_quant;
         cb_map[CSINN_OP_PAD][i].exec = shl_ref_pad_quant;
+        cb_map[CSINN_OP_PAD][i].init = shl_ref_pad_init;
         cb_map[CSINN_OP_POWER][i].exec = shl_ref_power_quant;
         cb_map[CSINN_OP_PRELU][i].exec = shl_ref_prelu_quant;
         cb_map[CSINN_OP_PROD][i].exec = shl_ref_prod_stride_quant;
         cb_map[CSINN_OP_PROPOSAL][i].exec = shl_ref_proposal_quant;
+        cb_map[CSINN_OP_PROPOSAL][i].init = shl_ref_proposal_init;
         cb_map[CSINN_OP_PSROIPOOLING][i].exec = shl_ref_psroipooling_quant;
         cb_map[CSINN_OP_REDUCE_LOGSUMEXP][i].exec = shl_ref_reduce_logsumexp_quant;
         cb_map[CSINN_OP_REDUCE_MAX][i].exec = shl_ref_reduce_max_quant;
@@ -310,6 +322,7 @@ static void *setup_cb_map()
         cb_map[CSINN_OP_ROIPOOL][i].exec = shl_ref_roipool_quant;
         cb_map[CSINN_OP_ROUND][i].exec = shl_ref_round_quant;
         cb_map[CSINN_OP_RSQRT][i].exec = shl_ref_rsqrt_quant;
+        cb_map[CSINN_OP_RSQRT][i].init = shl_ref_rsqrt_init;
         cb_map[CSINN_OP_SEGMENT_MAX][i].exec = shl_ref_segment_max_quant;
         cb_map[CSINN_OP_UNSORTED_SEGMENT_MAX][i].exec = shl_ref_unsorted_segment_max_quant;
         cb_map[CSINN_OP_SEGMENT_MEAN][i].exec = shl_ref_segment_mean_quant;
@@ -322,25 +335,33 @@ static void *setup_cb_map()
         cb_map[CSINN_OP_UNSORTED_SEGMENT_SUM][i].exec = shl_ref_unsorted_segment_sum_quant;
         cb_map[CSINN_OP_SHUFFLE_CHANNEL][i].exec = shl_ref_shuffle_channel_quant;
         cb_map[CSINN_OP_SIGMOID][i].exec = shl_ref_sigmoid_quant;
+        cb_map[CSINN_OP_SIGMOID][i].init = shl_ref_sigmoid_init;
         cb_map[CSINN_OP_SIGN][i].exec = shl_ref_sign_quant;
         cb_map[CSINN_OP_SIN][i].exec = shl_ref_sin_quant;
         cb_map[CSINN_OP_SINH][i].exec = shl_ref_sinh_quant;
         cb_map[CSINN_OP_SLICE][i].exec = shl_ref_slice_quant;
+        cb_map[CSINN_OP_SLICE][i].init = shl_ref_slice_init;
         cb_map[CSINN_OP_SOFTMAX][i].exec = shl_ref_softmax_quant;
         cb_map[CSINN_OP_SOFTPLUS][i].exec = shl_ref_softplus_quant;
+        cb_map[CSINN_OP_SOFTPLUS][i].init = shl_ref_softplus_init;
         cb_map[CSINN_OP_SOFTRELU][i].exec = shl_ref_softrelu_quant;
         cb_map[CSINN_OP_SOFTSIGN][i].exec = shl_ref_softsign_quant;
+        cb_map[CSINN_OP_SOFTSIGN][i].init = shl_ref_softsign_init;
         cb_map[CSINN_OP_SPACE_TO_BATCH][i].exec = shl_ref_space_to_batch_quant;
         cb_map[CSINN_OP_SPACE_TO_DEPTH][i].exec = shl_ref_space_to_depth_quant;
         cb_map[CSINN_OP_SQRT][i].exec = shl_ref_sqrt_quant;
+        cb_map[CSINN_OP_SQRT][i].init = shl_ref_sqrt_init;
         cb_map[CSINN_OP_STACK][i].exec = shl_ref_stack_quant;
         cb_map[CSINN_OP_STRIDED_SLICE][i].exec = shl_ref_strided_slice_quant;
+        cb_map[CSINN_OP_STRIDED_SLICE][i].init = shl_ref_strided_slice_init;
         cb_map[CSINN_OP_SUB][i].exec = shl_ref_sub_quant;
         cb_map[CSINN_OP_SUM][i].exec = shl_ref_sum_stride_quant;
         cb_map[CSINN_OP_TAN][i].exec = shl_ref_tan_quant;
         cb_map[CSINN_OP_TANH][i].exec = shl_ref_tanh_quant;
+        cb_map[CSINN_OP_TANH][i].init = shl_ref_tanh_init;
         cb_map[CSINN_OP_THRESHOLD_RELU][i].exec = shl_ref_threshold_relu_quant;
         cb_map[CSINN_OP_TILE][i].exec = shl_ref_tile_quant;
+        cb_map[CSINN_OP_TILE][i].init = shl_ref_tile_init;
         cb_map[CSINN_OP_TOPK][i].exec = shl_ref_topk_quant;
         cb_map[CSINN_OP_TRANSPOSE][i].exec = shl_ref_transpose;
         cb_map[CSINN_OP_TRANSPOSE][i].init = shl_ref_transpose_init;
@@ -348,8 +369,11 @@ static void *setup_cb_map()
         cb_map[CSINN_OP_UNPOOLING][i].exec = shl_ref_unpooling_quant;
         cb_map[CSINN_OP_YUV_RGB_SCALE][i].exec = shl_ref_yuv_rgb_scale_quant;
         cb_map[CSINN_OP_CONV2D][i].exec = shl_ref_conv2d_quant;
+        cb_map[CSINN_OP_CONV2D][i].init = shl_ref_conv2d_init;
         cb_map[CSINN_OP_CONV2D_RELU][i].exec = shl_ref_conv2d_relu_quant;
+        cb_map[CSINN_OP_CONV2D_RELU][i].init = shl_ref_conv2d_init;
         cb_map[CSINN_OP_CONV2D_RELU6][i].exec = shl_ref_conv2d_relu6_quant;
+        cb_map[CSINN_OP_CONV2D_RELU6][i].init = shl_ref_conv2d_init;
         cb_map[CSINN_OP_CONV2D_CHANNEL][i].exec = shl_ref_conv2d_channel_quant;
         cb_map[CSINN_OP_CONV2D_CHANNEL_RELU][i].exec = shl_ref_conv2d_channel_relu_quant;
         cb_map[CSINN_OP_CONV2D_CHANNEL_RELU6][i].exec = shl_ref_conv2d_channel_relu6_quant;
@@ -369,11 +393,14 @@ static void *setup_cb_map()
             shl_ref_group_conv2d_channel_relu_quant;
         cb_map[CSINN_OP_CONV3D][i].exec = shl_ref_conv3d_quant;
         cb_map[CSINN_OP_DECONV2D][i].exec = shl_ref_deconv2d_quant;
+        cb_map[CSINN_OP_DECONV2D][i].init = shl_ref_deconv2d_init;
         cb_map[CSINN_OP_DEPTHWISE_DECONV2D][i].exec = shl_ref_depthwise_deconv2d_quant;
+        cb_map[CSINN_OP_DEPTHWISE_DECONV2D][i].init = shl_ref_deconv2d_init;
         cb_map[CSINN_OP_DECONV3D][i].exec = shl_ref_deconv3d_quant;
         cb_map[CSINN_OP_FULLYCONNECTED][i].exec = shl_ref_fullyconnected_quant;
         cb_map[CSINN_OP_SCATTER_ND][i].exec = shl_ref_scatter_nd_quant;
         cb_map[CSINN_OP_SPLIT][i].exec = shl_ref_split_quant;
+        cb_map[CSINN_OP_SPLIT][i].init = shl_ref_split_init;
     }
 
     for (int i = CSINN_DTYPE_UINT8; i <= CSINN_DTYPE_FLOAT64; i++) {
@@ -402,6 +429,8 @@ static void *setup_cb_map()
     cb_map[CSINN_OP_XOR][CSINN_DTYPE_UINT8].exec = shl_ref_xor_u8;
     cb_map[CSINN_OP_XOR][CSINN_DTYPE_INT8].exec = shl_ref_xor_i8;
     cb_map[CSINN_OP_XOR][CSINN_DTYPE_UINT32].exec = shl_ref_xor_u32;
+    cb_map[CSINN_OP_YUV_PREPROCESS][CSINN_DTYPE_UINT8].init = shl_ref_yuv_preprocess_init;
+    cb_map[CSINN_OP_YUV_PREPROCESS][CSINN_DTYPE_UINT8].exec = shl_ref_yuv_preprocess;
 
     cb_map[CSINN_OP_ABS][CSINN_DTYPE_FLOAT32].exec = shl_ref_abs_f32;
     cb_map[CSINN_OP_ACOS][CSINN_DTYPE_FLOAT32].exec = shl_ref_acos_f32;
@@ -414,6 +443,7 @@ static void *setup_cb_map()
     cb_map[CSINN_OP_ASINH][CSINN_DTYPE_FLOAT32].exec = shl_ref_asinh_f32;
     cb_map[CSINN_OP_ATAN][CSINN_DTYPE_FLOAT32].exec = shl_ref_atan_f32;
     cb_map[CSINN_OP_ATANH][CSINN_DTYPE_FLOAT32].exec = shl_ref_atanh_f32;
+    cb_map[CSINN_OP_ATTENTION][CSINN_DTYPE_FLOAT32].exec = shl_ref_attention_f32;
     cb_map[CSINN_OP_AVGPOOL2D][CSINN_DTYPE_FLOAT32].exec = shl_ref_avgpool2d_f32;
     cb_map[CSINN_OP_AVGPOOL3D][CSINN_DTYPE_FLOAT32].exec = shl_ref_avgpool3d_f32;
     cb_map[CSINN_OP_BN][CSINN_DTYPE_FLOAT32].exec = shl_ref_batch_normalization_f32;
@@ -427,11 +457,14 @@ static void *setup_cb_map()
     cb_map[CSINN_OP_CLIP][CSINN_DTYPE_FLOAT32].exec = shl_ref_clip_f32;
     cb_map[CSINN_OP_CONCAT][CSINN_DTYPE_FLOAT32].exec = shl_ref_concat_f32;
     cb_map[CSINN_OP_CONV2D][CSINN_DTYPE_FLOAT32].exec = shl_ref_conv2d_f32;
+    cb_map[CSINN_OP_CONV2D][CSINN_DTYPE_FLOAT32].init = shl_ref_conv2d_init;
     cb_map[CSINN_OP_DEPTHWISE_CONV2D][CSINN_DTYPE_FLOAT32].exec = shl_ref_depthwise_conv2d_f32;
     cb_map[CSINN_OP_GROUP_CONV2D][CSINN_DTYPE_FLOAT32].exec = shl_ref_group_conv2d_f32;
     cb_map[CSINN_OP_CONV3D][CSINN_DTYPE_FLOAT32].exec = shl_ref_conv3d_f32;
     cb_map[CSINN_OP_DECONV2D][CSINN_DTYPE_FLOAT32].exec = shl_ref_deconv2d_f32;
+    cb_map[CSINN_OP_DECONV2D][CSINN_DTYPE_FLOAT32].init = shl_ref_deconv2d_init;
     cb_map[CSINN_OP_DEPTHWISE_DECONV2D][CSINN_DTYPE_FLOAT32].exec = shl_ref_depthwise_deconv2d_f32;
+    cb_map[CSINN_OP_DEPTHWISE_DECONV2D][CSINN_DTYPE_FLOAT32].init = shl_ref_deconv2d_init;
     cb_map[CSINN_OP_DECONV3D][CSINN_DTYPE_FLOAT32].exec = shl_ref_deconv3d_f32;
     cb_map[CSINN_OP_COS][CSINN_DTYPE_FLOAT32].exec = shl_ref_cos_f32;
     cb_map[CSINN_OP_COSH][CSINN_DTYPE_FLOAT32].exec = shl_ref_cosh_f32;
@@ -493,6 +526,7 @@ static void *setup_cb_map()
     cb_map[CSINN_OP_PRELU][CSINN_DTYPE_FLOAT32].exec = shl_ref_prelu_f32;
     cb_map[CSINN_OP_PROD][CSINN_DTYPE_FLOAT32].exec = shl_ref_prod_stride_f32;
     cb_map[CSINN_OP_PROPOSAL][CSINN_DTYPE_FLOAT32].exec = shl_ref_proposal_f32;
+    cb_map[CSINN_OP_PROPOSAL][CSINN_DTYPE_FLOAT32].init = shl_ref_proposal_init;
     cb_map[CSINN_OP_PSROIPOOLING][CSINN_DTYPE_FLOAT32].exec = shl_ref_psroipooling_f32;
     cb_map[CSINN_OP_REDUCE_LOGSUMEXP][CSINN_DTYPE_FLOAT32].exec = shl_ref_reduce_logsumexp_f32;
     cb_map[CSINN_OP_REDUCE_MAX][CSINN_DTYPE_FLOAT32].exec = shl_ref_reduce_max_f32;
@@ -576,6 +610,7 @@ static void *setup_cb_map()
         cb_map[CSINN_OP_ASINH][i].est = shl_gref_asinh;
         cb_map[CSINN_OP_ATAN][i].est = shl_gref_atan;
         cb_map[CSINN_OP_ATANH][i].est = shl_gref_atanh;
+        cb_map[CSINN_OP_ATTENTION][i].est = shl_gref_attention;
         cb_map[CSINN_OP_AVGPOOL2D][i].est = shl_gref_avgpool2d;
         cb_map[CSINN_OP_AVGPOOL3D][i].est = shl_gref_avgpool3d;
         cb_map[CSINN_OP_BN][i].est = shl_gref_batch_normalization;
@@ -695,6 +730,7 @@ static void *setup_cb_map()
         cb_map[CSINN_OP_TRANSPOSE][i].est = shl_gref_transpose;
         cb_map[CSINN_OP_TRUNC][i].est = shl_gref_trunc;
         cb_map[CSINN_OP_UNPOOLING][i].est = shl_gref_unpooling;
+        cb_map[CSINN_OP_YUV_PREPROCESS][i].est = shl_gref_yuv_preprocess;
         cb_map[CSINN_OP_YUV_RGB_SCALE][i].est = shl_gref_yuv_rgb_scale;
         cb_map[CSINN_OP_CONV2D][i].est = shl_gref_conv2d;
         cb_map[CSINN_OP_CONV2D_RELU][i].est = shl_gref_conv2d_relu;
@@ -715,6 +751,58 @@ static void *setup_cb_map()
     return cb_map;
 }
 
+static void op_deinit_lut(uint8_t **lut)
+{
+    shl_mem_free(*lut);
+    *lut = NULL;
+}
+
+/*
+ * Release the data an init callback cached in params. Init frees the copy of a previous call
+ * itself, this is for the end of the op's life, e.g. from session deinit.
+ */
+void shl_ref_op_deinit(int op, void *params)
+{
+    switch (op) {
+        case CSINN_OP_CONV2D:
+        case CSINN_OP_CONV2D_RELU:
+        case CSINN_OP_CONV2D_RELU6:
+            shl_ref_conv2d_deinit(params);
+            break;
+        case CSINN_OP_DECONV2D:
+        case CSINN_OP_DEPTHWISE_DECONV2D:
+            shl_ref_deconv2d_deinit(params);
+            break;
+        case CSINN_OP_ERF:
+        case CSINN_OP_EXP:
+        case CSINN_OP_EXPM1:
+        case CSINN_OP_LOG:
+        case CSINN_OP_LOG1P:
+        case CSINN_OP_RSQRT:
+        case CSINN_OP_SOFTPLUS:
+        case CSINN_OP_SOFTSIGN:
+        case CSINN_OP_SQRT:
+        case CSINN_OP_TANH:
+            op_deinit_lut(&((struct csinn_siso_params *)params)->lut);
+            break;
+        case CSINN_OP_ELU:
+            op_deinit_lut(&((struct csinn_relu_params *)params)->lut);
+            break;
+        case CSINN_OP_SIGMOID:
+        case CSINN_OP_HARD_SIGMOID:
+            op_deinit_lut(&((struct csinn_sigmoid_params *)params)->lut);
+            break;
+        case CSINN_OP_PROPOSAL:
+            shl_ref_proposal_deinit(params);
+            break;
+        case CSINN_OP_YUV_PREPROCESS:
+            shl_ref_yuv_preprocess_deinit(params);
+            break;
+        default:
+            break;
+    }
+}
+
 static int get_cb_map_index(int op, int dtype) { return op * CSINN_DTYPE_SIZE + dtype; }
 static struct csinn_callback *__cb_map_table_ref;
 struct csinn_callback *shl_cb_map_ref(int op, int dtype)
@@ -74,6 +74,7 @@ int shl_ref_shuffle_channel_f32(struct csinn_tensor *input, struct csinn_tensor
     } else {
         return CSINN_UNSUPPORT_LAYOUT;
     }
+    return CSINN_TRUE;
 }
 
 int shl_ref_shuffle_channel_quant(struct csinn_tensor *input, struct csinn_tensor *output,
@@ -20,47 +20,47 @@
 
 #include "shl_ref.h"
 
-int shl_ref_slice_f32(struct csinn_tensor *input, struct csinn_tensor *output,
-                      struct csinn_slice_params *params)
+int shl_ref_slice_init(struct csinn_tensor *input, struct csinn_tensor *output,
+                       struct csinn_slice_params *params)
+{
+    struct csinn_callback *cb = params->base.cb;
+    if (shl_ref_is_same_quant(input, output)) {
+        cb->exec = shl_ref_slice;
+    } else {
+        cb->exec = shl_ref_slice_quant;
+    }
+    return CSINN_TRUE;
+}
+
+static int slice_copy(struct csinn_tensor *input, struct csinn_tensor *output,
+                      struct csinn_slice_params *params, int elem_size)
 {
-    float *input_data = input->data;
-    float *output_data = output->data;
-    if (input->dim_count == 4) {
-        for (int b = params->begin[0]; b < params->end[0]; b++) {
-            for (int c = params->begin[1]; c < params->end[1]; c++) {
-                for (int h = params->begin[2]; h < params->end[2]; h++) {
-                    for (int w = params->begin[3]; w < params->end[3]; w++) {
-                        int32_t input_index = shl_ref_get_index(input->dim, b, c, h, w);
-                        float out_val = input_data[input_index];
-                        int32_t out_index = shl_ref_get_index(
-                            output->dim, b - params->begin[0], c - params->begin[1],
-                            h - params->begin[2], w - params->begin[3]);
-                        output_data[out_index] = out_val;
-                    }
-                }
-            }
-        }
-    } else if (input->dim_count == 5) {
-        for (int i = params->begin[0]; i < params->end[0]; i++) {
-            for (int j = params->begin[1]; j < params->end[1]; j++) {
-                for (int k = params->begin[2]; k < params->end[2]; k++) {
-                    for (int l = params->begin[3]; l < params->end[3]; l++) {
-                        for (int m = params->begin[4]; m < params->end[4]; m++) {
-                            int32_t input_index = shl_ref_get_index_5(input->dim, i, j, k, l, m);
-                            float out_val = input_data[input_index];
-                            int32_t out_index = shl_ref_get_index_5(
-                                output->dim, i - params->begin[0], j - params->begin[1],
-                                k - params->begin[2], l - params->begin[3], m - params->begin[4]);
-                            output_data[out_index] = out_val;
-                        }
-                    }
-                }
-            }
-        }
+    int32_t begin[MAX_DIM];
+    int32_t count[MAX_DIM];
+    int32_t stride[MAX_DIM];
+    for (int i = 0; i < input->dim_count; i++) {
+        begin[i] = params->begin[i];
+        count[i] = params->end[i] - params->begin[i];
+        stride[i] = 1;
     }
+    shl_ref_strided_copy(input->data, output->data, input->dim_count, input->dim, begin, count,
+                         stride, elem_size);
     return CSINN_TRUE;
 }
 
+int shl_ref_slice_f32(struct csinn_tensor *input, struct csinn_tensor *output,
+                      struct csinn_slice_params *params)
+{
+    return slice_copy(input, output, params, sizeof(float));
+}
+
+/* input and output share dtype and quantization, move raw elements */
+int shl_ref_slice(struct csinn_tensor *input, struct csinn_tensor *output,
+                  struct csinn_slice_params *params)
+{
+    return slice_copy(input, output, params, shl_ref_get_dtype_size(input->dtype));
+}
+
 int shl_ref_slice_quant(struct csinn_tensor *input, struct csinn_tensor *output,
                         struct csinn_slice_params *params)
 {
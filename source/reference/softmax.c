@@ -18,7 +18,55 @@
 
 /* CSI-NN2 version 2.0.x */
 
-#include "shl_ref.h"
+#include "ref_mathfun.h"
+
+/* each outer block is cnt rows of inner_size contiguous values, reduced row-wise */
+static int softmax_fast_f32(float *input_data, float *output_data, int64_t outer_size,
+                            int64_t inner_size, int cnt)
+{
+    float *max = shl_mem_alloc(inner_size * sizeof(float));
+    float *sum = shl_mem_alloc(inner_size * sizeof(float));
+    for (int64_t i = 0; i < outer_size; i++) {
+        for (int64_t k = 0; k < inner_size; k++) {
+            max[k] = -FLT_MAX;
+            sum[k] = 0.0f;
+        }
+        for (int j = 0; j < cnt; j++) {
+            const float *in_row = input_data + j * inner_size;
+            for (int64_t k = 0; k < inner_size; k++) {
+                max[k] = fmaxf(max[k], in_row[k]);
+            }
+        }
+        for (int j = 0; j < cnt; j++) {
+            const float *in_row = input_data + j * inner_size;
+            float *out_row = output_data + j * inner_size;
+            for (int64_t k = 0; k < inner_size; k++) {
+                out_row[k] = in_row[k] - max[k];
+            }
+        }
+        shl_ref_fast_exp_f32(output_data, output_data, inner_size * cnt);
+        for (int j = 0; j < cnt; j++) {
+            const float *out_row = output_data + j * inner_size;
+            for (int64_t k = 0; k < inner_size; k++) {
+                sum[k] += out_row[k];
+            }
+        }
+        for (int64_t k = 0; k < inner_size; k++) {
+            sum[k] = 1.0f / sum[k];
+        }
+        for (int j = 0; j < cnt; j++) {
+            float *out_row = output_data + j * inner_size;
+            for (int64_t k = 0; k < inner_size; k++) {
+                out_row[k] *= sum[k];
+            }
+        }
+        input_data += inner_size * cnt;
+        output_data += inner_size * cnt;
+    }
+    shl_mem_free(max);
+    shl_mem_free(sum);
+    return CSINN_TRUE;
+}
 
 int shl_ref_softmax_f32(struct csinn_tensor *input, struct csinn_tensor *output,
                         struct csinn_softmax_params *params)
@@ -40,6 +88,10 @@ int shl_ref_softmax_f32(struct csinn_tensor *input, struct csinn_tensor *output,
 
     int cnt = input->dim[axis];
 
+    if (shl_ref_fast_math_enabled(params)) {
+        return softmax_fast_f32(input_data, output_data, outer_size, inner_size, cnt);
+    }
+
     for (int i = 0; i < outer_size; i++) {
         for (int k = 0; k < inner_size; k++) {
             float acc_exp = 0.0f;
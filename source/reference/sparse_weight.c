@@ -0,0 +1,230 @@
+/*
+ * Copyright (C) 2016-2022 T-Head Semiconductor Co., Ltd. All rights reserved.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* CSI-NN2 version 2.0.x */
+
+#include "shl_ref.h"
+
+/*
+ * Kernels for ASP42/ASP41 weights compressed by csinn_sparse_weight_compress. Only the kept
+ * lanes are stored and multiplied, so a 2:4 weight costs half the MACs and about half the
+ * bytes of the dense one, 1:4 a quarter.
+ */
+
+bool shl_ref_is_sparse_weight(struct csinn_tensor *weight)
+{
+    return weight->mtype == CSINN_MEM_TYPE_ASP42 || weight->mtype == CSINN_MEM_TYPE_ASP41;
+}
+
+/* reduction column of every kept value, [dim[0]][kept] */
+static int32_t *sparse_weight_columns(struct csinn_tensor *weight, int kept)
+{
+    const int n = weight->mtype == CSINN_MEM_TYPE_ASP42 ? 2 : 1;
+    const int rows = weight->dim[0];
+    const int index_bytes = (kept + 3) / 4;
+    const uint8_t *index = (uint8_t *)((float *)weight->data + rows * kept);
+    int32_t *columns = shl_mem_alloc(rows * kept * sizeof(int32_t));
+    for (int r = 0; r < rows; r++) {
+        for (int e = 0; e < kept; e++) {
+            int lane = (index[r * index_bytes + e / 4] >> (2 * (e % 4))) & 3;
+            columns[r * kept + e] = e / n * 4 + lane;
+        }
+    }
+    return columns;
+}
+
+int shl_ref_fullyconnected_sparse_f32(struct csinn_tensor *input, struct csinn_tensor *output,
+                                      struct csinn_tensor *weights, struct csinn_tensor *bias,
+                                      struct csinn_fc_params *params)
+{
+    float *input_data = input->data;
+    float *output_data = output->data;
+    float *values = weights->data;
+    float *bias_data = bias->data;
+    int batches = 1;
+    for (int i = 0; i < output->dim_count - 1; i++) {
+        batches *= output->dim[i];
+    }
+    const int output_depth = weights->dim[0];
+    const int accum_depth = csinn_tensor_size(weights) / output_depth;
+    const int kept = csinn_sparse_weight_kept(weights);
+    int32_t *columns = sparse_weight_columns(weights, kept);
+
+    for (int out_c = 0; out_c < output_depth; ++out_c) {
+        const float *row_values = values + out_c * kept;
+        const int32_t *row_columns = columns + out_c * kept;
+        float bias_value = bias->dim_count != 0 ? bias_data[out_c] : 0.0f;
+        for (int b = 0; b < batches; ++b) {
+            const float *x = input_data + b * accum_depth;
+            float total = 0.f;
+            for (int e = 0; e < kept; e++) {
+                total += row_values[e] * x[row_columns[e]];
+            }
+            output_data[out_c + output_depth * b] = total + bias_value;
+        }
+    }
+    shl_mem_free(columns);
+    return CSINN_TRUE;
+}
+
+/* rows ordered like the OIHW kernel inner dims (c, ky, kx), columns are output pixels */
+static void sparse_im2col_nchw(const float *input, float *col, int channels, int in_h, int in_w,
+                               int kernel_h, int kernel_w, int out_h, int out_w,
+                               struct csinn_conv2d_params *params)
+{
+    for (int c = 0; c < channels; c++) {
+        for (int ky = 0; ky < kernel_h; ky++) {
+            for (int kx = 0; kx < kernel_w; kx++) {
+                float *col_row = col + ((c * kernel_h + ky) * kernel_w + kx) * out_h * out_w;
+                for (int oy = 0; oy < out_h; oy++) {
+                    int iy = oy * params->stride_height - params->pad_top +
+                             ky * params->dilation_height;
+                    for (int ox = 0; ox < out_w; ox++) {
+                        int ix = ox * params->stride_width - params->pad_left +
+                                 kx * params->dilation_width;
+                        bool inside = iy >= 0 && iy < in_h && ix >= 0 && ix < in_w;
+                        col_row[oy * out_w + ox] =
+                            inside ? input[(c * in_h + iy) * in_w + ix] : 0.0f;
+                    }
+                }
+            }
+        }
+    }
+}
+
+/* one row per output pixel, ordered like the OHWI kernel inner dims (ky, kx, c) */
+static void sparse_im2col_nhwc(const float *input, float *col, int channels, int in_c,
+                               int in_h, int in_w, int kernel_h, int kernel_w, int out_h,
+                               int out_w, struct csinn_conv2d_params *params)
+{
+    const int k = kernel_h * kernel_w * channels;
+    for (int oy = 0; oy < out_h; oy++) {
+        for (int ox = 0; ox < out_w; ox++) {
+            float *col_row = col + (oy * out_w + ox) * k;
+            for (int ky = 0; ky < kernel_h; ky++) {
+                int iy = oy * params->stride_height - params->pad_top +
+                         ky * params->dilation_height;
+                for (int kx = 0; kx < kernel_w; kx++) {
+                    int ix = ox * params->stride_width - params->pad_left +
+                             kx * params->dilation_width;
+                    bool inside = iy >= 0 && iy < in_h && ix >= 0 && ix < in_w;
+                    float *dst = col_row + (ky * kernel_w + kx) * channels;
+                    for (int c = 0; c < channels; c++) {
+                        dst[c] = inside ? input[(iy * in_w + ix) * in_c + c] : 0.0f;
+                    }
+                }
+            }
+        }
+    }
+}
+
+/*
+ * Sparse GEMM over im2col columns, covering conv2d and group conv2d. A 1x1 stride 1 unpadded
+ * convolution reads the input in place instead of building columns.
+ */
+int shl_ref_conv2d_sparse_f32(struct csinn_tensor *input, struct csinn_tensor *output,
+                              struct csinn_tensor *kernel, struct csinn_tensor *bias,
+                              struct csinn_conv2d_params *params)
+{
+    const bool nchw = params->base.layout == CSINN_LAYOUT_NCHW;
+    if (!nchw && params->base.layout != CSINN_LAYOUT_NHWC) {
+        return CSINN_UNSUPPORT_LAYOUT;
+    }
+    float *input_data = input->data;
+    float *output_data = output->data;
+    float *values = kernel->data;
+    float *bias_data = bias->data;
+    const int group = params->group > 0 ? params->group : 1;
+    const int batches = input->dim[0];
+    const int in_c = nchw ? input->dim[1] : input->dim[3];
+    const int in_h = nchw ? input->dim[2] : input->dim[1];
+    const int in_w = nchw ? input->dim[3] : input->dim[2];
+    const int out_c = nchw ? output->dim[1] : output->dim[3];
+    const int out_h = nchw ? output->dim[2] : output->dim[1];
+    const int out_w = nchw ? output->dim[3] : output->dim[2];
+    const int kernel_h = nchw ? kernel->dim[2] : kernel->dim[1];
+    const int kernel_w = nchw ? kernel->dim[3] : kernel->dim[2];
+    const int group_in_c = in_c / group;
+    const int group_out_c = out_c / group;
+    const int k = group_in_c * kernel_h * kernel_w;
+    const int pixels = out_h * out_w;
+    const bool direct = kernel_h == 1 && kernel_w == 1 && params->stride_height == 1 &&
+                        params->stride_width == 1 && params->pad_top == 0 &&
+                        params->pad_left == 0 && out_h == in_h && out_w == in_w;
+
+    const int kept = csinn_sparse_weight_kept(kernel);
+    int32_t *columns = sparse_weight_columns(kernel, kept);
+    float *col = direct ? NULL : shl_mem_alloc((int64_t)k * pixels * sizeof(float));
+    /* NHWC rows of a direct convolution are input pixels, strided by all channels */
+    const int ld = direct && !nchw ? in_c : k;
+
+    for (int b = 0; b < batches; b++) {
+        for (int g = 0; g < group; g++) {
+            const float *src;
+            if (nchw) {
+                const float *in_g = input_data + ((int64_t)b * in_c + g * group_in_c) * in_h * in_w;
+                if (!direct) {
+                    sparse_im2col_nchw(in_g, col, group_in_c, in_h, in_w, kernel_h, kernel_w,
+                                       out_h, out_w, params);
+                }
+                src = direct ? in_g : col;
+            } else {
+                const float *in_g = input_data + (int64_t)b * in_h * in_w * in_c + g * group_in_c;
+                if (!direct) {
+                    sparse_im2col_nhwc(in_g, col, group_in_c, in_c, in_h, in_w, kernel_h,
+                                       kernel_w, out_h, out_w, params);
+                }
+                src = direct ? in_g : col;
+            }
+
+            for (int oc = 0; oc < group_out_c; oc++) {
+                const int o = g * group_out_c + oc;
+                const float *row_values = values + o * kept;
+                const int32_t *row_columns = columns + o * kept;
+                float bias_value = bias_data && bias->dim_count != 0 ? bias_data[o] : 0.0f;
+                if (nchw) {
+                    /* out[o, :] += w * col[column, :] over the kept weights */
+                    float *out = output_data + ((int64_t)b * out_c + o) * pixels;
+                    for (int p = 0; p < pixels; p++) {
+                        out[p] = bias_value;
+                    }
+                    for (int e = 0; e < kept; e++) {
+                        const float *src_row = src + (int64_t)row_columns[e] * pixels;
+                        const float w = row_values[e];
+                        for (int p = 0; p < pixels; p++) {
+                            out[p] += w * src_row[p];
+                        }
+                    }
+                } else {
+                    float *out = output_data + (int64_t)b * pixels * out_c + o;
+                    for (int p = 0; p < pixels; p++) {
+                        const float *src_row = src + (int64_t)p * ld;
+                        float total = 0.f;
+                        for (int e = 0; e < kept; e++) {
+                            total += row_values[e] * src_row[row_columns[e]];
+                        }
+                        out[(int64_t)p * out_c] = total + bias_value;
+                    }
+                }
+            }
+        }
+    }
+    shl_mem_free(col);
+    shl_mem_free(columns);
+    return CSINN_TRUE;
+}
@@ -20,12 +20,27 @@
 
 #include "shl_ref.h"
 
-int shl_ref_split_f32(struct csinn_tensor *input, struct csinn_tensor **output,
-                      struct csinn_split_params *params)
+int shl_ref_split_init(struct csinn_tensor *input, struct csinn_tensor **output,
+                       struct csinn_split_params *params)
+{
+    struct csinn_callback *cb = params->base.cb;
+    for (int i = 0; i < params->output_num; i++) {
+        if (!shl_ref_is_same_quant(input, output[i])) {
+            cb->exec = shl_ref_split_quant;
+            return CSINN_TRUE;
+        }
+    }
+    cb->exec = shl_ref_split;
+    return CSINN_TRUE;
+}
+
+static int split_copy(struct csinn_tensor *input, struct csinn_tensor **output,
+                      struct csinn_split_params *params, int elem_size)
 {
     int32_t inner_size = 1;
     int32_t out_size = 1;
-    float *input_data = input->data;
+    char *input_data = input->data;
+    const int axis_dim = input->dim[params->axis];
 
     for (int i = 0; i < params->axis; i++) {
         out_size *= input->dim[i];
@@ -36,31 +51,34 @@ int shl_ref_split_f32(struct csinn_tensor *input, struct csinn_tensor **output,
     }
 
     for (int i = 0; i < params->output_num; i++) {
-        int p_size = 0;
-        int s_index;
-        if (i == params->output_num - 1) {
-            p_size = inner_size * (input->dim[params->axis] - params->split_index[i - 1]);
-            s_index = params->split_index[i - 1];
-        } else if (i == 0) {
-            p_size = inner_size * params->split_index[0];
-            s_index = 0;
-        } else {
-            p_size = inner_size * (params->split_index[i] - params->split_index[i - 1]);
-            s_index = params->split_index[i - 1];
-        }
+        int s_index = i == 0 ? 0 : params->split_index[i - 1];
+        int e_index = i == params->output_num - 1 ? axis_dim : params->split_index[i];
+        int p_size = inner_size * (e_index - s_index) * elem_size;
 
-        float *output_i_data = output[i]->data;
+        char *output_i_data = output[i]->data;
 
         for (int out = 0; out < out_size; out++) {
-            int in_index = out * input->dim[params->axis] * inner_size + s_index * inner_size;
-            int out_index = out * inner_size;
-            memcpy(output_i_data + out_index, input_data + in_index, p_size * 4);
+            int64_t in_index = ((int64_t)out * axis_dim + s_index) * inner_size * elem_size;
+            memcpy(output_i_data + (int64_t)out * p_size, input_data + in_index, p_size);
         }
     }
 
     return CSINN_TRUE;
 }
 
+int shl_ref_split_f32(struct csinn_tensor *input, struct csinn_tensor **output,
+                      struct csinn_split_params *params)
+{
+    return split_copy(input, output, params, sizeof(float));
+}
+
+/* input and outputs share dtype and quantization, move raw elements */
+int shl_ref_split(struct csinn_tensor *input, struct csinn_tensor **output,
+                  struct csinn_split_params *params)
+{
+    return split_copy(input, output, params, shl_ref_get_dtype_size(input->dtype));
+}
+
 int shl_ref_split_quant(struct csinn_tensor *input, struct csinn_tensor **output,
                         struct csinn_split_params *params)
 {
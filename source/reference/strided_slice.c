@@ -20,70 +20,60 @@
 
 #include "shl_ref.h"
 
-int shl_ref_strided_slice_f32(struct csinn_tensor *input, struct csinn_tensor *output,
-                              struct csinn_strided_slice_params *params)
+int shl_ref_strided_slice_init(struct csinn_tensor *input, struct csinn_tensor *output,
+                               struct csinn_strided_slice_params *params)
 {
-    float *input_data = (float *)input->data;
-    float *output_data = (float *)output->data;
-    int slice_dim_count = params->slice_count;
-
-    int out_size = 1;
-    // for(int i = 0; i < output->dim_count; i++) {
-    //     out_size *= output->dim[i];
-    // }
-    int outer_size = 1;
-    int inner_size = 1;
-    int inner_size_copy_num = 1;
-
-    for (int i = 0; i < input->dim_count; i++) {
-        inner_size *= input->dim[i];
+    struct csinn_callback *cb = params->base.cb;
+    if (shl_ref_is_same_quant(input, output)) {
+        cb->exec = shl_ref_strided_slice;
+    } else {
+        cb->exec = shl_ref_strided_slice_quant;
     }
+    return CSINN_TRUE;
+}
 
-    float *temp_copy = NULL;
-    for (int slice_dim = 0; slice_dim < slice_dim_count; slice_dim++) {
-        int begin = params->begin[slice_dim];
-        int end = params->end[slice_dim];
-        int stride = params->stride[slice_dim];
-
-        if (begin >= end) {
-            return CSINN_FALSE;
-        }
-        if (end > input->dim[slice_dim]) {
-            end = input->dim[slice_dim];
-        }
-
-        inner_size /= input->dim[slice_dim];
-        outer_size *= inner_size_copy_num;
-
-        inner_size_copy_num = 1 + (end - 1 - begin) / stride;
-        out_size *= inner_size_copy_num;
-
-        float *temp =
-            (float *)shl_mem_alloc(outer_size * inner_size * inner_size_copy_num * sizeof(float));
-        float *temp_addr = temp;
-        for (int n = 0; n < outer_size; n++) {
-            for (int i = begin; i < end; i = i + stride) {
-                memcpy(temp_addr, input_data + i * inner_size, inner_size * sizeof(float));
-                temp_addr += inner_size;
+static int strided_slice_copy(struct csinn_tensor *input, struct csinn_tensor *output,
+                              struct csinn_strided_slice_params *params, int elem_size)
+{
+    int32_t begin[MAX_DIM];
+    int32_t count[MAX_DIM];
+    int32_t stride[MAX_DIM];
+    for (int i = 0; i < input->dim_count; i++) {
+        if (i < params->slice_count) {
+            int end = params->end[i];
+            if (params->begin[i] >= end) {
+                return CSINN_FALSE;
             }
-            input_data += inner_size * input->dim[slice_dim];
-        }
-        if (temp != NULL) {
-            shl_mem_free(temp_copy);
+            if (end > input->dim[i]) {
+                end = input->dim[i];
+            }
+            begin[i] = params->begin[i];
+            stride[i] = params->stride[i];
+            count[i] = 1 + (end - 1 - begin[i]) / stride[i];
+        } else {
+            begin[i] = 0;
+            stride[i] = 1;
+            count[i] = input->dim[i];
         }
-        temp_copy =
-            (float *)shl_mem_alloc(outer_size * inner_size * inner_size_copy_num * sizeof(float));
-        memcpy(temp_copy, temp, outer_size * inner_size * inner_size_copy_num * sizeof(float));
-        input_data = temp_copy;
-        shl_mem_free(temp);
-        temp = NULL;
     }
-    out_size = out_size * inner_size;
-    memcpy(output_data, input_data, out_size * sizeof(float));
-    shl_mem_free(input_data);
+    shl_ref_strided_copy(input->data, output->data, input->dim_count, input->dim, begin, count,
+                         stride, elem_size);
     return CSINN_TRUE;
 }
 
+int shl_ref_strided_slice_f32(struct csinn_tensor *input, struct csinn_tensor *output,
+                              struct csinn_strided_slice_params *params)
+{
+    return strided_slice_copy(input, output, params, sizeof(float));
+}
+
+/* input and output share dtype and quantization, move raw elements */
+int shl_ref_strided_slice(struct csinn_tensor *input, struct csinn_tensor *output,
+                          struct csinn_strided_slice_params *params)
+{
+    return strided_slice_copy(input, output, params, shl_ref_get_dtype_size(input->dtype));
+}
+
 int shl_ref_strided_slice_quant(struct csinn_tensor *input, struct csinn_tensor *output,
                                 struct csinn_strided_slice_params *params)
 {
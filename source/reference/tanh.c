@@ -18,7 +18,7 @@
 
 /* CSI-NN2 version 2.0.x */
 
-#include "shl_ref.h"
+#include "ref_mathfun.h"
 
 int shl_ref_tanh_f32(struct csinn_tensor *input, struct csinn_tensor *output,
                      struct csinn_siso_params *params)
@@ -27,6 +27,10 @@ int shl_ref_tanh_f32(struct csinn_tensor *input, struct csinn_tensor *output,
     float *output_data = output->data;
     int size = csinn_tensor_size(input);
 
+    if (shl_ref_fast_math_enabled(params)) {
+        shl_ref_fast_tanh_f32(input_data, output_data, size);
+        return CSINN_TRUE;
+    }
     for (int i = 0; i < size; i++) {
         output_data[i] = tanh(input_data[i]);
     }
@@ -51,3 +55,21 @@ int shl_ref_tanh_quant(struct csinn_tensor *input, struct csinn_tensor *output,
 {
     return shl_ref_siso_callback_base(input, output, params, shl_ref_tanh_f32);
 }
+
+static int tanh_lut(struct csinn_tensor *input, struct csinn_tensor *output,
+                    struct csinn_siso_params *params)
+{
+    return shl_ref_siso_lut(input, output, params->lut);
+}
+
+int shl_ref_tanh_init(struct csinn_tensor *input, struct csinn_tensor *output,
+                      struct csinn_siso_params *params)
+{
+    struct csinn_callback *cb = params->base.cb;
+    shl_mem_free(params->lut);
+    params->lut = shl_ref_siso_lut_init(input, output, params, shl_ref_tanh_f32);
+    if (params->lut != NULL) {
+        cb->exec = tanh_lut;
+    }
+    return CSINN_TRUE;
+}
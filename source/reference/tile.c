@@ -20,57 +20,74 @@
 
 #include "shl_ref.h"
 
-static int Multiplication(int32_t *dim, int s, int e)
+int shl_ref_tile_init(struct csinn_tensor *input, struct csinn_tensor *output,
+                      struct csinn_tile_params *params)
 {
-    int res = 1;
-    for (int i = s; i <= e; i++) {
-        res = res * dim[i];
+    struct csinn_callback *cb = params->base.cb;
+    if (shl_ref_is_same_quant(input, output)) {
+        cb->exec = shl_ref_tile;
+    } else {
+        cb->exec = shl_ref_tile_quant;
     }
-    return res;
+    return CSINN_TRUE;
 }
 
-int shl_ref_tile_f32(struct csinn_tensor *input, struct csinn_tensor *output,
-                     struct csinn_tile_params *params)
+/* write one tiled copy of input dim d, then replicate it reps[d] - 1 times */
+static void tile_dim(const char *src, char *dst, const int32_t *in_dim, const int32_t *reps,
+                     const int64_t *in_stride, const int64_t *out_stride, int d, int dim_count)
 {
-    float *input_data = (float *)input->data;
-    float *output_data = (float *)output->data;
+    if (d == dim_count - 1) {
+        memcpy(dst, src, in_dim[d] * in_stride[d]);
+    } else {
+        for (int i = 0; i < in_dim[d]; i++) {
+            tile_dim(src + i * in_stride[d], dst + i * out_stride[d], in_dim, reps, in_stride,
+                     out_stride, d + 1, dim_count);
+        }
+    }
+    const int64_t block = in_dim[d] * out_stride[d];
+    for (int r = 1; r < reps[d]; r++) {
+        memcpy(dst + r * block, dst, block);
+    }
+}
 
+static int tile_copy(struct csinn_tensor *input, struct csinn_tensor *output,
+                     struct csinn_tile_params *params, int elem_size)
+{
     int reps_count = params->reps_num;
     assert(reps_count == input->dim_count);
 
-    int in_size = 1;
-    for (int i = 0; i < input->dim_count; i++) {
-        in_size *= input->dim[i];
+    int64_t in_stride[MAX_DIM];
+    int64_t out_stride[MAX_DIM];
+    int64_t in_acc = elem_size;
+    int64_t out_acc = elem_size;
+    for (int d = reps_count - 1; d >= 0; d--) {
+        in_stride[d] = in_acc;
+        out_stride[d] = out_acc;
+        in_acc *= input->dim[d];
+        out_acc *= input->dim[d] * params->reps[d];
     }
-    int out_size = 1;
-    for (int i = 0; i < input->dim_count; i++) {
-        out_size *= params->reps[i];
+    if (reps_count == 0 || out_acc == 0) {
+        memcpy(output->data, input->data, reps_count == 0 ? elem_size : 0);
+        return CSINN_TRUE;
     }
-    out_size = out_size * in_size;
-
-    for (int dim_idx = reps_count - 1; dim_idx >= 0; dim_idx--) {
-        int reps_num = params->reps[dim_idx];
-        int num = Multiplication(input->dim, 0, dim_idx) / (input->dim[dim_idx]);
-        int step = Multiplication(input->dim, dim_idx, input->dim_count - 1) *
-                   Multiplication(params->reps, dim_idx, reps_count - 1) / (params->reps[dim_idx]);
-        float *temp = (float *)shl_mem_alloc(reps_num * num * step * sizeof(float));
-        float *temp_cpy_addr = temp;
-        for (int input_pre_i = 0; input_pre_i < num; input_pre_i++) {
-            for (int rep_i = 0; rep_i < reps_num; rep_i++) {
-                memcpy(temp_cpy_addr, input_data, step * sizeof(float));
-                temp_cpy_addr += step;
-            }
-            input_data += step;
-        }
-        memcpy(output_data, temp, reps_num * num * step * sizeof(float));
-        input_data = output_data;
-        shl_mem_free(temp);
-        temp = NULL;
-    }
-    memcpy(output_data, input_data, out_size * sizeof(float));
+    tile_dim(input->data, output->data, input->dim, params->reps, in_stride, out_stride, 0,
+             reps_count);
     return CSINN_TRUE;
 }
 
+int shl_ref_tile_f32(struct csinn_tensor *input, struct csinn_tensor *output,
+                     struct csinn_tile_params *params)
+{
+    return tile_copy(input, output, params, sizeof(float));
+}
+
+/* input and output share dtype and quantization, move raw elements */
+int shl_ref_tile(struct csinn_tensor *input, struct csinn_tensor *output,
+                 struct csinn_tile_params *params)
+{
+    return tile_copy(input, output, params, shl_ref_get_dtype_size(input->dtype));
+}
+
 int shl_ref_tile_quant(struct csinn_tensor *input, struct csinn_tensor *output,
                        struct csinn_tile_params *params)
 {
@@ -82,6 +82,69 @@ int32_t *shl_ref_get_input_dim(struct csinn_tensor *input, int dim_count, int32_
     return ret;
 }
 
+/*
+ * Per-dimension element strides of both inputs against the output shape,
+ * 0 on broadcast dims. Size-1 output dims are dropped and adjacent dims are
+ * merged while both inputs stay contiguous (or broadcast) across them, so a
+ * bias or scalar operand leaves only two or three dims to walk. Returns the
+ * collapsed rank, or -1 when the inputs do not broadcast to the output.
+ */
+static int broadcast_strides(struct csinn_tensor *input0, struct csinn_tensor *input1,
+                             struct csinn_tensor *output, int32_t *dim, int32_t *stride0,
+                             int32_t *stride1)
+{
+    int32_t rdim[MAX_DIM], rs0[MAX_DIM], rs1[MAX_DIM];
+    int32_t acc0 = 1, acc1 = 1;
+    int rank = 0;
+
+    if (input0->dim_count > output->dim_count || input1->dim_count > output->dim_count) {
+        return -1;
+    }
+    /* innermost dim first */
+    for (int k = 0; k < output->dim_count; k++) {
+        int32_t d = output->dim[output->dim_count - 1 - k];
+        int32_t d0 = k < input0->dim_count ? input0->dim[input0->dim_count - 1 - k] : 1;
+        int32_t d1 = k < input1->dim_count ? input1->dim[input1->dim_count - 1 - k] : 1;
+        if ((d0 != d && d0 != 1) || (d1 != d && d1 != 1)) {
+            return -1;
+        }
+        if (d == 1) {
+            continue;
+        }
+        int32_t s0 = d0 == 1 ? 0 : acc0;
+        int32_t s1 = d1 == 1 ? 0 : acc1;
+        acc0 *= d0;
+        acc1 *= d1;
+        if (rank > 0 && rs0[rank - 1] * rdim[rank - 1] == s0 &&
+            rs1[rank - 1] * rdim[rank - 1] == s1) {
+            rdim[rank - 1] *= d;
+        } else {
+            rdim[rank] = d;
+            rs0[rank] = s0;
+            rs1[rank] = s1;
+            rank++;
+        }
+    }
+    if (rank == 0) {
+        rdim[0] = 1;
+        rs0[0] = 1;
+        rs1[0] = 1;
+        rank = 1;
+    }
+
+    for (int i = 0; i < rank; i++) {
+        dim[i] = rdim[rank - 1 - i];
+        stride0[i] = rs0[rank - 1 - i];
+        stride1[i] = rs1[rank - 1 - i];
+    }
+    return rank;
+}
+
+/*
+ * Broadcast binary op over float tensors without materializing the inputs:
+ * the output is produced as contiguous runs of the innermost collapsed dim,
+ * each handed to the op's run kernel (see SHL_REF_DISO_LOOP).
+ */
 int shl_ref_diso_broadcast_base(struct csinn_tensor *input0, struct csinn_tensor *input1,
                                 struct csinn_tensor *output, struct csinn_diso_params *params,
                                 struct shl_ref_diso_callback *cb)
@@ -89,43 +152,35 @@ int shl_ref_diso_broadcast_base(struct csinn_tensor *input0, struct csinn_tensor
     float *input0_data = input0->data;
     float *input1_data = input1->data;
     float *output_data = output->data;
+    int32_t dim[MAX_DIM], stride0[MAX_DIM], stride1[MAX_DIM];
+    int32_t index[MAX_DIM] = {0};
 
-    cb->output = output;
-
-    int out_size = csinn_tensor_size(output);
-    float *in0_data_b = shl_mem_alloc(out_size * 4);
-    float *in1_data_b = shl_mem_alloc(out_size * 4);
-
-    struct csinn_tensor *b_input0 = csinn_alloc_tensor(NULL);
-    struct csinn_tensor *b_input1 = csinn_alloc_tensor(NULL);
-    csinn_tensor_copy(b_input0, output);
-    csinn_tensor_copy(b_input1, output);
-    b_input0->data = in0_data_b;
-    b_input1->data = in1_data_b;
-
-    if (shl_ref_broadcast_to_shape(input0, b_input0, output->dim, output->dim_count) ==
-        CSINN_FALSE) {
-        SHL_DEBUG_CALL(shl_debug_info("%s: broadcast input0 failed.", __func__));
-        return CSINN_FALSE;
-    };
-    if (shl_ref_broadcast_to_shape(input1, b_input1, output->dim, output->dim_count) ==
-        CSINN_FALSE) {
-        SHL_DEBUG_CALL(shl_debug_info("%s: broadcast input1 failed.", __func__));
+    int rank = broadcast_strides(input0, input1, output, dim, stride0, stride1);
+    if (rank < 0) {
+        shl_debug_error("%s: input shapes do not broadcast to output\n", __func__);
         return CSINN_FALSE;
-    };
-
-    int size0 = csinn_tensor_size(b_input0);
-    int size1 = csinn_tensor_size(b_input1);
+    }
 
-    if (size0 == size1) {
-        for (int i = 0; i < size0; i++) {
-            cb->bc(in0_data_b, in1_data_b, output_data, i, i);
+    int inner = dim[rank - 1];
+    int outer = 1;
+    for (int i = 0; i < rank - 1; i++) {
+        outer *= dim[i];
+    }
+    int64_t offset0 = 0, offset1 = 0;
+    for (int o = 0; o < outer; o++) {
+        cb->bc(input0_data + offset0, input1_data + offset1, output_data + (int64_t)o * inner,
+               inner, stride0[rank - 1], stride1[rank - 1]);
+        for (int j = rank - 2; j >= 0; j--) {
+            offset0 += stride0[j];
+            offset1 += stride1[j];
+            if (++index[j] < dim[j]) {
+                break;
+            }
+            offset0 -= (int64_t)stride0[j] * dim[j];
+            offset1 -= (int64_t)stride1[j] * dim[j];
+            index[j] = 0;
         }
-    } else {
-        return CSINN_FALSE;
     }
-    shl_mem_free(in0_data_b);
-    shl_mem_free(in1_data_b);
     return CSINN_TRUE;
 }
 
@@ -518,6 +573,147 @@ int shl_ref_tensor_transform_free_f32(struct csinn_tensor *input)
     return CSINN_TRUE;
 }
 
+/*
+ * Cache storage as float, still laid out as a ring of max_len rows: kernels read it in place as
+ * rows [start, max_len) followed by [0, ...). Only a quantized cache is converted.
+ */
+struct csinn_tensor *shl_ref_kv_cache_storage_f32(struct csinn_kv_cache *cache, bool value)
+{
+    struct csinn_tensor *storage = value ? cache->value : cache->key;
+    if (storage->dtype == CSINN_DTYPE_FLOAT32) {
+        return storage;
+    }
+    return shl_ref_tensor_transform_f32(storage);
+}
+
+void shl_ref_kv_cache_storage_free_f32(struct csinn_kv_cache *cache, struct csinn_tensor *storage)
+{
+    if (storage != cache->key && storage != cache->value) {
+        shl_ref_tensor_transform_free_f32(storage);
+    }
+}
+
+/* element size in bytes for dtypes that can be moved as raw data, 0 otherwise */
+int shl_ref_get_dtype_size(enum csinn_dtype_enum dtype)
+{
+    switch (dtype) {
+        case CSINN_DTYPE_BOOL:
+        case CSINN_DTYPE_UINT8:
+        case CSINN_DTYPE_INT8:
+            return 1;
+        case CSINN_DTYPE_UINT16:
+        case CSINN_DTYPE_INT16:
+        case CSINN_DTYPE_FLOAT16:
+        case CSINN_DTYPE_BFLOAT16:
+            return 2;
+        case CSINN_DTYPE_UINT32:
+        case CSINN_DTYPE_INT32:
+        case CSINN_DTYPE_FLOAT32:
+            return 4;
+        case CSINN_DTYPE_FLOAT64:
+            return 8;
+        default:
+            return 0;
+    }
+}
+
+/*
+ * True when a and b store values identically, so data movement ops can copy raw
+ * elements instead of dequantizing and requantizing.
+ */
+bool shl_ref_is_same_quant(struct csinn_tensor *a, struct csinn_tensor *b)
+{
+    if (a->dtype != b->dtype || shl_ref_get_dtype_size(a->dtype) == 0) {
+        return false;
+    }
+    if (a->dtype == CSINN_DTYPE_FLOAT32 || a->dtype == CSINN_DTYPE_FLOAT64) {
+        return true;
+    }
+    if (a->quant_channel != b->quant_channel) {
+        return false;
+    }
+    int quant_size = a->quant_channel * sizeof(struct csinn_quant_info);
+    return memcmp(a->qinfo, b->qinfo, quant_size) == 0;
+}
+
+/*
+ * Store value in the storage format of t (dtype and per-tensor qinfo) at dst, converted exactly
+ * like csinn_tensor_data_convert would convert a whole tensor. dst needs 8 bytes.
+ */
+bool shl_ref_scalar_to_dtype(struct csinn_tensor *t, float value, void *dst)
+{
+    if (t->quant_channel > 1) {
+        return false;
+    }
+    struct csinn_tensor src = *t;
+    struct csinn_tensor dest = *t;
+    src.dtype = CSINN_DTYPE_FLOAT32;
+    src.data = &value;
+    src.quant_channel = 1;
+    src.dim_count = dest.dim_count = 1;
+    src.dim[0] = dest.dim[0] = 1;
+    src.layout = dest.layout = CSINN_LAYOUT_N;
+    dest.data = dst;
+    memset(dst, 0, sizeof(double));
+    return csinn_tensor_data_convert(&dest, &src) == CSINN_TRUE;
+}
+
+static void strided_copy_dim(const char *src, char *dst, const int32_t *begin,
+                             const int32_t *count, const int32_t *stride, const int64_t *in_stride,
+                             const int64_t *out_stride, int d, int last)
+{
+    src += begin[d] * in_stride[d];
+    if (d == last) {
+        if (stride[d] == 1) {
+            memcpy(dst, src, count[d] * in_stride[d]);
+        } else {
+            for (int i = 0; i < count[d]; i++) {
+                memcpy(dst + i * out_stride[d], src + i * stride[d] * in_stride[d], in_stride[d]);
+            }
+        }
+        return;
+    }
+    for (int i = 0; i < count[d]; i++) {
+        strided_copy_dim(src + i * stride[d] * in_stride[d], dst + i * out_stride[d], begin, count,
+                         stride, in_stride, out_stride, d + 1, last);
+    }
+}
+
+/*
+ * Copy the box begin[d] + i * stride[d], i < count[d], of a dense tensor into a dense output.
+ * Trailing dimensions that are copied whole are folded into a single memcpy per row.
+ */
+void shl_ref_strided_copy(const void *src, void *dst, int dim_count, const int32_t *dim,
+                          const int32_t *begin, const int32_t *count, const int32_t *stride,
+                          int elem_size)
+{
+    if (dim_count == 0) {
+        memcpy(dst, src, elem_size);
+        return;
+    }
+    for (int d = 0; d < dim_count; d++) {
+        if (count[d] == 0) {
+            return;
+        }
+    }
+    int64_t in_stride[MAX_DIM];
+    int64_t out_stride[MAX_DIM];
+    int64_t in_acc = elem_size;
+    int64_t out_acc = elem_size;
+    for (int d = dim_count - 1; d >= 0; d--) {
+        in_stride[d] = in_acc;
+        out_stride[d] = out_acc;
+        in_acc *= dim[d];
+        out_acc *= count[d];
+    }
+
+    int last = dim_count - 1;
+    while (last > 0 && begin[last] == 0 && count[last] == dim[last] && stride[last] == 1) {
+        last--;
+    }
+    strided_copy_dim(src, dst, begin, count, stride, in_stride, out_stride, 0, last);
+}
+
 int shl_ref_siso_callback_base(struct csinn_tensor *input, struct csinn_tensor *output,
                                void *params, void *cb)
 {
@@ -532,6 +728,69 @@ int shl_ref_siso_callback_base(struct csinn_tensor *input, struct csinn_tensor *
     return ret;
 }
 
+static bool is_8bit_quant(struct csinn_tensor *t)
+{
+    return (t->dtype == CSINN_DTYPE_INT8 || t->dtype == CSINN_DTYPE_UINT8) &&
+           t->quant_channel <= 1 && t->qinfo != NULL;
+}
+
+/*
+ * An 8-bit input only has 256 possible values: run the f32 op once over all
+ * of them, with the same dequantize/requantize as shl_ref_siso_callback_base,
+ * and keep the resulting output bytes. Returns NULL when input or output is
+ * not per-tensor 8-bit quantized.
+ */
+uint8_t *shl_ref_siso_lut_init(struct csinn_tensor *input, struct csinn_tensor *output,
+                               void *params, void *cb)
+{
+    if (!is_8bit_quant(input) || !is_8bit_quant(output)) {
+        return NULL;
+    }
+    int (*callback)() = cb;
+    uint8_t codes[256];
+    float fin[256], fout[256];
+    uint8_t *lut = shl_mem_alloc(256);
+    for (int i = 0; i < 256; i++) {
+        codes[i] = i;
+    }
+
+    struct csinn_tensor qin = *input;
+    struct csinn_tensor qout = *output;
+    qin.dim_count = qout.dim_count = 1;
+    qin.dim[0] = qout.dim[0] = 256;
+    qin.layout = qout.layout = CSINN_LAYOUT_N;
+    qin.quant_channel = qout.quant_channel = 1;
+    struct csinn_tensor finput = qin;
+    struct csinn_tensor foutput = qout;
+    finput.dtype = foutput.dtype = CSINN_DTYPE_FLOAT32;
+    finput.qinfo = foutput.qinfo = NULL;
+    finput.quant_channel = foutput.quant_channel = 0;
+    qin.data = codes;
+    finput.data = fin;
+    foutput.data = fout;
+    qout.data = lut;
+
+    if (csinn_tensor_data_convert(&finput, &qin) != CSINN_TRUE ||
+        callback(&finput, &foutput, params) != CSINN_TRUE ||
+        csinn_tensor_data_convert(&qout, &foutput) != CSINN_TRUE) {
+        shl_mem_free(lut);
+        return NULL;
+    }
+    return lut;
+}
+
+/* 8-bit unary op as a byte gather through the table of shl_ref_siso_lut_init */
+int shl_ref_siso_lut(struct csinn_tensor *input, struct csinn_tensor *output, const uint8_t *lut)
+{
+    const uint8_t *input_data = input->data;
+    uint8_t *output_data = output->data;
+    int64_t size = csinn_tensor_size(input);
+    for (int64_t i = 0; i < size; i++) {
+        output_data[i] = lut[input_data[i]];
+    }
+    return CSINN_TRUE;
+}
+
 int shl_ref_diso_callback_base(struct csinn_tensor *input0, struct csinn_tensor *input1,
                                struct csinn_tensor *output, void *params, void *cb)
 {
@@ -0,0 +1,317 @@
+/*
+ * Copyright (C) 2016-2022 T-Head Semiconductor Co., Ltd. All rights reserved.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* CSI-NN2 version 2.0.x */
+
+#include "shl_ref.h"
+
+/*
+ * Camera frame to model input in one pass: an NV12 or I420 uint8 frame
+ * [batch, height * 3 / 2, width] is resized (bilinear, half-pixel centers),
+ * converted to RGB with BT.601, normalized with mean/std and written in the
+ * output dtype (f32, f16, uint8 or int8) and layout (NCHW, NHWC or
+ * NC1HWC0). Everything that only depends on the shapes and parameters is
+ * folded into a plan at init.
+ */
+
+#define TAP_BITS 11
+#define TAP_ONE (1 << TAP_BITS)
+
+/* source indices and Q11 weight of the second tap, for one axis */
+struct yuv_taps {
+    int32_t *i0;
+    int32_t *i1;
+    int32_t *w;
+};
+
+struct yuv_preprocess_plan {
+    int32_t in_h;
+    int32_t in_w;
+    int32_t out_h;
+    int32_t out_w;
+    struct yuv_taps luma_x;
+    struct yuv_taps luma_y;
+    struct yuv_taps chroma_x;
+    struct yuv_taps chroma_y;
+    float yuv_to_rgb[3][3];  // applied to Y - 16 (video range) or Y, U - 128 and V - 128
+    float alpha[3];          // output = rgb * alpha + beta, per output channel
+    float beta[3];
+    float pad_value;  // stored in the padded channels of NC1HWC0
+};
+
+static void yuv_taps_init(struct yuv_taps *taps, int out_size, int in_size, float scale)
+{
+    for (int i = 0; i < out_size; i++) {
+        float s = (i + 0.5f) * scale - 0.5f;
+        if (s < 0) {
+            s = 0;
+        }
+        int i0 = (int)s;
+        if (i0 > in_size - 1) {
+            i0 = in_size - 1;
+        }
+        taps->i0[i] = i0;
+        taps->i1[i] = i0 + 1 < in_size ? i0 + 1 : in_size - 1;
+        taps->w[i] = (int32_t)((s - i0) * TAP_ONE + 0.5f);
+    }
+}
+
+static int yuv_output_shape(struct csinn_tensor *output, int *out_h, int *out_w)
+{
+    switch (output->layout) {
+        case CSINN_LAYOUT_NCHW:
+            if (output->dim_count != 4 || output->dim[1] != 3) return CSINN_FALSE;
+            *out_h = output->dim[2];
+            *out_w = output->dim[3];
+            return CSINN_TRUE;
+        case CSINN_LAYOUT_NHWC:
+            if (output->dim_count != 4 || output->dim[3] != 3) return CSINN_FALSE;
+            *out_h = output->dim[1];
+            *out_w = output->dim[2];
+            return CSINN_TRUE;
+        case CSINN_LAYOUT_NC1HWC0:
+            if (output->dim_count != 5 || output->dim[4] <= 0 ||
+                output->dim[1] != (3 + output->dim[4] - 1) / output->dim[4]) {
+                return CSINN_FALSE;
+            }
+            *out_h = output->dim[2];
+            *out_w = output->dim[3];
+            return CSINN_TRUE;
+        default:
+            return CSINN_FALSE;
+    }
+}
+
+/* the plan belongs to params: released here, by a later init, or by session deinit */
+void shl_ref_yuv_preprocess_deinit(struct csinn_yuv_preprocess_params *params)
+{
+    shl_mem_free(params->plan);
+    params->plan = NULL;
+}
+
+int shl_ref_yuv_preprocess_init(struct csinn_tensor *input, struct csinn_tensor *output,
+                                struct csinn_yuv_preprocess_params *params)
+{
+    shl_ref_yuv_preprocess_deinit(params);
+
+    int out_h, out_w;
+    if (input->dim_count != 3 || input->dim[0] != output->dim[0] || input->dim[1] % 3 != 0 ||
+        input->dim[2] % 2 != 0 || yuv_output_shape(output, &out_h, &out_w) != CSINN_TRUE) {
+        shl_debug_error("yuv_preprocess: unsupported input or output shape\n");
+        return CSINN_FALSE;
+    }
+    if (output->dtype != CSINN_DTYPE_FLOAT32 && output->dtype != CSINN_DTYPE_FLOAT16 &&
+        output->dtype != CSINN_DTYPE_UINT8 && output->dtype != CSINN_DTYPE_INT8) {
+        shl_debug_error("yuv_preprocess: unsupported output dtype\n");
+        return CSINN_UNSUPPORT_DTYPE;
+    }
+    int in_h = input->dim[1] / 3 * 2;
+    int in_w = input->dim[2];
+
+    /* the plan and all its tables live in one block */
+    int ints = 3 * (2 * out_w + 2 * out_h);
+    struct yuv_preprocess_plan *plan =
+        shl_mem_alloc(sizeof(struct yuv_preprocess_plan) + ints * sizeof(int32_t));
+    int32_t *table = (int32_t *)(plan + 1);
+    struct yuv_taps *axes[4] = {&plan->luma_x, &plan->chroma_x, &plan->luma_y, &plan->chroma_y};
+    for (int a = 0; a < 4; a++) {
+        int size = a < 2 ? out_w : out_h;
+        axes[a]->i0 = table;
+        axes[a]->i1 = table + size;
+        axes[a]->w = table + 2 * size;
+        table += 3 * size;
+    }
+    plan->in_h = in_h;
+    plan->in_w = in_w;
+    plan->out_h = out_h;
+    plan->out_w = out_w;
+
+    float scale_x = (float)in_w / out_w;
+    float scale_y = (float)in_h / out_h;
+    yuv_taps_init(&plan->luma_x, out_w, in_w, scale_x);
+    yuv_taps_init(&plan->luma_y, out_h, in_h, scale_y);
+    /* chroma sample i sits at luma 2i + 0.5, so chroma coordinates are luma ones halved */
+    yuv_taps_init(&plan->chroma_x, out_w, in_w / 2, scale_x / 2);
+    yuv_taps_init(&plan->chroma_y, out_h, in_h / 2, scale_y / 2);
+
+    /* BT.601, rows R, G, B and columns Y, U, V */
+    static const float video_range[3][3] = {{1.164383562f, 0, 1.596026786f},
+                                            {1.164383562f, -0.391762290f, -0.812967647f},
+                                            {1.164383562f, 2.017232143f, 0}};
+    static const float full_range[3][3] = {
+        {1, 0, 1.402f}, {1, -0.344136286f, -0.714136286f}, {1, 1.772f, 0}};
+    memcpy(plan->yuv_to_rgb, params->full_range ? full_range : video_range,
+           sizeof(plan->yuv_to_rgb));
+
+    float qscale = 1;
+    float qzero = 0;
+    if (output->dtype == CSINN_DTYPE_UINT8 || output->dtype == CSINN_DTYPE_INT8) {
+        qscale = output->qinfo->scale;
+        qzero = output->qinfo->zero_point;
+    }
+    for (int c = 0; c < 3; c++) {
+        float std = params->std[c] != 0 ? params->std[c] : 1;
+        plan->alpha[c] = 1 / (std * qscale);
+        plan->beta[c] = -params->mean[c] / (std * qscale) + qzero;
+    }
+    plan->pad_value = qzero;
+    params->plan = plan;
+    return CSINN_TRUE;
+}
+
+/* bilinear luma or chroma sample in Q22, from rows r0 and r1 */
+static inline int32_t yuv_sample(const uint8_t *r0, const uint8_t *r1, int stride, int i0, int i1,
+                                 int wx, int wy)
+{
+    int32_t top = r0[i0 * stride] * (TAP_ONE - wx) + r0[i1 * stride] * wx;
+    int32_t bottom = r1[i0 * stride] * (TAP_ONE - wx) + r1[i1 * stride] * wx;
+    return top * (TAP_ONE - wy) + bottom * wy;
+}
+
+/* one output row as normalized floats, [3][out_w] in output channel order */
+static void yuv_row(struct yuv_preprocess_plan *plan, struct csinn_yuv_preprocess_params *params,
+                    const uint8_t *frame, int oy, float *row)
+{
+    const float q22 = 1.0f / (TAP_ONE * TAP_ONE);
+    int w = plan->in_w;
+    const uint8_t *luma = frame;
+    const uint8_t *chroma = frame + plan->in_h * w;
+    const uint8_t *y0 = luma + plan->luma_y.i0[oy] * w;
+    const uint8_t *y1 = luma + plan->luma_y.i1[oy] * w;
+    int ywy = plan->luma_y.w[oy];
+    int cwy = plan->chroma_y.w[oy];
+
+    /* NV12 keeps U and V interleaved, I420 in two planes */
+    const uint8_t *u0, *u1, *v0, *v1;
+    int stride;
+    if (params->format == CSINN_YUV_NV12) {
+        u0 = chroma + plan->chroma_y.i0[oy] * w;
+        u1 = chroma + plan->chroma_y.i1[oy] * w;
+        v0 = u0 + 1;
+        v1 = u1 + 1;
+        stride = 2;
+    } else {
+        int cw = w / 2;
+        const uint8_t *v_plane = chroma + plan->in_h / 2 * cw;
+        u0 = chroma + plan->chroma_y.i0[oy] * cw;
+        u1 = chroma + plan->chroma_y.i1[oy] * cw;
+        v0 = v_plane + plan->chroma_y.i0[oy] * cw;
+        v1 = v_plane + plan->chroma_y.i1[oy] * cw;
+        stride = 1;
+    }
+
+    float(*m)[3] = plan->yuv_to_rgb;
+    float y_offset = params->full_range ? 0 : 16;
+    int r = params->bgr ? 2 : 0;
+    int b = 2 - r;
+    float *out_r = row + r * plan->out_w;
+    float *out_g = row + plan->out_w;
+    float *out_b = row + b * plan->out_w;
+    for (int ox = 0; ox < plan->out_w; ox++) {
+        int cx0 = plan->chroma_x.i0[ox];
+        int cx1 = plan->chroma_x.i1[ox];
+        int cwx = plan->chroma_x.w[ox];
+        float y = yuv_sample(y0, y1, 1, plan->luma_x.i0[ox], plan->luma_x.i1[ox],
+                             plan->luma_x.w[ox], ywy) *
+                      q22 -
+                  y_offset;
+        float u = yuv_sample(u0, u1, stride, cx0, cx1, cwx, cwy) * q22 - 128;
+        float v = yuv_sample(v0, v1, stride, cx0, cx1, cwx, cwy) * q22 - 128;
+        float rgb[3];
+        for (int c = 0; c < 3; c++) {
+            float value = m[c][0] * y + m[c][1] * u + m[c][2] * v;
+            rgb[c] = fminf(255, fmaxf(0, value));
+        }
+        out_r[ox] = rgb[0] * plan->alpha[r] + plan->beta[r];
+        out_g[ox] = rgb[1] * plan->alpha[1] + plan->beta[1];
+        out_b[ox] = rgb[2] * plan->alpha[b] + plan->beta[b];
+    }
+}
+
+static inline void yuv_store(struct csinn_tensor *output, int64_t index, float value)
+{
+    switch (output->dtype) {
+        case CSINN_DTYPE_FLOAT32:
+            ((float *)output->data)[index] = value;
+            break;
+        case CSINN_DTYPE_FLOAT16:
+            ((int16_t *)output->data)[index] = shl_ref_float32_to_float16(value);
+            break;
+        case CSINN_DTYPE_UINT8:
+            ((uint8_t *)output->data)[index] = fminf(255, fmaxf(0, roundf(value)));
+            break;
+        case CSINN_DTYPE_INT8:
+            ((int8_t *)output->data)[index] = fminf(127, fmaxf(-128, roundf(value)));
+            break;
+        default:
+            break;
+    }
+}
+
+int shl_ref_yuv_preprocess(struct csinn_tensor *input, struct csinn_tensor *output,
+                           struct csinn_yuv_preprocess_params *params)
+{
+    struct yuv_preprocess_plan *plan = params->plan;
+    if (plan == NULL || plan->in_w != input->dim[2] || plan->in_h != input->dim[1] / 3 * 2) {
+        shl_debug_error("yuv_preprocess: plan missing or built for another shape\n");
+        return CSINN_FALSE;
+    }
+    int out_h = plan->out_h;
+    int out_w = plan->out_w;
+    int64_t frame_size = (int64_t)input->dim[1] * input->dim[2];
+    int64_t plane = (int64_t)out_h * out_w;
+    int c0 = output->layout == CSINN_LAYOUT_NC1HWC0 ? output->dim[4] : 1;
+    int c1 = output->layout == CSINN_LAYOUT_NC1HWC0 ? output->dim[1] : 3;
+    int64_t batch_size = (int64_t)c1 * c0 * plane;
+    /* per run, so a plan can be shared by runs on several threads */
+    float *row = shl_mem_alloc(3 * out_w * sizeof(float));
+
+    for (int n = 0; n < input->dim[0]; n++) {
+        const uint8_t *frame = (const uint8_t *)input->data + n * frame_size;
+        int64_t base = n * batch_size;
+        for (int oy = 0; oy < out_h; oy++) {
+            yuv_row(plan, params, frame, oy, row);
+            for (int c = 0; c < 3; c++) {
+                const float *src = row + c * out_w;
+                int64_t index, step;
+                if (output->layout == CSINN_LAYOUT_NCHW) {
+                    index = base + c * plane + oy * out_w;
+                    step = 1;
+                } else if (output->layout == CSINN_LAYOUT_NHWC) {
+                    index = base + oy * out_w * 3 + c;
+                    step = 3;
+                } else {
+                    index = base + (c / c0 * plane + oy * out_w) * c0 + c % c0;
+                    step = c0;
+                }
+                for (int ox = 0; ox < out_w; ox++) {
+                    yuv_store(output, index + ox * step, src[ox]);
+                }
+            }
+            /* channels past the third in the last NC1HWC0 block are padding */
+            for (int c = 3; c < c1 * c0; c++) {
+                int64_t index = base + (c / c0 * plane + oy * out_w) * c0 + c % c0;
+                for (int ox = 0; ox < out_w; ox++) {
+                    yuv_store(output, index + ox * c0, plan->pad_value);
+                }
+            }
+        }
+    }
+    shl_mem_free(row);
+    return CSINN_TRUE;
+}
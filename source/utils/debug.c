@@ -425,6 +425,25 @@ int shl_cache_matmul_debug_info(struct csinn_tensor *input, struct csinn_tensor
     return CSINN_TRUE;
 }
 
+int shl_attention_debug_info(struct csinn_tensor *query, struct csinn_tensor *key,
+                             struct csinn_tensor *value, struct csinn_tensor *mask,
+                             struct csinn_tensor *output, struct csinn_attention_params *params,
+                             const char *name)
+{
+    shl_debug_info("%s = %s(", output->name, name);
+    shl_debug_print_tensor(query);
+    shl_debug_print_tensor(key);
+    shl_debug_print_tensor(value);
+    if (mask != NULL) {
+        shl_debug_print_tensor(mask);
+    }
+    shl_debug_print_params_base(&(params->base));
+    shl_debug_info("scale=%f, num_heads=%d, block_size=%d, causal=%d", params->scale,
+                   params->num_heads, params->block_size, params->causal);
+    shl_debug_info(")\n");
+    return CSINN_TRUE;
+}
+
 int shl_cache_conv1d_debug_info(struct csinn_tensor *input, struct csinn_tensor *output,
                                 struct csinn_tensor *weight, struct csinn_tensor *bias,
                                 struct csinn_cache_conv1d_params *params, const char *name)
@@ -689,6 +708,18 @@ int shl_resize_debug_info(struct csinn_tensor *input, struct csinn_tensor *outpu
     return CSINN_TRUE;
 }
 
+int shl_yuv_preprocess_debug_info(struct csinn_tensor *input, struct csinn_tensor *output,
+                                  struct csinn_yuv_preprocess_params *params, const char *name)
+{
+    shl_debug_print_siso_base(input, output, &(params->base), name);
+    shl_debug_info("format=%d, full_range=%d, bgr=%d, mean=[%f, %f, %f], std=[%f, %f, %f]",
+                   params->format, params->full_range, params->bgr, params->mean[0],
+                   params->mean[1], params->mean[2], params->std[0], params->std[1],
+                   params->std[2]);
+    shl_debug_info(")\n");
+    return CSINN_TRUE;
+}
+
 int shl_reverse_debug_info(struct csinn_tensor *input, struct csinn_tensor *output,
                            struct csinn_reverse_params *params, const char *name)
 {
@@ -918,6 +949,7 @@ int shl_debug_dump_data(struct csinn_tensor *input, char *filename)
 char *op_strings[] = {
     [CSINN_OP_ABS] = "abs",
     [CSINN_OP_ADD] = "add",
+    [CSINN_OP_ATTENTION] = "attention",
     [CSINN_OP_MUL] = "mul",
     [CSINN_OP_AVGPOOL2D] = "avgpool2d",
     [CSINN_OP_CONCAT] = "concat",
@@ -935,6 +967,7 @@ char *op_strings[] = {
     [CSINN_OP_RESHAPE] = "reshape",
     [CSINN_OP_TRANSPOSE] = "transpose",
     [CSINN_OP_SOFTMAX] = "softmax",
+    [CSINN_OP_YUV_PREPROCESS] = "yuv_preprocess",
     [CSINN_OP_YUV_RGB_SCALE] = "yuv_rgb_scale",
 };
 
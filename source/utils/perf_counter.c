@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2016-2022 T-Head Semiconductor Co., Ltd. All rights reserved.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* CSI-NN2 version 2.0.x */
+
+#include "csi_nn.h"
+#include "shl_utils.h"
+
+#if defined(__linux__) && !defined(SHL_BUILD_RTOS)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static const uint64_t perf_counter_config[CSINN_COUNTER_SIZE] = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES,
+};
+
+/*
+ * User space counts only, which perf_event_paranoid <= 2 allows. An event counts the thread
+ * that opens it, and with inherit the threads that thread creates afterwards.
+ */
+static int perf_counter_open_event(uint64_t config)
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.inherit = 1;
+    return syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+/* the reference kernels run their parallel loops with num_threads(8) */
+#define PERF_COUNTER_KERNEL_THREADS 8
+
+/*
+ * OpenMP workers that already exist are not children of a later open, so every thread of a
+ * team opens its own events. The team is as large as the default team and the kernels' teams,
+ * which makes it cover the pooled workers; workers the runtime starts afterwards are created by
+ * the calling thread and inherit its events. Return NULL when no event can be counted, e.g.
+ * without a PMU in a VM.
+ */
+struct shl_perf_counters *shl_perf_counters_open()
+{
+    struct shl_perf_counters *pc = shl_mem_alloc(sizeof(struct shl_perf_counters));
+    pc->thread_num = 1;
+#ifdef _OPENMP
+    pc->thread_num = omp_get_max_threads() > PERF_COUNTER_KERNEL_THREADS
+                         ? omp_get_max_threads()
+                         : PERF_COUNTER_KERNEL_THREADS;
+#endif
+    pc->fd = shl_mem_alloc(pc->thread_num * CSINN_COUNTER_SIZE * sizeof(int));
+    for (int i = 0; i < pc->thread_num * CSINN_COUNTER_SIZE; i++) {
+        pc->fd[i] = -1;
+    }
+#ifdef _OPENMP
+#pragma omp parallel num_threads(pc->thread_num)
+#endif
+    {
+        int t = 0;
+#ifdef _OPENMP
+        t = omp_get_thread_num();
+#endif
+        for (int i = 0; i < CSINN_COUNTER_SIZE; i++) {
+            pc->fd[t * CSINN_COUNTER_SIZE + i] = perf_counter_open_event(perf_counter_config[i]);
+        }
+    }
+    for (int i = 0; i < CSINN_COUNTER_SIZE; i++) {
+        if (pc->fd[i] >= 0) {
+            pc->events |= 1 << i;
+        }
+    }
+    if (pc->events == 0) {
+        shl_perf_counters_close(pc);
+        return NULL;
+    }
+    return pc;
+}
+
+/* counts summed over the threads, events the calling thread could not open read 0 */
+void shl_perf_counters_read(struct shl_perf_counters *pc, uint64_t *value)
+{
+    for (int i = 0; i < CSINN_COUNTER_SIZE; i++) {
+        value[i] = 0;
+        if (!(pc->events & (1 << i))) {
+            continue;
+        }
+        for (int t = 0; t < pc->thread_num; t++) {
+            uint64_t count;
+            int fd = pc->fd[t * CSINN_COUNTER_SIZE + i];
+            if (fd >= 0 && read(fd, &count, sizeof(uint64_t)) == sizeof(uint64_t)) {
+                value[i] += count;
+            }
+        }
+    }
+}
+
+void shl_perf_counters_close(struct shl_perf_counters *pc)
+{
+    for (int i = 0; i < pc->thread_num * CSINN_COUNTER_SIZE; i++) {
+        if (pc->fd[i] >= 0) {
+            close(pc->fd[i]);
+        }
+    }
+    shl_mem_free(pc->fd);
+    shl_mem_free(pc);
+}
+#else
+struct shl_perf_counters *shl_perf_counters_open() { return NULL; }
+
+void shl_perf_counters_read(struct shl_perf_counters *pc, uint64_t *value) {}
+
+void shl_perf_counters_close(struct shl_perf_counters *pc) {}
+#endif
@@ -0,0 +1,60 @@
+#!/usr/bin/python
+#-*- coding:utf-8 -*-
+
+import sys
+import struct
+import numpy as np
+
+def attention_f32():
+    para = []
+    # init the input data and parameters
+    batch  = int(np.random.randint(1, high=3, size=1))
+    heads  = int(np.random.randint(1, high=5, size=1))
+    seq_q  = int(np.random.randint(1, high=80, size=1))
+    seq_k  = int(np.random.randint(seq_q, high=seq_q + 80, size=1))
+    dim    = int(np.random.randint(8, high=65, size=1))
+    dim_v  = int(np.random.randint(8, high=65, size=1))
+    causal = int(np.random.randint(0, high=2, size=1))
+
+    q = np.random.normal(0, 1, (batch, heads, seq_q, dim)).astype(np.float32)
+    k = np.random.normal(0, 1, (batch, heads, seq_k, dim)).astype(np.float32)
+    v = np.random.normal(0, 1, (batch, heads, seq_k, dim_v)).astype(np.float32)
+    # additive mask shared by all heads, hiding a few random keys
+    mask = np.where(np.random.uniform(0, 1, (seq_q, seq_k)) < 0.1, -1e9, 0).astype(np.float32)
+    mask[:, 0] = 0
+
+    score = np.matmul(q, k.transpose(0, 1, 3, 2)) / np.sqrt(dim) + mask
+    if causal:
+        shift = seq_k - seq_q
+        hidden = np.arange(seq_k)[None, :] > np.arange(seq_q)[:, None] + shift
+        score = np.where(hidden, -np.inf, score)
+    score = score - np.max(score, axis=-1, keepdims=True)
+    prob = np.exp(score)
+    prob = prob / np.sum(prob, axis=-1, keepdims=True)
+    out = np.matmul(prob, v).astype(np.float32)
+
+    para.append(batch)
+    para.append(heads)
+    para.append(seq_q)
+    para.append(seq_k)
+    para.append(dim)
+    para.append(dim_v)
+    para.append(causal)
+    total_size = q.size + k.size + v.size + mask.size + out.size + len(para)
+    print(para)
+
+    with open("attention_data_f32.bin", "wb") as fp:
+        data = struct.pack(('%di' % (len(para) + 1)), total_size, *para)
+        fp.write(data)
+        for t in (q, k, v, mask, out):
+            flat = t.ravel('C')
+            data = struct.pack(('%df' % len(flat)), *flat)
+            fp.write(data)
+        fp.close()
+
+    return 0
+
+
+if __name__ == '__main__':
+    attention_f32()
+    print("end")
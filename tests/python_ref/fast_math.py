@@ -0,0 +1,44 @@
+#!/usr/bin/python
+#-*- coding:utf-8 -*-
+
+import sys
+import math
+import struct
+import numpy as np
+
+def fast_math_f32():
+    para = []
+    # init the input data and parameters
+    size = int(np.random.randint(256, high=4097, size=1))
+
+    x = np.random.uniform(-12, 12, size).astype(np.float32)
+    # references in double precision, as libm computes them
+    xd = x.astype(np.float64)
+    sigmoid = 1 / (1 + np.exp(-xd))
+    tanh = np.tanh(xd)
+    erf = np.array([math.erf(v) for v in xd])
+    shifted = xd - np.max(xd)
+    log_sum = np.log(np.sum(np.exp(shifted)))
+    softmax = np.exp(shifted - log_sum)
+    log_softmax = shifted - log_sum
+    refs = [t.astype(np.float32) for t in (sigmoid, tanh, erf, softmax, log_softmax)]
+
+    para.append(size)
+    total_size = x.size * (1 + len(refs)) + len(para)
+    print(para)
+
+    with open("fast_math_data_f32.bin", "wb") as fp:
+        data = struct.pack(('%di' % (len(para) + 1)), total_size, *para)
+        fp.write(data)
+        for t in [x] + refs:
+            flat = t.ravel('C')
+            data = struct.pack(('%df' % len(flat)), *flat)
+            fp.write(data)
+        fp.close()
+
+    return 0
+
+
+if __name__ == '__main__':
+    fast_math_f32()
+    print("end")
@@ -0,0 +1,65 @@
+#!/usr/bin/python
+#-*- coding:utf-8 -*-
+
+import sys
+import struct
+import numpy as np
+
+def prune_2_4(weight):
+    # keep the two largest magnitudes of every four along the reduction axis
+    rows, k = np.shape(weight)
+    groups = (k + 3) // 4
+    padded = np.zeros((rows, groups * 4), dtype=weight.dtype)
+    padded[:, :k] = weight
+    padded = padded.reshape(rows, groups, 4)
+    order = np.argsort(np.abs(padded), axis=2)
+    np.put_along_axis(padded, order[:, :, :2], 0, axis=2)
+    return padded.reshape(rows, groups * 4)[:, :k]
+
+def fullconnected_asp_f32():
+    para = []
+    # init the input data and parameters, odd in_size leaves a partial last group
+    batch       = int(np.random.randint(1, high=8, size=1))
+    in_size     = int(np.random.randint(64, high=256, size=1)) | 1
+    out_size    = int(np.random.randint(64, high=256, size=1))
+
+    src_in = np.random.normal(0, 1, (batch, in_size))
+    weight = np.random.normal(0, 1, (out_size, in_size))
+    bias   = np.random.normal(0, 1, out_size)
+    src_in = src_in.astype(np.float32)
+    weight = prune_2_4(weight.astype(np.float32))
+    bias   = bias.astype(np.float32)
+
+    src_out = np.matmul(src_in, np.transpose(weight, [1, 0])) + bias
+    src_out = src_out.astype(np.float32)
+
+    src_in_1  = src_in.flatten()
+    weight_1  = weight.flatten()
+    src_out_1 = src_out.flatten()
+
+    total_size = len(src_in_1) + len(src_out_1) + len(bias) + len(weight_1) + 3
+
+    para.append(total_size)
+    para.append(batch)
+    para.append(in_size)
+    para.append(out_size)
+
+    with open("fullyconnected_asp_data_f32.bin", "wb") as fp:
+        data = struct.pack(('%di' % len(para)), *para)
+        fp.write(data)
+        data = struct.pack(('%df' % len(src_in_1)), *src_in_1)
+        fp.write(data)
+        data = struct.pack(('%df' % len(weight_1)), *weight_1)
+        fp.write(data)
+        data = struct.pack(('%df' % len(bias)), *bias)
+        fp.write(data)
+        data = struct.pack(('%df' % len(src_out_1)), *src_out_1)
+        fp.write(data)
+        fp.close()
+
+    return 0
+
+
+if __name__ == '__main__':
+    fullconnected_asp_f32()
+    print("end")
@@ -0,0 +1,56 @@
+#!/usr/bin/python
+#-*- coding:utf-8 -*-
+
+import sys
+import struct
+import numpy as np
+
+def fullconnected_weight_only_f32():
+    para = []
+    # init the input data and parameters, odd in_size puts int4 rows across byte boundaries
+    batch       = int(np.random.randint(1, high=4, size=1))
+    in_size     = int(np.random.randint(64, high=256, size=1)) | 1
+    out_size    = int(np.random.randint(64, high=256, size=1))
+
+    src_in = np.random.normal(0, 1, (batch, in_size))
+    weight = np.random.normal(0, 1, (out_size, in_size))
+    # spread the channel ranges so per channel scales matter
+    weight = weight * np.random.uniform(0.1, 4, (out_size, 1))
+    bias   = np.random.normal(0, 1, out_size)
+    src_in = src_in.astype(np.float32)
+    weight = weight.astype(np.float32)
+    bias   = bias.astype(np.float32)
+
+    src_out = np.matmul(src_in, np.transpose(weight, [1, 0])) + bias
+    src_out = src_out.astype(np.float32)
+
+    src_in_1  = src_in.flatten()
+    weight_1  = weight.flatten()
+    src_out_1 = src_out.flatten()
+
+    total_size = len(src_in_1) + len(src_out_1) + len(bias) + len(weight_1) + 3
+
+    para.append(total_size)
+    para.append(batch)
+    para.append(in_size)
+    para.append(out_size)
+
+    with open("fullyconnected_weight_only_data_f32.bin", "wb") as fp:
+        data = struct.pack(('%di' % len(para)), *para)
+        fp.write(data)
+        data = struct.pack(('%df' % len(src_in_1)), *src_in_1)
+        fp.write(data)
+        data = struct.pack(('%df' % len(weight_1)), *weight_1)
+        fp.write(data)
+        data = struct.pack(('%df' % len(bias)), *bias)
+        fp.write(data)
+        data = struct.pack(('%df' % len(src_out_1)), *src_out_1)
+        fp.write(data)
+        fp.close()
+
+    return 0
+
+
+if __name__ == '__main__':
+    fullconnected_weight_only_f32()
+    print("end")
@@ -0,0 +1,65 @@
+#!/usr/bin/python
+#-*- coding:utf-8 -*-
+
+import sys
+import struct
+import numpy as np
+
+def softmax(x):
+    e = np.exp(x - np.max(x, axis=-1, keepdims=True))
+    return e / np.sum(e, axis=-1, keepdims=True)
+
+def kv_cache_f32():
+    para = []
+    # init the input data and parameters
+    heads   = int(np.random.randint(1, high=5, size=1))
+    max_len = int(np.random.randint(8, high=25, size=1))
+    dim     = int(np.random.randint(8, high=33, size=1))
+    prefill = int(np.random.randint(1, high=max_len + 1, size=1))
+    # enough decode steps to wrap the ring and overflow an append-mode cache
+    steps   = max_len + int(np.random.randint(1, high=max_len + 1, size=1))
+    total   = prefill + steps
+
+    q = np.random.normal(0, 1, (heads, total, dim)).astype(np.float32)
+    k = np.random.normal(0, 1, (heads, total, dim)).astype(np.float32)
+    v = np.random.normal(0, 1, (heads, total, dim)).astype(np.float32)
+
+    # causal prefill, scale 1
+    score = np.matmul(q[:, :prefill], k[:, :prefill].transpose(0, 2, 1))
+    hidden = np.arange(prefill)[None, :] > np.arange(prefill)[:, None]
+    out_pre = np.matmul(softmax(np.where(hidden, -np.inf, score)), v[:, :prefill])
+
+    # every decode step sees the last max_len positions, its own included
+    out_step = np.zeros((steps, heads, dim), np.float32)
+    for s in range(steps):
+        t = prefill + s
+        lo = max(0, t + 1 - max_len)
+        score = np.matmul(q[:, t:t + 1], k[:, lo:t + 1].transpose(0, 2, 1))
+        out_step[s] = np.matmul(softmax(score), v[:, lo:t + 1])[:, 0]
+
+    para.append(heads)
+    para.append(max_len)
+    para.append(dim)
+    para.append(prefill)
+    para.append(steps)
+    tensors = (q[:, :prefill], k[:, :prefill], v[:, :prefill],
+               q[:, prefill:].transpose(1, 0, 2), k[:, prefill:].transpose(1, 0, 2),
+               v[:, prefill:].transpose(1, 0, 2), out_pre.astype(np.float32), out_step)
+    total_size = sum(t.size for t in tensors) + len(para)
+    print(para)
+
+    with open("kv_cache_data_f32.bin", "wb") as fp:
+        data = struct.pack(('%di' % (len(para) + 1)), total_size, *para)
+        fp.write(data)
+        for t in tensors:
+            flat = np.ascontiguousarray(t).ravel('C')
+            data = struct.pack(('%df' % len(flat)), *flat)
+            fp.write(data)
+        fp.close()
+
+    return 0
+
+
+if __name__ == '__main__':
+    kv_cache_f32()
+    print("end")
@@ -0,0 +1,152 @@
+#!/usr/bin/python
+#-*- coding:utf-8 -*-
+
+import sys
+import math
+import struct
+import numpy as np
+
+def generate_anchor(ratio, scale, base_size):
+    w = h = float(base_size)
+    x_ctr = 0.5 * (w - 1.0)
+    y_ctr = 0.5 * (h - 1.0)
+    size_ratios = math.floor(w * h / ratio)
+    new_w = int(math.floor(math.sqrt(size_ratios) + 0.5) * scale)
+    new_h = int(math.floor(new_w / scale * ratio + 0.5) * scale)
+    return (x_ctr - 0.5 * (new_w - 1.0), y_ctr - 0.5 * (new_h - 1.0),
+            x_ctr + 0.5 * (new_w - 1.0), y_ctr + 0.5 * (new_h - 1.0))
+
+def predict_bbox(cls_prob, bbox_pred, im_info, ratios, scales, stride, iou_loss, min_size):
+    num_anchors = len(ratios) * len(scales)
+    height = cls_prob.shape[1]
+    width = cls_prob.shape[2]
+    im_height = int(im_info[0])
+    im_width = int(im_info[1])
+    min_size = int(im_info[2] * min_size)
+    boxes = []
+    for i in range(height * width):
+        h = i // width
+        w = i % width
+        for k in range(num_anchors):
+            anchor = generate_anchor(ratios[k // len(scales)], scales[k % len(scales)], stride)
+            # anchors are shifted to the feature map cell and truncated to integers
+            x1 = int(anchor[0] + w * stride)
+            y1 = int(anchor[1] + h * stride)
+            x2 = int(anchor[2] + w * stride)
+            y2 = int(anchor[3] + h * stride)
+            dx, dy, dw, dh = [float(bbox_pred[k * 4 + j, h, w]) for j in range(4)]
+            if iou_loss:
+                box = [x1 + dx, y1 + dy, x2 + dw, y1 + dh]
+            else:
+                bw = x2 - x1 + 1.0
+                bh = y2 - y1 + 1.0
+                cx = dx * bw + (x1 + 0.5 * (bw - 1.0))
+                cy = dy * bh + (y1 + 0.5 * (bh - 1.0))
+                pw = math.exp(dw) * bw
+                ph = math.exp(dh) * bh
+                box = [cx - 0.5 * (pw - 1.0), cy - 0.5 * (ph - 1.0),
+                       cx + 0.5 * (pw - 1.0), cy + 0.5 * (ph - 1.0)]
+            box[0] = max(min(box[0], im_width - 1.0), 0.0)
+            box[1] = max(min(box[1], im_height - 1.0), 0.0)
+            box[2] = max(min(box[2], im_width - 1.0), 0.0)
+            box[3] = max(min(box[3], im_height - 1.0), 0.0)
+            score = float(cls_prob[num_anchors + k, h, w])
+            if h >= im_height // stride or w >= im_width // stride:
+                score = -1.0
+            if box[2] - box[0] + 1.0 < min_size or box[3] - box[1] + 1.0 < min_size:
+                box = [box[0] - min_size / 2.0, box[1] - min_size / 2.0,
+                       box[2] + min_size / 2.0, box[3] + min_size / 2.0]
+                score = -1.0
+            boxes.append(box + [score])
+    return boxes
+
+def nms(boxes, threshold):
+    removed = [False] * len(boxes)
+    keep = []
+    for l in range(len(boxes)):
+        if removed[l]:
+            continue
+        keep.append(l)
+        lx1, ly1, lx2, ly2 = boxes[l][:4]
+        for i in range(l + 1, len(boxes)):
+            x1, y1, x2, y2 = boxes[i][:4]
+            w = max(min(lx2, x2) - max(lx1, x1) + 1.0, 0.0)
+            h = max(min(ly2, y2) - max(ly1, y1) + 1.0, 0.0)
+            inter = w * h
+            l_area = (lx2 - lx1 + 1.0) * (ly2 - ly1 + 1.0)
+            area = (x2 - x1 + 1.0) * (y2 - y1 + 1.0)
+            union = l_area + area - inter
+            if inter / union > threshold:
+                removed[i] = True
+    return keep
+
+def proposal_f32():
+    para = []
+    # init the input data and parameters
+    batch          = int(np.random.randint(1, high=3, size=1))
+    ratios         = [0.5, 1.0, 2.0]
+    scales         = [8.0, 16.0, 32.0]
+    num_anchors    = len(ratios) * len(scales)
+    height         = int(np.random.randint(2, high=16, size=1))
+    width          = int(np.random.randint(2, high=16, size=1))
+    feature_stride = 16
+    num_bbox       = height * width * num_anchors
+    # fewer candidates than boxes, so only part of the ranking is kept
+    pre_nms_top_n  = int(np.random.randint(1, high=num_bbox, size=1))
+    post_nms_top_n = int(np.random.randint(1, high=100, size=1))
+    min_size       = int(np.random.randint(0, high=2, size=1)) * 16
+    iou_loss       = 0
+    threshold      = 0.7
+
+    # scores on a coarse grid, so many boxes tie
+    cls_prob = np.random.randint(0, high=8, size=(batch, 2 * num_anchors, height, width)) / 8.0
+    bbox_pred = np.random.uniform(-0.2, 0.2, (batch, 4 * num_anchors, height, width))
+    cls_prob = cls_prob.astype(np.float32)
+    bbox_pred = bbox_pred.astype(np.float32)
+    im_info = np.zeros((batch, 3), np.float32)
+    for b in range(batch):
+        im_info[b, 0] = height * feature_stride - int(np.random.randint(0, high=40, size=1))
+        im_info[b, 1] = width * feature_stride - int(np.random.randint(0, high=40, size=1))
+        im_info[b, 2] = int(np.random.randint(1, high=3, size=1))
+
+    out = np.zeros((batch, post_nms_top_n, 5), np.float32)
+    for b in range(batch):
+        boxes = predict_bbox(cls_prob[b], bbox_pred[b], im_info[b], ratios, scales,
+                             feature_stride, iou_loss, min_size)
+        # higher score first, on equal scores the later box first
+        order = sorted(range(num_bbox), key=lambda i: (-boxes[i][4], -i))[:pre_nms_top_n]
+        boxes = [boxes[i] for i in order]
+        keep = nms(boxes, threshold)
+        for i in range(post_nms_top_n):
+            out[b, i] = [b] + boxes[keep[i % len(keep)]][:4]
+
+    para.append(batch)
+    para.append(height)
+    para.append(width)
+    para.append(len(ratios))
+    para.append(len(scales))
+    para.append(feature_stride)
+    para.append(pre_nms_top_n)
+    para.append(post_nms_top_n)
+    para.append(min_size)
+    para.append(iou_loss)
+    tensors = (np.array([threshold], np.float32), np.array(ratios, np.float32),
+               np.array(scales, np.float32), cls_prob, bbox_pred, im_info, out)
+    total_size = sum(t.size for t in tensors) + len(para)
+    print(para)
+
+    with open("proposal_data_f32.bin", "wb") as fp:
+        data = struct.pack(('%di' % (len(para) + 1)), total_size, *para)
+        fp.write(data)
+        for t in tensors:
+            flat = t.ravel('C')
+            data = struct.pack(('%df' % len(flat)), *flat)
+            fp.write(data)
+        fp.close()
+
+    return 0
+
+
+if __name__ == '__main__':
+    proposal_f32()
+    print("end")
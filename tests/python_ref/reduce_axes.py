@@ -0,0 +1,56 @@
+#!/usr/bin/python
+#-*- coding:utf-8 -*-
+
+import sys
+import struct
+import numpy as np
+
+def reduce_axes_f32():
+    para = []
+    # init the input data and parameters, NCHW
+    batch      = int(np.random.randint(1, high=4, size=1))
+    in_channel = int(np.random.randint(1, high=16, size=1))
+    in_size_y  = int(np.random.randint(1, high=32, size=1))
+    in_size_x  = int(np.random.randint(1, high=32, size=1))
+
+    src_in = np.random.normal(0, 1, (batch, in_channel, in_size_y, in_size_x))
+    src_in = src_in.astype(np.float32)
+
+    # mean over H, W; sum over the non-adjacent N, H; sum over everything (axis = -1)
+    mean_hw = np.mean(src_in.astype(np.float64), axis=(2, 3))
+    sum_nh  = np.sum(src_in.astype(np.float64), axis=(0, 2))
+    sum_all = np.sum(src_in.astype(np.float64))
+
+    src_in_1   = src_in.flatten()
+    mean_hw_1  = mean_hw.flatten()
+    sum_nh_1   = sum_nh.flatten()
+    sum_all_1  = [float(sum_all)]
+
+    total_size = len(src_in_1) + len(mean_hw_1) + len(sum_nh_1) + len(sum_all_1) + 4
+
+    para.append(total_size)
+    para.append(batch)
+    para.append(in_channel)
+    para.append(in_size_y)
+    para.append(in_size_x)
+    print(para)
+
+    with open("reduce_axes_data_f32.bin", "wb") as fp:
+        data = struct.pack(('%di' % len(para)), *para)
+        fp.write(data)
+        data = struct.pack(('%df' % len(src_in_1)), *src_in_1)
+        fp.write(data)
+        data = struct.pack(('%df' % len(mean_hw_1)), *mean_hw_1)
+        fp.write(data)
+        data = struct.pack(('%df' % len(sum_nh_1)), *sum_nh_1)
+        fp.write(data)
+        data = struct.pack(('%df' % len(sum_all_1)), *sum_all_1)
+        fp.write(data)
+        fp.close()
+
+    return 0
+
+
+if __name__ == '__main__':
+    reduce_axes_f32()
+    print("end")
@@ -0,0 +1,40 @@
+#!/usr/bin/python
+#-*- coding:utf-8 -*-
+
+import sys
+import struct
+import numpy as np
+
+def stream_f32():
+    para = []
+    # init the input data and parameters
+    chunks  = int(np.random.randint(2, high=6, size=1))
+    channel = int(np.random.randint(1, high=9, size=1)) * 2
+    length  = int(np.random.randint(1, high=65, size=1))
+
+    bias = np.random.normal(0, 1, (1, channel, length)).astype(np.float32)
+    x = np.random.normal(0, 1, (chunks, 1, channel, length)).astype(np.float32)
+    # the graph is add(x, bias) split in two along the channels, only the first half is an output
+    out = (x + bias)[:, :, :channel // 2, :].astype(np.float32)
+
+    para.append(chunks)
+    para.append(channel)
+    para.append(length)
+    total_size = bias.size + x.size + out.size + len(para)
+    print(para)
+
+    with open("stream_data_f32.bin", "wb") as fp:
+        data = struct.pack(('%di' % (len(para) + 1)), total_size, *para)
+        fp.write(data)
+        for t in (bias, x, out):
+            flat = t.ravel('C')
+            data = struct.pack(('%df' % len(flat)), *flat)
+            fp.write(data)
+        fp.close()
+
+    return 0
+
+
+if __name__ == '__main__':
+    stream_f32()
+    print("end")
@@ -0,0 +1,90 @@
+#!/usr/bin/python
+#-*- coding:utf-8 -*-
+
+import sys
+import struct
+import numpy as np
+
+def bilinear(plane, out_h, out_w, scale_h, scale_w):
+    # half-pixel centers, coordinates clamped to the plane
+    in_h, in_w = plane.shape
+    ys = np.clip((np.arange(out_h) + 0.5) * scale_h - 0.5, 0, in_h - 1)
+    xs = np.clip((np.arange(out_w) + 0.5) * scale_w - 0.5, 0, in_w - 1)
+    y0 = np.floor(ys).astype(np.int32)
+    x0 = np.floor(xs).astype(np.int32)
+    y1 = np.minimum(y0 + 1, in_h - 1)
+    x1 = np.minimum(x0 + 1, in_w - 1)
+    wy = (ys - y0)[:, None]
+    wx = (xs - x0)[None, :]
+    top = plane[y0][:, x0] * (1 - wx) + plane[y0][:, x1] * wx
+    bottom = plane[y1][:, x0] * (1 - wx) + plane[y1][:, x1] * wx
+    return top * (1 - wy) + bottom * wy
+
+def yuv_preprocess_f32():
+    para = []
+    # init the input data and parameters
+    batch      = int(np.random.randint(1, high=3, size=1))
+    in_h       = int(np.random.randint(4, high=120, size=1)) * 2
+    in_w       = int(np.random.randint(4, high=160, size=1)) * 2
+    out_h      = int(np.random.randint(8, high=224, size=1))
+    out_w      = int(np.random.randint(8, high=224, size=1))
+    nv12       = int(np.random.randint(0, high=2, size=1))
+    full_range = int(np.random.randint(0, high=2, size=1))
+    mean = np.array([123.675, 116.28, 103.53], dtype=np.float32)
+    std  = np.array([58.395, 57.12, 57.375], dtype=np.float32)
+
+    frame = np.random.randint(0, 256, (batch, in_h * 3 // 2, in_w)).astype(np.float32)
+    if full_range:
+        m = np.array([[1, 0, 1.402], [1, -0.344136286, -0.714136286], [1, 1.772, 0]])
+        y_offset = 0
+    else:
+        m = np.array([[1.164383562, 0, 1.596026786],
+                      [1.164383562, -0.391762290, -0.812967647],
+                      [1.164383562, 2.017232143, 0]])
+        y_offset = 16
+
+    out = np.zeros((batch, 3, out_h, out_w), dtype=np.float32)
+    scale_h = in_h / out_h
+    scale_w = in_w / out_w
+    for n in range(batch):
+        luma = frame[n, :in_h]
+        chroma = frame[n, in_h:].ravel()
+        if nv12:
+            u = chroma[0::2].reshape(in_h // 2, in_w // 2)
+            v = chroma[1::2].reshape(in_h // 2, in_w // 2)
+        else:
+            u = chroma[:chroma.size // 2].reshape(in_h // 2, in_w // 2)
+            v = chroma[chroma.size // 2:].reshape(in_h // 2, in_w // 2)
+        y = bilinear(luma, out_h, out_w, scale_h, scale_w) - y_offset
+        u = bilinear(u, out_h, out_w, scale_h / 2, scale_w / 2) - 128
+        v = bilinear(v, out_h, out_w, scale_h / 2, scale_w / 2) - 128
+        for c in range(3):
+            rgb = np.clip(m[c][0] * y + m[c][1] * u + m[c][2] * v, 0, 255)
+            out[n, c] = (rgb - mean[c]) / std[c]
+
+    para.append(batch)
+    para.append(in_h)
+    para.append(in_w)
+    para.append(out_h)
+    para.append(out_w)
+    # csinn_yuv_format_enum: 0 is NV12, 1 is I420
+    para.append(0 if nv12 else 1)
+    para.append(full_range)
+    total_size = mean.size + std.size + frame.size + out.size + len(para)
+    print(para)
+
+    with open("yuv_preprocess_data_f32.bin", "wb") as fp:
+        data = struct.pack(('%di' % (len(para) + 1)), total_size, *para)
+        fp.write(data)
+        for t in (mean, std, frame, out):
+            flat = t.ravel('C')
+            data = struct.pack(('%df' % len(flat)), *flat)
+            fp.write(data)
+        fp.close()
+
+    return 0
+
+
+if __name__ == '__main__':
+    yuv_preprocess_f32()
+    print("end")
@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2016-2022 T-Head Semiconductor Co., Ltd. All rights reserved.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* CSI-NN2 version 2.0.x */
+
+#include "csi_nn.h"
+#include "math_snr.h"
+#include "test_utils.h"
+
+int main(int argc, char **argv)
+{
+    init_testsuite("Testing function of attention f32.\n");
+
+    struct csinn_session *sess = csinn_alloc_session();
+    sess->base_api = CSINN_API;
+    sess->base_run_mode = CSINN_RM_LAYER;
+    struct csinn_tensor *query = csinn_alloc_tensor(NULL);
+    struct csinn_tensor *key = csinn_alloc_tensor(NULL);
+    struct csinn_tensor *value = csinn_alloc_tensor(NULL);
+    struct csinn_tensor *mask = csinn_alloc_tensor(NULL);
+    struct csinn_tensor *output = csinn_alloc_tensor(NULL);
+    struct csinn_tensor *reference = csinn_alloc_tensor(NULL);
+    struct csinn_attention_params *params =
+        csinn_alloc_params(sizeof(struct csinn_attention_params), sess);
+
+    int *buffer = read_input_data_f32(argv[1]);
+    int batch = buffer[0];
+    int heads = buffer[1];
+    int seq_q = buffer[2];
+    int seq_k = buffer[3];
+    int dim = buffer[4];
+    int dim_v = buffer[5];
+    params->causal = buffer[6];
+
+    query->dim_count = 4;
+    query->dim[0] = batch;
+    query->dim[1] = heads;
+    query->dim[2] = seq_q;
+    query->dim[3] = dim;
+    key->dim_count = 4;
+    key->dim[0] = batch;
+    key->dim[1] = heads;
+    key->dim[2] = seq_k;
+    key->dim[3] = dim;
+    value->dim_count = 4;
+    value->dim[0] = batch;
+    value->dim[1] = heads;
+    value->dim[2] = seq_k;
+    value->dim[3] = dim_v;
+    mask->dim_count = 2;
+    mask->dim[0] = seq_q;
+    mask->dim[1] = seq_k;
+    output->dim_count = 4;
+    output->dim[0] = batch;
+    output->dim[1] = heads;
+    output->dim[2] = seq_q;
+    output->dim[3] = dim_v;
+
+    query->dtype = CSINN_DTYPE_FLOAT32;
+    key->dtype = CSINN_DTYPE_FLOAT32;
+    value->dtype = CSINN_DTYPE_FLOAT32;
+    mask->dtype = CSINN_DTYPE_FLOAT32;
+    output->dtype = CSINN_DTYPE_FLOAT32;
+    /* small blocks so the streaming softmax crosses several key blocks */
+    params->block_size = 16;
+    params->base.api = CSINN_API;
+
+    int q_size = batch * heads * seq_q * dim;
+    int k_size = batch * heads * seq_k * dim;
+    int v_size = batch * heads * seq_k * dim_v;
+    int out_size = batch * heads * seq_q * dim_v;
+    query->data = (float *)(buffer + 7);
+    key->data = (float *)query->data + q_size;
+    value->data = (float *)key->data + k_size;
+    mask->data = (float *)value->data + v_size;
+    reference->data = (float *)mask->data + seq_q * seq_k;
+    output->data = malloc(out_size * sizeof(float));
+    float difference = argc > 2 ? atof(argv[2]) : 0.99;
+
+    if (csinn_attention_init(query, key, value, mask, output, params) == CSINN_TRUE) {
+        csinn_attention(query, key, value, mask, output, params);
+    }
+
+    result_verify_f32(reference->data, output->data, query->data, difference, out_size, false);
+
+    free(buffer);
+    free(output->data);
+    return done_testing();
+}
@@ -0,0 +1,152 @@
+/*
+ * Copyright (C) 2016-2022 T-Head Semiconductor Co., Ltd. All rights reserved.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* CSI-NN2 version 2.0.x */
+
+#include "csi_nn.h"
+#include "math_snr.h"
+#include "shl_utils.h"
+#include "test_utils.h"
+
+/*
+ * Winograd error bound, as max |out - ref| / max |ref| against the direct reference: F(4,3)
+ * measures about 5e-6 and F(6,3) about 1e-5 on the generator's shapes.
+ */
+#define WINOGRAD_TOLERANCE 1e-4f
+
+static float max_rel_error(float *ref, float *out, int size)
+{
+    float max_err = 0.0f;
+    float max_ref = 0.0f;
+    for (int i = 0; i < size; i++) {
+        max_err = fmaxf(max_err, fabsf(out[i] - ref[i]));
+        max_ref = fmaxf(max_ref, fabsf(ref[i]));
+    }
+    return max_ref > 0.0f ? max_err / max_ref : max_err;
+}
+
+int main(int argc, char **argv)
+{
+    init_testsuite("Testing function of convolution winograd nchw f32.\n");
+
+    struct csinn_session *sess = csinn_alloc_session();
+    sess->base_api = CSINN_API;
+    sess->base_run_mode = CSINN_RM_LAYER;
+    struct csinn_tensor *input = csinn_alloc_tensor(NULL);
+    struct csinn_tensor *output = csinn_alloc_tensor(NULL);
+    struct csinn_tensor *reference = csinn_alloc_tensor(NULL);
+    struct csinn_tensor *kernel = csinn_alloc_tensor(NULL);
+    struct csinn_tensor *bias = csinn_alloc_tensor(NULL);
+    struct csinn_conv2d_params *params =
+        csinn_alloc_params(sizeof(struct csinn_conv2d_params), sess);
+    int in_size, out_size, weight_size;
+
+    if (argc == 1) {
+        printf("please assign the input data.\n");
+        return 0;
+    }
+
+    int *buffer = read_input_data_f32(argv[1]);
+    input->dim[0] = buffer[0];  // batch
+    input->dim[1] = buffer[1];  // in_channel
+    input->dim[2] = buffer[2];  // height
+    input->dim[3] = buffer[3];  // width
+    kernel->dim[1] = buffer[1];
+    kernel->dim[2] = buffer[6];
+    kernel->dim[3] = buffer[7];
+    kernel->dim[0] = buffer[12];
+    bias->dim[0] = buffer[12];
+    output->dim[0] = buffer[0];   // batch
+    output->dim[1] = buffer[12];  // out_channel
+    output->dim[2] = buffer[16];  // height
+    output->dim[3] = buffer[15];  // width
+
+    params->stride_height = buffer[4];
+    params->stride_width = buffer[5];
+    params->pad_left = buffer[8];
+    params->pad_right = buffer[9];
+    params->pad_top = buffer[10];
+    params->pad_down = buffer[11];
+    params->dilation_width = buffer[13];
+    params->dilation_height = buffer[14];
+    params->base.layout = CSINN_LAYOUT_NCHW;
+    params->base.api = CSINN_API;
+    params->group = 1;
+
+    input->dim_count = 4;
+    kernel->dim_count = 4;
+    bias->dim_count = 1;
+    output->dim_count = 4;
+
+    input->dtype = CSINN_DTYPE_FLOAT32;
+    kernel->dtype = CSINN_DTYPE_FLOAT32;
+    bias->dtype = CSINN_DTYPE_FLOAT32;
+    output->dtype = CSINN_DTYPE_FLOAT32;
+
+    in_size = input->dim[0] * input->dim[1] * input->dim[2] * input->dim[3];
+    out_size = output->dim[0] * output->dim[1] * output->dim[2] * output->dim[3];
+    weight_size = kernel->dim[0] * kernel->dim[1] * kernel->dim[2] * kernel->dim[3];
+
+    input->data = (float *)(buffer + 17);
+    kernel->data = (float *)(buffer + 17 + in_size);
+    bias->data = (float *)(buffer + 17 + in_size + weight_size);
+    reference->data = (float *)(buffer + 17 + in_size + weight_size + output->dim[1]);
+    output->data = malloc(out_size * sizeof(float));
+
+    float difference = argc > 2 ? atof(argv[2]) : 0.9;
+
+    /* both tile sizes, whichever one init would pick for this shape */
+    int within[4] = {0, 0, 0, 0};
+    const int tiles[2] = {4, 6};
+    for (int i = 0; i < 2; i++) {
+        struct csinn_tensor *kernel_tm = csinn_alloc_tensor(NULL);
+        shl_ref_wg_f3s1_trans_kernel_f32(kernel, kernel_tm, tiles[i], params->base.layout);
+        params->conv_extra.kernel_tm = kernel_tm;
+        params->conv_extra.conv_mode = CSINN_WINOGRAD;
+        memset(output->data, 0, out_size * sizeof(float));
+        shl_ref_conv2d_f32(input, output, kernel, bias, params);
+        float error = max_rel_error(reference->data, output->data, out_size);
+        printf("F(%d,3) max relative error %e\n", tiles[i], error);
+        within[i] = error <= WINOGRAD_TOLERANCE;
+        csinn_conv2d_deinit(params);
+    }
+
+    /* layer mode drops the transformed kernel after the run */
+    memset(output->data, 0, out_size * sizeof(float));
+    if (csinn_conv2d_init(input, output, kernel, bias, params) == CSINN_TRUE) {
+        within[2] = params->conv_extra.conv_mode == CSINN_WINOGRAD;
+        csinn_conv2d(input, output, kernel, bias, params);
+        within[2] &= params->conv_extra.kernel_tm == NULL;
+    }
+    result_verify_f32(reference->data, output->data, input->data, difference, out_size, false);
+
+    /* an initialized conv that never runs is released by deinit */
+    if (csinn_conv2d_init(input, output, kernel, bias, params) == CSINN_TRUE) {
+        csinn_conv2d_deinit(params);
+        within[3] = params->conv_extra.kernel_tm == NULL;
+    }
+
+    int expected[4] = {1, 1, 1, 1};
+    result_verify_int32(expected, within, expected, 0, 4, false);
+
+    csinn_free_params(params);
+    csinn_free_session(sess);
+    free(buffer);
+    free(output->data);
+    return done_testing();
+}
@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2016-2022 T-Head Semiconductor Co., Ltd. All rights reserved.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* CSI-NN2 version 2.0.x */
+
+#include "csi_nn.h"
+#include "math_snr.h"
+#include "test_utils.h"
+
+/* the approximations stay within a few ulp of libm, far above this */
+#define MIN_SNR 100.0f
+
+enum { OP_SIGMOID, OP_TANH, OP_ERF, OP_SOFTMAX, OP_LOG_SOFTMAX, OP_NUM };
+
+static const char *op_names[OP_NUM] = {"sigmoid", "tanh", "erf", "softmax", "log_softmax"};
+
+static void run_op(int op, struct csinn_tensor *input, struct csinn_tensor *output,
+                   struct csinn_session *sess)
+{
+    if (op == OP_SIGMOID) {
+        struct csinn_sigmoid_params *params =
+            csinn_alloc_params(sizeof(struct csinn_sigmoid_params), sess);
+        if (csinn_sigmoid_init(input, output, params) == CSINN_TRUE) {
+            csinn_sigmoid(input, output, params);
+        }
+        csinn_free_params(params);
+    } else if (op == OP_TANH || op == OP_ERF) {
+        struct csinn_siso_params *params =
+            csinn_alloc_params(sizeof(struct csinn_siso_params), sess);
+        if (op == OP_TANH && csinn_tanh_init(input, output, params) == CSINN_TRUE) {
+            csinn_tanh(input, output, params);
+        } else if (op == OP_ERF && csinn_erf_init(input, output, params) == CSINN_TRUE) {
+            csinn_erf(input, output, params);
+        }
+        csinn_free_params(params);
+    } else {
+        struct csinn_softmax_params *params =
+            csinn_alloc_params(sizeof(struct csinn_softmax_params), sess);
+        params->axis = 1;
+        if (op == OP_SOFTMAX && csinn_softmax_init(input, output, params) == CSINN_TRUE) {
+            csinn_softmax(input, output, params);
+        } else if (op == OP_LOG_SOFTMAX &&
+                   csinn_log_softmax_init(input, output, params) == CSINN_TRUE) {
+            csinn_log_softmax(input, output, params);
+        }
+        csinn_free_params(params);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    init_testsuite("Testing accuracy of the fast math functions f32.\n");
+
+    struct csinn_tensor *input = csinn_alloc_tensor(NULL);
+    struct csinn_tensor *output = csinn_alloc_tensor(NULL);
+
+    if (argc == 1) {
+        printf("please assign the input data.\n");
+        return 0;
+    }
+
+    int *buffer = read_input_data_f32(argv[1]);
+    int size = buffer[0];
+    input->dim[0] = 1;
+    input->dim[1] = size;
+    input->dim_count = 2;
+    input->dtype = CSINN_DTYPE_FLOAT32;
+    input->layout = CSINN_LAYOUT_NC;
+    csinn_tensor_copy(output, input);
+    input->data = (float *)(buffer + 1);
+    output->data = malloc(size * sizeof(float));
+    float difference = argc > 2 ? atof(argv[2]) : 0.9;
+
+    struct csinn_session *sess = csinn_alloc_session();
+    sess->base_api = CSINN_API;
+    sess->base_run_mode = CSINN_RM_LAYER;
+    sess->fast_math = true;
+
+    int expected[OP_NUM], snr_ok[OP_NUM];
+    for (int op = 0; op < OP_NUM; op++) {
+        float *reference = (float *)input->data + (op + 1) * size;
+        run_op(op, input, output, sess);
+        float snr = csi_snr_f32(reference, output->data, size);
+        printf("%s: SNR %.1f dB against libm\n", op_names[op], snr);
+        result_verify_f32(reference, output->data, input->data, difference, size, false);
+        expected[op] = 1;
+        snr_ok[op] = snr >= MIN_SNR;
+    }
+    result_verify_int32(expected, snr_ok, expected, 0, OP_NUM, false);
+
+    csinn_free_session(sess);
+    free(buffer);
+    free(output->data);
+    return done_testing();
+}
@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2016-2022 T-Head Semiconductor Co., Ltd. All rights reserved.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* CSI-NN2 version 2.0.x */
+
+#include "csi_nn.h"
+#include "math_snr.h"
+#include "test_utils.h"
+
+/* keep the largest magnitude of every four along the reduction axis */
+static void prune_1_4(float *weight, int rows, int k)
+{
+    for (int r = 0; r < rows; r++) {
+        for (int g = 0; g < k; g += 4) {
+            float *lanes = weight + r * k + g;
+            int valid = k - g < 4 ? k - g : 4;
+            int keep = 0;
+            for (int l = 1; l < valid; l++) {
+                keep = fabsf(lanes[l]) > fabsf(lanes[keep]) ? l : keep;
+            }
+            for (int l = 0; l < valid; l++) {
+                lanes[l] = l == keep ? lanes[l] : 0.0f;
+            }
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    init_testsuite("Testing function of fullyconnected with 4:2/4:1 sparse weights f32.\n");
+
+    struct csinn_session *sess = csinn_alloc_session();
+    sess->base_api = CSINN_API;
+    sess->base_run_mode = CSINN_RM_LAYER;
+    struct csinn_tensor *input = csinn_alloc_tensor(NULL);
+    struct csinn_tensor *output = csinn_alloc_tensor(NULL);
+    struct csinn_tensor *reference = csinn_alloc_tensor(NULL);
+    struct csinn_tensor *weight = csinn_alloc_tensor(NULL);
+    struct csinn_tensor *bias = csinn_alloc_tensor(NULL);
+    struct csinn_fc_params *params = csinn_alloc_params(sizeof(struct csinn_fc_params), sess);
+    int in_size0, in_size1, out_size;
+
+    int *buffer = read_input_data_f32(argv[1]);
+    input->dim[0] = buffer[0];   // batch
+    input->dim[1] = buffer[1];   // in_size
+    weight->dim[0] = buffer[2];  // out_size
+    weight->dim[1] = buffer[1];  // in_size
+    bias->dim[0] = buffer[2];
+    output->dim[0] = buffer[0];
+    output->dim[1] = buffer[2];
+    input->dim_count = 2;
+    weight->dim_count = 2;
+    bias->dim_count = 1;
+    output->dim_count = 2;
+    in_size0 = input->dim[0] * input->dim[1];
+    in_size1 = weight->dim[0] * weight->dim[1];
+    out_size = output->dim[0] * output->dim[1];
+    input->dtype = CSINN_DTYPE_FLOAT32;
+    output->dtype = CSINN_DTYPE_FLOAT32;
+    weight->dtype = CSINN_DTYPE_FLOAT32;
+
+    input->data = (float *)(buffer + 3);
+    float *dense_weight = (float *)(buffer + 3 + in_size0);
+    bias->data = (float *)(buffer + 3 + in_size0 + in_size1);
+    reference->data = (float *)(buffer + 3 + in_size0 + in_size1 + buffer[2]);
+    output->data = malloc(out_size * sizeof(float));
+    float difference = argc > 2 ? atof(argv[2]) : 0.9;
+
+    /* 4:2, the generator prunes the weights */
+    weight->data = dense_weight;
+    csinn_sparse_weight_compress(weight, CSINN_MEM_TYPE_ASP42);
+    printf("4:2 weight bytes %d of %d\n", csinn_sparse_weight_byte_size(weight),
+           in_size1 * (int)sizeof(float));
+    if (csinn_fullyconnected_init(input, output, weight, bias, params) == CSINN_TRUE) {
+        csinn_fullyconnected(input, output, weight, bias, params);
+    }
+    result_verify_f32(reference->data, output->data, input->data, difference, out_size, false);
+    shl_mem_free(weight->data);
+
+    /* 4:1 against the dense kernel on the same pruned weights */
+    prune_1_4(dense_weight, weight->dim[0], weight->dim[1]);
+    weight->data = dense_weight;
+    weight->mtype = CSINN_MEM_TYPE_CPU_NOT_ALIGNED;
+    float *reference_data = reference->data;
+    csinn_tensor_copy(reference, output);
+    reference->data = reference_data;
+    csinn_fullyconnected(input, reference, weight, bias, params);
+    csinn_sparse_weight_compress(weight, CSINN_MEM_TYPE_ASP41);
+    printf("4:1 weight bytes %d of %d\n", csinn_sparse_weight_byte_size(weight),
+           in_size1 * (int)sizeof(float));
+    csinn_fullyconnected(input, output, weight, bias, params);
+    result_verify_f32(reference->data, output->data, input->data, difference, out_size, false);
+    shl_mem_free(weight->data);
+
+    free(buffer);
+    free(output->data);
+    csinn_free_session(sess);
+    return done_testing();
+}
@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2016-2022 T-Head Semiconductor Co., Ltd. All rights reserved.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* CSI-NN2 version 2.0.x */
+
+#include "csi_nn.h"
+#include "math_snr.h"
+#include "shl_utils.h"
+#include "test_utils.h"
+
+/* symmetric per output channel quantization of float OI weights */
+static struct csinn_tensor *quantize_weight(struct csinn_tensor *weight,
+                                            enum csinn_dtype_enum dtype)
+{
+    int out_c = weight->dim[0];
+    int in_c = weight->dim[1];
+    float *data = weight->data;
+    float q_max = dtype == CSINN_DTYPE_INT4 ? 7.0f : 127.0f;
+    csinn_realloc_quant_info(weight, out_c);
+    for (int i = 0; i < out_c; i++) {
+        float max_abs = 0;
+        for (int j = 0; j < in_c; j++) {
+            max_abs = fmaxf(max_abs, fabsf(data[i * in_c + j]));
+        }
+        weight->qinfo[i].scale = max_abs > 0 ? max_abs / q_max : 1.0f;
+        weight->qinfo[i].zero_point = 0;
+    }
+
+    struct csinn_tensor *ret = csinn_alloc_tensor(NULL);
+    csinn_tensor_copy(ret, weight);
+    ret->dtype = dtype;
+    ret->data = shl_mem_alloc(csinn_tensor_byte_size(ret));
+    csinn_tensor_data_convert(ret, weight);
+    return ret;
+}
+
+static void run_fc(struct csinn_tensor *input, struct csinn_tensor *output,
+                   struct csinn_tensor *weight, struct csinn_tensor *bias,
+                   struct csinn_session *sess)
+{
+    struct csinn_fc_params *params = csinn_alloc_params(sizeof(struct csinn_fc_params), sess);
+    if (csinn_fullyconnected_init(input, output, weight, bias, params) == CSINN_TRUE) {
+        csinn_fullyconnected(input, output, weight, bias, params);
+    }
+    csinn_free_params(params);
+}
+
+int main(int argc, char **argv)
+{
+    init_testsuite("Testing function of fullyconnected with int8/int4 weights f32.\n");
+
+    struct csinn_session *sess = csinn_alloc_session();
+    sess->base_api = CSINN_API;
+    sess->base_run_mode = CSINN_RM_LAYER;
+
+    struct csinn_tensor *input = csinn_alloc_tensor(NULL);
+    struct csinn_tensor *output = csinn_alloc_tensor(NULL);
+    struct csinn_tensor *reference = csinn_alloc_tensor(NULL);
+    struct csinn_tensor *weight = csinn_alloc_tensor(NULL);
+    struct csinn_tensor *bias = csinn_alloc_tensor(NULL);
+    int in_size0, in_size1, out_size;
+
+    int *buffer = read_input_data_f32(argv[1]);
+    input->dim[0] = buffer[0];   // batch
+    input->dim[1] = buffer[1];   // in_size
+    weight->dim[0] = buffer[2];  // out_size
+    weight->dim[1] = buffer[1];  // in_size
+    bias->dim[0] = buffer[2];
+    output->dim[0] = buffer[0];
+    output->dim[1] = buffer[2];
+    input->dim_count = 2;
+    weight->dim_count = 2;
+    bias->dim_count = 1;
+    output->dim_count = 2;
+    in_size0 = input->dim[0] * input->dim[1];
+    in_size1 = weight->dim[0] * weight->dim[1];
+    out_size = output->dim[0] * output->dim[1];
+    input->dtype = CSINN_DTYPE_FLOAT32;
+    output->dtype = CSINN_DTYPE_FLOAT32;
+    weight->dtype = CSINN_DTYPE_FLOAT32;
+    weight->layout = CSINN_LAYOUT_OI;
+
+    input->data = (float *)(buffer + 3);
+    weight->data = (float *)(buffer + 3 + in_size0);
+    bias->data = (float *)(buffer + 3 + in_size0 + in_size1);
+    reference->data = (float *)(buffer + 3 + in_size0 + in_size1 + buffer[2]);
+    output->data = malloc(out_size * sizeof(float));
+    float difference = argc > 2 ? atof(argv[2]) : 0.99;
+
+    struct csinn_tensor *weight_i8 = quantize_weight(weight, CSINN_DTYPE_INT8);
+    run_fc(input, output, weight_i8, bias, sess);
+    result_verify_f32(reference->data, output->data, input->data, difference, out_size, false);
+
+    struct csinn_tensor *weight_i4 = quantize_weight(weight, CSINN_DTYPE_INT4);
+    run_fc(input, output, weight_i4, bias, sess);
+    result_verify_f32(reference->data, output->data, input->data, 0.9, out_size, false);
+
+    free_input(weight_i8);
+    free_input(weight_i4);
+    free(buffer);
+    free(output->data);
+    csinn_free_session(sess);
+    return done_testing();
+}
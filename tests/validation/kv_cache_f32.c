@@ -0,0 +1,205 @@
+/*
+ * Copyright (C) 2016-2022 T-Head Semiconductor Co., Ltd. All rights reserved.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* CSI-NN2 version 2.0.x */
+#include "csi_nn.h"
+#include "test_utils.h"
+
+static struct csinn_tensor *alloc_tensor(int heads, int seq, int dim, float *data)
+{
+    struct csinn_tensor *t = csinn_alloc_tensor(NULL);
+    t->dim_count = 4;
+    t->dim[0] = 1;
+    t->dim[1] = heads;
+    t->dim[2] = seq;
+    t->dim[3] = dim;
+    t->dtype = CSINN_DTYPE_FLOAT32;
+    t->data = data;
+    return t;
+}
+
+/* one decode step of q, k, v [1, heads, 1, dim] through attention over the cache */
+static void attention_step(struct csinn_tensor **qkv, struct csinn_tensor *output,
+                           struct csinn_attention_params *params, float *q, float *k, float *v,
+                           float *out)
+{
+    qkv[0]->data = q;
+    qkv[1]->data = k;
+    qkv[2]->data = v;
+    output->data = out;
+    csinn_attention(qkv[0], qkv[1], qkv[2], NULL, output, params);
+}
+
+int main(int argc, char **argv)
+{
+    init_testsuite("Testing function of kv cache f32.\n");
+
+    if (argc == 1) {
+        printf("please assign the input data.\n");
+        return 0;
+    }
+
+    int *buffer = read_input_data_f32(argv[1]);
+    int heads = buffer[0];
+    int max_len = buffer[1];
+    int dim = buffer[2];
+    int prefill = buffer[3];
+    int steps = buffer[4];
+    int pre_size = heads * prefill * dim;
+    int step_size = heads * dim;
+    float *q_pre = (float *)(buffer + 5);
+    float *k_pre = q_pre + pre_size;
+    float *v_pre = k_pre + pre_size;
+    float *q_step = v_pre + pre_size;
+    float *k_step = q_step + steps * step_size;
+    float *v_step = k_step + steps * step_size;
+    float *ref_pre = v_step + steps * step_size;
+    float *ref_step = ref_pre + pre_size;
+    float difference = argc > 2 ? atof(argv[2]) : 0.99;
+
+    struct csinn_session *sess = csinn_alloc_session();
+    sess->base_api = CSINN_API;
+    sess->base_run_mode = CSINN_RM_LAYER;
+
+    struct csinn_tensor *pre[3];
+    pre[0] = alloc_tensor(heads, prefill, dim, q_pre);
+    pre[1] = alloc_tensor(heads, prefill, dim, k_pre);
+    pre[2] = alloc_tensor(heads, prefill, dim, v_pre);
+    struct csinn_tensor *step[3];
+    for (int i = 0; i < 3; i++) {
+        step[i] = alloc_tensor(heads, 1, dim, NULL);
+    }
+    float *out_pre = malloc(pre_size * sizeof(float));
+    float *out_step = malloc(steps * step_size * sizeof(float));
+    float *out_last = malloc(step_size * sizeof(float));
+    struct csinn_tensor *output_pre = alloc_tensor(heads, prefill, dim, out_pre);
+    struct csinn_tensor *output_step = alloc_tensor(heads, 1, dim, NULL);
+
+    /* attention over a ring cache: prefill, then decode past max_len so the ring wraps */
+    struct csinn_kv_cache *cache =
+        csinn_alloc_kv_cache(step[1], step[2], max_len, CSINN_KV_CACHE_RING, sess);
+    struct csinn_attention_params *params =
+        csinn_alloc_params(sizeof(struct csinn_attention_params), sess);
+    params->base.api = CSINN_API;
+    params->scale = 1.0f;
+    params->causal = true;
+    params->block_size = 4;
+    params->kv_cache = cache;
+    csinn_attention_init(pre[0], pre[1], pre[2], NULL, output_pre, params);
+    csinn_attention(pre[0], pre[1], pre[2], NULL, output_pre, params);
+    result_verify_f32(ref_pre, out_pre, q_pre, difference, pre_size, false);
+
+    for (int s = 0; s < steps - 1; s++) {
+        int offset = s * step_size;
+        attention_step(step, output_step, params, q_step + offset, k_step + offset,
+                       v_step + offset, out_step + offset);
+    }
+
+    /* a clone takes the last step on its own storage, the original then takes the same step */
+    int last = (steps - 1) * step_size;
+    struct csinn_kv_cache *clone = csinn_kv_cache_clone(cache);
+    params->kv_cache = clone;
+    attention_step(step, output_step, params, q_step + last, k_step + last, v_step + last,
+                   out_step + last);
+    params->kv_cache = cache;
+    attention_step(step, output_step, params, q_step + last, k_step + last, v_step + last,
+                   out_last);
+    result_verify_f32(ref_step, out_step, q_step, difference, steps * step_size, false);
+    result_verify_f32(ref_step + last, out_last, q_step + last, difference, step_size, false);
+
+    /* a reset cache starts the sequence over */
+    csinn_kv_cache_reset(cache);
+    int reset_len = cache->cur_len;
+    csinn_attention(pre[0], pre[1], pre[2], NULL, output_pre, params);
+    result_verify_f32(ref_pre, out_pre, q_pre, difference, pre_size, false);
+
+    /* an append-mode cache refuses the position past max_len */
+    struct csinn_kv_cache *bounded =
+        csinn_alloc_kv_cache(step[1], step[2], max_len, CSINN_KV_CACHE_APPEND, sess);
+    int appended = 0;
+    for (int s = 0; s < steps; s++) {
+        step[1]->data = k_step + s * step_size;
+        step[2]->data = v_step + s * step_size;
+        if (csinn_kv_cache_append(bounded, step[1], step[2]) == CSINN_TRUE) {
+            appended++;
+        }
+    }
+
+    /* q x k^T, softmax and p x v bound to a cache give the attention results */
+    struct csinn_kv_cache *matmul_cache =
+        csinn_alloc_kv_cache(step[1], step[2], max_len, CSINN_KV_CACHE_RING, sess);
+    csinn_kv_cache_append(matmul_cache, pre[1], pre[2]);
+    float *score_data = malloc(heads * max_len * sizeof(float));
+    float *prob_data = malloc(heads * max_len * sizeof(float));
+    struct csinn_tensor *score = alloc_tensor(heads, 1, max_len, score_data);
+    struct csinn_tensor *prob = alloc_tensor(heads, 1, max_len, prob_data);
+    struct csinn_matmul_params *qk_params =
+        csinn_alloc_params(sizeof(struct csinn_matmul_params), sess);
+    qk_params->base.api = CSINN_API;
+    qk_params->trans_b = true;
+    qk_params->kv_cache = matmul_cache;
+    struct csinn_softmax_params *softmax_params =
+        csinn_alloc_params(sizeof(struct csinn_softmax_params), sess);
+    softmax_params->base.api = CSINN_API;
+    softmax_params->axis = 3;
+    struct csinn_matmul_params *pv_params =
+        csinn_alloc_params(sizeof(struct csinn_matmul_params), sess);
+    pv_params->base.api = CSINN_API;
+    pv_params->kv_cache = matmul_cache;
+    pv_params->kv_cache_value = true;
+    csinn_matmul_init(step[0], step[1], score, qk_params);
+    csinn_softmax_init(score, prob, softmax_params);
+    csinn_matmul_init(prob, step[2], output_step, pv_params);
+    for (int s = 0; s < steps; s++) {
+        int offset = s * step_size;
+        step[0]->data = q_step + offset;
+        step[1]->data = k_step + offset;
+        step[2]->data = v_step + offset;
+        output_step->data = out_step + offset;
+        csinn_matmul(step[0], step[1], score, qk_params);
+        csinn_softmax(score, prob, softmax_params);
+        csinn_matmul(prob, step[2], output_step, pv_params);
+    }
+    result_verify_f32(ref_step, out_step, q_step, difference, steps * step_size, false);
+
+    int expected[5] = {max_len, max_len, 0, max_len, max_len};
+    int lengths[5] = {clone->cur_len, matmul_cache->cur_len, reset_len, bounded->cur_len,
+                      appended};
+    result_verify_int32(expected, lengths, expected, 0, 5, false);
+    csinn_session_kv_cache_reset(sess);
+    int empty[3] = {0, 0, 0};
+    int cleared[3] = {cache->cur_len, clone->cur_len, matmul_cache->cur_len};
+    result_verify_int32(empty, cleared, empty, 0, 3, false);
+
+    for (int i = 0; i < 3; i++) {
+        csinn_free_tensor(pre[i]);
+        csinn_free_tensor(step[i]);
+    }
+    csinn_free_tensor(output_pre);
+    csinn_free_tensor(output_step);
+    csinn_free_tensor(score);
+    csinn_free_tensor(prob);
+    csinn_free_session(sess);
+    free(out_pre);
+    free(out_step);
+    free(out_last);
+    free(score_data);
+    free(prob_data);
+    free(buffer);
+    return done_testing();
+}
@@ -22,14 +22,89 @@
 #include "math_snr.h"
 #include "test_utils.h"
 
+/*
+ * An Inf at channel 2 and a NaN at channel 5 may only reach the outputs whose window holds
+ * them, and every output must match the window summed directly. Returns the mismatches.
+ */
+static int lrn_non_finite_mismatch(struct csinn_session *sess, enum csinn_layout_enum layout)
+{
+    const int depth = 8, points = 2, half_range = 1;
+    float in_data[16], out_data[16];
+    struct csinn_tensor *input = csinn_alloc_tensor(NULL);
+    struct csinn_tensor *output = csinn_alloc_tensor(NULL);
+    struct csinn_lrn_params *params = csinn_alloc_params(sizeof(struct csinn_lrn_params), sess);
+    /* element (c, p) of the point-major NHWC layout or the channel-major NCHW one */
+    const int c_stride = layout == CSINN_LAYOUT_NHWC ? 1 : points;
+    const int p_stride = layout == CSINN_LAYOUT_NHWC ? depth : 1;
+
+    input->dim_count = 4;
+    input->dim[0] = 1;
+    input->dim[1] = layout == CSINN_LAYOUT_NHWC ? 1 : depth;
+    input->dim[2] = layout == CSINN_LAYOUT_NHWC ? points : 1;
+    input->dim[3] = layout == CSINN_LAYOUT_NHWC ? depth : points;
+    input->dtype = CSINN_DTYPE_FLOAT32;
+    input->data = in_data;
+    csinn_tensor_copy(output, input);
+    output->data = out_data;
+
+    params->range = half_range * 2 + 1;
+    params->bias = 1.0f;
+    params->alpha = 0.5f;
+    params->beta = 0.75f;
+    params->base.layout = layout;
+    params->base.api = CSINN_API;
+
+    for (int c = 0; c < depth; c++) {
+        for (int p = 0; p < points; p++) {
+            in_data[c * c_stride + p * p_stride] = 0.25f * (c + 1) - 0.5f * p;
+        }
+    }
+    in_data[2 * c_stride] = INFINITY;
+    in_data[5 * c_stride + p_stride] = NAN;
+
+    int mismatch = -1;
+    if (csinn_lrn_init(input, output, params) == CSINN_TRUE) {
+        csinn_lrn(input, output, params);
+        mismatch = 0;
+        for (int c = 0; c < depth; c++) {
+            for (int p = 0; p < points; p++) {
+                double sum = 0;
+                for (int k = c - half_range; k <= c + half_range; k++) {
+                    if (k >= 0 && k < depth) {
+                        float v = in_data[k * c_stride + p * p_stride];
+                        sum += (double)v * v;
+                    }
+                }
+                float x = in_data[c * c_stride + p * p_stride];
+                float out = out_data[c * c_stride + p * p_stride];
+                float ref = x * pow(params->bias + params->alpha * sum / params->range,
+                                    -params->beta);
+                if (isnan(ref) || isnan(out)) {
+                    mismatch += isnan(ref) != isnan(out);
+                } else {
+                    mismatch += fabsf(ref - out) > 1e-5f * fabsf(ref) + 1e-6f;
+                }
+            }
+        }
+    }
+
+    csinn_free_tensor(input);
+    csinn_free_tensor(output);
+    csinn_free_params(params);
+    return mismatch;
+}
+
 int main(int argc, char **argv)
 {
     init_testsuite("Testing function of lrn f32.\n");
 
+    struct csinn_session *sess = csinn_alloc_session();
+    sess->base_api = CSINN_API;
+    sess->base_run_mode = CSINN_RM_LAYER;
     struct csinn_tensor *input = csinn_alloc_tensor(NULL);
     struct csinn_tensor *output = csinn_alloc_tensor(NULL);
     struct csinn_tensor *reference = csinn_alloc_tensor(NULL);
-    struct csinn_lrn_params *params = csinn_alloc_params(sizeof(struct csinn_lrn_params), NULL);
+    struct csinn_lrn_params *params = csinn_alloc_params(sizeof(struct csinn_lrn_params), sess);
     int in_size = 1;
     int out_size = 1;
 
@@ -71,7 +146,13 @@ int main(int argc, char **argv)
 
     result_verify_f32(reference->data, output->data, input->data, difference, out_size, false);
 
+    int expected[2] = {0, 0};
+    int mismatch[2] = {lrn_non_finite_mismatch(sess, CSINN_LAYOUT_NHWC),
+                       lrn_non_finite_mismatch(sess, CSINN_LAYOUT_NCHW)};
+    result_verify_int32(expected, mismatch, expected, 0, 2, false);
+
     free(buffer);
     free(output->data);
+    csinn_free_session(sess);
     return done_testing();
 }
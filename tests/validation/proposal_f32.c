@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2016-2022 T-Head Semiconductor Co., Ltd. All rights reserved.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* CSI-NN2 version 2.0.x */
+#include "csi_nn.h"
+#include "math_snr.h"
+#include "test_utils.h"
+
+int main(int argc, char **argv)
+{
+    init_testsuite("Testing function of proposal f32.\n");
+
+    if (argc == 1) {
+        printf("please assign the input data.\n");
+        return 0;
+    }
+
+    struct csinn_session *sess = csinn_alloc_session();
+    sess->base_api = CSINN_API;
+    sess->base_run_mode = CSINN_RM_LAYER;
+    struct csinn_tensor *cls_prob = csinn_alloc_tensor(NULL);
+    struct csinn_tensor *bbox_pred = csinn_alloc_tensor(NULL);
+    struct csinn_tensor *im_info = csinn_alloc_tensor(NULL);
+    struct csinn_tensor *output = csinn_alloc_tensor(NULL);
+    struct csinn_tensor *reference = csinn_alloc_tensor(NULL);
+    struct csinn_proposal_params *params =
+        csinn_alloc_params(sizeof(struct csinn_proposal_params), sess);
+
+    int *buffer = read_input_data_f32(argv[1]);
+    int batch = buffer[0];
+    int height = buffer[1];
+    int width = buffer[2];
+    params->ratios_num = buffer[3];
+    params->scales_num = buffer[4];
+    params->feature_stride = buffer[5];
+    params->rpn_pre_nms_top_n = buffer[6];
+    params->rpn_post_nms_top_n = buffer[7];
+    params->rpn_min_size = buffer[8];
+    params->iou_loss = buffer[9];
+    float *data = (float *)(buffer + 10);
+    params->threshold = data[0];
+    params->ratios = data + 1;
+    params->scales = params->ratios + params->ratios_num;
+    params->base.api = CSINN_API;
+    int num_anchors = params->ratios_num * params->scales_num;
+
+    cls_prob->dim_count = 4;
+    cls_prob->dim[0] = batch;
+    cls_prob->dim[1] = 2 * num_anchors;
+    cls_prob->dim[2] = height;
+    cls_prob->dim[3] = width;
+    bbox_pred->dim_count = 4;
+    bbox_pred->dim[0] = batch;
+    bbox_pred->dim[1] = 4 * num_anchors;
+    bbox_pred->dim[2] = height;
+    bbox_pred->dim[3] = width;
+    im_info->dim_count = 2;
+    im_info->dim[0] = batch;
+    im_info->dim[1] = 3;
+    output->dim_count = 2;
+    output->dim[0] = batch * params->rpn_post_nms_top_n;
+    output->dim[1] = 5;
+    cls_prob->dtype = CSINN_DTYPE_FLOAT32;
+    bbox_pred->dtype = CSINN_DTYPE_FLOAT32;
+    im_info->dtype = CSINN_DTYPE_FLOAT32;
+    output->dtype = CSINN_DTYPE_FLOAT32;
+
+    int cls_size = csinn_tensor_size(cls_prob);
+    int bbox_size = csinn_tensor_size(bbox_pred);
+    int out_size = csinn_tensor_size(output);
+    cls_prob->data = params->scales + params->scales_num;
+    bbox_pred->data = (float *)cls_prob->data + cls_size;
+    im_info->data = (float *)bbox_pred->data + bbox_size;
+    reference->data = (float *)im_info->data + batch * 3;
+    output->data = malloc(out_size * sizeof(float));
+    float difference = argc > 2 ? atof(argv[2]) : 0.99;
+
+    /* the plan is reused by a second run, and released with the op */
+    int mismatch[2] = {-1, -1};
+    if (csinn_proposal_init(cls_prob, bbox_pred, im_info, output, params) == CSINN_TRUE) {
+        for (int run = 0; run < 2; run++) {
+            memset(output->data, 0, out_size * sizeof(float));
+            csinn_proposal(cls_prob, bbox_pred, im_info, output, params);
+            result_verify_f32(reference->data, output->data, cls_prob->data, difference,
+                              out_size, false);
+            /* a box ranked differently among tied scores moves whole rows */
+            mismatch[run] = 0;
+            for (int i = 0; i < out_size; i++) {
+                float *ref = reference->data;
+                float *out = output->data;
+                mismatch[run] += fabsf(ref[i] - out[i]) > 1e-2f;
+            }
+        }
+    }
+    int expected[2] = {0, 0};
+    result_verify_int32(expected, mismatch, expected, 0, 2, false);
+    shl_ref_proposal_deinit(params);
+
+    free(buffer);
+    free(output->data);
+    return done_testing();
+}
@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2016-2022 T-Head Semiconductor Co., Ltd. All rights reserved.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* CSI-NN2 version 2.0.x */
+
+#include "csi_nn.h"
+#include "math_snr.h"
+#include "test_utils.h"
+
+/* reduce input over axes into a keepdims or squeezed output and compare with reference */
+static void run_reduce(struct csinn_session *sess, struct csinn_tensor *input, float *reference,
+                       int32_t *axis, int axis_count, bool keepdims, bool mean,
+                       float difference)
+{
+    struct csinn_tensor *output = csinn_alloc_tensor(NULL);
+    struct csinn_reduce_params *params =
+        csinn_alloc_params(sizeof(struct csinn_reduce_params), sess);
+    bool reduced[4] = {false, false, false, false};
+    for (int i = 0; i < axis_count; i++) {
+        if (axis[i] == -1) {
+            reduced[0] = reduced[1] = reduced[2] = reduced[3] = true;
+        } else {
+            reduced[axis[i]] = true;
+        }
+    }
+
+    output->dim_count = 0;
+    for (int i = 0; i < input->dim_count; i++) {
+        if (keepdims) {
+            output->dim[output->dim_count++] = reduced[i] ? 1 : input->dim[i];
+        } else if (!reduced[i]) {
+            output->dim[output->dim_count++] = input->dim[i];
+        }
+    }
+    if (output->dim_count == 0) {
+        output->dim_count = 1;
+        output->dim[0] = 1;
+    }
+    output->dtype = CSINN_DTYPE_FLOAT32;
+    int out_size = csinn_tensor_size(output);
+    output->data = malloc(out_size * sizeof(float));
+
+    params->axis = axis;
+    params->axis_count = axis_count;
+    params->keepdims = keepdims;
+    params->base.api = CSINN_API;
+
+    if (mean) {
+        if (csinn_reduce_mean_init(input, output, params) == CSINN_TRUE) {
+            csinn_reduce_mean(input, output, params);
+        }
+    } else {
+        if (csinn_reduce_sum_init(input, output, params) == CSINN_TRUE) {
+            csinn_reduce_sum(input, output, params);
+        }
+    }
+
+    result_verify_f32(reference, output->data, input->data, difference, out_size, false);
+
+    free(output->data);
+    csinn_free_tensor(output);
+    csinn_free_params(params);
+}
+
+int main(int argc, char **argv)
+{
+    init_testsuite("Testing function of reduce over several axes f32.\n");
+
+    struct csinn_session *sess = csinn_alloc_session();
+    sess->base_api = CSINN_API;
+    sess->base_run_mode = CSINN_RM_LAYER;
+    struct csinn_tensor *input = csinn_alloc_tensor(NULL);
+
+    if (argc == 1) {
+        printf("please assign the input data.\n");
+        return 0;
+    }
+
+    int *buffer = read_input_data_f32(argv[1]);
+    input->dim[0] = buffer[0];  // batch
+    input->dim[1] = buffer[1];  // channel
+    input->dim[2] = buffer[2];  // height
+    input->dim[3] = buffer[3];  // width
+    input->dim_count = 4;
+    input->dtype = CSINN_DTYPE_FLOAT32;
+    input->layout = CSINN_LAYOUT_NCHW;
+
+    int in_size = csinn_tensor_size(input);
+    input->data = (float *)(buffer + 4);
+    float *mean_hw = (float *)(buffer + 4 + in_size);
+    float *sum_nh = mean_hw + input->dim[0] * input->dim[1];
+    float *sum_all = sum_nh + input->dim[1] * input->dim[3];
+    float difference = argc > 2 ? atof(argv[2]) : 0.9;
+
+    int32_t hw[2] = {2, 3};
+    int32_t nh[2] = {0, 2};
+    int32_t all[1] = {-1};
+    for (int keepdims = 1; keepdims >= 0; keepdims--) {
+        run_reduce(sess, input, mean_hw, hw, 2, keepdims, true, difference);
+        run_reduce(sess, input, sum_nh, nh, 2, keepdims, false, difference);
+        run_reduce(sess, input, sum_all, all, 1, keepdims, false, difference);
+    }
+
+    csinn_free_tensor(input);
+    csinn_free_session(sess);
+    free(buffer);
+    return done_testing();
+}
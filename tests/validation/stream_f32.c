@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2016-2022 T-Head Semiconductor Co., Ltd. All rights reserved.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* CSI-NN2 version 2.0.x */
+
+#include "csi_nn.h"
+#include "shl_utils.h"
+#include "test_utils.h"
+
+static struct csinn_tensor *alloc_tensor(struct csinn_session *sess, int channel, int length)
+{
+    struct csinn_tensor *t = csinn_alloc_tensor(sess);
+    t->dim[0] = 1;
+    t->dim[1] = channel;
+    t->dim[2] = length;
+    t->dim_count = 3;
+    t->dtype = CSINN_DTYPE_FLOAT32;
+    t->layout = CSINN_LAYOUT_NCW;
+    return t;
+}
+
+/* add(x, bias) split in two along the channels, the second half has no consumer */
+static struct csinn_session *build_session(int channel, int length, float *bias_data,
+                                           int32_t *split_index)
+{
+    struct csinn_session *sess = csinn_alloc_session();
+    sess->base_api = CSINN_API;
+    sess->base_run_mode = CSINN_RM_CPU_GRAPH;
+    sess->base_dtype = CSINN_DTYPE_FLOAT32;
+    csinn_session_init(sess);
+    csinn_set_input_number(1, sess);
+    csinn_set_output_number(1, sess);
+
+    struct csinn_tensor *input = alloc_tensor(sess, channel, length);
+    input->name = "input";
+    csinn_set_tensor_entry(input, sess);
+    csinn_set_input(0, input, sess);
+
+    struct csinn_tensor *bias = alloc_tensor(sess, channel, length);
+    bias->is_const = 1;
+    bias->data = bias_data;
+    struct csinn_tensor *sum = alloc_tensor(sess, channel, length);
+    struct csinn_diso_params *add_params =
+        csinn_alloc_params(sizeof(struct csinn_diso_params), sess);
+    csinn_add_init(input, bias, sum, add_params);
+    csinn_add(input, bias, sum, add_params);
+
+    struct csinn_tensor *half[2];
+    half[0] = alloc_tensor(sess, channel / 2, length);
+    half[1] = alloc_tensor(sess, channel / 2, length);
+    struct csinn_split_params *split_params =
+        csinn_alloc_params(sizeof(struct csinn_split_params), sess);
+    split_params->split_index = split_index;
+    split_params->output_num = 2;
+    split_params->axis = 1;
+    csinn_split_init(sum, half, split_params);
+    csinn_split(sum, half, split_params);
+
+    csinn_set_output(0, half[0], sess);
+    csinn_session_setup(sess);
+    return sess;
+}
+
+/* run one chunk, the output is the caller's to free outside streaming mode */
+static void run_chunk(struct csinn_session *sess, float *input_data, float *reference,
+                      int out_size, float difference, bool streaming)
+{
+    struct csinn_tensor *input = csinn_alloc_tensor(NULL);
+    input->data = input_data;
+    csinn_update_input(0, input, sess);
+    csinn_session_run(sess);
+
+    struct csinn_tensor *output = csinn_alloc_tensor(NULL);
+    csinn_get_output(0, output, sess);
+    result_verify_f32(reference, output->data, input_data, difference, out_size, false);
+    if (!streaming) {
+        shl_mem_free(output->data);
+    }
+    csinn_free_tensor(output);
+    csinn_free_tensor(input);
+}
+
+int main(int argc, char **argv)
+{
+    init_testsuite("Testing function of streaming mode after a normal run f32.\n");
+
+    if (argc == 1) {
+        printf("please assign the input data.\n");
+        return 0;
+    }
+
+    int *buffer = read_input_data_f32(argv[1]);
+    int chunks = buffer[0];
+    int channel = buffer[1];
+    int length = buffer[2];
+    int in_size = channel * length;
+    int out_size = channel / 2 * length;
+    float *bias = (float *)(buffer + 3);
+    float *input = bias + in_size;
+    float *reference = input + chunks * in_size;
+    float difference = argc > 2 ? atof(argv[2]) : 0.99;
+
+    int32_t split_index[2] = {channel / 2, channel};
+    struct csinn_session *sess = build_session(channel, length, bias, split_index);
+
+    /* a normal run first, then every chunk in streaming mode, then a normal run again */
+    run_chunk(sess, input, reference, out_size, difference, false);
+    csinn_session_set_stream(sess, true);
+    for (int i = 0; i < chunks; i++) {
+        run_chunk(sess, input + i * in_size, reference + i * out_size, out_size, difference,
+                  true);
+    }
+    struct csinn_stream_stats stats;
+    csinn_session_stream_stats(sess, &stats);
+    int expected[3] = {chunks, 0, 2};
+    int counts[3] = {stats.chunk_count, stats.static_layers, stats.stream_layers};
+    result_verify_int32(expected, counts, expected, 0, 3, false);
+    csinn_session_set_stream(sess, false);
+    run_chunk(sess, input + (chunks - 1) * in_size, reference + (chunks - 1) * out_size,
+              out_size, difference, false);
+
+    csinn_session_deinit(sess);
+    csinn_free_session(sess);
+    free(buffer);
+    return done_testing();
+}
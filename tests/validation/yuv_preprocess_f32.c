@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2016-2022 T-Head Semiconductor Co., Ltd. All rights reserved.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* CSI-NN2 version 2.0.x */
+
+#include "csi_nn.h"
+#include "math_snr.h"
+#include "test_utils.h"
+
+int main(int argc, char **argv)
+{
+    init_testsuite("Testing function of yuv_preprocess f32.\n");
+
+    struct csinn_session *sess = csinn_alloc_session();
+    sess->base_api = CSINN_API;
+    sess->base_run_mode = CSINN_RM_LAYER;
+    struct csinn_tensor *input = csinn_alloc_tensor(NULL);
+    struct csinn_tensor *output = csinn_alloc_tensor(NULL);
+    struct csinn_tensor *reference = csinn_alloc_tensor(NULL);
+    struct csinn_yuv_preprocess_params *params =
+        csinn_alloc_params(sizeof(struct csinn_yuv_preprocess_params), sess);
+
+    int *buffer = read_input_data_f32(argv[1]);
+    int batch = buffer[0];
+    int in_h = buffer[1];
+    int in_w = buffer[2];
+    int out_h = buffer[3];
+    int out_w = buffer[4];
+    params->format = buffer[5];
+    params->full_range = buffer[6];
+    float *mean = (float *)(buffer + 7);
+    float *std = mean + 3;
+    for (int c = 0; c < 3; c++) {
+        params->mean[c] = mean[c];
+        params->std[c] = std[c];
+    }
+
+    input->dim_count = 3;
+    input->dim[0] = batch;
+    input->dim[1] = in_h * 3 / 2;
+    input->dim[2] = in_w;
+    output->dim_count = 4;
+    output->dim[0] = batch;
+    output->dim[1] = 3;
+    output->dim[2] = out_h;
+    output->dim[3] = out_w;
+    input->dtype = CSINN_DTYPE_UINT8;
+    output->dtype = CSINN_DTYPE_FLOAT32;
+    output->layout = CSINN_LAYOUT_NCHW;
+    params->base.api = CSINN_API;
+
+    /* the frame is stored as floats, one per byte */
+    int in_size = batch * in_h * 3 / 2 * in_w;
+    int out_size = batch * 3 * out_h * out_w;
+    float *frame = std + 3;
+    uint8_t *yuv = malloc(in_size);
+    for (int i = 0; i < in_size; i++) {
+        yuv[i] = (uint8_t)frame[i];
+    }
+    input->data = yuv;
+    reference->data = frame + in_size;
+    output->data = malloc(out_size * sizeof(float));
+    float difference = argc > 2 ? atof(argv[2]) : 0.01;
+
+    if (csinn_yuv_preprocess_init(input, output, params) == CSINN_TRUE) {
+        csinn_yuv_preprocess(input, output, params);
+    }
+
+    result_verify_f32(reference->data, output->data, frame, difference, out_size, false);
+
+    shl_ref_yuv_preprocess_deinit(params);
+    free(buffer);
+    free(yuv);
+    free(output->data);
+    return done_testing();
+}